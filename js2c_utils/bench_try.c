@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "js2c.h"
+
+// Measures what the exception checks of js2c_exception.h cost code that does
+// not throw: the same loop of calls, once with every call wrapped in
+// JS_CHECKED_CALL as the translator prints it inside a try statement, and
+// once without a handler. Run with `make bench-try`; the iteration count can
+// be given as the first argument.
+
+// Never reached unless given as the second argument, but the compiler cannot
+// tell, so step keeps its throw.
+int32_t throw_at = -1;
+
+// Kept out of line so that each iteration is a real call, as it is for the
+// translated functions that may throw.
+__attribute__((noinline)) static double step(double sum, int32_t i) {
+  if (i == throw_at) {
+    js_throw(make_int32(i));
+    return 0;
+  }
+  return sum + (i & 7);
+}
+
+static double now_ns(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+__attribute__((noinline)) static double checked_loop(int32_t count) {
+  double sum = 0;
+  for (int32_t i = 0; i < count; i++) {
+    sum = JS_CHECKED_CALL(handler, step(sum, i));
+  }
+  return sum;
+handler:
+  js_catch();
+  return -1;
+}
+
+__attribute__((noinline)) static double plain_loop(int32_t count) {
+  double sum = 0;
+  for (int32_t i = 0; i < count; i++) {
+    sum = step(sum, i);
+  }
+  return sum;
+}
+
+// The best of a few alternating runs of each loop, so that frequency scaling
+// and other noise affect both alike.
+#define RUNS 5
+
+int main(int argc, char** argv) {
+  int32_t count = argc > 1 ? (int32_t)atoi(argv[1]) : 100000000;
+  if (count <= 0) return 1;
+  if (argc > 2) throw_at = (int32_t)atoi(argv[2]);
+  double checked_ns = 0;
+  double plain_ns = 0;
+  for (int run = 0; run < RUNS; run++) {
+    double start = now_ns();
+    double checked = checked_loop(count);
+    double elapsed = now_ns() - start;
+    if (run == 0 || elapsed < checked_ns) checked_ns = elapsed;
+    start = now_ns();
+    double plain = plain_loop(count);
+    elapsed = now_ns() - start;
+    if (run == 0 || elapsed < plain_ns) plain_ns = elapsed;
+    if (checked < 0) {
+      printf("checked loop threw at %d\n", throw_at);
+      return 0;
+    }
+    if (checked != plain) {
+      fprintf(stderr, "results differ: %f %f\n", checked, plain);
+      return 1;
+    }
+  }
+  printf("checked: %.3f ns per call\n", checked_ns / count);
+  printf("plain:   %.3f ns per call\n", plain_ns / count);
+  printf("overhead: %.1f%%\n", (checked_ns / plain_ns - 1) * 100);
+  return 0;
+}
@@ -0,0 +1,67 @@
+// Keeps arrays, objects, closures and cons strings alive across many
+// allocations, so that a collection can run while each of them is reachable
+// only from the stack, from another heap object or from a closure
+// environment. `make test-gc-stress` runs it with JS2C_GC_STRESS=1, which
+// collects on every allocation. It prints 202211 either way.
+
+function makePoint(x, y) {
+  return {x: x, y: y};
+}
+
+function makeCounter(start) {
+  var count = start;
+  return function() {
+    count = count + 1;
+    return count;
+  };
+}
+
+function buildList(n) {
+  var list = [];
+  for (var i = 0; i < n; i++) {
+    list[i] = makePoint(i, [i, i + 1]);
+  }
+  return list;
+}
+
+function sumList(list) {
+  var sum = 0;
+  for (var i = 0; i < list.length; i++) {
+    sum = sum + list[i].x + list[i].y[1];
+  }
+  return sum;
+}
+
+function buildString(n) {
+  var s = "";
+  for (var i = 0; i < n; i++) {
+    s = s + "ab";
+  }
+  return s;
+}
+
+// Allocates only in an arena scope, where {a} holds the last reference to a
+// cons string that charAt then flattens.
+function firstCharacterLength(o) {
+  var a = [o.s];
+  o.s = 0;
+  return a[0].charAt(0).length;
+}
+
+function stress(rounds) {
+  var total = 0;
+  var counters = [];
+  for (var r = 0; r < rounds; r++) {
+    counters[r] = makeCounter(r);
+    var list = buildList(100);
+    var s = buildString(50);
+    total = total + sumList(list) + s.length;
+  }
+  for (var j = 0; j < counters.length; j++) {
+    total = total + counters[j]();
+  }
+  total = total + firstCharacterLength({s: buildString(10)});
+  return total;
+}
+
+stress(20);
@@ -1,35 +1,235 @@
 #include "js2c.h"
 
-js_data make_data(js_type type) {
-  js_data data;
-  switch (type) {
+uintptr_t js_interned_begin;
+uintptr_t js_interned_end;
+
+void js_intern_strings(const void* table, size_t size) {
+  js_interned_begin = (uintptr_t)table;
+  js_interned_end = js_interned_begin + size;
+}
+
+uint32_t js_string_hash(const char* chars) {
+  if (js_is_interned(chars)) return js_interned_header(chars)->hash;
+  uint32_t hash = 0;
+  for (const unsigned char* c = (const unsigned char*)chars; *c != 0; c++) {
+    hash += *c;
+    hash += hash << 10;
+    hash ^= hash >> 6;
+  }
+  hash += hash << 3;
+  hash ^= hash >> 11;
+  hash += hash << 15;
+  hash &= 0x3FFFFFFF;
+  return hash == 0 ? 27 : hash;
+}
+
+js_type js_type_of(js_value value) {
+  switch (js_tag(value)) {
+    case JS_TAG_INT32:
+      return JS_NUMBER;
+    case JS_TAG_BOOLEAN:
+      return JS_BOOLEAN;
+    case JS_TAG_NULL:
+      return JS_NULL;
+    case JS_TAG_UNDEFINED:
+      return JS_UNDEFINED;
+    case JS_TAG_STRING:
+      return JS_STRING;
+    case JS_TAG_OBJECT:
+      return JS_OBJECT;
+    default:
+      return JS_NUMBER;
+  }
+}
+
+double js_to_number(js_value value) {
+  switch (js_type_of(value)) {
     case JS_NUMBER:
-      data.type = JS_NUMBER;
-      data.value = (js_byte*)malloc(4);
-      break;
+      return js_number_value(value);
+    case JS_BOOLEAN:
+      return js_boolean_value(value) ? 1 : 0;
+    case JS_NULL:
+      return 0;
+    case JS_STRING: {
+      const char* string = js_string_value(value);
+      char* end;
+      while (*string == ' ' || (*string >= '\t' && *string <= '\r')) string++;
+      if (*string == '\0') return 0;
+      double result = strtod(string, &end);
+      while (*end == ' ' || (*end >= '\t' && *end <= '\r')) end++;
+      return *end == '\0' ? result : NAN;
+    }
+    default:
+      return NAN;
   }
-  return data;
 }
 
-js_data make_number() {
-  return make_data(JS_NUMBER);
+int32_t js_double_to_int32(double value) {
+  if (!isfinite(value)) return 0;
+  double truncated = fmod(trunc(value), 4294967296.0);
+  if (truncated < 0) truncated += 4294967296.0;
+  return (int32_t)(uint32_t)truncated;
 }
 
-void print_typed(js_data data) {
-  switch (data.type) {
+bool js_to_boolean(js_value value) {
+  switch (js_type_of(value)) {
     case JS_NUMBER:
-      printf("NUMBER: %d\n", *((int32_t*)data.value));
-      break;
+      if (js_is_int32(value)) return js_int32_value(value) != 0;
+      return js_double_to_boolean(js_double_value(value));
+    case JS_BOOLEAN:
+      return js_boolean_value(value);
+    case JS_STRING:
+      return js_string_length(value) != 0;
+    case JS_NULL:
+    case JS_UNDEFINED:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Formats a number the way Number.prototype.toString does for the common
+// cases: integers without a fraction and everything else with the shortest
+// precision that round-trips.
+static void format_number(double value, char* buffer, size_t size) {
+  if (isnan(value)) {
+    snprintf(buffer, size, "NaN");
+  } else if (isinf(value)) {
+    snprintf(buffer, size, value < 0 ? "-Infinity" : "Infinity");
+  } else if (value == 0) {
+    snprintf(buffer, size, "0");
+  } else if (value == trunc(value) && fabs(value) < 1e21) {
+    snprintf(buffer, size, "%.0f", value);
+  } else {
+    for (int precision = 1; precision <= 17; precision++) {
+      snprintf(buffer, size, "%.*g", precision, value);
+      if (strtod(buffer, NULL) == value) break;
+    }
+  }
+}
+
+const char* js_to_cstring(js_value value, char* buffer, size_t size) {
+  switch (js_type_of(value)) {
+    case JS_NUMBER:
+      format_number(js_number_value(value), buffer, size);
+      return buffer;
+    case JS_BOOLEAN:
+      return js_boolean_value(value) ? "true" : "false";
+    case JS_STRING:
+      return js_string_value(value);
+    case JS_NULL:
+      return "null";
+    case JS_UNDEFINED:
+      return "undefined";
+    default:
+      return js_is_closure(value) ? "function" : "[object Object]";
+  }
+}
+
+js_value js_add(js_value left, js_value right) {
+  if (js_is_int32(left) && js_is_int32(right)) {
+    return make_number((double)js_int32_value(left) + js_int32_value(right));
+  }
+  if (!js_is_string(left) && !js_is_string(right)) {
+    return make_number(js_to_number(left) + js_to_number(right));
+  }
+  // Allocating may collect, but both operands are still rooted by the caller.
+  js_value parts[2] = {left, right};
+  return js_string_concat(2, parts);
+}
+
+js_value js_typeof(js_value value) {
+  switch (js_type_of(value)) {
+    case JS_NUMBER:
+      return make_string("number");
+    case JS_BOOLEAN:
+      return make_string("boolean");
+    case JS_STRING:
+      return make_string("string");
+    case JS_UNDEFINED:
+      return make_string("undefined");
+    default:
+      return make_string(js_is_closure(value) ? "function" : "object");
   }
 }
 
-int main() {
-  js_data num;
-  num = make_number();
+bool js_strict_equals(js_value left, js_value right) {
+  // Numbers have a unique encoding, so bit equality decides everything but
+  // NaN and string contents.
+  if (left == right) return left != JS_CANONICAL_NAN;
+  if (js_is_string(left) && js_is_string(right)) {
+    return js_string_equals(js_string_value(left), js_string_value(right));
+  }
+  return false;
+}
+
+bool js_equals(js_value left, js_value right) {
+  if (js_type_of(left) == js_type_of(right)) {
+    return js_strict_equals(left, right);
+  }
+  if (js_is_nullish(left) || js_is_nullish(right)) {
+    return js_is_nullish(left) && js_is_nullish(right);
+  }
+  if (js_is_object(left) || js_is_object(right)) return false;
+  return js_to_number(left) == js_to_number(right);
+}
+
+// Returns -1, 0 or 1, or 2 if the operands are unordered because one of
+// them is NaN.
+static int compare(js_value left, js_value right) {
+  if (js_is_int32(left) && js_is_int32(right)) {
+    int32_t left_int = js_int32_value(left);
+    int32_t right_int = js_int32_value(right);
+    return left_int < right_int ? -1 : left_int > right_int;
+  }
+  if (js_is_string(left) && js_is_string(right)) {
+    int result = strcmp(js_string_value(left), js_string_value(right));
+    return result < 0 ? -1 : result > 0;
+  }
+  double left_number = js_to_number(left);
+  double right_number = js_to_number(right);
+  if (isnan(left_number) || isnan(right_number)) return 2;
+  return left_number < right_number ? -1 : left_number > right_number;
+}
+
+bool js_less_than(js_value left, js_value right) {
+  return compare(left, right) == -1;
+}
+
+bool js_greater_than(js_value left, js_value right) {
+  return compare(left, right) == 1;
+}
+
+bool js_less_than_or_equal(js_value left, js_value right) {
+  int result = compare(left, right);
+  return result == -1 || result == 0;
+}
 
-  num.value[0] = 0x05;
-  num.value[1] = 0x00;
-  num.value[2] = 0x00;
-  num.value[3] = 0x00;
-  print_typed(num);
+bool js_greater_than_or_equal(js_value left, js_value right) {
+  int result = compare(left, right);
+  return result == 1 || result == 0;
+}
+
+void print_typed(js_value value) {
+  char buffer[32];
+  switch (js_type_of(value)) {
+    case JS_NUMBER:
+      printf("NUMBER: %s\n", js_to_cstring(value, buffer, sizeof(buffer)));
+      break;
+    case JS_BOOLEAN:
+      printf("BOOLEAN: %s\n", js_to_cstring(value, buffer, sizeof(buffer)));
+      break;
+    case JS_STRING:
+      printf("STRING: %s\n", js_string_value(value));
+      break;
+    case JS_NULL:
+      printf("NULL\n");
+      break;
+    case JS_UNDEFINED:
+      printf("UNDEFINED\n");
+      break;
+    case JS_OBJECT:
+      printf(js_is_closure(value) ? "FUNCTION\n" : "OBJECT\n");
+      break;
+  }
 }
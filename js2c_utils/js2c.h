@@ -1,9 +1,14 @@
 #ifndef JS2C_H_
 #define JS2C_H_
 
+#include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "js2c_arena.h"
 
 #define JS_NULL 1
 #define JS_UNDEFINED 2
@@ -14,17 +19,328 @@
 #define JS_SYMBOL 7
 #define JS_OBJECT 8
 
-typedef unsigned char js_byte;
 typedef unsigned int js_type;
 
-struct data {
-  js_type type;
-  js_byte* value;
-};
+// A NaN-boxed JavaScript value. Doubles are stored as their own bits, with
+// every NaN canonicalized to JS_CANONICAL_NAN. The remaining NaN space, i.e.
+// every pattern whose top 16 bits are JS_TAG_INT32 or above, holds the other
+// values: the tag lives in the top 16 bits and the payload in the low 48.
+//
+//   int32      0xFFF9 | 32 bit integer
+//   boolean    0xFFFA | 0 or 1
+//   null       0xFFFB | 0
+//   undefined  0xFFFC | 0
+//   string     0xFFFD | 48 bit pointer
+//   object     0xFFFE | 48 bit pointer
+//
+// Heap pointers point at a js_gc_header. String literals are not allocated;
+// their payload is the address of the characters with JS_STATIC_BIT set,
+// which user space addresses never have.
+//
+// Numbers that fit an int32 (except -0) are always stored as int32, so two
+// numbers other than NaN are equal exactly when their bits are.
+typedef uint64_t js_value;
+
+#define JS_TAG_SHIFT 48
+#define JS_PAYLOAD_MASK 0x0000FFFFFFFFFFFFull
+#define JS_CANONICAL_NAN 0x7FF8000000000000ull
+
+#define JS_TAG_INT32 0xFFF9ull
+#define JS_TAG_BOOLEAN 0xFFFAull
+#define JS_TAG_NULL 0xFFFBull
+#define JS_TAG_UNDEFINED 0xFFFCull
+#define JS_TAG_STRING 0xFFFDull
+#define JS_TAG_OBJECT 0xFFFEull
+
+#define JS_MAKE_TAGGED(tag, payload) \
+  (((tag) << JS_TAG_SHIFT) | ((uint64_t)(payload)&JS_PAYLOAD_MASK))
+
+#define JS_NULL_VALUE JS_MAKE_TAGGED(JS_TAG_NULL, 0)
+#define JS_UNDEFINED_VALUE JS_MAKE_TAGGED(JS_TAG_UNDEFINED, 0)
+#define JS_FALSE_VALUE JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 0)
+#define JS_TRUE_VALUE JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 1)
+
+#define JS_STATIC_BIT (1ull << 47)
+
+static inline uint64_t js_tag(js_value value) {
+  return value >> JS_TAG_SHIFT;
+}
+
+static inline bool js_is_double(js_value value) {
+  return js_tag(value) < JS_TAG_INT32;
+}
+
+static inline bool js_is_int32(js_value value) {
+  return js_tag(value) == JS_TAG_INT32;
+}
+
+static inline bool js_is_number(js_value value) {
+  return js_tag(value) <= JS_TAG_INT32;
+}
+
+static inline bool js_is_boolean(js_value value) {
+  return js_tag(value) == JS_TAG_BOOLEAN;
+}
+
+static inline bool js_is_null(js_value value) {
+  return value == JS_NULL_VALUE;
+}
+
+static inline bool js_is_undefined(js_value value) {
+  return value == JS_UNDEFINED_VALUE;
+}
+
+static inline bool js_is_nullish(js_value value) {
+  return js_is_null(value) || js_is_undefined(value);
+}
+
+static inline bool js_is_string(js_value value) {
+  return js_tag(value) == JS_TAG_STRING;
+}
+
+static inline bool js_is_object(js_value value) {
+  return js_tag(value) == JS_TAG_OBJECT;
+}
+
+// True for values whose payload is a pointer into the heap.
+static inline bool js_is_heap_value(js_value value) {
+  return js_tag(value) >= JS_TAG_STRING;
+}
+
+static inline int32_t js_int32_value(js_value value) {
+  return (int32_t)(uint32_t)value;
+}
+
+static inline double js_double_value(js_value value) {
+  double result;
+  memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+static inline double js_number_value(js_value value) {
+  return js_is_int32(value) ? js_int32_value(value) : js_double_value(value);
+}
+
+static inline bool js_boolean_value(js_value value) {
+  return (value & 1) != 0;
+}
+
+static inline bool js_is_static_value(js_value value) {
+  return (value & JS_STATIC_BIT) != 0;
+}
+
+static inline void* js_heap_pointer(js_value value) {
+  return (void*)(uintptr_t)(value & JS_PAYLOAD_MASK);
+}
+
+static inline js_value make_int32(int32_t value) {
+  return JS_MAKE_TAGGED(JS_TAG_INT32, (uint32_t)value);
+}
+
+static inline js_value make_number(double value) {
+  if (value >= INT32_MIN && value <= INT32_MAX) {
+    int32_t integer = (int32_t)value;
+    if (integer == value && (integer != 0 || !signbit(value))) {
+      return make_int32(integer);
+    }
+  }
+  if (isnan(value)) return JS_CANONICAL_NAN;
+  js_value result;
+  memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+static inline js_value make_boolean(bool value) {
+  return value ? JS_TRUE_VALUE : JS_FALSE_VALUE;
+}
+
+static inline js_value make_null(void) {
+  return JS_NULL_VALUE;
+}
+
+static inline js_value make_undefined(void) {
+  return JS_UNDEFINED_VALUE;
+}
+
+#include "js2c_gc.h"
+
+// Wraps a string with static storage duration, such as a literal, without
+// copying it.
+static inline js_value make_string(const char* value) {
+  return JS_MAKE_TAGGED(JS_TAG_STRING, (uintptr_t)value | JS_STATIC_BIT);
+}
+
+// Strings allocated at runtime; see js2c_string.h.
+static inline js_value make_heap_string(js_gc_header* string) {
+  return JS_MAKE_TAGGED(JS_TAG_STRING, (uintptr_t)string);
+}
+
+#include "js2c_string.h"
+
+// The string literals of a translated program are interned by the
+// translator. Each distinct literal is emitted once, as a js_string_header
+// directly followed by its characters, into one static table in .rodata that
+// the generated main registers with js_intern_strings. Two interned strings
+// are equal exactly when their characters are at the same address.
+typedef struct js_string_header {
+  uint32_t hash;    // js_string_hash of the characters
+  uint32_t length;  // in bytes, without the NUL
+  uint32_t flags;
+} js_string_header;
+
+// Set if every character of the JavaScript string is below 0x100.
+#define JS_STRING_ONE_BYTE 1u
+
+extern uintptr_t js_interned_begin;
+extern uintptr_t js_interned_end;
+
+void js_intern_strings(const void* table, size_t size);
+
+static inline bool js_is_interned(const char* chars) {
+  uintptr_t address = (uintptr_t)chars;
+  return address >= js_interned_begin && address < js_interned_end;
+}
+
+static inline const js_string_header* js_interned_header(const char* chars) {
+  return (const js_string_header*)chars - 1;
+}
+
+// V8's StringHasher with a zero seed, over the UTF-8 bytes. The translator
+// computes the same hash for the interned strings.
+uint32_t js_string_hash(const char* chars);
+
+static inline bool js_string_equals(const char* left, const char* right) {
+  if (left == right) return true;
+  if (js_is_interned(left) && js_is_interned(right)) return false;
+  return strcmp(left, right) == 0;
+}
+
+static inline const char* js_string_value(js_value value) {
+  if (js_is_static_value(value)) {
+    return (const char*)(uintptr_t)(value & JS_PAYLOAD_MASK & ~JS_STATIC_BIT);
+  }
+  js_gc_header* string = (js_gc_header*)js_heap_pointer(value);
+  if (string->kind != JS_GC_KIND_STRING) return js_string_flatten(value);
+  return (const char*)js_gc_payload(string);
+}
+
+// Does not flatten.
+static inline int32_t js_string_length(js_value value) {
+  if (js_is_static_value(value)) {
+    const char* chars = js_string_value(value);
+    if (js_is_interned(chars)) {
+      return (int32_t)js_interned_header(chars)->length;
+    }
+    return (int32_t)strlen(chars);
+  }
+  js_gc_header* string = (js_gc_header*)js_heap_pointer(value);
+  switch (string->kind) {
+    case JS_GC_KIND_CONS_STRING:
+      return (int32_t)js_cons_string_value(value)->length;
+    case JS_GC_KIND_SLICED_STRING:
+      return (int32_t)js_sliced_string_value(value)->length;
+    default:
+      return (int32_t)(string->size - sizeof(js_gc_header) - 1);
+  }
+}
+
+js_type js_type_of(js_value value);
+
+// Conversions used where the translator could not prove a type.
+double js_to_number(js_value value);
+int32_t js_double_to_int32(double value);
+bool js_to_boolean(js_value value);
+
+static inline int32_t js_to_int32(js_value value) {
+  if (js_is_int32(value)) return js_int32_value(value);
+  return js_double_to_int32(js_to_number(value));
+}
+
+static inline bool js_double_to_boolean(double value) {
+  return value != 0 && !isnan(value);
+}
+
+// Generic operations on boxed values.
+// Returns the string conversion of {value}, formatting numbers into
+// {buffer}.
+const char* js_to_cstring(js_value value, char* buffer, size_t size);
+js_value js_add(js_value left, js_value right);
+js_value js_typeof(js_value value);
+bool js_strict_equals(js_value left, js_value right);
+bool js_equals(js_value left, js_value right);
+bool js_less_than(js_value left, js_value right);
+bool js_greater_than(js_value left, js_value right);
+bool js_less_than_or_equal(js_value left, js_value right);
+bool js_greater_than_or_equal(js_value left, js_value right);
+
+// Speculative versions of the generic operations, emitted where type
+// feedback from a training run (v8_js2c --js2c-feedback) says the operands
+// were numbers. The guard is a tag check; anything else takes the generic
+// path.
+static inline js_value js_speculative_add(js_value left, js_value right) {
+  if (__builtin_expect(js_is_int32(left) && js_is_int32(right), 1)) {
+    int32_t result;
+    if (!__builtin_add_overflow(js_int32_value(left), js_int32_value(right),
+                                &result)) {
+      return make_int32(result);
+    }
+  }
+  if (js_is_number(left) && js_is_number(right)) {
+    return make_number(js_number_value(left) + js_number_value(right));
+  }
+  return js_add(left, right);
+}
+
+#define JS_SPECULATIVE_COMPARE(name, op)                                   \
+  static inline bool js_speculative_##name(js_value left, js_value right) { \
+    if (__builtin_expect(js_is_number(left) && js_is_number(right), 1)) {   \
+      return js_number_value(left) op js_number_value(right);               \
+    }                                                                       \
+    return js_##name(left, right);                                          \
+  }
+JS_SPECULATIVE_COMPARE(strict_equals, ==)
+JS_SPECULATIVE_COMPARE(equals, ==)
+JS_SPECULATIVE_COMPARE(less_than, <)
+JS_SPECULATIVE_COMPARE(greater_than, >)
+JS_SPECULATIVE_COMPARE(less_than_or_equal, <=)
+JS_SPECULATIVE_COMPARE(greater_than_or_equal, >=)
+#undef JS_SPECULATIVE_COMPARE
+
+// The values that switch statements dispatch on with a C switch. The
+// translator emits one when every case label is a Smi literal, or when every
+// one is a string literal.
+
+// The case label {value} is strictly equal to, or {no_match}, which is no
+// label of the switch, if it is not an int32 number. -0 matches 0.
+static inline int32_t js_switch_int32(js_value value, int32_t no_match) {
+  if (js_is_int32(value)) return js_int32_value(value);
+  if (js_is_double(value) && js_double_value(value) == 0) return 0;
+  return no_match;
+}
+
+// The slot of {value} in {labels}, a table of 1 << {bits} strings that the
+// translator lays out as a perfect hash: the slot of each label is the top
+// {bits} bits of its hash times {multiplier}, and the other slots are NULL.
+// Returns -1 if {value} is not one of the labels, which takes one compare.
+static inline int32_t js_switch_string(js_value value,
+                                       const char* const* labels,
+                                       uint32_t multiplier, uint32_t bits) {
+  if (!js_is_string(value)) return -1;
+  const char* chars = js_string_value(value);
+  uint32_t hash = js_is_interned(chars) ? js_interned_header(chars)->hash
+                                        : js_string_hash(chars);
+  uint32_t slot = (hash * multiplier) >> (32 - bits);
+  const char* label = labels[slot];
+  return label != NULL && js_string_equals(chars, label) ? (int32_t)slot : -1;
+}
 
-typedef struct data js_data;
+#include "js2c_object.h"
+#include "js2c_array.h"
+#include "js2c_closure.h"
+#include "js2c_exception.h"
+#include "js2c_generator.h"
+#include "js2c_iteration.h"
 
-js_data make_data(js_type type);
-void print_typed(js_data data);
+void print_typed(js_value value);
 
 #endif
@@ -0,0 +1,65 @@
+#include "js2c_arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+js_arena js_global_arena;
+js_arena js_scratch_arena;
+int js_arena_scope_depth;
+size_t js_arena_scopes_entered;
+
+static js_arena_chunk* new_chunk(js_arena* arena, size_t size) {
+  // Reuse a released chunk if it is large enough.
+  js_arena_chunk** link = &arena->spare;
+  for (js_arena_chunk* chunk = arena->spare; chunk != NULL;
+       chunk = chunk->next) {
+    if (chunk->size >= size) {
+      *link = chunk->next;
+      return chunk;
+    }
+    link = &chunk->next;
+  }
+  size_t chunk_size = size > JS_ARENA_CHUNK_SIZE ? size : JS_ARENA_CHUNK_SIZE;
+  js_arena_chunk* chunk =
+      (js_arena_chunk*)malloc(sizeof(js_arena_chunk) + chunk_size);
+  if (chunk == NULL) {
+    fprintf(stderr, "js2c: out of memory\n");
+    abort();
+  }
+  chunk->size = chunk_size;
+  return chunk;
+}
+
+void* js_arena_alloc_slow(js_arena* arena, size_t size) {
+  js_arena_chunk* chunk = new_chunk(arena, size);
+  chunk->next = arena->chunk;
+  arena->chunk = chunk;
+  arena->top = chunk->data;
+  arena->limit = chunk->data + chunk->size;
+  return js_arena_alloc(arena, size);
+}
+
+void js_arena_exit_scope(js_arena_scope scope) {
+  js_arena* arena = &js_scratch_arena;
+  while (arena->chunk != scope.chunk) {
+    js_arena_chunk* chunk = arena->chunk;
+    arena->chunk = chunk->next;
+    chunk->next = arena->spare;
+    arena->spare = chunk;
+  }
+  arena->top = scope.top;
+  arena->limit =
+      scope.chunk != NULL ? scope.chunk->data + scope.chunk->size : NULL;
+  arena->bytes_reset +=
+      arena->bytes_allocated - arena->bytes_reset - scope.live_bytes;
+  js_arena_scope_depth--;
+}
+
+js_arena_stats js2c_arena_stats(void) {
+  js_arena_stats stats;
+  stats.global_bytes_allocated = js_global_arena.bytes_allocated;
+  stats.scratch_bytes_allocated = js_scratch_arena.bytes_allocated;
+  stats.scratch_bytes_reset = js_scratch_arena.bytes_reset;
+  stats.scopes_entered = js_arena_scopes_entered;
+  return stats;
+}
@@ -0,0 +1,80 @@
+#ifndef JS2C_ARENA_H_
+#define JS2C_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump-pointer arenas for the runtime.
+//
+// Heap values normally live in the collected heap (js2c_gc.h), and
+// js_global_arena only holds runtime data that lives as long as the program.
+// Calls whose allocations provably do not outlive them are wrapped by the
+// translator in js_arena_enter_scope/js_arena_exit_scope; while such a scope
+// is open js_gc_alloc takes objects from js_scratch_arena instead, and leaving
+// the scope releases everything allocated since it was entered in one step.
+
+#define JS_ARENA_ALIGNMENT 16
+#define JS_ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct js_arena_chunk {
+  struct js_arena_chunk* next;
+  size_t size;
+  _Alignas(JS_ARENA_ALIGNMENT) char data[];
+} js_arena_chunk;
+
+typedef struct js_arena {
+  js_arena_chunk* chunk;  // the chunk allocated from, newest first
+  js_arena_chunk* spare;  // released chunks kept for reuse
+  char* top;
+  char* limit;
+  size_t bytes_allocated;
+  size_t bytes_reset;
+} js_arena;
+
+typedef struct js_arena_scope {
+  js_arena_chunk* chunk;
+  char* top;
+  size_t live_bytes;
+} js_arena_scope;
+
+typedef struct js_arena_stats {
+  size_t global_bytes_allocated;
+  size_t scratch_bytes_allocated;
+  size_t scratch_bytes_reset;
+  size_t scopes_entered;
+} js_arena_stats;
+
+extern js_arena js_global_arena;
+extern js_arena js_scratch_arena;
+extern int js_arena_scope_depth;
+extern size_t js_arena_scopes_entered;
+
+void* js_arena_alloc_slow(js_arena* arena, size_t size);
+
+static inline void* js_arena_alloc(js_arena* arena, size_t size) {
+  size = (size + JS_ARENA_ALIGNMENT - 1) & ~(size_t)(JS_ARENA_ALIGNMENT - 1);
+  if ((size_t)(arena->limit - arena->top) < size) {
+    return js_arena_alloc_slow(arena, size);
+  }
+  void* result = arena->top;
+  arena->top += size;
+  arena->bytes_allocated += size;
+  return result;
+}
+
+static inline js_arena_scope js_arena_enter_scope(void) {
+  js_arena_scope scope;
+  scope.chunk = js_scratch_arena.chunk;
+  scope.top = js_scratch_arena.top;
+  scope.live_bytes =
+      js_scratch_arena.bytes_allocated - js_scratch_arena.bytes_reset;
+  js_arena_scope_depth++;
+  js_arena_scopes_entered++;
+  return scope;
+}
+
+void js_arena_exit_scope(js_arena_scope scope);
+
+js_arena_stats js2c_arena_stats(void);
+
+#endif
@@ -0,0 +1,553 @@
+#include "js2c.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define JS_ARRAY_SIMD 1
+#endif
+
+static js_shape array_shape;
+static bool tracer_registered;
+
+static void fatal(const char* message) {
+  fprintf(stderr, "js2c: %s\n", message);
+  abort();
+}
+
+static void trace_array(js_gc_header* header, js_gc_visitor visit) {
+  visit(&((js_array*)js_gc_payload(header))->elements);
+}
+
+static size_t element_size(uint8_t kind) {
+  switch (kind) {
+    case JS_ELEMENTS_SMI:
+      return sizeof(int32_t);
+    case JS_ELEMENTS_DOUBLE:
+      return sizeof(double);
+    default:
+      return sizeof(js_value);
+  }
+}
+
+static js_value new_store(uint8_t kind, uint32_t capacity) {
+  js_gc_header* store =
+      js_gc_alloc(capacity * element_size(kind),
+                  kind == JS_ELEMENTS_GENERIC ? JS_GC_KIND_VALUES
+                                              : JS_GC_KIND_RAW);
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)store);
+}
+
+static void* store_payload(js_value store) {
+  return js_gc_payload((js_gc_header*)js_heap_pointer(store));
+}
+
+js_value js_array_new(uint8_t kind, uint32_t length) {
+  if (!tracer_registered) {
+    js_gc_set_tracer(JS_GC_KIND_ARRAY, trace_array);
+    tracer_registered = true;
+  }
+  js_gc_header* header = js_gc_alloc(sizeof(js_array), JS_GC_KIND_ARRAY);
+  js_array* array = (js_array*)js_gc_payload(header);
+  array->shape = &array_shape;
+  array->kind = kind;
+  array->length = length;
+  array->capacity = length < 4 ? 4 : length;
+  array->elements = make_undefined();
+  js_value result = JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+  // The array is on the recent list while its store is allocated.
+  array->elements = new_store(kind, array->capacity);
+  if (kind == JS_ELEMENTS_GENERIC) {
+    js_value* values = js_array_elements(array);
+    for (uint32_t i = 0; i < array->capacity; i++) values[i] = make_undefined();
+  }
+  return result;
+}
+
+// Moves {array} to {kind}, which is at least as general as its current one,
+// and makes room for {capacity} elements.
+static void reallocate(js_array* array, uint8_t kind, uint32_t capacity) {
+  js_value store = new_store(kind, capacity);
+  void* from = js_array_elements(array);
+  void* to = store_payload(store);
+  if (kind == array->kind) {
+    memcpy(to, from, array->length * element_size(kind));
+  } else if (kind == JS_ELEMENTS_DOUBLE) {
+    for (uint32_t i = 0; i < array->length; i++) {
+      ((double*)to)[i] = ((int32_t*)from)[i];
+    }
+  } else {
+    for (uint32_t i = 0; i < array->length; i++) {
+      ((js_value*)to)[i] = array->kind == JS_ELEMENTS_SMI
+                               ? make_int32(((int32_t*)from)[i])
+                               : make_number(((double*)from)[i]);
+    }
+  }
+  if (kind == JS_ELEMENTS_GENERIC) {
+    for (uint32_t i = array->length; i < capacity; i++) {
+      ((js_value*)to)[i] = make_undefined();
+    }
+  }
+  array->kind = kind;
+  array->capacity = capacity;
+  array->elements = store;
+}
+
+static uint8_t kind_for(js_value value) {
+  if (js_is_int32(value)) return JS_ELEMENTS_SMI;
+  if (js_is_number(value)) return JS_ELEMENTS_DOUBLE;
+  return JS_ELEMENTS_GENERIC;
+}
+
+js_value js_get_element_slow(js_value object, int32_t index) {
+  if (js_is_array(object)) return make_undefined();
+  return js_get_property(object, make_int32(index));
+}
+
+js_value js_set_element_slow(js_value object, int32_t index, js_value value) {
+  if (!js_is_array(object) || index < 0) {
+    return js_set_property(object, make_int32(index), value);
+  }
+  js_array* array = js_array_value(object);
+  uint8_t kind = kind_for(value);
+  if (kind < array->kind) kind = array->kind;
+  // Writing past the end leaves a gap of undefined.
+  if ((uint32_t)index > array->length) kind = JS_ELEMENTS_GENERIC;
+  uint32_t capacity = array->capacity;
+  if ((uint32_t)index >= capacity) {
+    capacity = (uint32_t)index + 1;
+    if (capacity < array->capacity * 2) capacity = array->capacity * 2;
+  }
+  if (kind != array->kind || capacity != array->capacity) {
+    reallocate(array, kind, capacity);
+  }
+  if ((uint32_t)index >= array->length) array->length = index + 1;
+  switch (array->kind) {
+    case JS_ELEMENTS_SMI:
+      ((int32_t*)js_array_elements(array))[index] = js_int32_value(value);
+      break;
+    case JS_ELEMENTS_DOUBLE:
+      ((double*)js_array_elements(array))[index] = js_number_value(value);
+      break;
+    default:
+      ((js_value*)js_array_elements(array))[index] = value;
+      break;
+  }
+  return value;
+}
+
+void js_array_set_length(js_value object, uint32_t length) {
+  js_array* array = js_array_value(object);
+  if (length > array->length) {
+    if (array->kind != JS_ELEMENTS_GENERIC || length > array->capacity) {
+      reallocate(array, JS_ELEMENTS_GENERIC,
+                 length > array->capacity ? length : array->capacity);
+    }
+  } else if (array->kind == JS_ELEMENTS_GENERIC) {
+    js_value* values = js_array_elements(array);
+    for (uint32_t i = length; i < array->length; i++) {
+      values[i] = make_undefined();
+    }
+  }
+  array->length = length;
+}
+
+//-----------------------------------------------------------------------------
+// Vector kernels. Each has an AVX2 version, selected at runtime, and an SSE2
+// version that every x86-64 CPU supports.
+
+#ifdef JS_ARRAY_SIMD
+
+static bool has_avx2(void) {
+  static int result = -1;
+  if (result < 0) {
+    __builtin_cpu_init();
+    result = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return result;
+}
+
+__attribute__((target("avx2"))) static void fill_int32_avx2(int32_t* p,
+                                                            size_t n,
+                                                            int32_t value) {
+  __m256i v = _mm256_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i*)(p + i), v);
+  for (; i < n; i++) p[i] = value;
+}
+
+__attribute__((target("avx2"))) static void fill_double_avx2(double* p,
+                                                             size_t n,
+                                                             double value) {
+  __m256d v = _mm256_set1_pd(value);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) _mm256_storeu_pd(p + i, v);
+  for (; i < n; i++) p[i] = value;
+}
+
+__attribute__((target("avx2"))) static int64_t index_of_int32_avx2(
+    const int32_t* p, size_t n, int32_t value) {
+  __m256i v = _mm256_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i lanes = _mm256_loadu_si256((const __m256i*)(p + i));
+    int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(lanes, v));
+    if (mask != 0) return i + __builtin_ctz(mask) / 4;
+  }
+  for (; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+__attribute__((target("avx2"))) static int64_t index_of_double_avx2(
+    const double* p, size_t n, double value) {
+  __m256d v = _mm256_set1_pd(value);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d lanes = _mm256_loadu_pd(p + i);
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(lanes, v, _CMP_EQ_OQ));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  for (; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+__attribute__((target("avx2"))) static int64_t sum_int32_avx2(
+    const int32_t* p, size_t n) {
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i lanes = _mm_loadu_si128((const __m128i*)(p + i));
+    sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(lanes));
+  }
+  int64_t parts[4];
+  _mm256_storeu_si256((__m256i*)parts, sum);
+  int64_t result = parts[0] + parts[1] + parts[2] + parts[3];
+  for (; i < n; i++) result += p[i];
+  return result;
+}
+
+__attribute__((target("avx2"))) static inline __m256d apply_avx2(
+    js_array_op op, __m256d left, __m256d right) {
+  switch (op) {
+    case JS_ARRAY_OP_ADD:
+      return _mm256_add_pd(left, right);
+    case JS_ARRAY_OP_SUB:
+      return _mm256_sub_pd(left, right);
+    case JS_ARRAY_OP_MUL:
+      return _mm256_mul_pd(left, right);
+    default:
+      return _mm256_div_pd(left, right);
+  }
+}
+
+// Maps four elements at a time and returns how many were done. Int32
+// elements are converted to double, which is exact.
+__attribute__((target("avx2"))) static size_t map_avx2(
+    const int32_t* ints, const double* doubles, double* out, size_t n,
+    js_array_op op, double operand, bool operand_first) {
+  __m256d c = _mm256_set1_pd(operand);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d x =
+        ints != NULL
+            ? _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(ints + i)))
+            : _mm256_loadu_pd(doubles + i);
+    _mm256_storeu_pd(out + i, operand_first ? apply_avx2(op, c, x)
+                                            : apply_avx2(op, x, c));
+  }
+  return i;
+}
+
+static void fill_int32(int32_t* p, size_t n, int32_t value) {
+  if (has_avx2()) return fill_int32_avx2(p, n, value);
+  __m128i v = _mm_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(p + i), v);
+  for (; i < n; i++) p[i] = value;
+}
+
+static void fill_double(double* p, size_t n, double value) {
+  if (has_avx2()) return fill_double_avx2(p, n, value);
+  __m128d v = _mm_set1_pd(value);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) _mm_storeu_pd(p + i, v);
+  for (; i < n; i++) p[i] = value;
+}
+
+static int64_t index_of_int32(const int32_t* p, size_t n, int32_t value) {
+  if (has_avx2()) return index_of_int32_avx2(p, n, value);
+  __m128i v = _mm_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i lanes = _mm_loadu_si128((const __m128i*)(p + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(lanes, v));
+    if (mask != 0) return i + __builtin_ctz(mask) / 4;
+  }
+  for (; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+static int64_t index_of_double(const double* p, size_t n, double value) {
+  if (has_avx2()) return index_of_double_avx2(p, n, value);
+  __m128d v = _mm_set1_pd(value);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(p + i), v));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  for (; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+static int64_t sum_int32(const int32_t* p, size_t n) {
+  if (has_avx2()) return sum_int32_avx2(p, n);
+  // SSE2 has no sign extension to 64 bits, so pair each lane with its sign.
+  __m128i sum = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i lanes = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i sign = _mm_srai_epi32(lanes, 31);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(lanes, sign));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(lanes, sign));
+  }
+  int64_t parts[2];
+  _mm_storeu_si128((__m128i*)parts, sum);
+  int64_t result = parts[0] + parts[1];
+  for (; i < n; i++) result += p[i];
+  return result;
+}
+
+#else
+
+static void fill_int32(int32_t* p, size_t n, int32_t value) {
+  for (size_t i = 0; i < n; i++) p[i] = value;
+}
+
+static void fill_double(double* p, size_t n, double value) {
+  for (size_t i = 0; i < n; i++) p[i] = value;
+}
+
+static int64_t index_of_int32(const int32_t* p, size_t n, int32_t value) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+static int64_t index_of_double(const double* p, size_t n, double value) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] == value) return i;
+  }
+  return -1;
+}
+
+static int64_t sum_int32(const int32_t* p, size_t n) {
+  int64_t result = 0;
+  for (size_t i = 0; i < n; i++) result += p[i];
+  return result;
+}
+
+#endif
+
+static double apply(js_array_op op, double left, double right) {
+  switch (op) {
+    case JS_ARRAY_OP_ADD:
+      return left + right;
+    case JS_ARRAY_OP_SUB:
+      return left - right;
+    case JS_ARRAY_OP_MUL:
+      return left * right;
+    default:
+      return left / right;
+  }
+}
+
+static js_value apply_boxed(js_array_op op, js_value left, js_value right) {
+  if (op == JS_ARRAY_OP_ADD) return js_add(left, right);
+  return make_number(apply(op, js_to_number(left), js_to_number(right)));
+}
+
+// Computes the elements of a numeric array mapped by {op} into {out},
+// vectorized where the hardware allows.
+static void map_numbers(js_array* array, double* out, js_array_op op,
+                        double operand, bool operand_first) {
+  const int32_t* ints = NULL;
+  const double* doubles = NULL;
+  if (array->kind == JS_ELEMENTS_SMI) {
+    ints = js_array_elements(array);
+  } else {
+    doubles = js_array_elements(array);
+  }
+  size_t n = array->length;
+  size_t i = 0;
+#ifdef JS_ARRAY_SIMD
+  if (has_avx2()) {
+    i = map_avx2(ints, doubles, out, n, op, operand, operand_first);
+  }
+#endif
+  for (; i < n; i++) {
+    double x = ints != NULL ? ints[i] : doubles[i];
+    out[i] = operand_first ? apply(op, operand, x) : apply(op, x, operand);
+  }
+}
+
+static js_array* checked_array(js_value value, const char* builtin) {
+  if (!js_is_array(value)) {
+    fprintf(stderr, "js2c: %s called on a non-array\n", builtin);
+    abort();
+  }
+  return js_array_value(value);
+}
+
+js_value js_array_fill(js_value object, js_value value) {
+  js_array* array = checked_array(object, "Array.prototype.fill");
+  uint8_t kind = kind_for(value);
+  if (kind > array->kind) reallocate(array, kind, array->capacity);
+  switch (array->kind) {
+    case JS_ELEMENTS_SMI:
+      fill_int32(js_array_elements(array), array->length,
+                 js_int32_value(value));
+      break;
+    case JS_ELEMENTS_DOUBLE:
+      fill_double(js_array_elements(array), array->length,
+                  js_number_value(value));
+      break;
+    default: {
+      js_value* values = js_array_elements(array);
+      for (uint32_t i = 0; i < array->length; i++) values[i] = value;
+      break;
+    }
+  }
+  return object;
+}
+
+js_value js_array_index_of(js_value object, js_value value) {
+  if (js_is_string(object)) {
+    // String.prototype.indexOf searches for the string conversion.
+    value = js_to_string(value);
+    const char* string = js_string_value(object);
+    const char* found = strstr(string, js_string_value(value));
+    return make_int32(found != NULL ? (int32_t)(found - string) : -1);
+  }
+  js_array* array = checked_array(object, "Array.prototype.indexOf");
+  int64_t result = -1;
+  switch (array->kind) {
+    case JS_ELEMENTS_SMI:
+      // Numbers with an int32 value are boxed as int32, except -0, which is
+      // strictly equal to 0.
+      if (js_is_int32(value)) {
+        result = index_of_int32(js_array_elements(array), array->length,
+                                js_int32_value(value));
+      } else if (js_is_double(value) && js_double_value(value) == 0) {
+        result = index_of_int32(js_array_elements(array), array->length, 0);
+      }
+      break;
+    case JS_ELEMENTS_DOUBLE:
+      if (js_is_number(value)) {
+        result = index_of_double(js_array_elements(array), array->length,
+                                 js_number_value(value));
+      }
+      break;
+    default: {
+      js_value* values = js_array_elements(array);
+      for (uint32_t i = 0; i < array->length; i++) {
+        if (js_strict_equals(values[i], value)) {
+          result = i;
+          break;
+        }
+      }
+      break;
+    }
+  }
+  return make_int32((int32_t)result);
+}
+
+js_value js_array_map_op(js_value object, js_array_op op, js_value operand,
+                         bool operand_first) {
+  js_array* array = checked_array(object, "Array.prototype.map");
+  uint32_t length = array->length;
+  if (array->kind == JS_ELEMENTS_GENERIC || !js_is_number(operand)) {
+    js_value result = js_array_new(JS_ELEMENTS_GENERIC, length);
+    // Every step may allocate; the frame keeps the intermediate results from
+    // piling up on the recent list.
+    js_value* roots[] = {&object, &operand, &result};
+    js_gc_frame frame;
+    js_gc_push_frame(&frame, roots, 3);
+    for (uint32_t i = 0; i < length; i++) {
+      js_gc_end_statement(&frame);
+      js_value x = js_get_element(object, i);
+      js_value value = operand_first ? apply_boxed(op, operand, x)
+                                     : apply_boxed(op, x, operand);
+      js_array_generic_elements(result)[i] = value;
+    }
+    js_gc_pop_frame(&frame);
+    return js_gc_retain(result);
+  }
+  js_value result = js_array_new(JS_ELEMENTS_DOUBLE, length);
+  // js_array_new may have collected, but {array} is rooted by the caller.
+  double* out = js_array_double_elements(result);
+  map_numbers(array, out, op, js_number_value(operand), operand_first);
+  // Keep int32 results in the smi kind, as the array would have been built.
+  for (uint32_t i = 0; i < length; i++) {
+    double x = out[i];
+    if (!(x >= INT32_MIN && x <= INT32_MAX && x == (int32_t)x) ||
+        (x == 0 && signbit(x))) {
+      return result;
+    }
+  }
+  js_array* result_array = js_array_value(result);
+  int32_t* ints = (int32_t*)out;
+  for (uint32_t i = 0; i < length; i++) ints[i] = (int32_t)out[i];
+  result_array->kind = JS_ELEMENTS_SMI;
+  return result;
+}
+
+js_value js_array_reduce_op(js_value object, js_array_op op, bool has_initial,
+                            js_value initial, bool element_first) {
+  js_array* array = checked_array(object, "Array.prototype.reduce");
+  uint32_t start = 0;
+  if (!has_initial) {
+    if (array->length == 0) {
+      fatal("Reduce of empty array with no initial value");
+    }
+    initial = js_get_element(object, 0);
+    start = 1;
+  }
+  uint32_t length = array->length;
+  // Integer sums are exact in any order; everything else keeps the order of
+  // the callback calls, since floating point addition is not associative.
+  if (array->kind == JS_ELEMENTS_SMI && op == JS_ARRAY_OP_ADD &&
+      js_is_int32(initial)) {
+    const int32_t* ints = js_array_elements(array);
+    int64_t sum =
+        js_int32_value(initial) + sum_int32(ints + start, length - start);
+    return make_number((double)sum);
+  }
+  if (array->kind != JS_ELEMENTS_GENERIC && js_is_number(initial)) {
+    double acc = js_number_value(initial);
+    for (uint32_t i = start; i < length; i++) {
+      double x = array->kind == JS_ELEMENTS_SMI
+                     ? ((int32_t*)js_array_elements(array))[i]
+                     : ((double*)js_array_elements(array))[i];
+      acc = element_first ? apply(op, x, acc) : apply(op, acc, x);
+    }
+    return make_number(acc);
+  }
+  js_value acc = initial;
+  js_value* roots[] = {&object, &acc};
+  js_gc_frame frame;
+  js_gc_push_frame(&frame, roots, 2);
+  for (uint32_t i = start; i < length; i++) {
+    js_gc_end_statement(&frame);
+    js_value x = js_get_element(object, i);
+    acc = element_first ? apply_boxed(op, x, acc) : apply_boxed(op, acc, x);
+  }
+  js_gc_pop_frame(&frame);
+  return js_gc_retain(acc);
+}
@@ -0,0 +1,154 @@
+#ifndef JS2C_ARRAY_H_
+#define JS2C_ARRAY_H_
+
+// Arrays with elements kinds, modelled on V8's ElementsKind. Included from
+// js2c.h.
+//
+// The elements of an array are stored unboxed as long as they allow it:
+//
+//   JS_ELEMENTS_SMI     int32_t, every element is an int32 number
+//   JS_ELEMENTS_DOUBLE  double, every element is a number
+//   JS_ELEMENTS_GENERIC js_value
+//
+// Storing an element that does not fit moves the array to the next, more
+// general kind; arrays never go back. Arrays are always packed: writing past
+// the end fills the gap with undefined, which makes the array generic.
+//
+// The builtins below have SSE2 and AVX2 loops for the unboxed kinds.
+
+#define JS_ELEMENTS_SMI 0
+#define JS_ELEMENTS_DOUBLE 1
+#define JS_ELEMENTS_GENERIC 2
+
+typedef struct js_array {
+  // Never matches an inline cache, so named accesses always take the miss
+  // path, which knows about arrays.
+  js_shape* shape;
+  uint8_t kind;
+  uint32_t length;
+  uint32_t capacity;
+  // A JS_GC_KIND_VALUES object for generic elements and a JS_GC_KIND_RAW
+  // one otherwise, boxed so that it is traced like any slot.
+  js_value elements;
+} js_array;
+
+js_value js_array_new(uint8_t kind, uint32_t length);
+
+static inline bool js_is_array(js_value value) {
+  return js_is_object(value) &&
+         ((js_gc_header*)js_heap_pointer(value))->kind == JS_GC_KIND_ARRAY;
+}
+
+static inline js_array* js_array_value(js_value value) {
+  return (js_array*)js_gc_payload((js_gc_header*)js_heap_pointer(value));
+}
+
+static inline void* js_array_elements(js_array* array) {
+  return js_gc_payload((js_gc_header*)js_heap_pointer(array->elements));
+}
+
+static inline int32_t* js_array_smi_elements(js_value value) {
+  return (int32_t*)js_array_elements(js_array_value(value));
+}
+
+static inline double* js_array_double_elements(js_value value) {
+  return (double*)js_array_elements(js_array_value(value));
+}
+
+static inline js_value* js_array_generic_elements(js_value value) {
+  return (js_value*)js_array_elements(js_array_value(value));
+}
+
+static inline int32_t js_array_length(js_value value) {
+  return (int32_t)js_array_value(value)->length;
+}
+
+// Whether {value} is an array of elements kind {kind} with at least {length}
+// elements. The translator versions counted loops over arrays on this: the
+// version for the kind reads and writes the elements directly, without the
+// bounds and kind checks of js_get_element and js_set_element.
+static inline bool js_array_has_kind(js_value value, uint8_t kind,
+                                     int32_t length) {
+  if (!js_is_array(value)) return false;
+  js_array* array = js_array_value(value);
+  return array->kind == kind && array->length >= (uint32_t)length;
+}
+
+js_value js_get_element_slow(js_value object, int32_t index);
+void js_array_set_length(js_value object, uint32_t length);
+js_value js_set_element_slow(js_value object, int32_t index, js_value value);
+
+static inline js_value js_get_element(js_value object, int32_t index) {
+  if (js_is_array(object)) {
+    js_array* array = js_array_value(object);
+    if ((uint32_t)index < array->length) {
+      switch (array->kind) {
+        case JS_ELEMENTS_SMI:
+          return make_int32(((int32_t*)js_array_elements(array))[index]);
+        case JS_ELEMENTS_DOUBLE:
+          return make_number(((double*)js_array_elements(array))[index]);
+        default:
+          return ((js_value*)js_array_elements(array))[index];
+      }
+    }
+  }
+  return js_get_element_slow(object, index);
+}
+
+// Returns {value}, like the assignment expression.
+static inline js_value js_set_element(js_value object, int32_t index,
+                                      js_value value) {
+  if (js_is_array(object)) {
+    js_array* array = js_array_value(object);
+    if ((uint32_t)index < array->length) {
+      if (array->kind == JS_ELEMENTS_GENERIC) {
+        ((js_value*)js_array_elements(array))[index] = value;
+        return value;
+      }
+      if (array->kind == JS_ELEMENTS_SMI && js_is_int32(value)) {
+        ((int32_t*)js_array_elements(array))[index] = js_int32_value(value);
+        return value;
+      }
+      if (array->kind == JS_ELEMENTS_DOUBLE && js_is_number(value)) {
+        ((double*)js_array_elements(array))[index] = js_number_value(value);
+        return value;
+      }
+    }
+  }
+  return js_set_element_slow(object, index, value);
+}
+
+// Reads a.length, which is also how the length of strings is read when the
+// translator could not prove the receiver to be one.
+static inline js_value js_load_length(js_value object, js_ic* ic) {
+  if (js_is_array(object)) {
+    return make_int32(js_array_length(object));
+  }
+  return js_load_named(object, ic);
+}
+
+// The arithmetic a map or reduce callback performs, when the translator
+// could match it.
+typedef enum js_array_op {
+  JS_ARRAY_OP_ADD,
+  JS_ARRAY_OP_SUB,
+  JS_ARRAY_OP_MUL,
+  JS_ARRAY_OP_DIV
+} js_array_op;
+
+// The translator only calls the following on an array, or on a string for
+// indexOf. Any other receiver has its own method called instead.
+
+// array.fill(value)
+js_value js_array_fill(js_value array, js_value value);
+// array.indexOf(value), also for strings.
+js_value js_array_index_of(js_value array, js_value value);
+// array.map(x => x op operand), or operand op x if {operand_first}.
+js_value js_array_map_op(js_value array, js_array_op op, js_value operand,
+                         bool operand_first);
+// array.reduce((acc, x) => acc op x[, initial]), or x op acc if
+// {element_first}. {initial} is ignored unless {has_initial}.
+js_value js_array_reduce_op(js_value array, js_array_op op, bool has_initial,
+                            js_value initial, bool element_first);
+
+#endif
@@ -0,0 +1,46 @@
+#include "js2c.h"
+
+static js_shape closure_shape;
+static bool tracer_registered;
+
+static void trace_closure(js_gc_header* header, js_gc_visitor visit) {
+  js_closure* closure = (js_closure*)js_gc_payload(header);
+  for (uint32_t i = 0; i < closure->capture_count; i++) {
+    visit(&closure->captures[i]);
+  }
+}
+
+js_value js_closure_new(js_code code, uint32_t capture_count) {
+  if (!tracer_registered) {
+    js_gc_set_tracer(JS_GC_KIND_CLOSURE, trace_closure);
+    tracer_registered = true;
+  }
+  js_gc_header* header =
+      js_gc_alloc(sizeof(js_closure) + capture_count * sizeof(js_value),
+                  JS_GC_KIND_CLOSURE);
+  js_closure* closure = (js_closure*)js_gc_payload(header);
+  closure->shape = &closure_shape;
+  closure->code = code;
+  closure->capture_count = capture_count;
+  for (uint32_t i = 0; i < capture_count; i++) {
+    closure->captures[i] = make_undefined();
+  }
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+}
+
+js_value js_call(js_value callee, int32_t argc, const js_value* argv) {
+  if (!js_is_closure(callee)) {
+    char buffer[32];
+    fprintf(stderr, "js2c: %s is not a function\n",
+            js_to_cstring(callee, buffer, sizeof(buffer)));
+    abort();
+  }
+  return js_closure_value(callee)->code(callee, argc, argv);
+}
+
+js_value js_env_new(uint32_t size) {
+  js_gc_header* env = js_gc_alloc(size * sizeof(js_value), JS_GC_KIND_VALUES);
+  js_value* slots = (js_value*)js_gc_payload(env);
+  for (uint32_t i = 0; i < size; i++) slots[i] = make_undefined();
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)env);
+}
@@ -0,0 +1,63 @@
+#ifndef JS2C_CLOSURE_H_
+#define JS2C_CLOSURE_H_
+
+// Closures and environment records. Included from js2c.h.
+//
+// The translator converts closures to flat ones: a js_closure holds the code
+// of the function and one capture for each variable of the enclosing
+// functions that the function, or a function nested in it, uses. Variables
+// that are never assigned after their initialization are copied into the
+// closure by value. The others live in the environment record of the
+// function that declares them, a JS_GC_KIND_VALUES object, and the closure
+// captures the record. Either way a captured variable is at most one load
+// away, however deep the nesting.
+//
+// Functions that may be called through their value have a boxed entry point
+// with the js_code signature, which converts the arguments to the
+// representations of the parameters and calls the typed function.
+
+typedef js_value (*js_code)(js_value closure, int32_t argc,
+                            const js_value* argv);
+
+typedef struct js_closure {
+  // Never matches an inline cache, like the shape of an array.
+  js_shape* shape;
+  js_code code;
+  uint32_t capture_count;
+  js_value captures[];
+} js_closure;
+
+// The captures start out undefined and are filled in by the caller.
+js_value js_closure_new(js_code code, uint32_t capture_count);
+
+static inline bool js_is_closure(js_value value) {
+  return js_is_object(value) &&
+         ((js_gc_header*)js_heap_pointer(value))->kind == JS_GC_KIND_CLOSURE;
+}
+
+static inline js_closure* js_closure_value(js_value value) {
+  return (js_closure*)js_gc_payload((js_gc_header*)js_heap_pointer(value));
+}
+
+static inline js_value* js_closure_captures(js_value closure) {
+  return js_closure_value(closure)->captures;
+}
+
+// True if {callee} is a closure with the boxed entry {code}. Guards the
+// direct calls emitted for call sites that type feedback saw going to a
+// single function.
+static inline bool js_is_closure_of(js_value callee, js_code code) {
+  return js_is_closure(callee) && js_closure_value(callee)->code == code;
+}
+
+// Calls {callee} with {argc} arguments; aborts if it is not a function.
+js_value js_call(js_value callee, int32_t argc, const js_value* argv);
+
+// Creates an environment record with {size} slots, all undefined.
+js_value js_env_new(uint32_t size);
+
+static inline js_value* js_env_slots(js_value env) {
+  return (js_value*)js_gc_payload((js_gc_header*)js_heap_pointer(env));
+}
+
+#endif
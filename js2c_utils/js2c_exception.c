@@ -0,0 +1,22 @@
+#include "js2c.h"
+
+bool js_exception_pending;
+js_value js_exception = JS_UNDEFINED_VALUE;
+
+static bool root_registered;
+
+void js_throw(js_value value) {
+  if (!root_registered) {
+    js_gc_add_root(&js_exception);
+    root_registered = true;
+  }
+  js_exception = value;
+  js_exception_pending = true;
+}
+
+int js_report_uncaught_exception(void) {
+  char buffer[32];
+  fprintf(stderr, "Uncaught %s\n",
+          js_to_cstring(js_catch(), buffer, sizeof(buffer)));
+  return 1;
+}
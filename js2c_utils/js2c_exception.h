@@ -0,0 +1,42 @@
+#ifndef JS2C_EXCEPTION_H_
+#define JS2C_EXCEPTION_H_
+
+// Exceptions. Included from js2c.h.
+//
+// Generated code neither uses setjmp nor unwinds with tables: a throw stores
+// the exception, sets js_exception_pending and returns normally. Every call
+// that may throw is followed by a test of the flag, hinted as not taken, that
+// jumps to the handler of the innermost try statement around the call. Outside
+// of any, it jumps to the exit of the function, which pops its GC frame and
+// returns a dummy value for its caller to test the flag in turn.
+//
+// Entering a try statement costs nothing. What code that does not throw pays
+// is the tests, and the translator leaves those out after direct calls of
+// functions that the call graph shows cannot throw.
+
+extern bool js_exception_pending;
+// The pending exception. A GC root once anything has been thrown.
+extern js_value js_exception;
+
+// Makes {value} the pending exception.
+void js_throw(js_value value);
+
+// Clears the pending exception and returns it, on entry to a catch block or
+// to the finally block of a try statement that threw.
+static inline js_value js_catch(void) {
+  js_exception_pending = false;
+  return js_exception;
+}
+
+// Prints the pending exception to stderr. Returns the exit status of main.
+int js_report_uncaught_exception(void);
+
+// Evaluates the call after {handler} and goes to {handler} if it threw.
+#define JS_CHECKED_CALL(handler, ...)                               \
+  ({                                                                \
+    __auto_type _js_result = (__VA_ARGS__);                         \
+    if (__builtin_expect(js_exception_pending, 0)) goto handler;    \
+    _js_result;                                                     \
+  })
+
+#endif
@@ -0,0 +1,340 @@
+#include "js2c.h"
+
+#define JS_GC_PAGE_SIZE (64 * 1024)
+#define JS_GC_MIN_THRESHOLD (1024 * 1024)
+
+static const uint32_t size_classes[] = {16,  32,  48,  64,  96,   128,  192,
+                                        256, 384, 512, 768, 1024, 1536, 2048};
+#define JS_GC_SIZE_CLASSES (sizeof(size_classes) / sizeof(size_classes[0]))
+
+typedef struct js_gc_page {
+  struct js_gc_page* next;
+  uint32_t cell_size;
+  uint32_t cell_count;
+  uint8_t size_class;
+  _Alignas(16) char cells[];
+} js_gc_page;
+
+typedef struct js_gc_large {
+  struct js_gc_large* next;
+  size_t reserved;
+  js_gc_header header;  // the payload follows
+} js_gc_large;
+
+js_gc_frame* js_gc_top_frame;
+js_gc_header** js_gc_recent;
+size_t js_gc_recent_count;
+static size_t recent_capacity;
+
+static js_gc_page* pages;
+static js_gc_large* large_objects;
+static js_gc_header* free_lists[JS_GC_SIZE_CLASSES];
+static js_gc_tracer tracers[JS_GC_MAX_KINDS];
+
+static js_value** global_roots;
+static size_t global_root_count;
+static size_t global_root_capacity;
+
+static js_gc_header** mark_stack;
+static size_t mark_stack_count;
+static size_t mark_stack_capacity;
+
+static bool initialized;
+static bool stress;
+static size_t allocated_since_collection;
+static size_t threshold = JS_GC_MIN_THRESHOLD;
+static js_gc_stats stats;
+
+static void fatal(const char* message) {
+  fprintf(stderr, "js2c: %s\n", message);
+  abort();
+}
+
+static void* grow(void* array, size_t* capacity, size_t element_size) {
+  *capacity = *capacity == 0 ? 64 : *capacity * 2;
+  void* result = realloc(array, *capacity * element_size);
+  if (result == NULL) fatal("out of memory");
+  return result;
+}
+
+static void initialize(void) {
+  if (initialized) return;
+  initialized = true;
+  const char* stress_flag = getenv("JS2C_GC_STRESS");
+  if (stress_flag != NULL && *stress_flag != '\0' &&
+      strcmp(stress_flag, "0") != 0) {
+    stress = true;
+  }
+  const char* limit = getenv("JS2C_GC_HEAP_LIMIT");
+  if (limit != NULL) stats.heap_limit = strtoull(limit, NULL, 10);
+}
+
+static js_gc_header** free_list_next(js_gc_header* cell) {
+  return (js_gc_header**)js_gc_payload(cell);
+}
+
+static js_gc_header* cell_at(js_gc_page* page, uint32_t index) {
+  return (js_gc_header*)(page->cells + (size_t)index * page->cell_size);
+}
+
+static void add_page(uint8_t size_class) {
+  js_gc_page* page = (js_gc_page*)malloc(sizeof(js_gc_page) + JS_GC_PAGE_SIZE);
+  if (page == NULL) fatal("out of memory");
+  page->cell_size = size_classes[size_class];
+  page->cell_count = JS_GC_PAGE_SIZE / page->cell_size;
+  page->size_class = size_class;
+  page->next = pages;
+  pages = page;
+  for (uint32_t i = page->cell_count; i-- > 0;) {
+    js_gc_header* cell = cell_at(page, i);
+    cell->kind = JS_GC_KIND_FREE;
+    cell->size_class = size_class;
+    *free_list_next(cell) = free_lists[size_class];
+    free_lists[size_class] = cell;
+  }
+  stats.heap_bytes += JS_GC_PAGE_SIZE;
+}
+
+static js_gc_header* allocate_small(uint8_t size_class) {
+  if (free_lists[size_class] == NULL) add_page(size_class);
+  js_gc_header* cell = free_lists[size_class];
+  free_lists[size_class] = *free_list_next(cell);
+  return cell;
+}
+
+static js_gc_header* allocate_large(size_t size) {
+  js_gc_large* large = (js_gc_large*)malloc(sizeof(js_gc_large) -
+                                            sizeof(js_gc_header) + size);
+  if (large == NULL) fatal("out of memory");
+  large->next = large_objects;
+  large_objects = large;
+  stats.heap_bytes += size;
+  return &large->header;
+}
+
+static int size_class_for(size_t size) {
+  for (size_t i = 0; i < JS_GC_SIZE_CLASSES; i++) {
+    if (size <= size_classes[i]) return (int)i;
+  }
+  return -1;
+}
+
+static size_t reserved_size(size_t size) {
+  int size_class = size_class_for(size);
+  return size_class < 0 ? size : JS_GC_PAGE_SIZE;
+}
+
+static void push_recent(js_gc_header* object) {
+  if (js_gc_recent_count == recent_capacity) {
+    js_gc_recent = (js_gc_header**)grow(js_gc_recent, &recent_capacity,
+                                        sizeof(js_gc_header*));
+  }
+  js_gc_recent[js_gc_recent_count++] = object;
+}
+
+static js_gc_header* allocate(size_t size, uint8_t kind, bool in_heap) {
+  size_t total = sizeof(js_gc_header) + size;
+  if (total > UINT32_MAX) fatal("allocation too large");
+  js_gc_header* object;
+  if (!in_heap && js_arena_scope_depth > 0) {
+    object = (js_gc_header*)js_arena_alloc(&js_scratch_arena, total);
+    object->flags = JS_GC_FLAG_ARENA;
+    object->size_class = 0;
+  } else {
+    initialize();
+    bool over_limit =
+        stats.heap_limit != 0 &&
+        stats.heap_bytes + reserved_size(total) > stats.heap_limit;
+    // Marking does not trace through arena objects, so while a scope is
+    // open a heap object that only they reference would be swept.
+    if (js_arena_scope_depth == 0 &&
+        (stress || over_limit ||
+         allocated_since_collection + total > threshold)) {
+      js_gc_collect();
+    }
+    int size_class = size_class_for(total);
+    object = size_class < 0 ? allocate_large(total)
+                            : allocate_small((uint8_t)size_class);
+    if (stats.heap_limit != 0 && stats.heap_bytes > stats.heap_limit) {
+      fatal("heap limit exceeded");
+    }
+    object->flags = size_class < 0 ? JS_GC_FLAG_LARGE : 0;
+    object->size_class = size_class < 0 ? 0 : (uint8_t)size_class;
+    stats.bytes_allocated += total;
+    allocated_since_collection += total;
+    push_recent(object);
+  }
+  object->size = (uint32_t)total;
+  object->kind = kind;
+  object->marked = 0;
+  // Tracing may see the object before its owner fills it in; zero bits are
+  // the number +0.
+  memset(js_gc_payload(object), 0, size);
+  return object;
+}
+
+js_gc_header* js_gc_alloc(size_t size, uint8_t kind) {
+  return allocate(size, kind, false);
+}
+
+js_gc_header* js_gc_alloc_in_heap(size_t size, uint8_t kind) {
+  return allocate(size, kind, true);
+}
+
+void js_gc_set_tracer(uint8_t kind, js_gc_tracer tracer) {
+  tracers[kind] = tracer;
+}
+
+void js_gc_add_root(js_value* slot) {
+  if (global_root_count == global_root_capacity) {
+    global_roots = (js_value**)grow(global_roots, &global_root_capacity,
+                                    sizeof(js_value*));
+  }
+  global_roots[global_root_count++] = slot;
+}
+
+void js_gc_set_stress(bool value) {
+  initialize();
+  stress = value;
+}
+
+void js_gc_set_heap_limit(size_t bytes) {
+  initialize();
+  stats.heap_limit = bytes;
+}
+
+js_value js_gc_retain(js_value value) {
+  if (js_is_heap_value(value) && !js_is_static_value(value)) {
+    js_gc_header* object = (js_gc_header*)js_heap_pointer(value);
+    if (!(object->flags & JS_GC_FLAG_ARENA)) push_recent(object);
+  }
+  return value;
+}
+
+//-----------------------------------------------------------------------------
+// Marking
+
+static void mark_object(js_gc_header* object) {
+  if (object->marked || (object->flags & JS_GC_FLAG_ARENA)) return;
+  object->marked = 1;
+  if (mark_stack_count == mark_stack_capacity) {
+    mark_stack = (js_gc_header**)grow(mark_stack, &mark_stack_capacity,
+                                      sizeof(js_gc_header*));
+  }
+  mark_stack[mark_stack_count++] = object;
+}
+
+static void mark_slot(js_value* slot) {
+  js_value value = *slot;
+  if (!js_is_heap_value(value) || js_is_static_value(value)) return;
+  mark_object((js_gc_header*)js_heap_pointer(value));
+}
+
+static void trace(js_gc_header* object) {
+  switch (object->kind) {
+    case JS_GC_KIND_STRING:
+      break;
+    case JS_GC_KIND_VALUES: {
+      js_value* slots = (js_value*)js_gc_payload(object);
+      size_t count = (object->size - sizeof(js_gc_header)) / sizeof(js_value);
+      for (size_t i = 0; i < count; i++) mark_slot(&slots[i]);
+      break;
+    }
+    default:
+      if (tracers[object->kind] != NULL) {
+        tracers[object->kind](object, mark_slot);
+      }
+      break;
+  }
+}
+
+static void mark_roots(void) {
+  for (js_gc_frame* frame = js_gc_top_frame; frame != NULL;
+       frame = frame->prev) {
+    for (size_t i = 0; i < frame->root_count; i++) mark_slot(frame->roots[i]);
+  }
+  for (size_t i = 0; i < js_gc_recent_count; i++) {
+    mark_object(js_gc_recent[i]);
+  }
+  for (size_t i = 0; i < global_root_count; i++) mark_slot(global_roots[i]);
+  while (mark_stack_count > 0) trace(mark_stack[--mark_stack_count]);
+}
+
+//-----------------------------------------------------------------------------
+// Sweeping
+
+static size_t sweep_pages(void) {
+  size_t live_bytes = 0;
+  for (size_t i = 0; i < JS_GC_SIZE_CLASSES; i++) free_lists[i] = NULL;
+  js_gc_page** link = &pages;
+  while (*link != NULL) {
+    js_gc_page* page = *link;
+    js_gc_header* free_head = NULL;
+    js_gc_header* free_tail = NULL;
+    uint32_t live_cells = 0;
+    for (uint32_t i = page->cell_count; i-- > 0;) {
+      js_gc_header* cell = cell_at(page, i);
+      if (cell->kind != JS_GC_KIND_FREE) {
+        if (cell->marked) {
+          cell->marked = 0;
+          live_cells++;
+          live_bytes += cell->size;
+          continue;
+        }
+        stats.bytes_freed += cell->size;
+        cell->kind = JS_GC_KIND_FREE;
+      }
+      *free_list_next(cell) = free_head;
+      if (free_head == NULL) free_tail = cell;
+      free_head = cell;
+    }
+    if (live_cells == 0) {
+      // Give empty pages back so that the heap shrinks with the live set.
+      *link = page->next;
+      free(page);
+      stats.heap_bytes -= JS_GC_PAGE_SIZE;
+      continue;
+    }
+    if (free_head != NULL) {
+      *free_list_next(free_tail) = free_lists[page->size_class];
+      free_lists[page->size_class] = free_head;
+    }
+    link = &page->next;
+  }
+  return live_bytes;
+}
+
+static size_t sweep_large_objects(void) {
+  size_t live_bytes = 0;
+  js_gc_large** link = &large_objects;
+  while (*link != NULL) {
+    js_gc_large* large = *link;
+    if (large->header.marked) {
+      large->header.marked = 0;
+      live_bytes += large->header.size;
+      link = &large->next;
+      continue;
+    }
+    *link = large->next;
+    stats.bytes_freed += large->header.size;
+    stats.heap_bytes -= large->header.size;
+    free(large);
+  }
+  return live_bytes;
+}
+
+void js_gc_collect(void) {
+  initialize();
+  mark_roots();
+  stats.live_bytes = sweep_pages() + sweep_large_objects();
+  stats.collections++;
+  allocated_since_collection = 0;
+  threshold = stats.live_bytes > JS_GC_MIN_THRESHOLD / 2
+                  ? stats.live_bytes * 2
+                  : JS_GC_MIN_THRESHOLD;
+}
+
+js_gc_stats js2c_gc_stats(void) {
+  initialize();
+  return stats;
+}
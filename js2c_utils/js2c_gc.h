@@ -0,0 +1,118 @@
+#ifndef JS2C_GC_H_
+#define JS2C_GC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A precise, non-moving mark-sweep collector for the heap values of
+// translated programs. Included from js2c.h after js_value is defined.
+//
+// Roots come from three places:
+//  - the shadow stack: every generated function that holds boxed values
+//    pushes a js_gc_frame listing the addresses of its js_value locals,
+//  - the recent list: every object allocated is kept alive until the
+//    statement that allocated it ends, which covers values that only live in
+//    C temporaries,
+//  - global roots registered with js_gc_add_root.
+//
+// Small objects are carved from pages of a single size class and recycled
+// through per-class free lists; large objects are allocated individually.
+// Setting JS2C_GC_STRESS=1 in the environment collects on every allocation.
+
+// Every heap object starts with this header. Values point at the header.
+typedef struct js_gc_header {
+  uint32_t size;  // including the header
+  uint8_t kind;
+  uint8_t marked;
+  uint8_t flags;
+  uint8_t size_class;
+} js_gc_header;
+
+#define JS_GC_KIND_FREE 0
+#define JS_GC_KIND_STRING 1   // no references
+#define JS_GC_KIND_VALUES 2   // an array of js_value after the header
+#define JS_GC_KIND_OBJECT 3   // a js_object, see js2c_object.h
+#define JS_GC_KIND_ARRAY 4    // a js_array, see js2c_array.h
+#define JS_GC_KIND_RAW 5      // no references, such as unboxed elements
+#define JS_GC_KIND_CLOSURE 6  // a js_closure, see js2c_closure.h
+#define JS_GC_KIND_CONS_STRING 7    // see js2c_string.h
+#define JS_GC_KIND_SLICED_STRING 8  // see js2c_string.h
+#define JS_GC_KIND_GENERATOR 9      // see js2c_generator.h
+#define JS_GC_KIND_PROMISE 10       // see js2c_generator.h
+#define JS_GC_MAX_KINDS 16
+
+// The object lives in the scratch arena of an arena scope and is neither
+// marked nor swept.
+#define JS_GC_FLAG_ARENA 1
+#define JS_GC_FLAG_LARGE 2
+
+typedef void (*js_gc_visitor)(js_value* slot);
+typedef void (*js_gc_tracer)(js_gc_header* object, js_gc_visitor visit);
+
+typedef struct js_gc_frame {
+  struct js_gc_frame* prev;
+  js_value** roots;
+  size_t root_count;
+  size_t recent_mark;
+} js_gc_frame;
+
+typedef struct js_gc_stats {
+  size_t collections;
+  size_t bytes_allocated;  // since startup
+  size_t bytes_freed;      // since startup
+  size_t live_bytes;       // after the last collection
+  size_t heap_bytes;       // reserved for pages and large objects
+  size_t heap_limit;       // 0 if unlimited
+} js_gc_stats;
+
+extern js_gc_frame* js_gc_top_frame;
+extern js_gc_header** js_gc_recent;
+extern size_t js_gc_recent_count;
+
+static inline void* js_gc_payload(js_gc_header* object) {
+  return object + 1;
+}
+
+// Allocates {size} bytes of payload. Inside an arena scope the object goes
+// to the scratch arena instead of the collected heap.
+js_gc_header* js_gc_alloc(size_t size, uint8_t kind);
+// Allocates in the collected heap even inside an arena scope, for objects
+// that a heap object keeps. It does not collect while a scope is open.
+js_gc_header* js_gc_alloc_in_heap(size_t size, uint8_t kind);
+
+// Registers how objects of {kind} reference other values.
+void js_gc_set_tracer(uint8_t kind, js_gc_tracer tracer);
+
+void js_gc_add_root(js_value* slot);
+void js_gc_collect(void);
+void js_gc_set_stress(bool stress);
+// Collections are forced as the heap approaches {bytes}; exceeding it
+// afterwards is fatal. 0 removes the limit.
+void js_gc_set_heap_limit(size_t bytes);
+
+static inline void js_gc_push_frame(js_gc_frame* frame, js_value** roots,
+                                    size_t root_count) {
+  frame->prev = js_gc_top_frame;
+  frame->roots = roots;
+  frame->root_count = root_count;
+  frame->recent_mark = js_gc_recent_count;
+  js_gc_top_frame = frame;
+}
+
+// Also drops everything the function allocated from the recent list.
+static inline void js_gc_pop_frame(js_gc_frame* frame) {
+  js_gc_top_frame = frame->prev;
+  js_gc_recent_count = frame->recent_mark;
+}
+
+static inline void js_gc_end_statement(js_gc_frame* frame) {
+  js_gc_recent_count = frame->recent_mark;
+}
+
+// Keeps a returned value alive until the caller's statement ends.
+js_value js_gc_retain(js_value value);
+
+js_gc_stats js2c_gc_stats(void);
+
+#endif
@@ -0,0 +1,257 @@
+#include "js2c.h"
+
+static js_shape generator_shape;
+static js_shape promise_shape;
+static bool tracers_registered;
+
+// The microtask queue, a list of {generator, value, thrown, next} jobs in
+// JS_GC_KIND_VALUES objects. Rooted once anything has been queued.
+static js_value queue_head = JS_UNDEFINED_VALUE;
+static js_value queue_tail = JS_UNDEFINED_VALUE;
+static bool queue_rooted;
+
+static js_ic value_ic = {.key = "value"};
+static js_ic done_ic = {.key = "done"};
+static js_ic next_ic = {.key = "next"};
+static js_ic throw_ic = {.key = "throw"};
+
+static void trace_generator(js_gc_header* header, js_gc_visitor visit) {
+  js_generator* generator = (js_generator*)js_gc_payload(header);
+  visit(&generator->promise);
+  for (uint32_t i = 0; i < generator->slot_count; i++) {
+    visit(&generator->slots[i]);
+  }
+}
+
+static void trace_promise(js_gc_header* header, js_gc_visitor visit) {
+  js_promise* promise = (js_promise*)js_gc_payload(header);
+  visit(&promise->result);
+  visit(&promise->reactions);
+}
+
+static void register_tracers(void) {
+  if (tracers_registered) return;
+  js_gc_set_tracer(JS_GC_KIND_GENERATOR, trace_generator);
+  js_gc_set_tracer(JS_GC_KIND_PROMISE, trace_promise);
+  tracers_registered = true;
+}
+
+static js_value new_values(uint32_t count, const js_value* values) {
+  js_gc_header* header =
+      js_gc_alloc(count * sizeof(js_value), JS_GC_KIND_VALUES);
+  memcpy(js_gc_payload(header), values, count * sizeof(js_value));
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+}
+
+static js_value* values_of(js_value values) {
+  return (js_value*)js_gc_payload((js_gc_header*)js_heap_pointer(values));
+}
+
+js_value js_generator_new(js_resume resume, uint32_t slot_count) {
+  register_tracers();
+  js_gc_header* header =
+      js_gc_alloc(sizeof(js_generator) + slot_count * sizeof(js_value),
+                  JS_GC_KIND_GENERATOR);
+  js_generator* generator = (js_generator*)js_gc_payload(header);
+  generator->shape = &generator_shape;
+  generator->resume = resume;
+  generator->state = 0;
+  generator->running = false;
+  generator->promise = make_undefined();
+  generator->slot_count = slot_count;
+  for (uint32_t i = 0; i < slot_count; i++) {
+    generator->slots[i] = make_undefined();
+  }
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+}
+
+static js_value promise_new(void) {
+  register_tracers();
+  js_gc_header* header = js_gc_alloc(sizeof(js_promise), JS_GC_KIND_PROMISE);
+  js_promise* promise = (js_promise*)js_gc_payload(header);
+  promise->shape = &promise_shape;
+  promise->state = JS_PROMISE_PENDING;
+  promise->result = make_undefined();
+  promise->reactions = make_undefined();
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+}
+
+js_value js_async_function_new(js_resume resume, uint32_t slot_count) {
+  // The generator stays on the recent list while the promise is allocated.
+  js_value generator = js_generator_new(resume, slot_count);
+  js_value promise = promise_new();
+  js_generator_value(generator)->promise = promise;
+  return generator;
+}
+
+// Resumes {generator}, which closes if the body throws.
+static js_value run(js_value generator, js_value sent, bool thrown) {
+  js_generator* state = js_generator_value(generator);
+  if (state->running) {
+    fprintf(stderr, "js2c: generator is already running\n");
+    abort();
+  }
+  state->running = true;
+  js_value result = state->resume(generator, sent, thrown);
+  state->running = false;
+  if (js_exception_pending) state->state = JS_GENERATOR_CLOSED;
+  return result;
+}
+
+js_value js_generator_start(js_value generator) {
+  run(generator, make_undefined(), false);
+  return js_gc_retain(generator);
+}
+
+js_value js_async_function_start(js_value generator) {
+  run(generator, make_undefined(), false);
+  return js_gc_retain(js_generator_value(generator)->promise);
+}
+
+static js_value iterator_result(js_value value, bool done) {
+  js_value result = js_object_new(2);
+  js_store_named(result, value, &value_ic);
+  js_store_named(result, make_boolean(done), &done_ic);
+  return result;
+}
+
+static js_value resume_generator(js_value generator, js_value sent,
+                                 bool thrown) {
+  js_generator* state = js_generator_value(generator);
+  if (state->state == JS_GENERATOR_CLOSED) {
+    if (thrown) {
+      js_throw(sent);
+      return make_undefined();
+    }
+    return iterator_result(make_undefined(), true);
+  }
+  js_value value = run(generator, sent, thrown);
+  if (js_exception_pending) return make_undefined();
+  return iterator_result(value, state->state == JS_GENERATOR_CLOSED);
+}
+
+js_value js_generator_next(js_value generator, js_value value) {
+  if (!js_is_generator(generator)) {
+    return js_call(js_load_named(generator, &next_ic), 1, &value);
+  }
+  return resume_generator(generator, value, false);
+}
+
+js_value js_generator_throw(js_value generator, js_value exception) {
+  if (!js_is_generator(generator)) {
+    return js_call(js_load_named(generator, &throw_ic), 1, &exception);
+  }
+  return resume_generator(generator, exception, true);
+}
+
+bool js_generator_next_value(js_value generator, js_value* value) {
+  js_generator* state = js_generator_value(generator);
+  if (state->state == JS_GENERATOR_CLOSED) return false;
+  js_value result = run(generator, make_undefined(), false);
+  if (js_exception_pending || state->state == JS_GENERATOR_CLOSED) {
+    return false;
+  }
+  *value = result;
+  return true;
+}
+
+static void enqueue(js_value generator, js_value value, bool thrown) {
+  if (!queue_rooted) {
+    js_gc_add_root(&queue_head);
+    js_gc_add_root(&queue_tail);
+    queue_rooted = true;
+  }
+  js_value job = new_values(
+      4, (const js_value[]){generator, value, make_boolean(thrown),
+                            make_undefined()});
+  if (js_is_undefined(queue_head)) {
+    queue_head = job;
+  } else {
+    values_of(queue_tail)[3] = job;
+  }
+  queue_tail = job;
+}
+
+static void settle(js_value promise, int32_t state, js_value result);
+
+// Adds {target}, an async function or a promise that follows {promise}, to
+// the reactions of {promise}, or reacts right away if it has settled.
+static void subscribe(js_value promise, js_value target) {
+  js_promise* source = js_promise_value(promise);
+  if (source->state == JS_PROMISE_PENDING) {
+    source->reactions =
+        new_values(2, (const js_value[]){target, source->reactions});
+  } else if (js_is_generator(target)) {
+    enqueue(target, source->result, source->state == JS_PROMISE_REJECTED);
+  } else {
+    settle(target, source->state, source->result);
+  }
+}
+
+static void settle(js_value promise, int32_t state, js_value result) {
+  js_promise* target = js_promise_value(promise);
+  if (target->state != JS_PROMISE_PENDING) return;
+  if (state == JS_PROMISE_FULFILLED && js_is_promise(result)) {
+    // Resolving with a promise follows it.
+    subscribe(result, promise);
+    return;
+  }
+  target->state = state;
+  target->result = result;
+  // Reactions are prepended as they subscribe. Reversing the list in place
+  // runs them in that order, as promise jobs are.
+  js_value reversed = make_undefined();
+  for (js_value reaction = target->reactions; !js_is_undefined(reaction);) {
+    js_value next = values_of(reaction)[1];
+    values_of(reaction)[1] = reversed;
+    reversed = reaction;
+    reaction = next;
+  }
+  target->reactions = reversed;
+  // The list stays reachable from the promise while the jobs are queued.
+  for (js_value reaction = target->reactions; !js_is_undefined(reaction);
+       reaction = values_of(reaction)[1]) {
+    subscribe(promise, values_of(reaction)[0]);
+  }
+  target->reactions = make_undefined();
+}
+
+void js_await(js_value generator, int32_t state, js_value value) {
+  js_generator_suspend(generator, state);
+  if (js_is_promise(value)) {
+    subscribe(value, generator);
+  } else {
+    enqueue(generator, value, false);
+  }
+}
+
+js_value js_async_function_resolve(js_value generator, js_value value) {
+  js_generator_close(generator, value);
+  settle(js_generator_value(generator)->promise, JS_PROMISE_FULFILLED, value);
+  return make_undefined();
+}
+
+js_value js_async_function_reject(js_value generator, js_value exception) {
+  js_generator_close(generator, exception);
+  settle(js_generator_value(generator)->promise, JS_PROMISE_REJECTED,
+         exception);
+  return make_undefined();
+}
+
+void js_run_microtasks(void) {
+  js_gc_frame frame;
+  js_gc_push_frame(&frame, NULL, 0);
+  while (!js_is_undefined(queue_head)) {
+    js_value* job = values_of(queue_head);
+    js_value generator = job[0];
+    js_value value = job[1];
+    bool thrown = js_boolean_value(job[2]);
+    // The job stays reachable from the queue while it runs.
+    run(generator, value, thrown);
+    queue_head = values_of(queue_head)[3];
+    if (js_is_undefined(queue_head)) queue_tail = make_undefined();
+    js_gc_end_statement(&frame);
+    if (js_exception_pending) break;
+  }
+  js_gc_pop_frame(&frame);
+}
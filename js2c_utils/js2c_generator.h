@@ -0,0 +1,130 @@
+#ifndef JS2C_GENERATOR_H_
+#define JS2C_GENERATOR_H_
+
+// Generators, async functions and the promises they await. Included from
+// js2c.h.
+//
+// The translator turns the body of a generator or async function into a
+// stackless state machine, its resume function: every yield or await is a
+// numbered resume point, and the resume function starts with a switch that
+// jumps to the one it was suspended at. A suspend stores the number of its
+// resume point and returns from the C function. Only the variables whose
+// values are needed after some suspend live in the slots of the heap frame,
+// the js_generator; all others stay C locals of the resume function.
+//
+// Calling the function only creates the frame, stores the parameters and
+// runs the body up to the initial yield of a generator, or up to the first
+// await of an async function.
+//
+// Async functions run their continuations as jobs of a microtask queue,
+// which the generated main drains with js_run_microtasks once the script
+// has run.
+
+// Resumes {generator} with {sent}, the value of the suspended yield or await,
+// or with {sent} thrown there if {thrown}. A generator returns the value it
+// yields or returns.
+typedef js_value (*js_resume)(js_value generator, js_value sent, bool thrown);
+
+// The state of a generator that ran to completion or threw.
+#define JS_GENERATOR_CLOSED -1
+
+typedef struct js_generator {
+  // Never matches an inline cache, like the shape of a closure.
+  js_shape* shape;
+  js_resume resume;
+  // The resume point to continue at, 0 before the first run.
+  int32_t state;
+  bool running;
+  // The promise of an async function, undefined for a generator.
+  js_value promise;
+  uint32_t slot_count;
+  js_value slots[];
+} js_generator;
+
+// The slots start out undefined and are filled in by the caller.
+js_value js_generator_new(js_resume resume, uint32_t slot_count);
+js_value js_async_function_new(js_resume resume, uint32_t slot_count);
+
+static inline bool js_is_generator(js_value value) {
+  return js_is_object(value) &&
+         ((js_gc_header*)js_heap_pointer(value))->kind ==
+             JS_GC_KIND_GENERATOR;
+}
+
+static inline js_generator* js_generator_value(js_value value) {
+  return (js_generator*)js_gc_payload((js_gc_header*)js_heap_pointer(value));
+}
+
+static inline js_value* js_generator_slots(js_value generator) {
+  return js_generator_value(generator)->slots;
+}
+
+static inline int32_t js_generator_state(js_value generator) {
+  return js_generator_value(generator)->state;
+}
+
+// Records the resume point of a yield, before the resume function returns
+// the yielded value.
+static inline void js_generator_suspend(js_value generator, int32_t state) {
+  js_generator_value(generator)->state = state;
+}
+
+// Closes {generator} on a return and passes the returned value through.
+static inline js_value js_generator_close(js_value generator, js_value value) {
+  js_generator_value(generator)->state = JS_GENERATOR_CLOSED;
+  return value;
+}
+
+// Runs a new generator up to its initial yield and returns it.
+js_value js_generator_start(js_value generator);
+// Runs a new async function up to its first await and returns its promise.
+js_value js_async_function_start(js_value generator);
+
+// generator.next(value) and generator.throw(exception), which return the
+// {value, done} iterator result. The translator lowers every call of a
+// method with these names; for anything that is not a generator they call
+// the method.
+js_value js_generator_next(js_value generator, js_value value);
+js_value js_generator_throw(js_value generator, js_value exception);
+// The step of a for-of loop over {generator}: stores the next value it
+// yields in *value, or returns false once it has returned, without making
+// an iterator result.
+bool js_generator_next_value(js_value generator, js_value* value);
+
+// Suspends the async function {generator} at {state} until {value}
+// settles. A value that is not a promise is resumed with as a job.
+void js_await(js_value generator, int32_t state, js_value value);
+
+// Settle the promise of the async function {generator} on its return, or on
+// an exception that its body did not catch, and close it.
+js_value js_async_function_resolve(js_value generator, js_value value);
+js_value js_async_function_reject(js_value generator, js_value exception);
+
+#define JS_PROMISE_PENDING 0
+#define JS_PROMISE_FULFILLED 1
+#define JS_PROMISE_REJECTED 2
+
+typedef struct js_promise {
+  js_shape* shape;
+  int32_t state;
+  // The value or the reason once settled.
+  js_value result;
+  // What to settle or resume once the promise settles: a list of
+  // {generator or promise, next} pairs, JS_GC_KIND_VALUES objects.
+  js_value reactions;
+} js_promise;
+
+static inline bool js_is_promise(js_value value) {
+  return js_is_object(value) &&
+         ((js_gc_header*)js_heap_pointer(value))->kind == JS_GC_KIND_PROMISE;
+}
+
+static inline js_promise* js_promise_value(js_value value) {
+  return (js_promise*)js_gc_payload((js_gc_header*)js_heap_pointer(value));
+}
+
+// Runs the queued jobs, and those they queue, until there are none left.
+// Stops with the exception pending if one throws.
+void js_run_microtasks(void);
+
+#endif
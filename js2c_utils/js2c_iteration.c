@@ -0,0 +1,39 @@
+#include "js2c.h"
+
+static void fatal_not_iterable(js_value value) {
+  char buffer[32];
+  fprintf(stderr, "js2c: %s is not iterable\n",
+          js_to_cstring(value, buffer, sizeof(buffer)));
+  abort();
+}
+
+int32_t js_for_of_step(js_value iterable, int32_t index, int32_t length,
+                       js_value* value) {
+  if (js_is_string(iterable)) {
+    if (length < 0) length = js_string_length(iterable);
+    if (index >= length) return -1;
+    // Steps by UTF-8 characters rather than UTF-16 code units, reading each
+    // the way string[index] does at its first byte. A stray continuation
+    // byte, which only a substring that split a character leaves, is a step
+    // of its own and reads as the empty string.
+    const char* chars = js_string_value(iterable);
+    int32_t size = js_utf8_sequence_length((unsigned char)chars[index]);
+    if (size > length - index) size = length - index;
+    *value = js_string_get_char(iterable, index);
+    return index + size;
+  }
+  if (js_is_generator(iterable)) {
+    return js_generator_next_value(iterable, value) ? index + 1 : -1;
+  }
+  fatal_not_iterable(iterable);
+  return -1;
+}
+
+int32_t js_for_in_step(js_value object, int32_t index, js_value* key) {
+  if (js_is_array(object) &&
+      (uint32_t)index >= js_array_value(object)->length) {
+    return -1;
+  }
+  *key = js_to_string(make_int32(index));
+  return index + 1;
+}
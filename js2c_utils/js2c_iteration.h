@@ -0,0 +1,92 @@
+#ifndef JS2C_ITERATION_H_
+#define JS2C_ITERATION_H_
+
+// for-of and for-in loops. Included from js2c.h.
+//
+// The translator lowers both to counted C loops over an index, without the
+// iterator objects and {value, done} results of the iteration protocol:
+//
+//   _js_iterable_N = subject;
+//   for (int32_t _js_index_N = 0, _js_length_N = js_for_of_length(...);
+//        js_for_of_next(_js_iterable_N, &_js_index_N, _js_length_N, &each);) {
+//     ...
+//   }
+//
+// for-of walks the elements of an array and the characters of a string in
+// place. The length of an array is read once before the loop when the body
+// cannot change it, which the translator decides from the body having no
+// calls and no property stores; otherwise the loop passes
+// JS_FOR_OF_LIVE_LENGTH and the length is read on every iteration, as the
+// array iterator does. Only characters outside ASCII allocate a string.
+// Generators, the only other iterables of the runtime, are resumed for each
+// value.
+//
+// for-in walks the keys of an object in the order they were added, from
+// the list its shape computes once; see js_shape_keys. The count is taken
+// before the loop, so properties that the body adds are not visited, which
+// the language allows. The keys of arrays and strings are their indices.
+
+#define JS_FOR_OF_LIVE_LENGTH -1
+
+static inline int32_t js_for_of_length(js_value iterable) {
+  if (js_is_array(iterable)) return (int32_t)js_array_value(iterable)->length;
+  if (js_is_string(iterable)) return js_string_length(iterable);
+  return 0;
+}
+
+// The steps of strings and generators. Return the next index, or -1 when
+// done. Aborts for anything that is not iterable.
+int32_t js_for_of_step(js_value iterable, int32_t index, int32_t length,
+                       js_value* value);
+
+// Stores the next value of {iterable} in *value, or returns false when the
+// loop is done. Sets js_exception_pending if a generator throws.
+static inline bool js_for_of_next(js_value iterable, int32_t* index,
+                                  int32_t length, js_value* value) {
+  if (js_is_array(iterable)) {
+    if (length < 0) length = (int32_t)js_array_value(iterable)->length;
+    if (*index >= length) return false;
+    *value = js_get_element(iterable, (*index)++);
+    return true;
+  }
+  *index = js_for_of_step(iterable, *index, length, value);
+  return *index >= 0;
+}
+
+static inline int32_t js_for_in_length(js_value object) {
+  if (js_is_string(object)) return js_string_length(object);
+  if (!js_is_object(object)) return 0;
+  switch (((js_gc_header*)js_heap_pointer(object))->kind) {
+    case JS_GC_KIND_OBJECT:
+      return (int32_t)js_object_value(object)->shape->property_count;
+    case JS_GC_KIND_ARRAY:
+      return (int32_t)js_array_value(object)->length;
+    default:
+      return 0;
+  }
+}
+
+// The step of arrays and strings, whose keys are allocated. Returns the
+// next index, or -1 once an array has shrunk below {index}.
+int32_t js_for_in_step(js_value object, int32_t index, js_value* key);
+
+// Stores the next key of {object} in *key, or returns false when the loop
+// is done.
+static inline bool js_for_in_next(js_value object, int32_t* index,
+                                  int32_t length, js_value* key) {
+  if (*index >= length) return false;
+  if (js_is_object(object) &&
+      ((js_gc_header*)js_heap_pointer(object))->kind == JS_GC_KIND_OBJECT) {
+    // Added properties keep the keys before them, so the shape the object
+    // has by now lists the same ones first.
+    js_shape* shape = js_object_value(object)->shape;
+    const char** keys =
+        shape->keys != NULL ? shape->keys : js_shape_keys(shape);
+    *key = make_string(keys[(*index)++]);
+    return true;
+  }
+  *index = js_for_in_step(object, *index, key);
+  return *index >= 0;
+}
+
+#endif
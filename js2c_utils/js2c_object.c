@@ -0,0 +1,242 @@
+#include "js2c.h"
+
+static js_shape* root_shapes[JS_OBJECT_MAX_INOBJECT + 1];
+static bool tracer_registered;
+
+static void fatal_property_access(js_value object, const char* key) {
+  fprintf(stderr, "js2c: cannot access property '%s' of %s\n", key,
+          js_is_null(object) ? "null" : "undefined");
+  abort();
+}
+
+static void trace_object(js_gc_header* header, js_gc_visitor visit) {
+  js_object* object = (js_object*)js_gc_payload(header);
+  size_t inobject = (header->size - sizeof(js_gc_header) - sizeof(js_object)) /
+                    sizeof(js_value);
+  for (size_t i = 0; i < inobject; i++) visit(&object->inobject[i]);
+  visit(&object->out_of_line);
+}
+
+static js_shape* new_shape(js_shape* parent, const char* key,
+                           uint32_t inobject_capacity) {
+  js_shape* shape =
+      (js_shape*)js_arena_alloc(&js_global_arena, sizeof(js_shape));
+  shape->parent = parent;
+  shape->transitions = NULL;
+  shape->next_transition = NULL;
+  shape->key = key;
+  shape->key_hash = key != NULL ? js_string_hash(key) : 0;
+  shape->property_count = parent != NULL ? parent->property_count + 1 : 0;
+  shape->inobject_capacity = inobject_capacity;
+  shape->keys = NULL;
+  return shape;
+}
+
+static js_shape* transition(js_shape* shape, const char* key) {
+  uint32_t hash = js_string_hash(key);
+  for (js_shape* child = shape->transitions; child != NULL;
+       child = child->next_transition) {
+    if (child->key_hash == hash && js_string_equals(child->key, key)) {
+      return child;
+    }
+  }
+  // The key may be a heap string, so shapes keep their own copy of anything
+  // that is not interned.
+  if (!js_is_interned(key)) {
+    size_t length = strlen(key);
+    char* copy = (char*)js_arena_alloc(&js_global_arena, length + 1);
+    memcpy(copy, key, length + 1);
+    key = copy;
+  }
+  js_shape* child = new_shape(shape, key, shape->inobject_capacity);
+  child->next_transition = shape->transitions;
+  shape->transitions = child;
+  return child;
+}
+
+int32_t js_shape_lookup(js_shape* shape, const char* key) {
+  uint32_t hash = js_string_hash(key);
+  for (; shape->parent != NULL; shape = shape->parent) {
+    if (shape->key_hash == hash && js_string_equals(shape->key, key)) {
+      return (int32_t)shape->property_count - 1;
+    }
+  }
+  return -1;
+}
+
+const char** js_shape_keys(js_shape* shape) {
+  if (shape->keys != NULL) return shape->keys;
+  const char** keys = (const char**)js_arena_alloc(
+      &js_global_arena, shape->property_count * sizeof(const char*));
+  for (js_shape* s = shape; s->parent != NULL; s = s->parent) {
+    keys[s->property_count - 1] = s->key;
+  }
+  shape->keys = keys;
+  return keys;
+}
+
+js_value js_object_new(uint32_t property_count) {
+  if (!tracer_registered) {
+    js_gc_set_tracer(JS_GC_KIND_OBJECT, trace_object);
+    tracer_registered = true;
+  }
+  uint32_t capacity = property_count;
+  if (capacity < JS_OBJECT_MIN_INOBJECT) capacity = JS_OBJECT_MIN_INOBJECT;
+  if (capacity > JS_OBJECT_MAX_INOBJECT) capacity = JS_OBJECT_MAX_INOBJECT;
+  if (root_shapes[capacity] == NULL) {
+    root_shapes[capacity] = new_shape(NULL, NULL, capacity);
+  }
+  js_gc_header* header =
+      js_gc_alloc(sizeof(js_object) + capacity * sizeof(js_value),
+                  JS_GC_KIND_OBJECT);
+  js_object* object = (js_object*)js_gc_payload(header);
+  object->shape = root_shapes[capacity];
+  object->out_of_line_capacity = 0;
+  object->out_of_line = make_undefined();
+  for (uint32_t i = 0; i < capacity; i++) {
+    object->inobject[i] = make_undefined();
+  }
+  return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)header);
+}
+
+// The object must be reachable from the caller, since this may collect.
+static void grow_out_of_line(js_object* object) {
+  uint32_t old_capacity = object->out_of_line_capacity;
+  uint32_t capacity = old_capacity == 0 ? 4 : old_capacity * 2;
+  js_gc_header* store =
+      js_gc_alloc(capacity * sizeof(js_value), JS_GC_KIND_VALUES);
+  js_value* values = (js_value*)js_gc_payload(store);
+  if (old_capacity != 0) {
+    js_gc_header* old_store =
+        (js_gc_header*)js_heap_pointer(object->out_of_line);
+    memcpy(values, js_gc_payload(old_store), old_capacity * sizeof(js_value));
+  }
+  for (uint32_t i = old_capacity; i < capacity; i++) {
+    values[i] = make_undefined();
+  }
+  object->out_of_line = JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)store);
+  object->out_of_line_capacity = capacity;
+}
+
+// Moves {object} to the shape with {key} added and returns the new slot.
+static uint32_t add_property(js_object* object, const char* key) {
+  js_shape* next = transition(object->shape, key);
+  uint32_t slot = next->property_count - 1;
+  if (slot >= next->inobject_capacity + object->out_of_line_capacity) {
+    grow_out_of_line(object);
+  }
+  object->shape = next;
+  return slot;
+}
+
+static void update_ic(js_ic* ic, js_shape* shape, js_shape* transition,
+                      uint32_t slot) {
+  ic->misses++;
+  if (ic->state == JS_IC_MEGAMORPHIC) return;
+  if (ic->state == JS_IC_ENTRIES) {
+    ic->state = JS_IC_MEGAMORPHIC;
+    return;
+  }
+  ic->shapes[ic->state] = shape;
+  ic->transitions[ic->state] = transition;
+  ic->slots[ic->state] = slot;
+  ic->state++;
+}
+
+static js_value load_primitive(js_value object, const char* key) {
+  if (js_is_nullish(object)) fatal_property_access(object, key);
+  if (js_is_string(object) && strcmp(key, "length") == 0) {
+    return make_int32(js_string_length(object));
+  }
+  return make_undefined();
+}
+
+// Arrays have no named properties other than their length.
+static js_value load_array(js_value object, const char* key) {
+  if (strcmp(key, "length") == 0) {
+    return make_int32((int32_t)js_array_value(object)->length);
+  }
+  return make_undefined();
+}
+
+static js_value store_array(js_value object, const char* key, js_value value) {
+  if (strcmp(key, "length") == 0) {
+    js_array_set_length(object, (uint32_t)js_to_number(value));
+  }
+  return value;
+}
+
+// Functions, generators and promises have no properties of their own.
+static bool has_properties(js_value object) {
+  return ((js_gc_header*)js_heap_pointer(object))->kind == JS_GC_KIND_OBJECT;
+}
+
+js_value js_load_named_miss(js_value object, js_ic* ic) {
+  if (!js_is_object(object)) return load_primitive(object, ic->key);
+  if (js_is_array(object)) return load_array(object, ic->key);
+  if (!has_properties(object)) return make_undefined();
+  js_object* receiver = js_object_value(object);
+  int32_t slot = js_shape_lookup(receiver->shape, ic->key);
+  if (slot < 0) return make_undefined();
+  update_ic(ic, receiver->shape, NULL, (uint32_t)slot);
+  return *js_object_slot(receiver, (uint32_t)slot);
+}
+
+js_value js_store_named_miss(js_value object, js_value value, js_ic* ic) {
+  if (!js_is_object(object)) {
+    if (js_is_nullish(object)) fatal_property_access(object, ic->key);
+    return value;
+  }
+  if (js_is_array(object)) return store_array(object, ic->key, value);
+  if (!has_properties(object)) return value;
+  js_object* receiver = js_object_value(object);
+  js_shape* shape = receiver->shape;
+  int32_t slot = js_shape_lookup(shape, ic->key);
+  if (slot >= 0) {
+    update_ic(ic, shape, NULL, (uint32_t)slot);
+  } else {
+    slot = (int32_t)add_property(receiver, ic->key);
+    update_ic(ic, shape, receiver->shape, (uint32_t)slot);
+  }
+  *js_object_slot(receiver, (uint32_t)slot) = value;
+  return value;
+}
+
+js_value js_get_property(js_value object, js_value key) {
+  if (js_is_array(object) && js_is_int32(key)) {
+    return js_get_element(object, js_int32_value(key));
+  }
+  if (js_is_string(object) && js_is_int32(key)) {
+    // {key} is a byte offset into the UTF-8, not a UTF-16 code unit index,
+    // so "é"[0] is "é" and "é"[1] is "".
+    return js_string_get_char(object, js_int32_value(key));
+  }
+  char buffer[32];
+  const char* name = js_to_cstring(key, buffer, sizeof(buffer));
+  if (!js_is_object(object)) return load_primitive(object, name);
+  if (js_is_array(object)) return load_array(object, name);
+  if (!has_properties(object)) return make_undefined();
+  js_object* receiver = js_object_value(object);
+  int32_t slot = js_shape_lookup(receiver->shape, name);
+  if (slot < 0) return make_undefined();
+  return *js_object_slot(receiver, (uint32_t)slot);
+}
+
+js_value js_set_property(js_value object, js_value key, js_value value) {
+  if (js_is_array(object) && js_is_int32(key) && js_int32_value(key) >= 0) {
+    return js_set_element(object, js_int32_value(key), value);
+  }
+  char buffer[32];
+  const char* name = js_to_cstring(key, buffer, sizeof(buffer));
+  if (!js_is_object(object)) {
+    if (js_is_nullish(object)) fatal_property_access(object, name);
+    return value;
+  }
+  if (js_is_array(object)) return store_array(object, name, value);
+  if (!has_properties(object)) return value;
+  js_object* receiver = js_object_value(object);
+  int32_t slot = js_shape_lookup(receiver->shape, name);
+  if (slot < 0) slot = (int32_t)add_property(receiver, name);
+  *js_object_slot(receiver, (uint32_t)slot) = value;
+  return value;
+}
@@ -0,0 +1,130 @@
+#ifndef JS2C_OBJECT_H_
+#define JS2C_OBJECT_H_
+
+// Objects with hidden classes, modelled on V8's maps. Included from js2c.h.
+//
+// Every object points to a js_shape that says which properties it has and
+// in which slot each one lives. Shapes form transition trees rooted at one
+// empty shape per in-object capacity: adding property "x" to an object moves
+// it to the child of its shape for "x", so objects built the same way end up
+// sharing a shape. Shapes are never freed and live in js_global_arena.
+//
+// The first inobject_capacity slots are stored in the object itself, the
+// rest in an out-of-line array that grows as properties are added.
+//
+// Named property accesses in translated code go through a js_ic, a static
+// struct per access site that caches the slot of the property for up to
+// JS_IC_ENTRIES shapes. A hit costs a shape compare and an indexed load; a
+// site that sees more shapes goes megamorphic and always looks the property
+// up in the shape.
+
+#define JS_OBJECT_MIN_INOBJECT 4
+#define JS_OBJECT_MAX_INOBJECT 16
+
+typedef struct js_shape {
+  struct js_shape* parent;
+  struct js_shape* transitions;  // children, linked through next_transition
+  struct js_shape* next_transition;
+  const char* key;  // added by the transition from the parent
+  uint32_t key_hash;
+  uint32_t property_count;
+  uint32_t inobject_capacity;
+  // The keys in the order they were added, or NULL until js_shape_keys
+  // computes them.
+  const char** keys;
+} js_shape;
+
+typedef struct js_object {
+  js_shape* shape;
+  uint32_t out_of_line_capacity;
+  // A JS_GC_KIND_VALUES object, boxed so that it is traced like any slot.
+  js_value out_of_line;
+  js_value inobject[];
+} js_object;
+
+#define JS_IC_ENTRIES 4
+#define JS_IC_MEGAMORPHIC 0xFF
+
+// Generated code declares one per access site, at the top of the function
+// that contains it, as
+//   static js_ic _js_ic_N = {_js_strings.sM};
+// where the key is interned, so that comparing it with the keys of shapes is
+// a pointer compare; see js_string_header.
+// Stores that add a property cache the transition as well, so that building
+// an object literal hits the cache once the transitions exist.
+typedef struct js_ic {
+  const char* key;
+  uint8_t state;  // the number of entries in use, or JS_IC_MEGAMORPHIC
+  js_shape* shapes[JS_IC_ENTRIES];
+  js_shape* transitions[JS_IC_ENTRIES];  // the shape after a store, or NULL
+  uint32_t slots[JS_IC_ENTRIES];
+  size_t misses;
+} js_ic;
+
+// Creates an empty object with room for {property_count} properties inside
+// the object, within the limits above.
+js_value js_object_new(uint32_t property_count);
+
+static inline js_object* js_object_value(js_value value) {
+  return (js_object*)js_gc_payload((js_gc_header*)js_heap_pointer(value));
+}
+
+static inline js_value* js_object_slot(js_object* object, uint32_t slot) {
+  uint32_t inobject = object->shape->inobject_capacity;
+  if (slot < inobject) return &object->inobject[slot];
+  js_gc_header* out_of_line =
+      (js_gc_header*)js_heap_pointer(object->out_of_line);
+  return (js_value*)js_gc_payload(out_of_line) + (slot - inobject);
+}
+
+// Returns the slot of {key} in {shape}, or -1.
+int32_t js_shape_lookup(js_shape* shape, const char* key);
+// The keys of {shape} in the order they were added, which is the order of
+// their slots. Computed once per shape, for for-in loops.
+const char** js_shape_keys(js_shape* shape);
+
+js_value js_load_named_miss(js_value object, js_ic* ic);
+js_value js_store_named_miss(js_value object, js_value value, js_ic* ic);
+
+static inline js_value js_load_named(js_value object, js_ic* ic) {
+  if (js_is_object(object)) {
+    js_object* receiver = js_object_value(object);
+    uint8_t count = ic->state == JS_IC_MEGAMORPHIC ? 0 : ic->state;
+    for (uint8_t i = 0; i < count; i++) {
+      if (ic->shapes[i] == receiver->shape) {
+        return *js_object_slot(receiver, ic->slots[i]);
+      }
+    }
+  }
+  return js_load_named_miss(object, ic);
+}
+
+// Returns {value}, like the assignment expression.
+static inline js_value js_store_named(js_value object, js_value value,
+                                      js_ic* ic) {
+  if (js_is_object(object)) {
+    js_object* receiver = js_object_value(object);
+    uint8_t count = ic->state == JS_IC_MEGAMORPHIC ? 0 : ic->state;
+    for (uint8_t i = 0; i < count; i++) {
+      if (ic->shapes[i] != receiver->shape) continue;
+      js_shape* transition = ic->transitions[i];
+      if (transition != NULL) {
+        // A transition only hits while the slot is already allocated.
+        if (ic->slots[i] >= transition->inobject_capacity +
+                                receiver->out_of_line_capacity) {
+          break;
+        }
+        receiver->shape = transition;
+      }
+      *js_object_slot(receiver, ic->slots[i]) = value;
+      return value;
+    }
+  }
+  return js_store_named_miss(object, value, ic);
+}
+
+// Accesses with a computed key.
+js_value js_get_property(js_value object, js_value key);
+js_value js_set_property(js_value object, js_value key, js_value value);
+
+#endif
@@ -0,0 +1,294 @@
+#include "js2c.h"
+
+static bool tracers_registered;
+
+// The one-character ASCII strings, filled in as they are used.
+static char one_char_strings[128][2];
+
+static void fatal(const char* message) {
+  fprintf(stderr, "js2c: %s\n", message);
+  abort();
+}
+
+static void trace_cons_string(js_gc_header* header, js_gc_visitor visit) {
+  js_cons_string* cons = (js_cons_string*)js_gc_payload(header);
+  visit(&cons->first);
+  visit(&cons->second);
+}
+
+static void trace_sliced_string(js_gc_header* header, js_gc_visitor visit) {
+  visit(&((js_sliced_string*)js_gc_payload(header))->parent);
+}
+
+static js_gc_header* alloc_indirect(size_t size, uint8_t kind) {
+  if (!tracers_registered) {
+    js_gc_set_tracer(JS_GC_KIND_CONS_STRING, trace_cons_string);
+    js_gc_set_tracer(JS_GC_KIND_SLICED_STRING, trace_sliced_string);
+    tracers_registered = true;
+  }
+  return js_gc_alloc(size, kind);
+}
+
+static void check_string(js_value value, const char* builtin) {
+  if (!js_is_string(value)) {
+    fprintf(stderr, "js2c: %s called on a non-string\n", builtin);
+    abort();
+  }
+}
+
+// A sequential string of {length} characters for the caller to fill in.
+// The allocation is zeroed, so the NUL is already there.
+static js_value new_sequential(size_t length, char** chars) {
+  if (length > INT32_MAX) fatal("string too long");
+  js_gc_header* string = js_gc_alloc(length + 1, JS_GC_KIND_STRING);
+  *chars = (char*)js_gc_payload(string);
+  return make_heap_string(string);
+}
+
+static js_value copy_chars(const char* chars, int32_t length) {
+  char* result_chars;
+  js_value result = new_sequential((size_t)length, &result_chars);
+  memcpy(result_chars, chars, (size_t)length);
+  return result;
+}
+
+static uint32_t depth_of(js_value string) {
+  if (js_is_static_value(string) ||
+      ((js_gc_header*)js_heap_pointer(string))->kind !=
+          JS_GC_KIND_CONS_STRING) {
+    return 0;
+  }
+  return js_cons_string_value(string)->depth;
+}
+
+// Copies the characters of {string} to {dest} without flattening it. Cons
+// strings built by appending are deep on the left, so the loop walks down
+// the first parts and only the second parts recurse.
+static void write_chars(js_value string, char* dest) {
+  while (js_is_indirect_string(string)) {
+    js_gc_header* header = (js_gc_header*)js_heap_pointer(string);
+    if (header->kind == JS_GC_KIND_SLICED_STRING) {
+      js_sliced_string* slice = js_sliced_string_value(string);
+      memcpy(dest, js_string_value(slice->parent) + slice->offset,
+             slice->length);
+      return;
+    }
+    js_cons_string* cons = js_cons_string_value(string);
+    write_chars(cons->second, dest + js_string_length(cons->first));
+    string = cons->first;
+  }
+  memcpy(dest, js_string_value(string), (size_t)js_string_length(string));
+}
+
+const char* js_string_flatten(js_value value) {
+  js_gc_header* header = (js_gc_header*)js_heap_pointer(value);
+  js_cons_string* cons = NULL;
+  js_sliced_string* slice = NULL;
+  if (header->kind == JS_GC_KIND_CONS_STRING) {
+    cons = js_cons_string_value(value);
+    if (js_string_length(cons->second) == 0) {
+      return js_string_value(cons->first);
+    }
+  } else {
+    slice = js_sliced_string_value(value);
+    if (slice->is_suffix) {
+      return js_string_value(slice->parent) + slice->offset;
+    }
+  }
+  // A string in the collected heap keeps its flat copy, which therefore
+  // goes to the collected heap as well, even inside an arena scope. There it
+  // is allocated without collecting, since {value} may be reachable only
+  // from arena objects, which are not traced. A string in the scratch arena
+  // is copied again on every access.
+  bool keep = !(header->flags & JS_GC_FLAG_ARENA);
+  size_t length = (size_t)js_string_length(value);
+  char* chars;
+  js_value flat;
+  if (keep) {
+    js_gc_header* string = js_gc_alloc_in_heap(length + 1, JS_GC_KIND_STRING);
+    chars = (char*)js_gc_payload(string);
+    flat = make_heap_string(string);
+  } else {
+    flat = new_sequential(length, &chars);
+  }
+  write_chars(value, chars);
+  if (keep && cons != NULL) {
+    cons->first = flat;
+    cons->second = make_string("");
+  } else if (keep) {
+    slice->parent = flat;
+    slice->offset = 0;
+    slice->is_suffix = true;
+  }
+  return chars;
+}
+
+js_value js_to_string(js_value value) {
+  if (js_is_string(value)) return value;
+  char buffer[32];
+  const char* string = js_to_cstring(value, buffer, sizeof(buffer));
+  return copy_chars(string, (int32_t)strlen(string));
+}
+
+js_value js_string_add(js_value left, js_value right) {
+  size_t left_length = (size_t)js_string_length(left);
+  size_t right_length = (size_t)js_string_length(right);
+  if (left_length == 0) return right;
+  if (right_length == 0) return left;
+  size_t length = left_length + right_length;
+  uint32_t depth = depth_of(left) > depth_of(right) ? depth_of(left)
+                                                    : depth_of(right);
+  depth++;
+  if (length < JS_STRING_MIN_INDIRECT_LENGTH || depth > JS_STRING_MAX_DEPTH) {
+    char* chars;
+    js_value result = new_sequential(length, &chars);
+    write_chars(left, chars);
+    write_chars(right, chars + left_length);
+    return result;
+  }
+  if (length > INT32_MAX) fatal("string too long");
+  js_gc_header* header =
+      alloc_indirect(sizeof(js_cons_string), JS_GC_KIND_CONS_STRING);
+  js_cons_string* cons = (js_cons_string*)js_gc_payload(header);
+  cons->first = left;
+  cons->second = right;
+  cons->length = (uint32_t)length;
+  cons->depth = depth;
+  return make_heap_string(header);
+}
+
+static size_t part_length(js_value part) {
+  if (js_is_string(part)) return (size_t)js_string_length(part);
+  char buffer[32];
+  return strlen(js_to_cstring(part, buffer, sizeof(buffer)));
+}
+
+static js_value build(int32_t count, const js_value* parts, size_t length) {
+  char* chars;
+  js_value result = new_sequential(length, &chars);
+  for (int32_t i = 0; i < count; i++) {
+    if (js_is_string(parts[i])) {
+      write_chars(parts[i], chars);
+      chars += js_string_length(parts[i]);
+    } else {
+      char buffer[32];
+      const char* string = js_to_cstring(parts[i], buffer, sizeof(buffer));
+      size_t part_length = strlen(string);
+      memcpy(chars, string, part_length);
+      chars += part_length;
+    }
+  }
+  return result;
+}
+
+js_value js_string_concat(int32_t count, const js_value* parts) {
+  if (count == 1 && js_is_string(parts[0])) return parts[0];
+  if (count == 2 && js_is_string(parts[0]) && js_is_string(parts[1])) {
+    return js_string_add(parts[0], parts[1]);
+  }
+  size_t rest_length = 0;
+  for (int32_t i = 1; i < count; i++) rest_length += part_length(parts[i]);
+  // A long first part, typically what a loop accumulates into, is not
+  // copied; the rest is built on its own and appended as a cons string.
+  js_value first = parts[0];
+  if (count > 1 && js_is_string(first) && rest_length > 0 &&
+      (js_is_indirect_string(first) ||
+       js_string_length(first) >= JS_STRING_MIN_INDIRECT_LENGTH)) {
+    return js_string_add(first, build(count - 1, parts + 1, rest_length));
+  }
+  return build(count, parts, part_length(first) + rest_length);
+}
+
+// ToIntegerOrInfinity clamped to [0, length].
+static int32_t clamp_index(js_value index, int32_t length) {
+  double value = js_to_number(index);
+  if (isnan(value) || value <= 0) return 0;
+  return value >= length ? length : (int32_t)value;
+}
+
+// The substring of {string} of {length} characters at {offset}, which is
+// neither empty nor the whole string.
+static js_value substring(js_value string, int32_t offset, int32_t length) {
+  if (length < JS_STRING_MIN_INDIRECT_LENGTH) {
+    return copy_chars(js_string_value(string) + offset, length);
+  }
+  // The parent of a slice is always flat: slices of slices share the
+  // parent, and cons strings are flattened first.
+  js_value parent = string;
+  if (js_is_indirect_string(string)) {
+    js_gc_header* header = (js_gc_header*)js_heap_pointer(string);
+    if (header->kind == JS_GC_KIND_SLICED_STRING) {
+      js_sliced_string* slice = js_sliced_string_value(string);
+      parent = slice->parent;
+      offset += (int32_t)slice->offset;
+    } else {
+      const char* chars = js_string_value(string);
+      js_cons_string* cons = js_cons_string_value(string);
+      // A string in the scratch arena does not keep its flat copy, so there
+      // is nothing to slice.
+      if (js_string_length(cons->second) != 0) {
+        return copy_chars(chars + offset, length);
+      }
+      parent = cons->first;
+    }
+  }
+  js_gc_header* header =
+      alloc_indirect(sizeof(js_sliced_string), JS_GC_KIND_SLICED_STRING);
+  js_sliced_string* slice = (js_sliced_string*)js_gc_payload(header);
+  slice->parent = parent;
+  slice->offset = (uint32_t)offset;
+  slice->length = (uint32_t)length;
+  slice->is_suffix = offset + length == js_string_length(parent);
+  return make_heap_string(header);
+}
+
+js_value js_string_substring(js_value string, js_value start, js_value end) {
+  check_string(string, "String.prototype.substring");
+  int32_t length = js_string_length(string);
+  int32_t from = clamp_index(start, length);
+  int32_t to = js_is_undefined(end) ? length : clamp_index(end, length);
+  if (from > to) {
+    int32_t swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from == to) return make_string("");
+  if (from == 0 && to == length) return string;
+  return substring(string, from, to - from);
+}
+
+// Like string[index], this reads the whole UTF-8 character at a byte index,
+// not a UTF-16 code unit; see js_string_get_char.
+js_value js_string_char_at(js_value string, js_value index) {
+  check_string(string, "String.prototype.charAt");
+  double position = js_to_number(index);
+  if (isnan(position)) position = 0;
+  position = trunc(position);
+  if (position < 0 || position >= js_string_length(string)) {
+    return make_string("");
+  }
+  return js_string_get_char(string, (int32_t)position);
+}
+
+int32_t js_utf8_sequence_length(unsigned char lead) {
+  if (lead < 0xC0) return 1;
+  if (lead < 0xE0) return 2;
+  if (lead < 0xF0) return 3;
+  return 4;
+}
+
+js_value js_string_get_char(js_value string, int32_t index) {
+  int32_t length = js_string_length(string);
+  if (index < 0 || index >= length) return make_undefined();
+  unsigned char c = (unsigned char)js_string_value(string)[index];
+  if (c < 0x80) {
+    one_char_strings[c][0] = (char)c;
+    return make_string(one_char_strings[c]);
+  }
+  // The rest of a character that starts at an earlier index.
+  if (c < 0xC0) return make_string("");
+  int32_t size = js_utf8_sequence_length(c);
+  if (size > length - index) size = length - index;
+  if (size == length) return string;
+  return substring(string, index, size);
+}
@@ -0,0 +1,96 @@
+#ifndef JS2C_STRING_H_
+#define JS2C_STRING_H_
+
+// Heap strings. Included from js2c.h after js2c_gc.h.
+//
+// Like V8's String, a heap string is one of:
+//  - sequential (JS_GC_KIND_STRING): the NUL-terminated characters follow
+//    the header, and the allocation is exactly their length plus one,
+//  - cons (JS_GC_KIND_CONS_STRING): the concatenation of two strings, built
+//    by js_add without copying either,
+//  - sliced (JS_GC_KIND_SLICED_STRING): a substring of a flat string.
+// Cons and sliced strings are indirect. They are only made when the result
+// is at least JS_STRING_MIN_INDIRECT_LENGTH long; shorter ones are copied.
+//
+// Indirect strings are flattened lazily, the first time their characters
+// are needed: js_string_value copies them into a sequential string and
+// caches it. A flattened cons string has the flat copy as its first part and
+// the empty string as its second; a flattened sliced string has it as its
+// parent. A concatenation that would be deeper than JS_STRING_MAX_DEPTH is
+// copied instead, so that flattening never recurses further.
+//
+// Lengths and indices count bytes of the UTF-8 encoding, where JavaScript
+// counts UTF-16 code units. They agree on ASCII. Reading a character by
+// index never splits a UTF-8 sequence: the index of its first byte reads the
+// whole character and the indices of the others read the empty string, so
+// every index still reads something and the reads concatenate back to the
+// string.
+
+#define JS_STRING_MIN_INDIRECT_LENGTH 13
+#define JS_STRING_MAX_DEPTH 256
+
+typedef struct js_cons_string {
+  js_value first;
+  js_value second;
+  uint32_t length;
+  uint32_t depth;  // 1 + the depth of the deeper part; flat strings are 0
+} js_cons_string;
+
+typedef struct js_sliced_string {
+  js_value parent;  // a flat string
+  uint32_t offset;
+  uint32_t length;
+  // The slice ends where its parent does, so its characters are already
+  // NUL-terminated in place.
+  bool is_suffix;
+} js_sliced_string;
+
+static inline bool js_is_indirect_string(js_value value) {
+  if (js_is_static_value(value)) return false;
+  uint8_t kind = ((js_gc_header*)js_heap_pointer(value))->kind;
+  return kind == JS_GC_KIND_CONS_STRING || kind == JS_GC_KIND_SLICED_STRING;
+}
+
+static inline js_cons_string* js_cons_string_value(js_value value) {
+  return (js_cons_string*)js_gc_payload(
+      (js_gc_header*)js_heap_pointer(value));
+}
+
+static inline js_sliced_string* js_sliced_string_value(js_value value) {
+  return (js_sliced_string*)js_gc_payload(
+      (js_gc_header*)js_heap_pointer(value));
+}
+
+// Returns the NUL-terminated characters of an indirect string, flattening it
+// if it has not been yet. Allocates.
+const char* js_string_flatten(js_value value);
+
+// The string conversion of {value} as a string value, which is {value}
+// itself for strings. Allocates for anything else.
+js_value js_to_string(js_value value);
+
+// left + right for two string values.
+js_value js_string_add(js_value left, js_value right);
+
+// The string conversions of {parts} concatenated with a single allocation
+// of the final size. Emitted for chains of + that produce a string and for
+// template literals.
+js_value js_string_concat(int32_t count, const js_value* parts);
+
+// The translator calls these two on strings only, and the method of any
+// other receiver instead.
+
+// string.substring(start[, end]); {end} is undefined if omitted.
+js_value js_string_substring(js_value string, js_value start, js_value end);
+// string.charAt(index)
+js_value js_string_char_at(js_value string, js_value index);
+// string[index], undefined if {index} is out of range. Reads the character
+// whose UTF-8 sequence starts at byte {index}, or the empty string inside
+// one.
+js_value js_string_get_char(js_value string, int32_t index);
+
+// The number of bytes of the UTF-8 sequence that starts with {lead}, 1 for
+// ASCII and for continuation bytes.
+int32_t js_utf8_sequence_length(unsigned char lead);
+
+#endif
@@ -3,4 +3,211 @@ function add(x, y) {
 }
 
 add(100, 4);
-add(1, 2)
+add(1, 2);
+
+// Every check below that fails adds one, so the program prints 0.
+var failures = 0;
+
+// Int32 arithmetic that overflows moves to doubles, and -0 is kept.
+function multiply(x, y) {
+  return x * y;
+}
+
+function negate(x) {
+  return -x;
+}
+
+function remainder(x, y) {
+  return x % y;
+}
+
+if (add(2147483647, 1) !== 2147483648) failures++;
+if (multiply(65536, 65536) !== 4294967296) failures++;
+if (negate(-2147483648) !== 2147483648) failures++;
+if (1 / negate(0) > 0) failures++;
+if (1 / multiply(0, -5) > 0) failures++;
+if (1 / remainder(-4, 2) > 0) failures++;
+if (remainder(7, 3) !== 1) failures++;
+
+// The break runs the finally block first, so x is a string at the return.
+function breakThroughFinally() {
+  var x = 1;
+  for (;;) {
+    try {
+      break;
+    } finally {
+      x = "s";
+    }
+  }
+  return x;
+}
+
+if (breakThroughFinally() !== "s") failures++;
+
+function tryCatchFinally(n) {
+  var log = 0;
+  try {
+    if (n > 1) throw n;
+    log = log + 1;
+  } catch (e) {
+    log = log + e * 10;
+  } finally {
+    log = log + 100;
+  }
+  return log;
+}
+
+function finallyOverridesReturn() {
+  try {
+    return 1;
+  } finally {
+    return 2;
+  }
+}
+
+if (tryCatchFinally(1) !== 101) failures++;
+if (tryCatchFinally(5) !== 150) failures++;
+if (finallyOverridesReturn() !== 2) failures++;
+
+function* count(limit) {
+  for (var i = 0; i < limit; i++) yield i;
+}
+
+function sumGenerated(limit) {
+  var sum = 0;
+  var generator = count(limit);
+  var step = generator.next();
+  while (!step.done) {
+    sum = sum + step.value;
+    step = generator.next();
+  }
+  return sum;
+}
+
+if (sumGenerated(5) !== 10) failures++;
+
+function classify(n) {
+  switch (n) {
+    case 0:
+      return 10;
+    case 1:
+    case 2:
+      return 20;
+    default:
+      return 30;
+  }
+}
+
+if (classify(0) + classify(2) + classify(7) !== 60) failures++;
+
+function sumOf(array) {
+  var sum = 0;
+  for (var x of array) sum = sum + x;
+  return sum;
+}
+
+function countKeys(object) {
+  var keys = 0;
+  for (var key in object) keys++;
+  return keys;
+}
+
+if (sumOf([1, 2, 3, 4]) !== 10) failures++;
+if (countKeys({a: 1, b: 2, c: 3}) !== 3) failures++;
+
+// Folds to `return 100`; the branch is removed.
+function folded() {
+  var x = 2 * 3 + 4;
+  if (false) return 0;
+  return x * x;
+}
+
+if (folded() !== 100) failures++;
+
+// Indexing reads a non-ASCII character whole, as for-of does.
+function joinCharacters(string) {
+  var joined = "";
+  for (var c of string) joined = joined + c + ",";
+  return joined;
+}
+
+if ("aé"[1] !== "é") failures++;
+if (joinCharacters("aé") !== "a,é,") failures++;
+
+// String methods are only lowered to the builtins for strings.
+function charAtObject() {
+  var text = {charAt: function(index) { return index * 2; }};
+  return text.charAt(3);
+}
+
+if (charAtObject() !== 6) failures++;
+if ("hello".substring(1, 3) !== "el") failures++;
+
+// Array methods are only lowered to the builtins for arrays.
+function fillObject() {
+  var filler = {fill: function(value) { return value + 1; }};
+  return filler.fill(1);
+}
+
+if (fillObject() !== 2) failures++;
+if ("a1".indexOf(1) !== 1) failures++;
+if ([1, 2, 3].map(function(x) { return x * 2; })[2] !== 6) failures++;
+if ([0, 1].indexOf(-0) !== 0) failures++;
+
+// Range analysis keeps the bounded sum on int32; the product overflows it
+// and moves to doubles.
+function boundedSum() {
+  var sum = 0;
+  for (var i = 0; i < 100; i++) sum = sum + i;
+  return sum;
+}
+
+function growingProduct() {
+  var product = 1;
+  for (var i = 0; i < 40; i++) product = product * 2;
+  return product;
+}
+
+if (boundedSum() !== 4950) failures++;
+if (growingProduct() !== 1099511627776) failures++;
+
+// Counted loops over arrays run a version for the elements kind of the
+// arrays they index, or the loop as written when they share none.
+function sumElements(a) {
+  var sum = 0;
+  for (var i = 0; i < a.length; i++) sum = sum + a[i];
+  return sum;
+}
+
+function dot(a, b) {
+  var sum = 0;
+  for (var i = 0; i < a.length; i++) sum = sum + a[i] * b[i];
+  return sum;
+}
+
+if (sumElements([1, 2, 3]) !== 6) failures++;
+if (sumElements([0.5, 1.5]) !== 2) failures++;
+if (sumElements([1, "2"]) !== "12") failures++;
+if (dot([1, 2], [0.5, 1.5]) !== 3.5) failures++;
+
+// Nothing pairHolds allocates escapes it and it returns a boolean, so its
+// calls run in an arena scope. The argument array is allocated before the
+// scope, since the caller keeps it.
+function pairHolds(x, y) {
+  var pair = [x, y];
+  return pair[0] === x && pair[1] === y;
+}
+
+function countPairs(n) {
+  var count = 0;
+  for (var i = 0; i < n; i++) {
+    if (pairHolds(i, i + 1)) count++;
+  }
+  return count;
+}
+
+var kept;
+if (countPairs(1000) !== 1000) failures++;
+if (!pairHolds(1, kept = [2]) || kept[0] !== 2) failures++;
+
+failures;
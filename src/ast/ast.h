@@ -451,6 +451,7 @@ class DoWhileStatement final : public IterationStatement {
   }
 
   Expression* cond() const { return cond_; }
+  void set_cond(Expression* e) { cond_ = e; }
 
  private:
   friend class AstNodeFactory;
@@ -471,6 +472,7 @@ class WhileStatement final : public IterationStatement {
   }
 
   Expression* cond() const { return cond_; }
+  void set_cond(Expression* e) { cond_ = e; }
 
  private:
   friend class AstNodeFactory;
@@ -497,6 +499,8 @@ class ForStatement final : public IterationStatement {
   Expression* cond() const { return cond_; }
   Statement* next() const { return next_; }
 
+  void set_cond(Expression* e) { cond_ = e; }
+
  private:
   friend class AstNodeFactory;
   friend Zone;
@@ -625,6 +629,7 @@ class ReturnStatement final : public JumpStatement {
  public:
   enum Type { kNormal, kAsyncReturn, kSyntheticAsyncReturn };
   Expression* expression() const { return expression_; }
+  void set_expression(Expression* e) { expression_ = e; }
 
   Type type() const { return TypeField::decode(bit_field_); }
   bool is_async_return() const { return type() != kNormal; }
@@ -734,6 +739,7 @@ class IfStatement final : public Statement {
   Statement* then_statement() const { return then_statement_; }
   Statement* else_statement() const { return else_statement_; }
 
+  void set_condition(Expression* e) { condition_ = e; }
   void set_then_statement(Statement* s) { then_statement_ = s; }
   void set_else_statement(Statement* s) { else_statement_ = s; }
 
@@ -1834,6 +1840,7 @@ class UnaryOperation final : public Expression {
  public:
   Token::Value op() const { return OperatorField::decode(bit_field_); }
   Expression* expression() const { return expression_; }
+  void set_expression(Expression* e) { expression_ = e; }
 
  private:
   friend class AstNodeFactory;
@@ -1856,6 +1863,8 @@ class BinaryOperation final : public Expression {
   Token::Value op() const { return OperatorField::decode(bit_field_); }
   Expression* left() const { return left_; }
   Expression* right() const { return right_; }
+  void set_left(Expression* e) { left_ = e; }
+  void set_right(Expression* e) { right_ = e; }
 
   // Returns true if one side is a Smi literal, returning the other side's
   // sub-expression in |subexpr| and the literal Smi in |literal|.
@@ -1884,6 +1893,10 @@ class NaryOperation final : public Expression {
   Expression* subsequent(size_t index) const {
     return subsequent_[index].expression;
   }
+  void set_first(Expression* e) { first_ = e; }
+  void set_subsequent(size_t index, Expression* e) {
+    subsequent_[index].expression = e;
+  }
 
   size_t subsequent_length() const { return subsequent_.size(); }
   int subsequent_op_position(size_t index) const {
@@ -1967,6 +1980,8 @@ class CompareOperation final : public Expression {
   Token::Value op() const { return OperatorField::decode(bit_field_); }
   Expression* left() const { return left_; }
   Expression* right() const { return right_; }
+  void set_left(Expression* e) { left_ = e; }
+  void set_right(Expression* e) { right_ = e; }
 
   // Match special cases.
   bool IsLiteralCompareTypeof(Expression** expr, Literal** literal);
@@ -2017,6 +2032,10 @@ class Conditional final : public Expression {
   Expression* then_expression() const { return then_expression_; }
   Expression* else_expression() const { return else_expression_; }
 
+  void set_condition(Expression* e) { condition_ = e; }
+  void set_then_expression(Expression* e) { then_expression_ = e; }
+  void set_else_expression(Expression* e) { else_expression_ = e; }
+
  private:
   friend class AstNodeFactory;
   friend Zone;
@@ -2038,6 +2057,7 @@ class Assignment : public Expression {
   Token::Value op() const { return TokenField::decode(bit_field_); }
   Expression* target() const { return target_; }
   Expression* value() const { return value_; }
+  void set_value(Expression* e) { value_ = e; }
 
   // The assignment was generated as part of block-scoped sloppy-mode
   // function hoisting, see
@@ -55,6 +55,7 @@
 #include "src/heap/parked-scope.h"
 #include "src/init/v8.h"
 #include "src/interpreter/interpreter.h"
+#include "src/js2c/type-feedback.h"
 #include "src/logging/counters.h"
 #include "src/logging/log-file.h"
 #include "src/objects/managed-inl.h"
@@ -5168,6 +5169,10 @@ int Shell::RunMain(Isolate* isolate, bool last_run) {
       if (!CompleteMessageLoop(isolate)) success = false;
     }
     WriteLcovData(isolate, options.lcov_file);
+    if (last_run && i::v8_flags.js2c_feedback_dump != nullptr) {
+      i::DumpTypeFeedback(reinterpret_cast<i::Isolate*>(isolate),
+                          i::v8_flags.js2c_feedback_dump);
+    }
     if (last_run && i::v8_flags.stress_snapshot) {
       static constexpr bool kClearRecompilableData = true;
       i::Isolate* i_isolate = reinterpret_cast<i::Isolate*>(isolate);
@@ -2381,6 +2381,33 @@ DEFINE_BOOL(experimental_web_snapshots, false, "enable Web Snapshots")
 DEFINE_NEG_IMPLICATION(experimental_web_snapshots, script_streaming)
 
 DEFINE_BOOL(js2c, false, "enable js2c")
+DEFINE_STRING(js2c_feedback_dump, nullptr,
+              "write the type feedback of the user scripts to this file when "
+              "d8 is done, for use with --js2c-feedback")
+DEFINE_STRING(js2c_feedback, nullptr,
+              "emit speculative fast paths in v8_js2c from the type feedback "
+              "in this file")
+DEFINE_STRING(js2c_cache, nullptr,
+              "reuse the C code of unchanged functions from this directory "
+              "in v8_js2c")
+DEFINE_BOOL(js2c_parallel, true,
+            "print the C functions of a script on the worker threads of the "
+            "platform in v8_js2c")
+DEFINE_BOOL(js2c_batch, false,
+            "translate every file on the v8_js2c command line to "
+            "<file without extension>.h and .c")
+DEFINE_BOOL(js2c_server, false,
+            "translate the files named on the lines of stdin in v8_js2c, "
+            "answering each with a line on stdout")
+DEFINE_INT(js2c_jobs, 1,
+           "number of isolates that translate files in parallel in "
+           "--js2c-batch and --js2c-server mode")
+DEFINE_BOOL(js2c_range_stats, false,
+            "report how many Smi operations range analysis kept on int32 "
+            "in v8_js2c")
+DEFINE_BOOL(js2c_startup_stats, false,
+            "report how long v8_js2c takes to start up and to translate "
+            "each file")
 
 #if defined(V8_USE_LIBM_TRIG_FUNCTIONS)
 DEFINE_BOOL(use_libm_trig_functions, true, "use libm trig functions")
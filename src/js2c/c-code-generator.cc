@@ -1,11 +1,16 @@
 #include "src/js2c/c-code-generator.h"
 
 #include <stdarg.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cmath>
+
+#include "src/ast/ast-traversal-visitor.h"
 #include "src/ast/ast-value-factory.h"
 #include "src/ast/scopes.h"
 #include "src/base/strings.h"
@@ -18,40 +23,606 @@
 namespace v8 {
 namespace internal {
 
-void CCodeGenerator::Init() {
-  if (size_ == 0) {
-    DCHECK_NULL(output_);
-    const int initial_size = 256;
-    output_ = NewArray<char>(initial_size);
-    size_ = initial_size;
+namespace {
+
+// The C representation of a value of {type}; anything that is not a raw
+// number or boolean is a NaN-boxed js_value.
+InferredType CRepresentation(InferredType type) {
+  return IsUnboxedType(type) ? type : InferredType::kDynamic;
+}
+
+bool IsLogicalOp(Token::Value op) {
+  return op == Token::OR || op == Token::AND || op == Token::NULLISH;
+}
+
+// How a binary operation is spelled in C. The operands are converted to
+// {left} and {right} (kNone leaves an operand as it is) and the whole
+// expression produces a value in the representation {result}.
+struct CBinaryOperation {
+  InferredType left;
+  InferredType right;
+  InferredType result;
+  const char* prefix;
+  const char* infix;
+  const char* suffix;
+};
+
+// Smi addition, subtraction, multiplication and remainder are only typed
+// kSmi where RangeAnalysis proved that they stay in int32 without -0, so
+// they are plain C arithmetic.
+CBinaryOperation GetCBinaryOperation(Token::Value op, InferredType type) {
+  const InferredType kNone = InferredType::kNone;
+  const InferredType kSmi = InferredType::kSmi;
+  const InferredType kDouble = InferredType::kDouble;
+  const InferredType kDynamic = InferredType::kDynamic;
+  switch (op) {
+    case Token::COMMA:
+      return {kNone, type, type, "(", ", ", ")"};
+    case Token::ADD:
+      if (type == kSmi) return {kSmi, kSmi, kSmi, "(", " + ", ")"};
+      if (type == kDouble) return {kDouble, kDouble, kDouble, "(", " + ", ")"};
+      return {kDynamic, kDynamic, kDynamic, "js_add(", ", ", ")"};
+    case Token::SUB:
+      if (type == kSmi) return {kSmi, kSmi, kSmi, "(", " - ", ")"};
+      return {kDouble, kDouble, kDouble, "(", " - ", ")"};
+    case Token::MUL:
+      if (type == kSmi) return {kSmi, kSmi, kSmi, "(", " * ", ")"};
+      return {kDouble, kDouble, kDouble, "(", " * ", ")"};
+    case Token::DIV:
+      return {kDouble, kDouble, kDouble, "(", " / ", ")"};
+    case Token::MOD:
+      // Only emitted on int32 when the divisor is a positive constant.
+      if (type == kSmi) return {kSmi, kSmi, kSmi, "(", " % ", ")"};
+      return {kDouble, kDouble, kDouble, "fmod(", ", ", ")"};
+    case Token::EXP:
+      return {kDouble, kDouble, kDouble, "pow(", ", ", ")"};
+    case Token::BIT_OR:
+      return {kSmi, kSmi, kSmi, "(", " | ", ")"};
+    case Token::BIT_XOR:
+      return {kSmi, kSmi, kSmi, "(", " ^ ", ")"};
+    case Token::BIT_AND:
+      return {kSmi, kSmi, kSmi, "(", " & ", ")"};
+    case Token::SHL:
+      return {kSmi, kSmi, kSmi, "((int32_t)((uint32_t)", " << (", " & 31)))"};
+    case Token::SAR:
+      return {kSmi, kSmi, kSmi, "(", " >> (", " & 31))"};
+    case Token::SHR:
+      return {kSmi, kSmi, kDouble, "((double)((uint32_t)", " >> (",
+              " & 31)))"};
+    default:
+      UNREACHABLE();
   }
-  output_[0] = '\0';
-  pos_ = 0;
 }
 
-void CCodeGenerator::Print(const char* format, ...) {
-  for (;;) {
-    va_list arguments;
-    va_start(arguments, format);
-    int n = base::VSNPrintF(base::Vector<char>(output_, size_) + pos_, format,
-                            arguments);
-    va_end(arguments);
-
-    if (n >= 0) {
-      // there was enough space - we are done
-      pos_ += n;
+// Returns the function a call can jump to directly, mirroring the check in
+// TypeInference::VisitCall.
+FunctionLiteral* DirectCallee(const TypeInference* types, Call* call) {
+  if (types == nullptr || call->is_possibly_eval() ||
+      call->spread_position() != Call::kNoSpread) {
+    return nullptr;
+  }
+  VariableProxy* proxy = call->expression()->AsVariableProxy();
+  if (proxy == nullptr || !proxy->is_resolved()) return nullptr;
+  FunctionLiteral* callee = types->DeclaredFunction(proxy->var());
+  if (callee == nullptr || types->TypesFor(callee) == nullptr) return nullptr;
+  return callee;
+}
+
+// The C identifier for a JavaScript name; '.' of internal names such as
+// .result becomes '_'.
+std::string CName(const AstRawString* name) {
+  std::string result;
+  const unsigned char* raw_bytes = name->raw_data();
+  const uint16_t* raw_chars = reinterpret_cast<const uint16_t*>(raw_bytes);
+  for (int i = 0; i < name->length(); i++) {
+    if (!name->is_one_byte() && raw_chars[i] >= 0x80) {
+      base::EmbeddedVector<char, 8> buf;
+      SNPrintF(buf, "_u%04x", raw_chars[i]);
+      result += buf.begin();
+      continue;
+    }
+    char c = static_cast<char>(name->is_one_byte() ? raw_bytes[i]
+                                                   : raw_chars[i]);
+    result += c == '.' ? '_' : c;
+  }
+  return result;
+}
+
+std::string CName(const AstConsString* name) {
+  std::string result;
+  if (name == nullptr) return result;
+  for (const AstRawString* part : name->ToRawStrings()) result += CName(part);
+  return result;
+}
+
+// The name of a property access that can use an inline cache, or nullptr for
+// computed keys.
+const AstRawString* NamedPropertyKey(Property* property) {
+  if (Property::GetAssignType(property) != NAMED_PROPERTY) return nullptr;
+  return property->key()->AsLiteral()->AsRawPropertyName();
+}
+
+const AstRawString* NamedPropertyKey(ObjectLiteral::Property* property) {
+  if (property->is_computed_name() || !property->key()->IsPropertyName()) {
+    return nullptr;
+  }
+  return property->key()->AsLiteral()->AsRawPropertyName();
+}
+
+// Array.prototype methods that have a runtime builtin; see js2c_array.h.
+// indexOf serves strings too, and the String.prototype methods substring
+// and charAt are lowered the same way; see js2c_string.h. So are the
+// generator methods next and throw; see js2c_generator.h.
+enum class ArrayBuiltin {
+  kNone,
+  kFill,
+  kIndexOf,
+  kMap,
+  kReduce,
+  kSubstring,
+  kCharAt,
+  kGeneratorNext,
+  kGeneratorThrow
+};
+
+// The arithmetic of a map or reduce callback whose body is a single
+// `return x op c` for map, where c is a literal, or `return acc op x` for
+// reduce. Other callbacks need closures and are called normally.
+struct ArrayOpCallback {
+  const char* op = nullptr;  // a js_array_op
+  Literal* operand = nullptr;
+  bool swapped = false;  // operand_first or element_first
+};
+
+bool MatchArrayOpCallback(const TypeInference* types, Expression* callback,
+                          int parameter_count, ArrayOpCallback* result) {
+  FunctionLiteral* function = callback->AsFunctionLiteral();
+  VariableProxy* proxy = callback->AsVariableProxy();
+  if (proxy != nullptr && proxy->is_resolved() && types != nullptr) {
+    function = types->DeclaredFunction(proxy->var());
+  }
+  if (function == nullptr || function->body()->length() != 1 ||
+      function->scope()->num_parameters() != parameter_count) {
+    return false;
+  }
+  ReturnStatement* statement = function->body()->at(0)->AsReturnStatement();
+  BinaryOperation* operation =
+      statement != nullptr ? statement->expression()->AsBinaryOperation()
+                           : nullptr;
+  if (operation == nullptr) return false;
+  switch (operation->op()) {
+    case Token::ADD:
+      result->op = "JS_ARRAY_OP_ADD";
+      break;
+    case Token::SUB:
+      result->op = "JS_ARRAY_OP_SUB";
+      break;
+    case Token::MUL:
+      result->op = "JS_ARRAY_OP_MUL";
+      break;
+    case Token::DIV:
+      result->op = "JS_ARRAY_OP_DIV";
+      break;
+    default:
+      return false;
+  }
+  auto is_parameter = [&](Expression* expr, int index) {
+    VariableProxy* parameter = expr->AsVariableProxy();
+    return parameter != nullptr && parameter->is_resolved() &&
+           parameter->var() == function->scope()->parameter(index);
+  };
+  Expression* left = operation->left();
+  Expression* right = operation->right();
+  if (parameter_count == 1) {
+    result->swapped = !is_parameter(left, 0);
+    result->operand = (result->swapped ? left : right)->AsLiteral();
+    return result->operand != nullptr &&
+           is_parameter(result->swapped ? right : left, 0);
+  }
+  result->swapped = is_parameter(left, 1);
+  return result->swapped ? is_parameter(right, 0)
+                         : is_parameter(left, 0) && is_parameter(right, 1);
+}
+
+// Returns the builtin {call} is lowered to, matching its callback into
+// {callback} for map and reduce.
+ArrayBuiltin LowerableArrayBuiltin(const TypeInference* types, Call* call,
+                                   ArrayOpCallback* callback) {
+  Property* property = call->expression()->AsProperty();
+  if (property == nullptr || call->spread_position() != Call::kNoSpread) {
+    return ArrayBuiltin::kNone;
+  }
+  const AstRawString* name = NamedPropertyKey(property);
+  const ZonePtrList<Expression>* arguments = call->arguments();
+  if (name == nullptr) return ArrayBuiltin::kNone;
+  if (name->IsOneByteEqualTo("fill") && arguments->length() == 1) {
+    return ArrayBuiltin::kFill;
+  }
+  if (name->IsOneByteEqualTo("indexOf") && arguments->length() == 1) {
+    return ArrayBuiltin::kIndexOf;
+  }
+  if (name->IsOneByteEqualTo("map") && arguments->length() == 1 &&
+      MatchArrayOpCallback(types, arguments->at(0), 1, callback)) {
+    return ArrayBuiltin::kMap;
+  }
+  if (name->IsOneByteEqualTo("reduce") &&
+      (arguments->length() == 1 || arguments->length() == 2) &&
+      MatchArrayOpCallback(types, arguments->at(0), 2, callback)) {
+    return ArrayBuiltin::kReduce;
+  }
+  if (name->IsOneByteEqualTo("substring") &&
+      (arguments->length() == 1 || arguments->length() == 2)) {
+    return ArrayBuiltin::kSubstring;
+  }
+  if (name->IsOneByteEqualTo("charAt") && arguments->length() == 1) {
+    return ArrayBuiltin::kCharAt;
+  }
+  if (name->IsOneByteEqualTo("next") && arguments->length() <= 1) {
+    return ArrayBuiltin::kGeneratorNext;
+  }
+  if (name->IsOneByteEqualTo("throw") && arguments->length() == 1) {
+    return ArrayBuiltin::kGeneratorThrow;
+  }
+  return ArrayBuiltin::kNone;
+}
+
+struct InlineCacheSite {
+  const void* node;  // a Property or an ObjectLiteral::Property
+  bool is_store;
+  const AstRawString* name;
+};
+
+// Lists the named property accesses of a function body in the order they
+// are printed, without descending into nested functions.
+class InlineCacheCollector final
+    : public AstTraversalVisitor<InlineCacheCollector> {
+ public:
+  InlineCacheCollector(uintptr_t stack_limit, const TypeInference* types,
+                       std::vector<InlineCacheSite>* sites)
+      : AstTraversalVisitor(stack_limit), types_(types), sites_(sites) {}
+
+  void VisitFunctionLiteral(FunctionLiteral* node) {}
+
+  void VisitCall(Call* node) {
+    ArrayOpCallback callback;
+    switch (LowerableArrayBuiltin(types_, node, &callback)) {
+      case ArrayBuiltin::kNone:
+      case ArrayBuiltin::kFill:
+      case ArrayBuiltin::kIndexOf:
+      case ArrayBuiltin::kMap:
+      case ArrayBuiltin::kReduce:
+      case ArrayBuiltin::kSubstring:
+      case ArrayBuiltin::kCharAt:
+        // The method is loaded from a receiver of another type.
+        AstTraversalVisitor::VisitCall(node);
+        return;
+      default:
+        break;
+    }
+    // The generator methods are loaded by the runtime.
+    Visit(node->expression()->AsProperty()->obj());
+    for (Expression* argument : *node->arguments()) Visit(argument);
+  }
+
+  void VisitProperty(Property* node) {
+    Add(node, false, NamedPropertyKey(node));
+    AstTraversalVisitor::VisitProperty(node);
+  }
+
+  void VisitAssignment(Assignment* node) {
+    Property* property = node->target()->AsProperty();
+    if (property == nullptr) {
+      AstTraversalVisitor::VisitAssignment(node);
       return;
+    }
+    const AstRawString* name = NamedPropertyKey(property);
+    if (node->IsCompoundAssignment() ||
+        Token::IsLogicalAssignmentOp(node->op())) {
+      Add(property, false, name);
+    }
+    Add(property, true, name);
+    Visit(property->obj());
+    Visit(property->key());
+    Visit(node->value());
+  }
+
+  void VisitCompoundAssignment(CompoundAssignment* node) {
+    VisitAssignment(node);
+  }
+
+  void VisitCountOperation(CountOperation* node) {
+    Property* property = node->expression()->AsProperty();
+    if (property != nullptr) Add(property, true, NamedPropertyKey(property));
+    AstTraversalVisitor::VisitCountOperation(node);
+  }
+
+  void VisitObjectLiteral(ObjectLiteral* node) {
+    for (ObjectLiteral::Property* property : *node->properties()) {
+      Add(property, true, NamedPropertyKey(property));
+    }
+    AstTraversalVisitor::VisitObjectLiteral(node);
+  }
+
+ private:
+  void Add(const void* node, bool is_store, const AstRawString* name) {
+    if (name != nullptr) sites_->push_back({node, is_store, name});
+  }
+
+  const TypeInference* types_;
+  std::vector<InlineCacheSite>* sites_;
+};
+
+// Lists the try/finally statements of a function body, without descending
+// into nested functions, and finds whether a return leaves the try block of
+// one.
+class FinallyCollector final : public AstTraversalVisitor<FinallyCollector> {
+ public:
+  FinallyCollector(uintptr_t stack_limit,
+                   std::vector<TryFinallyStatement*>* statements)
+      : AstTraversalVisitor(stack_limit), statements_(statements) {}
+
+  bool returns_through_finally() const { return returns_through_finally_; }
+
+  void VisitFunctionLiteral(FunctionLiteral* node) {}
+
+  void VisitTryFinallyStatement(TryFinallyStatement* node) {
+    statements_->push_back(node);
+    depth_++;
+    Visit(node->try_block());
+    depth_--;
+    Visit(node->finally_block());
+  }
+
+  void VisitReturnStatement(ReturnStatement* node) {
+    if (depth_ > 0) returns_through_finally_ = true;
+    AstTraversalVisitor::VisitReturnStatement(node);
+  }
+
+ private:
+  std::vector<TryFinallyStatement*>* statements_;
+  int depth_ = 0;
+  bool returns_through_finally_ = false;
+};
+
+// Lists the for-in and for-of statements of a function body, without
+// descending into nested functions.
+class ForEachCollector final : public AstTraversalVisitor<ForEachCollector> {
+ public:
+  ForEachCollector(uintptr_t stack_limit,
+                   std::vector<ForEachStatement*>* statements)
+      : AstTraversalVisitor(stack_limit), statements_(statements) {}
+
+  void VisitFunctionLiteral(FunctionLiteral* node) {}
+
+  void VisitForInStatement(ForInStatement* node) {
+    statements_->push_back(node);
+    AstTraversalVisitor::VisitForInStatement(node);
+  }
+
+  void VisitForOfStatement(ForOfStatement* node) {
+    statements_->push_back(node);
+    AstTraversalVisitor::VisitForOfStatement(node);
+  }
+
+ private:
+  std::vector<ForEachStatement*>* statements_;
+};
+
+// Finds whether a loop body may change the length of an array: a property
+// store may, and so may any call or suspend, which runs code we do not see.
+class ArrayResizeFinder final : public AstTraversalVisitor<ArrayResizeFinder> {
+ public:
+  explicit ArrayResizeFinder(uintptr_t stack_limit)
+      : AstTraversalVisitor(stack_limit) {}
+
+  bool may_resize() const { return may_resize_; }
+
+  void VisitFunctionLiteral(FunctionLiteral* node) {}
+  void VisitCall(Call* node) { may_resize_ = true; }
+  void VisitCallNew(CallNew* node) { may_resize_ = true; }
+  void VisitYield(Yield* node) { may_resize_ = true; }
+  void VisitYieldStar(YieldStar* node) { may_resize_ = true; }
+  void VisitAwait(Await* node) { may_resize_ = true; }
+
+  void VisitAssignment(Assignment* node) {
+    if (node->target()->IsProperty()) may_resize_ = true;
+    AstTraversalVisitor::VisitAssignment(node);
+  }
+
+  void VisitCompoundAssignment(CompoundAssignment* node) {
+    VisitAssignment(node);
+  }
+
+  void VisitCountOperation(CountOperation* node) {
+    if (node->expression()->IsProperty()) may_resize_ = true;
+    AstTraversalVisitor::VisitCountOperation(node);
+  }
+
+  void VisitUnaryOperation(UnaryOperation* node) {
+    if (node->op() == Token::DELETE) may_resize_ = true;
+    AstTraversalVisitor::VisitUnaryOperation(node);
+  }
+
+ private:
+  bool may_resize_ = false;
+};
+
+// The array that {property} indexes with the variable {index}, as in a[i],
+// or nullptr.
+Variable* IndexedArray(Property* property, Variable* index) {
+  VariableProxy* object = property->obj()->AsVariableProxy();
+  VariableProxy* key = property->key()->AsVariableProxy();
+  if (object == nullptr || key == nullptr || !object->is_resolved() ||
+      !key->is_resolved() || key->var() != index ||
+      IsDynamicVariableMode(object->var()->mode())) {
+    return nullptr;
+  }
+  return object->var();
+}
+
+// Checks the body of a counted loop over the indices of an array for what
+// keeps it from being versioned; see CCodeGenerator::PrintArrayLoop. Like
+// ArrayResizeFinder it rejects whatever may resize an array, except stores
+// x[index] = value, which stay in bounds, and it collects the arrays indexed
+// with the index. The body is printed once per version, so statements that
+// print a label are rejected as well.
+class ArrayLoopFinder final : public AstTraversalVisitor<ArrayLoopFinder> {
+ public:
+  ArrayLoopFinder(uintptr_t stack_limit, Variable* index)
+      : AstTraversalVisitor(stack_limit), index_(index) {}
+
+  bool is_supported() const { return supported_; }
+  // In the order they are first indexed.
+  const std::vector<Variable*>& arrays() const { return arrays_; }
+  const std::vector<Assignment*>& stores() const { return stores_; }
+  bool IsAssigned(Variable* var) const { return assigned_.count(var) != 0; }
+
+  void VisitFunctionLiteral(FunctionLiteral* node) {}
+  void VisitClassLiteral(ClassLiteral* node) { supported_ = false; }
+  void VisitCall(Call* node) { supported_ = false; }
+  void VisitCallNew(CallNew* node) { supported_ = false; }
+  void VisitSpread(Spread* node) { supported_ = false; }
+  void VisitYield(Yield* node) { supported_ = false; }
+  void VisitYieldStar(YieldStar* node) { supported_ = false; }
+  void VisitAwait(Await* node) { supported_ = false; }
+  void VisitDoWhileStatement(DoWhileStatement* node) { supported_ = false; }
+  void VisitWhileStatement(WhileStatement* node) { supported_ = false; }
+  void VisitForStatement(ForStatement* node) { supported_ = false; }
+  void VisitForInStatement(ForInStatement* node) { supported_ = false; }
+  void VisitForOfStatement(ForOfStatement* node) { supported_ = false; }
+  void VisitSwitchStatement(SwitchStatement* node) { supported_ = false; }
+  void VisitTryCatchStatement(TryCatchStatement* node) { supported_ = false; }
+  void VisitTryFinallyStatement(TryFinallyStatement* node) {
+    supported_ = false;
+  }
+
+  void VisitBlock(Block* node) {
+    blocks_.insert(node);
+    AstTraversalVisitor::VisitBlock(node);
+  }
+
+  // A break out of a labelled block of the body prints a label after it.
+  void VisitBreakStatement(BreakStatement* node) {
+    if (blocks_.count(node->target()) != 0) supported_ = false;
+  }
+
+  void VisitAssignment(Assignment* node) {
+    Expression* target = node->target();
+    if (target->IsVariableProxy()) {
+      VariableProxy* proxy = target->AsVariableProxy();
+      if (proxy->is_resolved()) assigned_.insert(proxy->var());
+    } else if (target->IsProperty() && node->op() == Token::ASSIGN &&
+               IndexedArray(target->AsProperty(), index_) != nullptr) {
+      stores_.push_back(node);
     } else {
-      // there was not enough space - allocate more and try again
-      const int slack = 32;
-      int new_size = size_ + (size_ >> 1) + slack;
-      char* new_output = NewArray<char>(new_size);
-      MemCopy(new_output, output_, pos_);
-      DeleteArray(output_);
-      output_ = new_output;
-      size_ = new_size;
+      supported_ = false;
+    }
+    AstTraversalVisitor::VisitAssignment(node);
+  }
+
+  void VisitCompoundAssignment(CompoundAssignment* node) {
+    VisitAssignment(node);
+  }
+
+  void VisitCountOperation(CountOperation* node) {
+    VariableProxy* proxy = node->expression()->AsVariableProxy();
+    if (proxy == nullptr) {
+      supported_ = false;
+    } else if (proxy->is_resolved()) {
+      assigned_.insert(proxy->var());
+    }
+    AstTraversalVisitor::VisitCountOperation(node);
+  }
+
+  void VisitUnaryOperation(UnaryOperation* node) {
+    if (node->op() == Token::DELETE) supported_ = false;
+    AstTraversalVisitor::VisitUnaryOperation(node);
+  }
+
+  void VisitProperty(Property* node) {
+    Variable* array = IndexedArray(node, index_);
+    if (array != nullptr &&
+        std::find(arrays_.begin(), arrays_.end(), array) == arrays_.end()) {
+      arrays_.push_back(array);
+    }
+    AstTraversalVisitor::VisitProperty(node);
+  }
+
+ private:
+  Variable* index_;
+  bool supported_ = true;
+  std::vector<Variable*> arrays_;
+  std::vector<Assignment*> stores_;
+  std::unordered_set<Variable*> assigned_;
+  std::unordered_set<BreakableStatement*> blocks_;
+};
+
+// True for calls of the names the runtime provides as C functions, such as
+// print, which are not declared anywhere.
+bool IsRuntimeFunctionCall(Call* call) {
+  VariableProxy* proxy = call->expression()->AsVariableProxy();
+  return proxy != nullptr && (!proxy->is_resolved() ||
+                              IsDynamicVariableMode(proxy->var()->mode()));
+}
+
+// The values of the completion variable of a try/finally statement, which
+// tells the end of the finally block how the try block was left.
+constexpr int kNormalCompletion = 0;
+constexpr int kThrowCompletion = 1;
+constexpr int kReturnCompletion = 2;
+// Breaks and continues, in the order of FinallyBlock::jumps.
+constexpr int kFirstJumpCompletion = 3;
+
+// A perfect hash of the hashes of the string labels of a switch: the top
+// {bits} bits of hash * multiplier differ for every label. See
+// js_switch_string.
+struct CaseHash {
+  uint32_t multiplier;
+  uint32_t bits;
+};
+
+// Tries odd multipliers for tables of up to 32 times as many slots as there
+// are labels, but no more than kMaxCaseHashBits. Fails for labels that
+// share a hash.
+constexpr uint32_t kMaxCaseHashBits = 12;
+
+bool FindCaseHash(const std::vector<uint32_t>& hashes, CaseHash* result) {
+  uint32_t min_bits = 1;
+  while ((size_t{1} << min_bits) < hashes.size()) min_bits++;
+  for (uint32_t bits = min_bits;
+       bits <= min_bits + 5 && bits <= kMaxCaseHashBits; bits++) {
+    // Starts from 2^32 divided by the golden ratio.
+    uint32_t multiplier = 0x9E3779B1u;
+    for (int attempt = 0; attempt < 1000; attempt++) {
+      std::vector<bool> used(size_t{1} << bits);
+      bool collides = false;
+      for (uint32_t hash : hashes) {
+        uint32_t slot = (hash * multiplier) >> (32 - bits);
+        if (used[slot]) {
+          collides = true;
+          break;
+        }
+        used[slot] = true;
+      }
+      if (!collides) {
+        *result = {multiplier, bits};
+        return true;
+      }
+      multiplier = (multiplier * 1664525u + 1013904223u) | 1u;
     }
   }
+  return false;
+}
+
+}  // namespace
+
+void CCodeGenerator::Init() { output_.Clear(); }
+
+void CCodeGenerator::Print(const char* format, ...) {
+  va_list arguments;
+  va_start(arguments, format);
+  output_.VPrintF(format, arguments);
+  va_end(arguments);
 }
 
 void CCodeGenerator::PrintLiteral(Literal* literal, bool quote) {
@@ -115,6 +686,196 @@ void CCodeGenerator::PrintLiteral(const AstConsString* value, bool quote) {
   if (quote) Print("\"");
 }
 
+void CCodeGenerator::PrintNumber(double value) {
+  if (std::isnan(value)) {
+    Print("NAN");
+  } else if (std::isinf(value)) {
+    Print(value < 0 ? "(-INFINITY)" : "INFINITY");
+  } else {
+    base::EmbeddedVector<char, 32> buf;
+    SNPrintF(buf, "%.17g", value);
+    Print("%s", buf.begin());
+    // Keep integral values double-typed in C.
+    if (strpbrk(buf.begin(), ".e") == nullptr) Print(".0");
+  }
+}
+
+void CCodeGenerator::PrintCString(const AstRawString* value) {
+  PrintCString(EncodeUtf8(value));
+}
+
+void CCodeGenerator::PrintCString(const std::string& utf8) {
+  Print("\"");
+  for (char byte : utf8) {
+    unsigned char c = static_cast<unsigned char>(byte);
+    if (c == '"' || c == '\\') {
+      Print("\\%c", c);
+    } else if (c >= 0x20 && c < 0x7F) {
+      Print("%c", c);
+    } else {
+      // Octal escapes cannot swallow the characters that follow them.
+      Print("\\%03o", c);
+    }
+  }
+  Print("\"");
+}
+
+void CCodeGenerator::PrintString(const AstRawString* value) {
+  int index = strings_ != nullptr ? strings_->IndexOf(value) : -1;
+  if (index < 0) {
+    PrintCString(value);
+  } else {
+    Print("_js_strings.s%d", index);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+InferredType CCodeGenerator::TypeOf(Expression* expr) const {
+  if (function_types_ == nullptr) return InferredType::kDynamic;
+  return function_types_->TypeOf(expr);
+}
+
+InferredType CCodeGenerator::RepresentationOf(Expression* expr) const {
+  Literal* literal = expr->AsLiteral();
+  if (literal != nullptr) {
+    switch (literal->type()) {
+      case Literal::kSmi:
+        return InferredType::kSmi;
+      case Literal::kHeapNumber:
+        return InferredType::kDouble;
+      case Literal::kBoolean:
+        return InferredType::kBoolean;
+      default:
+        return InferredType::kDynamic;
+    }
+  }
+  if (function_types_ == nullptr) return InferredType::kDynamic;
+
+  // Assignments and variable reads are in the storage representation of the
+  // variable, which may be wider than the type at this program point.
+  if (expr->IsAssignment() || expr->IsCompoundAssignment()) {
+    return RepresentationOf(static_cast<Assignment*>(expr)->target());
+  }
+  if (expr->IsCountOperation()) {
+    return RepresentationOf(expr->AsCountOperation()->expression());
+  }
+  VariableProxy* proxy = expr->AsVariableProxy();
+  if (proxy != nullptr) {
+    if (!proxy->is_resolved()) return InferredType::kDynamic;
+    return VariableRepresentation(proxy->var());
+  }
+  if (expr->IsCall()) {
+    FunctionLiteral* callee = DirectCallee(types_, expr->AsCall());
+    if (callee == nullptr) return InferredType::kDynamic;
+    return CRepresentation(
+        CalleeTypes(expr->AsCall(), callee)->return_type());
+  }
+  return CRepresentation(TypeOf(expr));
+}
+
+InferredType CCodeGenerator::VariableRepresentation(Variable* var) const {
+  // Environment slots and closures hold boxed values.
+  if (closures_ != nullptr &&
+      (closures_->EnvironmentSlotOf(var) >= 0 ||
+       (function_ != nullptr && var == function_->scope()->function_var()))) {
+    return InferredType::kDynamic;
+  }
+  if (function_types_ == nullptr) return InferredType::kDynamic;
+  return CRepresentation(function_types_->TypeOf(var));
+}
+
+void CCodeGenerator::PrintCType(InferredType type) {
+  switch (CRepresentation(type)) {
+    case InferredType::kSmi:
+      Print("int32_t");
+      break;
+    case InferredType::kDouble:
+      Print("double");
+      break;
+    case InferredType::kBoolean:
+      Print("bool");
+      break;
+    default:
+      Print("js_value");
+      break;
+  }
+}
+
+void CCodeGenerator::PrintConverted(Expression* expr, InferredType type) {
+  InferredType from = RepresentationOf(expr);
+  PrintConversionPrefix(from, type);
+  Visit(expr);
+  PrintConversionSuffix(from, type);
+}
+
+void CCodeGenerator::PrintConversionPrefix(InferredType from,
+                                           InferredType to) {
+  if (to == InferredType::kNone) return;
+  from = CRepresentation(from);
+  to = CRepresentation(to);
+  if (from == to) return;
+  switch (to) {
+    case InferredType::kSmi:
+      Print(from == InferredType::kDouble    ? "js_double_to_int32("
+            : from == InferredType::kBoolean ? "((int32_t)("
+                                             : "js_to_int32(");
+      break;
+    case InferredType::kDouble:
+      Print(from == InferredType::kDynamic ? "js_to_number(" : "((double)(");
+      break;
+    case InferredType::kBoolean:
+      Print(from == InferredType::kSmi      ? "(("
+            : from == InferredType::kDouble ? "js_double_to_boolean("
+                                            : "js_to_boolean(");
+      break;
+    default:
+      Print(from == InferredType::kSmi       ? "make_int32("
+            : from == InferredType::kBoolean ? "make_boolean("
+                                             : "make_number(");
+      break;
+  }
+}
+
+void CCodeGenerator::PrintConversionSuffix(InferredType from,
+                                           InferredType to) {
+  if (to == InferredType::kNone) return;
+  from = CRepresentation(from);
+  to = CRepresentation(to);
+  if (from == to) return;
+  switch (to) {
+    case InferredType::kSmi:
+      Print(from == InferredType::kBoolean ? "))" : ")");
+      break;
+    case InferredType::kDouble:
+      Print(from == InferredType::kDynamic ? ")" : "))");
+      break;
+    case InferredType::kBoolean:
+      Print(from == InferredType::kSmi ? ") != 0)" : ")");
+      break;
+    default:
+      Print(")");
+      break;
+  }
+}
+
+void CCodeGenerator::PrintTruthiness(const char* name, InferredType type) {
+  switch (CRepresentation(type)) {
+    case InferredType::kSmi:
+      Print("(%s != 0)", name);
+      break;
+    case InferredType::kDouble:
+      Print("js_double_to_boolean(%s)", name);
+      break;
+    case InferredType::kBoolean:
+      Print("%s", name);
+      break;
+    default:
+      Print("js_to_boolean(%s)", name);
+      break;
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 class V8_NODISCARD CIndentedScope {
@@ -143,25 +904,44 @@ class V8_NODISCARD CIndentedScope {
 
 //-----------------------------------------------------------------------------
 
-CCodeGenerator::CCodeGenerator(uintptr_t stack_limit)
-    : output_(nullptr), size_(0), pos_(0), indent_(0) {
+CCodeGenerator::CCodeGenerator(uintptr_t stack_limit,
+                               const TypeInference* types,
+                               const EscapeAnalysis* escapes,
+                               const CallGraph* call_graph,
+                               const ClosureConversion* closures,
+                               const TypeFeedback* feedback,
+                               const InternedStrings* strings)
+    : indent_(0),
+      types_(types),
+      escapes_(escapes),
+      call_graph_(call_graph),
+      closures_(closures),
+      feedback_(feedback),
+      strings_(strings),
+      function_(nullptr),
+      function_types_(nullptr),
+      return_type_(InferredType::kDynamic),
+      entry_return_type_(InferredType::kDynamic),
+      entry_may_throw_(true),
+      has_async_functions_(true),
+      temp_count_(0),
+      has_gc_frame_(false),
+      ic_count_(0),
+      unwind_used_(false),
+      array_loop_(nullptr),
+      array_loop_kind_(InferredType::kNone) {
   InitializeAstVisitor(stack_limit);
 
   Init();
+  AssignFunctionNames();
 }
 
 CCodeGenerator::~CCodeGenerator() {
   DCHECK_EQ(indent_, 0);
-  DeleteArray(output_);
   // close(c_file_fd_);
 }
 
 
-const char* CCodeGenerator::GetOutput() {
-  return output_;
-}
-
-
 void CCodeGenerator::PrintIndented(const char* txt) {
   for (int i = 0; i < indent_; i++) {
     Print("  ");
@@ -216,7 +996,7 @@ void CCodeGenerator::PrintIndentedVisit(const char* s, AstNode* node) {
 }
 
 
-const char* CCodeGenerator::PrintProgram(FunctionLiteral* program) {
+void CCodeGenerator::PrintProgram(FunctionLiteral* program) {
   bool empty = program->raw_name()->ToRawStrings().empty();
   if (empty) {
     Print("int _js_entry(");
@@ -235,74 +1015,517 @@ const char* CCodeGenerator::PrintProgram(FunctionLiteral* program) {
   PrintStatements(program->body());
 
   Print(" }");
+}
 
-  return output_;
+void CCodeGenerator::PrepareHeaderFile() {
+  Print("#include \"js2c.h\"\n\n");
 }
 
-void CCodeGenerator::PrepareCFile() {
+void CCodeGenerator::PrepareCFile(const char* header_name) {
   Print("#include <stdio.h>\n");
-  Print("#include \"test.h\"\n\n");
+  Print("#include \"%s\"\n\n", header_name);
+}
+
+void CCodeGenerator::PrintGlobals(FunctionLiteral* program) {
+  AssignGlobalNames(program);
+  for (Variable* var : globals_) {
+    InferredType type = types_ != nullptr
+                            ? CRepresentation(types_->StorageTypeOf(var))
+                            : InferredType::kDynamic;
+    Print("static ");
+    PrintCType(type);
+    Print(" %s", global_names_[var].c_str());
+    if (type == InferredType::kDynamic) Print(" = JS_UNDEFINED_VALUE");
+    Print(";\n");
+  }
+  if (!globals_.empty()) Print("\n");
+}
+
+// Each string is a js_string_header directly followed by its characters, so
+// that the runtime finds the header of an interned string in front of it.
+void CCodeGenerator::PrintInternedStrings() {
+  if (strings_ == nullptr || strings_->entries().empty()) return;
+  Print("static const struct {\n");
+  inc_indent();
+  for (size_t i = 0; i < strings_->entries().size(); i++) {
+    const InternedStrings::Entry& entry = strings_->entries()[i];
+    PrintIndented("");
+    Print("js_string_header h%zu;\n", i);
+    PrintIndented("");
+    Print("char s%zu[%zu];\n", i, entry.utf8.size() + 1);
+  }
+  dec_indent();
+  Print("} _js_strings = {\n");
+  inc_indent();
+  for (const InternedStrings::Entry& entry : strings_->entries()) {
+    PrintIndented("");
+    Print("{%uu, %zu, %s}, ", entry.hash, entry.utf8.size(),
+          entry.is_one_byte ? "JS_STRING_ONE_BYTE" : "0");
+    PrintCString(entry.utf8);
+    Print(",\n");
+  }
+  dec_indent();
+  Print("};\n\n");
+}
+
+void CCodeGenerator::AssignGlobalNames(FunctionLiteral* program) {
+  std::unordered_set<std::string> used = {"main", "_js_entry"};
+  for (auto& entry : function_names_) used.insert(entry.second);
+  for (Declaration* decl : *program->scope()->declarations()) {
+    Variable* var = decl->var();
+    if (!ClosureConversion::IsGlobal(var) || global_names_.count(var) != 0) {
+      continue;
+    }
+    std::string base = CName(var->raw_name());
+    std::string name = base;
+    for (int suffix = 2; !used.insert(name).second; suffix++) {
+      name = base + "_" + std::to_string(suffix);
+    }
+    global_names_[var] = name;
+    globals_.push_back(var);
+  }
 }
 
 void CCodeGenerator::FinishCFile() {
 
   PrintIndented("int main() {\n");
   inc_indent();
-  PrintIndented("printf(\"\045d\\n\", _js_entry());\n");
+  if (strings_ != nullptr && !strings_->entries().empty()) {
+    PrintIndented("js_intern_strings(&_js_strings, sizeof(_js_strings));\n");
+  }
+  PrintIndented("");
+  PrintCType(entry_return_type_);
+  Print(" _js_result = _js_entry();\n");
+  if (entry_may_throw_) {
+    PrintIndented("if (js_exception_pending) ");
+    Print("return js_report_uncaught_exception();\n");
+  }
+  if (has_async_functions_) {
+    PrintIndented("js_run_microtasks();\n");
+    PrintIndented("if (js_exception_pending) ");
+    Print("return js_report_uncaught_exception();\n");
+  }
+  PrintIndented("print_typed(");
+  PrintConversionPrefix(entry_return_type_, InferredType::kDynamic);
+  Print("_js_result");
+  PrintConversionSuffix(entry_return_type_, InferredType::kDynamic);
+  Print(");\n");
   PrintIndented("return 0;\n");
   dec_indent();
   PrintIndented("}\n");
 }
 
-void CCodeGenerator::PrintFunction(FunctionLiteral* function, bool is_top_level) {
-  PrintIndented("int ");
-  if (is_top_level) {
-    Print("_js_entry");
+void CCodeGenerator::AssignFunctionNames() {
+  if (call_graph_ == nullptr) return;
+  std::unordered_set<std::string> used = {"main", "_js_entry"};
+  has_async_functions_ = false;
+  for (FunctionLiteral* function : call_graph_->functions()) {
+    if (IsAsyncFunction(function->kind())) has_async_functions_ = true;
+    if (function->is_toplevel()) continue;
+    std::string base = CName(function->raw_name());
+    if (base.empty()) base = "_js_anonymous";
+    std::string name = base;
+    for (int i = 1; !used.insert(name).second; i++) {
+      name = base + "_" + std::to_string(i);
+    }
+    function_names_[function] = name;
+    functions_by_position_[function->start_position()] = function;
+  }
+  // The script is in the call graph too. Knowing its variables and return
+  // type up front lets any generator print any function, and FinishCFile.
+  for (FunctionLiteral* function : call_graph_->functions()) {
+    if (!function->is_toplevel()) continue;
+    AssignGlobalNames(function);
+    const FunctionTypes* types =
+        types_ != nullptr ? types_->TypesFor(function) : nullptr;
+    if (types != nullptr) {
+      entry_return_type_ = CRepresentation(types->return_type());
+    }
+    entry_may_throw_ = call_graph_->MayThrow(function);
+  }
+}
+
+// Specializations are named after their parameter types, as in add__i32_i32.
+void CCodeGenerator::PrintFunctionName(FunctionLiteral* function,
+                                       const FunctionTypes* types) {
+  auto it = function_names_.find(function);
+  if (it != function_names_.end()) {
+    Print("%s", it->second.c_str());
   } else {
     PrintLiteral(function->raw_name(), false);
   }
+  if (types == nullptr || !types->is_specialization()) return;
+  for (int i = 0; i < types->parameter_count(); i++) {
+    Print(i == 0 ? "__" : "_");
+    switch (types->parameter(i)) {
+      case InferredType::kSmi:
+        Print("i32");
+        break;
+      case InferredType::kDouble:
+        Print("f64");
+        break;
+      case InferredType::kBoolean:
+        Print("bool");
+        break;
+      default:
+        UNREACHABLE();
+    }
+  }
+}
 
+// The version of {callee} that the direct call {node} in the function being
+// printed goes to.
+const FunctionTypes* CCodeGenerator::CalleeTypes(
+    Call* node, FunctionLiteral* callee) const {
+  const FunctionTypes* target =
+      function_types_ != nullptr ? function_types_->CalleeTypesAt(node)
+                                 : nullptr;
+  return target != nullptr ? target : types_->TypesFor(callee);
+}
+
+void CCodeGenerator::PrintFunctionSignature(FunctionLiteral* function,
+                                            bool is_top_level,
+                                            const FunctionTypes* types) {
+  if (types == nullptr && types_ != nullptr) types = types_->TypesFor(function);
+  InferredType return_type =
+      types != nullptr ? types->return_type() : InferredType::kDynamic;
+  return_type_ = CRepresentation(return_type);
+  if (is_top_level) entry_return_type_ = return_type_;
+
+  if (!is_top_level && call_graph_ != nullptr &&
+      call_graph_->IsInlineCandidate(function)) {
+    Print("static inline ");
+  }
+  PrintCType(return_type);
+  Print(" ");
+  if (is_top_level) {
+    Print("_js_entry");
+  } else {
+    PrintFunctionName(function, types);
+  }
   Print("(");
-
+  function_types_ = types;
   PrintParameters(function->scope());
-  Print(") {\n");
+  if (NeedsClosure(function)) {
+    Print(function->scope()->num_parameters() > 0 ? ", " : "");
+    Print("js_value _js_closure");
+  }
+  Print(")");
+}
+
+// Resets the per-function state for printing {function}.
+void CCodeGenerator::BeginFunction(FunctionLiteral* function) {
+  DeclarationScope* scope = function->scope();
+  declared_variables_.clear();
+  variable_names_.clear();
+  used_names_.clear();
+  environment_names_.clear();
+  gc_roots_.clear();
+  jump_target_ids_.clear();
+  finally_exception_slots_.clear();
+  finally_depths_.clear();
+  iterable_locals_.clear();
+  unwind_used_ = false;
+  // Temporaries, labels and inline caches are numbered per function, so the
+  // output does not depend on which generator printed what before.
+  temp_count_ = 0;
+  ic_count_ = 0;
+  function_ = function;
+  for (auto& entry : function_names_) used_names_.insert(entry.second);
+  for (auto& entry : global_names_) used_names_.insert(entry.second);
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    DeclareVariableName(scope->parameter(i));
+  }
+}
+
+void CCodeGenerator::PrintFunction(FunctionLiteral* function, bool is_top_level,
+                                   const FunctionTypes* types) {
+  if (!is_top_level && PrintResumableFunction(function, types)) return;
+  DeclarationScope* scope = function->scope();
+  BeginFunction(function);
+
+  PrintIndented("");
+  PrintFunctionSignature(function, is_top_level, types);
+  Print(" {\n");
   inc_indent();
+  PrintInlineCaches(function);
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    Variable* parameter = scope->parameter(i);
+    if (function_types_ == nullptr ||
+        CRepresentation(function_types_->TypeOf(parameter)) ==
+            InferredType::kDynamic) {
+      gc_roots_.push_back(variable_names_[parameter]);
+    }
+  }
+  PrintCaptures(function);
+  PrintTemporaries(scope);
+  PrintScopeLocals(scope);
+  PrintFinallyLocals(function);
+  PrintIterationLocals(function);
+  PrintGcFrame(function);
+  PrintEnvironment(function);
   if (is_top_level) {
-    PrintIndented("int _result;\n");
+    for (Variable* var : globals_) {
+      if (VariableRepresentation(var) != InferredType::kDynamic) continue;
+      PrintIndented("");
+      Print("js_gc_add_root(&%s);\n", global_names_[var].c_str());
+    }
   }
-  PrintDeclarations(function->scope()->declarations());
+  PrintDeclaredClosures(scope);
   PrintStatements(function->body());
+  if (has_gc_frame_) PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+  bool returns_at_end =
+      !is_top_level && return_type_ == InferredType::kDynamic;
+  if (returns_at_end) {
+    // Falling off the end returns undefined.
+    PrintIndented("return make_undefined();\n");
+  }
+  if (unwind_used_) {
+    // An exception that no try statement of the function handles returns
+    // to the caller with the flag still set. The value is never used.
+    const char* dummy = return_type_ == InferredType::kDynamic
+                            ? "return make_undefined();\n"
+                            : "return 0;\n";
+    if (!returns_at_end) PrintIndented(dummy);
+    PrintIndented("js_unwind:\n");
+    if (has_gc_frame_) PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+    PrintIndented(dummy);
+  }
   dec_indent();
 
   PrintIndented("}\n\n");
+  // Calls through the value of the function go to the generic version.
+  if ((function_types_ == nullptr || !function_types_->is_specialization()) &&
+      HasBoxedEntry(function)) {
+    PrintBoxedEntry(function);
+  }
+  function_ = nullptr;
+  function_types_ = nullptr;
+  has_gc_frame_ = false;
 
   return;
 }
 
+// Prints a generator or async function, unless its body has a suspend the
+// frame layout does not support.
+bool CCodeGenerator::PrintResumableFunction(FunctionLiteral* function,
+                                            const FunctionTypes* types) {
+  if (!IsResumableFunction(function->kind())) return false;
+  auto frame =
+      std::make_unique<GeneratorFrame>(stack_limit(), closures_, function);
+  frame->Analyze();
+  if (!frame->is_supported()) return false;
+  generator_frame_ = std::move(frame);
+  PrintResumeFunction(function);
+  PrintGeneratorEntry(function, types);
+  generator_frame_.reset();
+  if (HasBoxedEntry(function)) PrintBoxedEntry(function);
+  function_ = nullptr;
+  function_types_ = nullptr;
+  has_gc_frame_ = false;
+  return true;
+}
+
+// The body, which starts with a jump to the resume point the generator is
+// suspended at. Every value in it is boxed, like the slots of the frame.
+void CCodeGenerator::PrintResumeFunction(FunctionLiteral* function) {
+  DeclarationScope* scope = function->scope();
+  BeginFunction(function);
+  function_types_ = nullptr;
+  return_type_ = InferredType::kDynamic;
+  PrintIndented("static js_value ");
+  PrintFunctionName(function);
+  Print("__resume(js_value _js_generator, js_value _js_sent, bool _js_thrown) "
+        "{\n");
+  inc_indent();
+  PrintInlineCaches(function);
+  gc_roots_.push_back("_js_generator");
+  gc_roots_.push_back("_js_sent");
+  if (generator_frame_->slot_count() > 0) {
+    PrintIndented("js_value* _js_slots = js_generator_slots(_js_generator);\n");
+  }
+  if (generator_frame_->closure_slot() >= 0) {
+    PrintIndented("");
+    Print("js_value _js_closure = _js_slots[%d];\n",
+          generator_frame_->closure_slot());
+  }
+  PrintCaptures(function);
+  PrintTemporaries(scope);
+  PrintScopeLocals(scope);
+  PrintFinallyLocals(function);
+  PrintIterationLocals(function);
+  PrintGcFrame(function);
+  if (generator_frame_->environment_slot() >= 0) {
+    PrintIndented("");
+    Print("_js_env = _js_slots[%d];\n", generator_frame_->environment_slot());
+  }
+  if (generator_frame_->resume_point_count() > 0) {
+    PrintIndented("switch (js_generator_state(_js_generator)) {\n");
+    for (int i = 1; i <= generator_frame_->resume_point_count(); i++) {
+      PrintIndented("");
+      Print("  case %d: goto js_resume_%d;\n", i, i);
+    }
+    PrintIndented("}\n");
+  }
+  PrintDeclaredClosures(scope);
+  PrintStatements(function->body());
+  PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+  PrintIndented("return js_generator_close(_js_generator, make_undefined());\n");
+  if (unwind_used_) {
+    // The runtime closes the generator when the flag is set.
+    PrintIndented("js_unwind:\n");
+    PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+    PrintIndented("return make_undefined();\n");
+  }
+  dec_indent();
+  PrintIndented("}\n\n");
+}
 
-const char* CCodeGenerator::PrintFunctionDeclaration(FunctionLiteral* function) {
-  Init();
-  bool empty = function->raw_name()->ToRawStrings().empty();
-  if (empty) {
-    Print("int _js_entry(");
-  } else {
-    Print("int ");
-    PrintLiteral(function->raw_name(), false);
-    Print("(");
+// Creates the frame, moves the parameters, the closure and the environment
+// record into it and runs the body up to its first suspend.
+void CCodeGenerator::PrintGeneratorEntry(FunctionLiteral* function,
+                                         const FunctionTypes* types) {
+  DeclarationScope* scope = function->scope();
+  BeginFunction(function);
+  PrintIndented("");
+  PrintFunctionSignature(function, false, types);
+  Print(" {\n");
+  inc_indent();
+  auto parameter_type = [&](Variable* parameter) {
+    return function_types_ != nullptr
+               ? CRepresentation(function_types_->TypeOf(parameter))
+               : InferredType::kDynamic;
+  };
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    Variable* parameter = scope->parameter(i);
+    if (parameter_type(parameter) == InferredType::kDynamic) {
+      gc_roots_.push_back(variable_names_[parameter]);
+    }
+  }
+  if (NeedsClosure(function)) gc_roots_.push_back("_js_closure");
+  gc_roots_.push_back("_js_generator");
+  PrintIndented("js_value _js_generator = make_undefined();\n");
+  PrintGcFrame(function);
+  bool is_async = IsAsyncFunction(function->kind());
+  PrintIndented("");
+  Print("_js_generator = %s(", is_async ? "js_async_function_new"
+                                         : "js_generator_new");
+  PrintFunctionName(function);
+  Print("__resume, %d);\n", generator_frame_->slot_count());
+  if (generator_frame_->slot_count() > 0) {
+    PrintIndented("js_value* _js_slots = js_generator_slots(_js_generator);\n");
+  }
+  auto print_parameter = [&](Variable* parameter) {
+    InferredType type = parameter_type(parameter);
+    PrintConversionPrefix(type, InferredType::kDynamic);
+    PrintVariableName(parameter);
+    PrintConversionSuffix(type, InferredType::kDynamic);
+    Print(";\n");
+  };
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    Variable* parameter = scope->parameter(i);
+    int slot = generator_frame_->SlotOf(parameter);
+    if (slot < 0) continue;
+    PrintIndented("");
+    Print("_js_slots[%d] = ", slot);
+    print_parameter(parameter);
+  }
+  if (generator_frame_->closure_slot() >= 0) {
+    PrintIndented("");
+    Print("_js_slots[%d] = _js_closure;\n", generator_frame_->closure_slot());
   }
+  int environment = generator_frame_->environment_slot();
+  if (environment >= 0) {
+    PrintIndented("");
+    Print("_js_slots[%d] = js_env_new(%d);\n", environment,
+          closures_->EnvironmentSizeOf(function));
+    for (int i = 0; i < scope->num_parameters(); i++) {
+      Variable* parameter = scope->parameter(i);
+      int slot = closures_->EnvironmentSlotOf(parameter);
+      if (slot < 0) continue;
+      PrintIndented("");
+      Print("js_env_slots(_js_slots[%d])[%d] = ", environment, slot);
+      print_parameter(parameter);
+    }
+  }
+  PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+  PrintIndented("");
+  Print("return %s(_js_generator);\n", is_async ? "js_async_function_start"
+                                                 : "js_generator_start");
+  dec_indent();
+  PrintIndented("}\n\n");
+}
 
-  PrintParameters(function->scope());
+// Returns from the resume function at a suspend, and continues right after
+// it once resumed. The statement around the suspend is printed next, with
+// the suspend evaluating to _js_sent.
+void CCodeGenerator::PrintSuspend(Suspend* node) {
+  int resume_point = generator_frame_->ResumePointOf(node);
+  if (node->IsAwait()) {
+    PrintIndented("");
+    Print("js_await(_js_generator, %d, ", resume_point);
+    PrintConverted(node->expression(), InferredType::kDynamic);
+    Print(");\n");
+    PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+    PrintIndented("return make_undefined();\n");
+  } else {
+    int value = temp_count_++;
+    PrintIndented("{\n");
+    inc_indent();
+    PrintIndented("");
+    Print("js_value _js_t%d = ", value);
+    PrintConverted(node->expression(), InferredType::kDynamic);
+    Print(";\n");
+    PrintIndented("");
+    Print("js_generator_suspend(_js_generator, %d);\n", resume_point);
+    PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+    PrintIndented("");
+    Print("return js_gc_retain(_js_t%d);\n", value);
+    dec_indent();
+    PrintIndented("}\n");
+  }
+  PrintIndented("");
+  Print("js_resume_%d:\n", resume_point);
+  for (FinallyBlock& finally : finallies_) finally.resumes = true;
+  PrintIndented("if (__builtin_expect(_js_thrown, 0)) {\n");
+  inc_indent();
+  PrintIndented("js_throw(_js_sent);\n");
+  PrintIndented("");
+  Print("goto %s;\n", ExceptionHandlerLabel().c_str());
+  dec_indent();
+  PrintIndented("}\n");
+}
 
-  Print(");\n");
-  return output_;
+void CCodeGenerator::PrintInlineCaches(FunctionLiteral* function) {
+  std::vector<InlineCacheSite> sites;
+  InlineCacheCollector collector(stack_limit(), types_, &sites);
+  collector.VisitStatements(function->body());
+  for (const InlineCacheSite& site : sites) {
+    int id = ic_count_++;
+    (site.is_store ? store_ics_ : load_ics_)[site.node] = id;
+    PrintIndented("");
+    Print("static js_ic _js_ic_%d = {", id);
+    PrintString(site.name);
+    Print("};\n");
+  }
+  if (!sites.empty()) Print("\n");
 }
 
-const char* CCodeGenerator::Finish() {
-  Init();
+void CCodeGenerator::PrintFunctionDeclaration(
+    FunctionLiteral* function, const FunctionTypes* types) {
+  PrintFunctionSignature(function, function->is_toplevel(), types);
+  function_types_ = nullptr;
 
-  return output_;
+  Print(";\n");
+  if ((types == nullptr || !types->is_specialization()) &&
+      HasBoxedEntry(function)) {
+    PrintBoxedEntrySignature(function);
+    Print(";\n");
+  }
 }
 
+void CCodeGenerator::Finish() { Init(); }
+
 void CCodeGenerator::PrintDeclarations(Declaration::List* declarations) {
   if (!declarations->is_empty()) {
     // CIndentedScope indent(this, "DECLS");
@@ -313,8 +1536,11 @@ void CCodeGenerator::PrintDeclarations(Declaration::List* declarations) {
 void CCodeGenerator::PrintParameters(DeclarationScope* scope) {
   if (scope->num_parameters() > 0) {
     for (int i = 0; i < scope->num_parameters(); i++) {
-      Print("int ");
-      PrintLiteral(scope->parameter(i)->raw_name(), false);
+      Variable* parameter = scope->parameter(i);
+      PrintCType(function_types_ != nullptr ? function_types_->TypeOf(parameter)
+                                            : InferredType::kDynamic);
+      Print(" ");
+      PrintVariableName(parameter);
       if (i != scope->num_parameters() - 1) {
         Print(", ");
       }
@@ -328,6 +1554,337 @@ void CCodeGenerator::PrintStatements(const ZonePtrList<Statement>* statements) {
   }
 }
 
+void CCodeGenerator::PrintTemporaries(DeclarationScope* scope) {
+  for (Variable* var : *scope->locals()) {
+    if (var->mode() == VariableMode::kTemporary) PrintLocalDeclaration(var);
+  }
+}
+
+// Declares the lexical variables of {scope} and of the blocks nested in it,
+// but not those of nested functions.
+void CCodeGenerator::PrintScopeLocals(Scope* scope) {
+  PrintDeclarations(scope->declarations());
+  // The variable of a catch clause has no declaration.
+  if (scope->is_catch_scope()) PrintLocalDeclaration(scope->catch_variable());
+  for (Scope* inner = scope->inner_scope(); inner != nullptr;
+       inner = inner->sibling()) {
+    if (!inner->is_function_scope()) PrintScopeLocals(inner);
+  }
+}
+
+void CCodeGenerator::PrintLocalDeclaration(Variable* var) {
+  // Parameters are already declared and sloppy mode allows redeclaring a
+  // var any number of times. Variables in an environment record or of the
+  // script have no local.
+  if (var->IsParameter() || !declared_variables_.insert(var).second) return;
+  if (ClosureConversion::IsGlobal(var) ||
+      (closures_ != nullptr && closures_->EnvironmentSlotOf(var) >= 0)) {
+    return;
+  }
+  // Nor do the variables in the frame of a generator.
+  if (generator_frame_ != nullptr &&
+      (generator_frame_->SlotOf(var) >= 0 ||
+       var == function_->scope()->generator_object_var())) {
+    return;
+  }
+  DeclareVariableName(var);
+  InferredType type = function_types_ != nullptr
+                          ? CRepresentation(function_types_->TypeOf(var))
+                          : InferredType::kDynamic;
+  PrintIndented("");
+  PrintCType(type);
+  Print(" ");
+  PrintVariableName(var);
+  if (type == InferredType::kDynamic) {
+    Print(" = make_undefined()");
+    gc_roots_.push_back(variable_names_[var]);
+  }
+  Print(";\n");
+}
+
+// Declares the locals that hold the exception of each try/finally statement
+// while its finally block runs, and the value of a return that has to run
+// finally blocks first. Both are rooted if boxed.
+void CCodeGenerator::PrintFinallyLocals(FunctionLiteral* function) {
+  std::vector<TryFinallyStatement*> statements;
+  FinallyCollector collector(stack_limit(), &statements);
+  collector.VisitStatements(function->body());
+  for (size_t i = 0; i < statements.size(); i++) {
+    finally_exception_slots_[statements[i]] = static_cast<int>(i);
+    std::string name = "_js_exception_" + std::to_string(i);
+    PrintIndented("");
+    Print("js_value %s = make_undefined();\n", name.c_str());
+    gc_roots_.push_back(name);
+  }
+  if (!collector.returns_through_finally()) return;
+  PrintIndented("");
+  PrintCType(return_type_);
+  Print(" _js_return_value;\n");
+  if (return_type_ == InferredType::kDynamic) {
+    gc_roots_.push_back("_js_return_value");
+  }
+}
+
+void CCodeGenerator::DeclareVariableName(Variable* var) {
+  std::string base = CName(var->raw_name());
+  std::string name = base;
+  for (int suffix = 2; !used_names_.insert(name).second; suffix++) {
+    name = base + "_" + std::to_string(suffix);
+  }
+  variable_names_[var] = name;
+}
+
+void CCodeGenerator::PrintVariableName(Variable* var) {
+  auto it = variable_names_.find(var);
+  if (it != variable_names_.end()) {
+    Print("%s", it->second.c_str());
+    return;
+  }
+  it = global_names_.find(var);
+  if (it != global_names_.end()) {
+    Print("%s", it->second.c_str());
+  } else {
+    PrintLiteral(var->raw_name(), false);
+  }
+}
+
+// Prints an access to {var}, which may be a slot of an environment record
+// or of the frame of a generator, or the closure of the function being
+// printed.
+void CCodeGenerator::PrintVariable(Variable* var) {
+  if (generator_frame_ != nullptr) {
+    if (var == function_->scope()->generator_object_var()) {
+      Print("_js_generator");
+      return;
+    }
+    int slot = generator_frame_->SlotOf(var);
+    if (slot >= 0) {
+      Print("_js_slots[%d]", slot);
+      return;
+    }
+  }
+  if (closures_ == nullptr) {
+    PrintVariableName(var);
+    return;
+  }
+  if (var == function_->scope()->function_var()) {
+    Print("_js_closure");
+    return;
+  }
+  int slot = closures_->EnvironmentSlotOf(var);
+  if (slot < 0) {
+    PrintVariableName(var);
+    return;
+  }
+  DeclarationScope* owner = var->scope()->GetClosureScope();
+  DCHECK_NE(environment_names_.count(owner), 0);
+  Print("js_env_slots(%s)[%d]", environment_names_[owner].c_str(), slot);
+}
+
+// Pushes the shadow stack frame of the function being printed, which roots
+// its boxed locals. Functions that hold no boxed values and allocate nothing
+// do without one.
+void CCodeGenerator::PrintGcFrame(FunctionLiteral* function) {
+  has_gc_frame_ = !gc_roots_.empty() || escapes_ == nullptr ||
+                  escapes_->MayAllocate(function);
+  if (!has_gc_frame_) return;
+  if (!gc_roots_.empty()) {
+    PrintIndented("js_value* _js_roots[] = {");
+    for (size_t i = 0; i < gc_roots_.size(); i++) {
+      Print(i == 0 ? "&%s" : ", &%s", gc_roots_[i].c_str());
+    }
+    Print("};\n");
+  }
+  PrintIndented("js_gc_frame _js_frame;\n");
+  if (gc_roots_.empty()) {
+    PrintIndented("js_gc_push_frame(&_js_frame, NULL, 0);\n");
+  } else {
+    PrintIndented("");
+    Print("js_gc_push_frame(&_js_frame, _js_roots, %zu);\n",
+          gc_roots_.size());
+  }
+}
+
+bool CCodeGenerator::NeedsClosure(FunctionLiteral* function) const {
+  return closures_ != nullptr && closures_->NeedsClosure(function);
+}
+
+bool CCodeGenerator::HasBoxedEntry(FunctionLiteral* function) const {
+  return !function->is_toplevel() &&
+         (call_graph_ == nullptr || call_graph_->MayEscape(function) ||
+          NeedsClosure(function));
+}
+
+void CCodeGenerator::PrintBoxedEntrySignature(FunctionLiteral* function) {
+  Print("static js_value ");
+  PrintFunctionName(function);
+  Print("__boxed(js_value _js_closure, int32_t argc, const js_value* argv)");
+}
+
+// The js_code that closures of {function} call, which unboxes the arguments
+// for the typed C function and boxes its result.
+void CCodeGenerator::PrintBoxedEntry(FunctionLiteral* function) {
+  const FunctionTypes* types =
+      types_ != nullptr ? types_->TypesFor(function) : nullptr;
+  DeclarationScope* scope = function->scope();
+  int parameter_count = scope->num_parameters();
+  InferredType return_type =
+      types != nullptr ? types->return_type() : InferredType::kDynamic;
+  PrintIndented("");
+  PrintBoxedEntrySignature(function);
+  Print(" {\n");
+  inc_indent();
+  if (!NeedsClosure(function)) PrintIndented("(void)_js_closure;\n");
+  if (parameter_count == 0) {
+    PrintIndented("(void)argc;\n");
+    PrintIndented("(void)argv;\n");
+  }
+  PrintIndented("return ");
+  PrintConversionPrefix(return_type, InferredType::kDynamic);
+  PrintFunctionName(function);
+  Print("(");
+  for (int i = 0; i < parameter_count; i++) {
+    InferredType type = types != nullptr ? types->TypeOf(scope->parameter(i))
+                                         : InferredType::kDynamic;
+    if (i > 0) Print(", ");
+    PrintConversionPrefix(InferredType::kDynamic, type);
+    Print("(argc > %d ? argv[%d] : make_undefined())", i, i);
+    PrintConversionSuffix(InferredType::kDynamic, type);
+  }
+  if (NeedsClosure(function)) {
+    Print(parameter_count > 0 ? ", _js_closure" : "_js_closure");
+  }
+  Print(")");
+  PrintConversionSuffix(return_type, InferredType::kDynamic);
+  Print(";\n");
+  dec_indent();
+  PrintIndented("}\n\n");
+}
+
+// Declares the locals that the captures of the function being printed are
+// copied into, and the one for its own environment record.
+void CCodeGenerator::PrintCaptures(FunctionLiteral* function) {
+  if (NeedsClosure(function)) {
+    gc_roots_.push_back("_js_closure");
+    const std::vector<ClosureConversion::Capture>& captures =
+        closures_->CapturesOf(function);
+    for (size_t i = 0; i < captures.size(); i++) {
+      const ClosureConversion::Capture& capture = captures[i];
+      PrintIndented("");
+      if (capture.var == nullptr) {
+        std::string name = "_js_env_" + std::to_string(i);
+        environment_names_[capture.owner] = name;
+        gc_roots_.push_back(name);
+        Print("js_value %s = js_closure_captures(_js_closure)[%zu];\n",
+              name.c_str(), i);
+        continue;
+      }
+      Variable* var = capture.var;
+      declared_variables_.insert(var);
+      DeclareVariableName(var);
+      InferredType type = VariableRepresentation(var);
+      PrintCType(type);
+      Print(" ");
+      PrintVariableName(var);
+      Print(" = ");
+      PrintConversionPrefix(InferredType::kDynamic, type);
+      Print("js_closure_captures(_js_closure)[%zu]", i);
+      PrintConversionSuffix(InferredType::kDynamic, type);
+      Print(";\n");
+      if (type == InferredType::kDynamic) {
+        gc_roots_.push_back(variable_names_[var]);
+      }
+    }
+  }
+  if (closures_ != nullptr && closures_->EnvironmentSizeOf(function) > 0) {
+    environment_names_[function->scope()] = "_js_env";
+    gc_roots_.push_back("_js_env");
+    PrintIndented("js_value _js_env = make_undefined();\n");
+  }
+}
+
+// Allocates the environment record of the function being printed and moves
+// the parameters that live in it there.
+void CCodeGenerator::PrintEnvironment(FunctionLiteral* function) {
+  int size = closures_ != nullptr ? closures_->EnvironmentSizeOf(function) : 0;
+  if (size == 0) return;
+  PrintIndented("");
+  Print("_js_env = js_env_new(%d);\n", size);
+  DeclarationScope* scope = function->scope();
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    Variable* parameter = scope->parameter(i);
+    int slot = closures_->EnvironmentSlotOf(parameter);
+    if (slot < 0) continue;
+    InferredType type =
+        function_types_ != nullptr
+            ? CRepresentation(function_types_->TypeOf(parameter))
+            : InferredType::kDynamic;
+    PrintIndented("");
+    Print("js_env_slots(_js_env)[%d] = ", slot);
+    PrintConversionPrefix(type, InferredType::kDynamic);
+    PrintVariableName(parameter);
+    PrintConversionSuffix(type, InferredType::kDynamic);
+    Print(";\n");
+  }
+}
+
+// Function declarations are hoisted: the closures of those in {scope} and
+// the blocks nested in it are created on entry to the function.
+void CCodeGenerator::PrintDeclaredClosures(Scope* scope) {
+  for (Declaration* decl : *scope->declarations()) {
+    if (!decl->IsFunctionDeclaration()) continue;
+    FunctionLiteral* literal = decl->AsFunctionDeclaration()->fun();
+    if (!HasBoxedEntry(literal)) continue;
+    InferredType type = VariableRepresentation(decl->var());
+    PrintIndented("");
+    PrintVariable(decl->var());
+    Print(" = ");
+    PrintConversionPrefix(InferredType::kDynamic, type);
+    PrintClosureCreation(literal);
+    PrintConversionSuffix(InferredType::kDynamic, type);
+    Print(";\n");
+  }
+  for (Scope* inner = scope->inner_scope(); inner != nullptr;
+       inner = inner->sibling()) {
+    if (!inner->is_function_scope()) PrintDeclaredClosures(inner);
+  }
+}
+
+// Nothing between the allocation of the closure and the end of the
+// expression can allocate, so the closure needs no root while its captures
+// are filled in.
+void CCodeGenerator::PrintClosureCreation(FunctionLiteral* function) {
+  if (!NeedsClosure(function) || closures_->CapturesOf(function).empty()) {
+    Print("js_closure_new(");
+    PrintFunctionName(function);
+    Print("__boxed, 0)");
+    return;
+  }
+  const std::vector<ClosureConversion::Capture>& captures =
+      closures_->CapturesOf(function);
+  int closure = temp_count_++;
+  int slots = temp_count_++;
+  Print("({ js_value _js_t%d = js_closure_new(", closure);
+  PrintFunctionName(function);
+  Print("__boxed, %zu); ", captures.size());
+  Print("js_value* _js_t%d = js_closure_captures(_js_t%d); ", slots, closure);
+  for (size_t i = 0; i < captures.size(); i++) {
+    const ClosureConversion::Capture& capture = captures[i];
+    Print("_js_t%d[%zu] = ", slots, i);
+    if (capture.var == nullptr) {
+      DCHECK_NE(environment_names_.count(capture.owner), 0);
+      Print("%s", environment_names_[capture.owner].c_str());
+    } else {
+      InferredType type = VariableRepresentation(capture.var);
+      PrintConversionPrefix(type, InferredType::kDynamic);
+      PrintVariable(capture.var);
+      PrintConversionSuffix(type, InferredType::kDynamic);
+    }
+    Print("; ");
+  }
+  Print("_js_t%d; })", closure);
+}
+
 void CCodeGenerator::PrintArguments(const ZonePtrList<Expression>* arguments) {
   for (int i = 0; i < arguments->length(); i++) {
     Visit(arguments->at(i));
@@ -342,7 +1899,46 @@ void CCodeGenerator::VisitBlock(Block* node) {
   // const char* block_txt =
   //     node->ignore_completion_value() ? "BLOCK NOCOMPLETIONS" : "BLOCK";
   // CIndentedScope indent(this, block_txt, node->position());
+  // Block scoped variables are declared at the top of the function.
+  finally_depths_[node] = finallies_.size();
   PrintStatements(node->statements());
+  PrintJumpLabel("js_break", node);
+}
+
+void CCodeGenerator::PrintBody(Statement* body) {
+  inc_indent();
+  Visit(body);
+  dec_indent();
+}
+
+void CCodeGenerator::PrintLoopBody(IterationStatement* node) {
+  breakables_.push_back(node);
+  finally_depths_[node] = finallies_.size();
+  inc_indent();
+  // Objects allocated by earlier iterations are only reachable through
+  // locals by now.
+  if (has_gc_frame_) PrintIndented("js_gc_end_statement(&_js_frame);\n");
+  Visit(node->body());
+  dec_indent();
+  breakables_.pop_back();
+}
+
+int CCodeGenerator::JumpTargetId(BreakableStatement* target) {
+  auto it = jump_target_ids_.find(target);
+  if (it != jump_target_ids_.end()) return it->second;
+  int id = static_cast<int>(jump_target_ids_.size());
+  jump_target_ids_[target] = id;
+  return id;
+}
+
+void CCodeGenerator::PrintJumpLabel(const char* prefix,
+                                    BreakableStatement* target) {
+  std::unordered_set<BreakableStatement*>& used =
+      strcmp(prefix, "js_break") == 0 ? break_targets_used_
+                                      : continue_targets_used_;
+  if (used.count(target) == 0) return;
+  PrintIndented("");
+  Print("%s_%d:;\n", prefix, JumpTargetId(target));
 }
 
 
@@ -350,31 +1946,40 @@ void CCodeGenerator::VisitBlock(Block* node) {
 void CCodeGenerator::VisitVariableDeclaration(VariableDeclaration* node) {
   // PrintLiteralWithModeIndented("VARIABLE", node->var(),
   //                              node->var()->raw_name());
-  PrintIndented("int ");
-  PrintLiteral(node->var()->raw_name(), false);
-  Print(";\n");
+  PrintLocalDeclaration(node->var());
 }
 
 
 // TODO(svenpanne) Start with IndentedScope.
 void CCodeGenerator::VisitFunctionDeclaration(FunctionDeclaration* node) {
-  // PrintIndented("FUNCTION ");
-  // PrintLiteral(node->var()->raw_name(), true);
-  // Print(" = function ");
-  // PrintLiteral(node->fun()->raw_name(), false);
-  // Print("\n");
+  // The function itself is printed on its own; the variable only holds its
+  // closure, see PrintDeclaredClosures.
+  if (HasBoxedEntry(node->fun())) PrintLocalDeclaration(node->var());
 }
 
 
 void CCodeGenerator::VisitExpressionStatement(ExpressionStatement* node) {
   // CIndentedScope indent(this, "EXPRESSION STATEMENT", node->position());
-  Visit(node->expression());
+  Expression* expression = node->expression();
+  Suspend* suspend = generator_frame_ != nullptr
+                         ? GeneratorFrame::StatementSuspend(node)
+                         : nullptr;
+  if (suspend != nullptr) {
+    PrintSuspend(suspend);
+    // The value of a suspend on its own is not used.
+    if (expression == suspend) return;
+  }
+  PrintIndented("");
+  if (expression->IsAssignment() || expression->IsCompoundAssignment()) {
+    PrintAssignment(static_cast<Assignment*>(expression));
+  } else {
+    Visit(expression);
+  }
+  Print(";\n");
 }
 
 
-void CCodeGenerator::VisitEmptyStatement(EmptyStatement* node) {
-  CIndentedScope indent(this, "EMPTY", node->position());
-}
+void CCodeGenerator::VisitEmptyStatement(EmptyStatement* node) {}
 
 
 void CCodeGenerator::VisitSloppyBlockFunctionStatement(
@@ -384,29 +1989,131 @@ void CCodeGenerator::VisitSloppyBlockFunctionStatement(
 
 
 void CCodeGenerator::VisitIfStatement(IfStatement* node) {
-  CIndentedScope indent(this, "IF", node->position());
-  PrintIndentedVisit("CONDITION", node->condition());
-  PrintIndentedVisit("THEN", node->then_statement());
+  PrintIndented("if (");
+  PrintConverted(node->condition(), InferredType::kBoolean);
+  Print(") {\n");
+  PrintBody(node->then_statement());
   if (node->HasElseStatement()) {
-    PrintIndentedVisit("ELSE", node->else_statement());
+    PrintIndented("} else {\n");
+    PrintBody(node->else_statement());
   }
+  PrintIndented("}\n");
 }
 
 
 void CCodeGenerator::VisitContinueStatement(ContinueStatement* node) {
-  CIndentedScope indent(this, "CONTINUE", node->position());
+  PrintJump(node->target(), true);
 }
 
 
 void CCodeGenerator::VisitBreakStatement(BreakStatement* node) {
-  CIndentedScope indent(this, "BREAK", node->position());
+  PrintJump(node->target(), false);
+}
+
+void CCodeGenerator::PrintJump(BreakableStatement* target, bool is_continue) {
+  auto depth = finally_depths_.find(target);
+  if (depth != finally_depths_.end() && depth->second < finallies_.size()) {
+    // The jump leaves a try block with a finally block, at whose end it is
+    // taken.
+    std::vector<std::pair<BreakableStatement*, bool>>& jumps =
+        finallies_.back().jumps;
+    std::pair<BreakableStatement*, bool> jump(target, is_continue);
+    size_t index = std::find(jumps.begin(), jumps.end(), jump) - jumps.begin();
+    if (index == jumps.size()) jumps.push_back(jump);
+    PrintLeaveToFinally(kFirstJumpCompletion + static_cast<int>(index));
+    return;
+  }
+  if (!breakables_.empty() && breakables_.back() == target) {
+    PrintIndented(is_continue ? "continue;\n" : "break;\n");
+    return;
+  }
+  (is_continue ? continue_targets_used_ : break_targets_used_).insert(target);
+  PrintIndented("");
+  Print("goto %s_%d;\n", is_continue ? "js_continue" : "js_break",
+        JumpTargetId(target));
 }
 
 
 void CCodeGenerator::VisitReturnStatement(ReturnStatement* node) {
-  PrintIndented("return ");
-  Visit(node->expression());
+  if (generator_frame_ != nullptr) {
+    Suspend* suspend = GeneratorFrame::StatementSuspend(node);
+    if (suspend != nullptr) PrintSuspend(suspend);
+  }
+  if (!finallies_.empty()) {
+    PrintIndented("_js_return_value = ");
+    PrintReturnOperand(node);
+    Print(";\n");
+    PrintReturnValue();
+    return;
+  }
+  if (!has_gc_frame_) {
+    PrintIndented("return ");
+    PrintReturnOperand(node);
+    Print(";\n");
+    return;
+  }
+  // The frame is popped after the value is computed, and a boxed result is
+  // kept alive for the caller's statement.
+  int result = temp_count_++;
+  PrintIndented("{\n");
+  inc_indent();
+  PrintIndented("");
+  PrintCType(return_type_);
+  Print(" _js_t%d = ", result);
+  PrintReturnOperand(node);
   Print(";\n");
+  PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+  PrintIndented("");
+  if (return_type_ == InferredType::kDynamic) {
+    Print("return js_gc_retain(_js_t%d);\n", result);
+  } else {
+    Print("return _js_t%d;\n", result);
+  }
+  dec_indent();
+  PrintIndented("}\n");
+}
+
+// A return from a generator closes it, and the return that ends the body of
+// an async function resolves its promise. The one that rejects it is a
+// runtime call.
+void CCodeGenerator::PrintReturnOperand(ReturnStatement* node) {
+  bool is_async = IsAsyncFunction(function_->kind());
+  if (generator_frame_ == nullptr || (is_async && !node->is_async_return())) {
+    PrintConverted(node->expression(), return_type_);
+    return;
+  }
+  Print(is_async ? "js_async_function_resolve(_js_generator, "
+                 : "js_generator_close(_js_generator, ");
+  PrintConverted(node->expression(), InferredType::kDynamic);
+  Print(")");
+}
+
+// Returns _js_return_value once the finally blocks around the code being
+// printed have run.
+void CCodeGenerator::PrintReturnValue() {
+  if (!finallies_.empty()) {
+    finallies_.back().returns = true;
+    PrintLeaveToFinally(kReturnCompletion);
+    return;
+  }
+  if (!has_gc_frame_) {
+    PrintIndented("return _js_return_value;\n");
+    return;
+  }
+  PrintIndented("js_gc_pop_frame(&_js_frame);\n");
+  if (return_type_ == InferredType::kDynamic) {
+    PrintIndented("return js_gc_retain(_js_return_value);\n");
+  } else {
+    PrintIndented("return _js_return_value;\n");
+  }
+}
+
+void CCodeGenerator::PrintLeaveToFinally(int completion) {
+  int id = finallies_.back().id;
+  PrintIndented("");
+  Print("_js_completion_%d = %d;\n", id, completion);
+  PrintIndented("");
+  Print("goto js_finally_%d;\n", id);
 }
 
 
@@ -417,46 +2124,250 @@ void CCodeGenerator::VisitWithStatement(WithStatement* node) {
 }
 
 
+// Every switch is printed as a C switch over its clauses, whose bodies fall
+// through like those of JavaScript. What it dispatches on depends on the
+// labels:
+//  - Smi literals: the value of the tag itself, so that the C compiler can
+//    build a jump table or a binary search; see js_switch_int32.
+//  - string literals: the slot of the tag in a perfect hash table over the
+//    labels, computed here, which takes one compare; see js_switch_string.
+//  - anything else: the index of the first label that the tag is strictly
+//    equal to, testing them in order.
+// A label that repeats an earlier one can never match and gets no case.
+// The parser has already stored the tag in a temporary, so it is evaluated
+// once.
 void CCodeGenerator::VisitSwitchStatement(SwitchStatement* node) {
-  CIndentedScope switch_indent(this, "SWITCH", node->position());
-  PrintIndentedVisit("TAG", node->tag());
-  for (CaseClause* clause : *node->cases()) {
-    if (clause->is_default()) {
-      CIndentedScope indent(this, "DEFAULT");
-      PrintStatements(clause->statements());
+  ZonePtrList<CaseClause>* cases = node->cases();
+  bool all_smis = true;
+  bool all_strings = true;
+  bool has_labels = false;
+  for (CaseClause* clause : *cases) {
+    if (clause->is_default()) continue;
+    has_labels = true;
+    Literal* literal = clause->label()->AsLiteral();
+    if (literal == nullptr || literal->type() != Literal::kSmi) {
+      all_smis = false;
+    }
+    if (literal == nullptr || literal->type() != Literal::kString) {
+      all_strings = false;
+    }
+  }
+
+  // The C label of each clause, empty for the default and for repeated
+  // labels.
+  std::vector<std::string> case_labels(cases->length());
+  // The string labels by slot, if they have a perfect hash.
+  std::vector<const AstRawString*> slots;
+  CaseHash hash = {0, 0};
+  if (has_labels && all_strings) {
+    // The parser interns the strings, so equal labels are one pointer.
+    std::vector<const AstRawString*> strings;
+    std::vector<uint32_t> hashes;
+    std::unordered_set<const AstRawString*> seen;
+    for (CaseClause* clause : *cases) {
+      if (clause->is_default()) continue;
+      const AstRawString* string = clause->label()->AsLiteral()->AsRawString();
+      if (!seen.insert(string).second) continue;
+      strings.push_back(string);
+      hashes.push_back(HashUtf8(EncodeUtf8(string)));
+    }
+    if (FindCaseHash(hashes, &hash)) {
+      slots.resize(size_t{1} << hash.bits);
+      std::unordered_map<const AstRawString*, uint32_t> slot_of;
+      for (size_t i = 0; i < strings.size(); i++) {
+        uint32_t slot = (hashes[i] * hash.multiplier) >> (32 - hash.bits);
+        slots[slot] = strings[i];
+        slot_of[strings[i]] = slot;
+      }
+      for (int i = 0; i < cases->length(); i++) {
+        CaseClause* clause = cases->at(i);
+        if (clause->is_default()) continue;
+        auto it = slot_of.find(clause->label()->AsLiteral()->AsRawString());
+        if (it == slot_of.end()) continue;
+        case_labels[i] = std::to_string(it->second);
+        slot_of.erase(it);
+      }
+    }
+  }
+
+  if (has_labels && all_smis) {
+    std::unordered_set<int> seen;
+    for (int i = 0; i < cases->length(); i++) {
+      CaseClause* clause = cases->at(i);
+      if (clause->is_default()) continue;
+      int value = Smi::ToInt(clause->label()->AsLiteral()->AsSmiLiteral());
+      if (seen.insert(value).second) case_labels[i] = std::to_string(value);
+    }
+    PrintIndented("switch (");
+    if (RepresentationOf(node->tag()) == InferredType::kSmi) {
+      Visit(node->tag());
     } else {
-      CIndentedScope indent(this, "CASE");
-      Visit(clause->label());
-      PrintStatements(clause->statements());
+      // Any value that is not a label does for a tag that matches none.
+      int no_match = -1;
+      while (seen.count(no_match) != 0) no_match--;
+      Print("js_switch_int32(");
+      PrintConverted(node->tag(), InferredType::kDynamic);
+      Print(", %d)", no_match);
+    }
+    Print(") {\n");
+  } else if (!slots.empty()) {
+    int id = temp_count_++;
+    PrintIndented("{\n");
+    inc_indent();
+    PrintIndented("");
+    Print("static const char* const _js_labels_%d[] = {", id);
+    for (size_t i = 0; i < slots.size(); i++) {
+      if (i > 0) Print(", ");
+      if (slots[i] == nullptr) {
+        Print("NULL");
+      } else {
+        PrintString(slots[i]);
+      }
+    }
+    Print("};\n");
+    PrintIndented("switch (js_switch_string(");
+    PrintConverted(node->tag(), InferredType::kDynamic);
+    Print(", _js_labels_%d, 0x%08Xu, %u)) {\n", id, hash.multiplier,
+          hash.bits);
+  } else {
+    PrintIndented("switch (");
+    for (int i = 0; i < cases->length(); i++) {
+      CaseClause* clause = cases->at(i);
+      if (clause->is_default()) continue;
+      case_labels[i] = std::to_string(i);
+      PrintCaseMatch(node->tag(), clause->label());
+      Print(" ? %d : ", i);
     }
+    Print("-1) {\n");
+  }
+
+  breakables_.push_back(node);
+  finally_depths_[node] = finallies_.size();
+  inc_indent();
+  for (int i = 0; i < cases->length(); i++) {
+    CaseClause* clause = cases->at(i);
+    const char* end = clause->statements()->is_empty() ? ";\n" : "\n";
+    if (clause->is_default()) {
+      PrintIndented("");
+      Print("default:%s", end);
+    } else if (!case_labels[i].empty()) {
+      PrintIndented("");
+      Print("case %s:%s", case_labels[i].c_str(), end);
+    }
+    inc_indent();
+    PrintStatements(clause->statements());
+    dec_indent();
+  }
+  dec_indent();
+  breakables_.pop_back();
+  PrintIndented("}\n");
+  if (!slots.empty()) {
+    dec_indent();
+    PrintIndented("}\n");
   }
+  PrintJumpLabel("js_break", node);
+}
+
+// tag === label, with numbers and booleans compared unboxed when both are.
+void CCodeGenerator::PrintCaseMatch(Expression* tag, Expression* label) {
+  InferredType tag_type = RepresentationOf(tag);
+  InferredType label_type = RepresentationOf(label);
+  if (IsNumericType(tag_type) && IsNumericType(label_type)) {
+    InferredType type =
+        tag_type == label_type ? tag_type : InferredType::kDouble;
+    Print("(");
+    PrintConverted(tag, type);
+    Print(" == ");
+    PrintConverted(label, type);
+    Print(")");
+    return;
+  }
+  if (tag_type == InferredType::kBoolean &&
+      label_type == InferredType::kBoolean) {
+    Print("(");
+    Visit(tag);
+    Print(" == ");
+    Visit(label);
+    Print(")");
+    return;
+  }
+  Print("js_strict_equals(");
+  PrintConverted(tag, InferredType::kDynamic);
+  Print(", ");
+  PrintConverted(label, InferredType::kDynamic);
+  Print(")");
 }
 
 
 void CCodeGenerator::VisitDoWhileStatement(DoWhileStatement* node) {
-  CIndentedScope indent(this, "DO", node->position());
-  PrintIndentedVisit("BODY", node->body());
-  PrintIndentedVisit("COND", node->cond());
+  PrintIndented("do {\n");
+  PrintLoopBody(node);
+  inc_indent();
+  PrintJumpLabel("js_continue", node);
+  dec_indent();
+  PrintIndented("} while (");
+  PrintConverted(node->cond(), InferredType::kBoolean);
+  Print(");\n");
+  PrintJumpLabel("js_break", node);
 }
 
 
 void CCodeGenerator::VisitWhileStatement(WhileStatement* node) {
-  CIndentedScope indent(this, "WHILE", node->position());
-  PrintIndentedVisit("COND", node->cond());
-  PrintIndentedVisit("BODY", node->body());
+  PrintIndented("while (");
+  PrintConverted(node->cond(), InferredType::kBoolean);
+  Print(") {\n");
+  PrintLoopBody(node);
+  inc_indent();
+  PrintJumpLabel("js_continue", node);
+  dec_indent();
+  PrintIndented("}\n");
+  PrintJumpLabel("js_break", node);
 }
 
 
 void CCodeGenerator::VisitForStatement(ForStatement* node) {
-  CIndentedScope indent(this, "FOR", node->position());
-  if (node->init()) PrintIndentedVisit("INIT", node->init());
-  if (node->cond()) PrintIndentedVisit("COND", node->cond());
-  PrintIndentedVisit("BODY", node->body());
-  if (node->next()) PrintIndentedVisit("NEXT", node->next());
+  if (node->init()) Visit(node->init());
+  ArrayLoop loop;
+  if (MatchArrayLoop(node, &loop)) {
+    PrintArrayLoop(node, loop);
+  } else {
+    PrintForLoop(node);
+  }
+}
+
+void CCodeGenerator::PrintForLoop(ForStatement* node) {
+  PrintIndented("for (; ");
+  if (array_loop_ != nullptr) {
+    Visit(array_loop_->index);
+    Print(" < _js_array_length_%d", array_loop_->id);
+  } else if (node->cond()) {
+    PrintConverted(node->cond(), InferredType::kBoolean);
+  }
+  Print("; ");
+  if (node->next()) {
+    // The parser always wraps the next expression in an ExpressionStatement.
+    Expression* next = node->next()->AsExpressionStatement()->expression();
+    if (next->IsAssignment() || next->IsCompoundAssignment()) {
+      PrintAssignment(static_cast<Assignment*>(next));
+    } else {
+      Visit(next);
+    }
+  }
+  Print(") {\n");
+  PrintLoopBody(node);
+  inc_indent();
+  PrintJumpLabel("js_continue", node);
+  dec_indent();
+  PrintIndented("}\n");
+  PrintJumpLabel("js_break", node);
 }
 
 
 void CCodeGenerator::VisitForInStatement(ForInStatement* node) {
+  if (IsLowerableForEach(node)) {
+    PrintForEach(node);
+    return;
+  }
   CIndentedScope indent(this, "FOR IN", node->position());
   PrintIndentedVisit("FOR", node->each());
   PrintIndentedVisit("IN", node->subject());
@@ -465,6 +2376,10 @@ void CCodeGenerator::VisitForInStatement(ForInStatement* node) {
 
 
 void CCodeGenerator::VisitForOfStatement(ForOfStatement* node) {
+  if (IsLowerableForEach(node)) {
+    PrintForEach(node);
+    return;
+  }
   CIndentedScope indent(this, "FOR OF", node->position());
   const char* for_type;
   switch (node->type()) {
@@ -475,47 +2390,377 @@ void CCodeGenerator::VisitForOfStatement(ForOfStatement* node) {
       for_type = "FOR AWAIT";
       break;
   }
-  PrintIndentedVisit(for_type, node->each());
-  PrintIndentedVisit("OF", node->subject());
-  PrintIndentedVisit("BODY", node->body());
+  PrintIndentedVisit(for_type, node->each());
+  PrintIndentedVisit("OF", node->subject());
+  PrintIndentedVisit("BODY", node->body());
+}
+
+
+// Matches for (; i < a.length; i++), or ++i or i += 1, with an int32 local
+// i and a local a. The init statement has been printed already: for a let
+// declaration, the parser moves it to a block around the loop.
+bool CCodeGenerator::MatchArrayLoop(ForStatement* node, ArrayLoop* loop) {
+  if (function_types_ == nullptr || node->cond() == nullptr ||
+      node->next() == nullptr) {
+    return false;
+  }
+  CompareOperation* cond = node->cond()->AsCompareOperation();
+  if (cond == nullptr || cond->op() != Token::LT) return false;
+  VariableProxy* index = cond->left()->AsVariableProxy();
+  Property* length = cond->right()->AsProperty();
+  if (index == nullptr || !index->is_resolved() ||
+      IsDynamicVariableMode(index->var()->mode()) ||
+      VariableRepresentation(index->var()) != InferredType::kSmi ||
+      length == nullptr ||
+      Property::GetAssignType(length) != NAMED_PROPERTY ||
+      !NamedPropertyKey(length)->IsOneByteEqualTo("length")) {
+    return false;
+  }
+  VariableProxy* bound = length->obj()->AsVariableProxy();
+  if (bound == nullptr || !bound->is_resolved() ||
+      IsDynamicVariableMode(bound->var()->mode()) ||
+      TypeOf(bound) == InferredType::kString) {
+    return false;
+  }
+  Expression* next = node->next()->AsExpressionStatement()->expression();
+  CountOperation* count = next->AsCountOperation();
+  CompoundAssignment* add = next->AsCompoundAssignment();
+  Expression* target = nullptr;
+  if (count != nullptr && count->op() == Token::INC) {
+    target = count->expression();
+  } else if (add != nullptr && add->op() == Token::ASSIGN_ADD &&
+             add->value()->IsLiteral() &&
+             add->value()->AsLiteral()->IsNumber() &&
+             add->value()->AsLiteral()->AsNumber() == 1) {
+    target = add->target();
+  }
+  if (target == nullptr || !target->IsVariableProxy() ||
+      target->AsVariableProxy()->var() != index->var()) {
+    return false;
+  }
+
+  ArrayLoopFinder finder(stack_limit(), index->var());
+  finder.Visit(node->body());
+  if (!finder.is_supported() || finder.IsAssigned(index->var()) ||
+      finder.IsAssigned(bound->var())) {
+    return false;
+  }
+  loop->arrays.clear();
+  for (Variable* array : finder.arrays()) {
+    if (finder.IsAssigned(array) ||
+        VariableRepresentation(array) != InferredType::kDynamic) {
+      continue;
+    }
+    loop->arrays.push_back(array);
+  }
+  // A store of a number cannot move an array of doubles to generic
+  // elements, nor one of an int32 an array of Smis.
+  bool smi_stores = true;
+  bool number_stores = true;
+  for (Assignment* store : finder.stores()) {
+    Variable* array = IndexedArray(store->target()->AsProperty(), index->var());
+    if (std::find(loop->arrays.begin(), loop->arrays.end(), array) ==
+        loop->arrays.end()) {
+      return false;
+    }
+    InferredType type = RepresentationOf(store->value());
+    smi_stores &= type == InferredType::kSmi;
+    number_stores &=
+        type == InferredType::kSmi || type == InferredType::kDouble;
+  }
+  loop->kinds.clear();
+  if (loop->arrays.empty()) {
+    loop->kinds.push_back(InferredType::kNone);
+  } else {
+    if (smi_stores) loop->kinds.push_back(InferredType::kSmi);
+    if (number_stores) loop->kinds.push_back(InferredType::kDouble);
+    loop->kinds.push_back(InferredType::kDynamic);
+  }
+  loop->id = temp_count_++;
+  loop->index = index;
+  loop->bound = bound;
+  return true;
+}
+
+// Inside a version, i is in [0, a.length) and the arrays keep their
+// elements kind and at least that many elements, so that x[i] is a plain C
+// array access. Arrays are always packed, so there is no hole to check for.
+void CCodeGenerator::PrintArrayLoop(ForStatement* node, const ArrayLoop& loop) {
+  for (size_t version = 0; version < loop.kinds.size(); version++) {
+    InferredType kind = loop.kinds[version];
+    const char* kind_name = kind == InferredType::kSmi      ? "SMI"
+                            : kind == InferredType::kDouble ? "DOUBLE"
+                                                            : "GENERIC";
+    const char* elements_type = kind == InferredType::kSmi      ? "int32_t"
+                                : kind == InferredType::kDouble ? "double"
+                                                                : "js_value";
+    const char* elements_name = kind == InferredType::kSmi      ? "smi"
+                                : kind == InferredType::kDouble ? "double"
+                                                                : "generic";
+    PrintIndented(version == 0 ? "if (" : "} else if (");
+    Print("js_is_array(");
+    Visit(loop.bound);
+    Print(") && ");
+    Visit(loop.index);
+    Print(" >= 0");
+    for (Variable* array : loop.arrays) {
+      Print(" &&\n");
+      PrintIndented("    js_array_has_kind(");
+      PrintVariable(array);
+      Print(", JS_ELEMENTS_%s, js_array_length(", kind_name);
+      Visit(loop.bound);
+      Print("))");
+    }
+    Print(") {\n");
+    inc_indent();
+    PrintIndented("");
+    Print("int32_t _js_array_length_%d = js_array_length(", loop.id);
+    Visit(loop.bound);
+    Print(");\n");
+    for (size_t i = 0; i < loop.arrays.size(); i++) {
+      PrintIndented("");
+      Print("%s* _js_elements_%d_%d = js_array_%s_elements(", elements_type,
+            loop.id, static_cast<int>(i), elements_name);
+      PrintVariable(loop.arrays[i]);
+      Print(");\n");
+    }
+    array_loop_ = &loop;
+    array_loop_kind_ = kind;
+    PrintForLoop(node);
+    array_loop_ = nullptr;
+    array_loop_kind_ = InferredType::kNone;
+    dec_indent();
+  }
+  PrintIndented("} else {\n");
+  inc_indent();
+  PrintForLoop(node);
+  dec_indent();
+  PrintIndented("}\n");
+}
+
+// The index of the elements local of the array that {property} indexes in
+// the array loop being printed, or -1.
+int CCodeGenerator::ArrayLoopElements(Property* property) const {
+  Variable* array = IndexedArray(property, array_loop_->index->var());
+  auto it =
+      std::find(array_loop_->arrays.begin(), array_loop_->arrays.end(), array);
+  if (array == nullptr || it == array_loop_->arrays.end()) return -1;
+  return static_cast<int>(it - array_loop_->arrays.begin());
+}
+
+bool CCodeGenerator::PrintArrayLoopLoad(Property* node) {
+  int elements = ArrayLoopElements(node);
+  if (elements < 0) return false;
+  Print(array_loop_kind_ == InferredType::kSmi      ? "make_int32("
+        : array_loop_kind_ == InferredType::kDouble ? "make_number("
+                                                    : "(");
+  Print("_js_elements_%d_%d[", array_loop_->id, elements);
+  Visit(node->key());
+  Print("])");
+  return true;
+}
+
+// The value of the store is that of the assignment, boxed.
+bool CCodeGenerator::PrintArrayLoopStore(Assignment* node,
+                                         Property* property) {
+  int elements = ArrayLoopElements(property);
+  if (elements < 0) return false;
+  Print(array_loop_kind_ == InferredType::kSmi      ? "make_int32("
+        : array_loop_kind_ == InferredType::kDouble ? "make_number("
+                                                    : "(");
+  Print("_js_elements_%d_%d[", array_loop_->id, elements);
+  Visit(property->key());
+  Print("] = ");
+  PrintConverted(node->value(), array_loop_kind_);
+  Print(")");
+  return true;
+}
+
+bool CCodeGenerator::IsLowerableForEach(ForEachStatement* node) const {
+  ForOfStatement* for_of = node->AsForOfStatement();
+  if (for_of != nullptr && for_of->type() != IteratorType::kNormal) {
+    return false;
+  }
+  VariableProxy* proxy = node->each()->AsVariableProxy();
+  return proxy != nullptr && proxy->is_resolved() &&
+         !IsDynamicVariableMode(proxy->var()->mode()) &&
+         proxy->var() != function_->scope()->function_var() &&
+         VariableRepresentation(proxy->var()) == InferredType::kDynamic;
+}
+
+// Declares the rooted locals that hold the iterable of each lowered for-in
+// and for-of statement while it runs.
+void CCodeGenerator::PrintIterationLocals(FunctionLiteral* function) {
+  std::vector<ForEachStatement*> statements;
+  ForEachCollector collector(stack_limit(), &statements);
+  collector.VisitStatements(function->body());
+  for (ForEachStatement* node : statements) {
+    if (!IsLowerableForEach(node)) continue;
+    int id = static_cast<int>(iterable_locals_.size());
+    iterable_locals_[node] = id;
+    std::string name = "_js_iterable_" + std::to_string(id);
+    PrintIndented("");
+    Print("js_value %s = make_undefined();\n", name.c_str());
+    gc_roots_.push_back(name);
+  }
 }
 
+// The next step stores straight into the variable, so no iterator result
+// is made. The length is read once unless the body may resize the array
+// being walked; strings cannot change, and for-in does not visit keys that
+// the body adds.
+void CCodeGenerator::PrintForEach(ForEachStatement* node) {
+  bool is_for_of = node->IsForOfStatement();
+  const char* prefix = is_for_of ? "js_for_of" : "js_for_in";
+  int id = iterable_locals_[node];
+  PrintIndented("");
+  Print("_js_iterable_%d = ", id);
+  PrintConverted(node->subject(), InferredType::kDynamic);
+  Print(";\n");
+  // Only arrays and generators remain once the subject is not a string.
+  bool may_be_array =
+      is_for_of && TypeOf(node->subject()) != InferredType::kString;
+  bool live_length = false;
+  if (may_be_array) {
+    ArrayResizeFinder finder(stack_limit());
+    finder.Visit(node->body());
+    live_length = finder.may_resize();
+  }
+  PrintIndented("");
+  Print("for (int32_t _js_index_%d = 0", id);
+  if (!live_length) {
+    Print(", _js_length_%d = %s_length(_js_iterable_%d)", id, prefix, id);
+  }
+  Print("; ");
+  if (may_be_array) {
+    Print("JS_CHECKED_CALL(%s, ", ExceptionHandlerLabel().c_str());
+  }
+  Print("%s_next(_js_iterable_%d, &_js_index_%d, ", prefix, id, id);
+  if (live_length) {
+    Print("JS_FOR_OF_LIVE_LENGTH");
+  } else {
+    Print("_js_length_%d", id);
+  }
+  Print(", &");
+  Visit(node->each());
+  Print("%s;) {\n", may_be_array ? "))" : ")");
+  PrintLoopBody(node);
+  inc_indent();
+  PrintJumpLabel("js_continue", node);
+  dec_indent();
+  PrintIndented("}\n");
+  PrintJumpLabel("js_break", node);
+}
 
+// A try block is printed as straight-line code. Whatever may throw in it
+// goes to js_catch_<id> when the exception flag is set; see
+// js2c_exception.h.
 void CCodeGenerator::VisitTryCatchStatement(TryCatchStatement* node) {
-  CIndentedScope indent(this, "TRY CATCH", node->position());
-  PrintIndentedVisit("TRY", node->try_block());
-  PrintIndented("CATCH PREDICTION");
-  const char* prediction = "";
-  switch (node->GetCatchPrediction(HandlerTable::UNCAUGHT)) {
-    case HandlerTable::UNCAUGHT:
-      prediction = "UNCAUGHT";
-      break;
-    case HandlerTable::CAUGHT:
-      prediction = "CAUGHT";
-      break;
-    case HandlerTable::ASYNC_AWAIT:
-      prediction = "ASYNC_AWAIT";
-      break;
-    case HandlerTable::UNCAUGHT_ASYNC_AWAIT:
-      prediction = "UNCAUGHT_ASYNC_AWAIT";
-      break;
-    case HandlerTable::PROMISE:
-      // Catch prediction resulting in promise rejections aren't
-      // parsed by the parser.
-      UNREACHABLE();
-  }
-  Print(" %s\n", prediction);
-  if (node->scope()) {
-    PrintLiteralWithModeIndented("CATCHVAR", node->scope()->catch_variable(),
-                                 node->scope()->catch_variable()->raw_name());
+  int id = temp_count_++;
+  handlers_.push_back({"js_catch_" + std::to_string(id), false});
+  Visit(node->try_block());
+  bool caught = handlers_.back().used;
+  handlers_.pop_back();
+  // Nothing in the try block throws, so the catch block is dead.
+  if (!caught) return;
+  PrintIndented("");
+  Print("goto js_try_end_%d;\n", id);
+  PrintIndented("");
+  Print("js_catch_%d:\n", id);
+  PrintIndented("");
+  if (node->scope() != nullptr) {
+    PrintVariable(node->scope()->catch_variable());
+    Print(" = js_catch();\n");
+  } else {
+    Print("(void)js_catch();\n");
   }
-  PrintIndentedVisit("CATCH", node->catch_block());
+  Visit(node->catch_block());
+  PrintIndented("");
+  Print("js_try_end_%d:;\n", id);
 }
 
+// The finally block is printed once. The try block is left for it normally,
+// or with a throw, a return or a jump that is recorded in the completion
+// variable and resumed at the end of the finally block.
 void CCodeGenerator::VisitTryFinallyStatement(TryFinallyStatement* node) {
-  CIndentedScope indent(this, "TRY FINALLY", node->position());
-  PrintIndentedVisit("TRY", node->try_block());
-  PrintIndentedVisit("FINALLY", node->finally_block());
+  int id = temp_count_++;
+  // The try block is printed on its own first, since whether it needs the
+  // completion variable depends on how it is left.
+  OutputBuffer before;
+  before.Append(&output_);
+  handlers_.push_back({"js_catch_" + std::to_string(id), false});
+  finallies_.push_back({id, false, false, {}});
+  Visit(node->try_block());
+  bool caught = handlers_.back().used;
+  FinallyBlock finally = std::move(finallies_.back());
+  handlers_.pop_back();
+  finallies_.pop_back();
+  OutputBuffer try_block;
+  try_block.Append(&output_);
+  output_.Append(&before);
+
+  bool has_completion = caught || finally.returns || !finally.jumps.empty();
+  if (has_completion) {
+    PrintIndented("");
+    Print("int32_t _js_completion_%d = %d;\n", id, kNormalCompletion);
+  }
+  output_.Append(&try_block);
+  if (has_completion && finally.resumes) {
+    // A call that resumed the try block did not run the declaration.
+    PrintIndented("");
+    Print("_js_completion_%d = %d;\n", id, kNormalCompletion);
+  }
+  int slot = finally_exception_slots_[node];
+  if (caught) {
+    PrintIndented("");
+    Print("goto js_finally_%d;\n", id);
+    PrintIndented("");
+    Print("js_catch_%d:\n", id);
+    PrintIndented("");
+    Print("_js_exception_%d = js_catch();\n", slot);
+    PrintIndented("");
+    Print("_js_completion_%d = %d;\n", id, kThrowCompletion);
+  }
+  if (has_completion) {
+    PrintIndented("");
+    Print("js_finally_%d:;\n", id);
+  }
+  Visit(node->finally_block());
+
+  auto print_resumption = [&](int completion, auto print_body) {
+    PrintIndented("");
+    Print("if (_js_completion_%d == %d) {\n", id, completion);
+    inc_indent();
+    print_body();
+    dec_indent();
+    PrintIndented("}\n");
+  };
+  if (caught) {
+    print_resumption(kThrowCompletion, [&]() {
+      PrintIndented("");
+      Print("js_throw(_js_exception_%d);\n", slot);
+      PrintIndented("");
+      Print("goto %s;\n", ExceptionHandlerLabel().c_str());
+    });
+  }
+  if (finally.returns) {
+    print_resumption(kReturnCompletion, [&]() { PrintReturnValue(); });
+  }
+  for (size_t i = 0; i < finally.jumps.size(); i++) {
+    print_resumption(kFirstJumpCompletion + static_cast<int>(i), [&]() {
+      PrintJump(finally.jumps[i].first, finally.jumps[i].second);
+    });
+  }
+}
+
+// The label an exception thrown by the code being printed goes to.
+std::string CCodeGenerator::ExceptionHandlerLabel() {
+  if (handlers_.empty()) {
+    unwind_used_ = true;
+    return "js_unwind";
+  }
+  handlers_.back().used = true;
+  return handlers_.back().label;
 }
 
 void CCodeGenerator::VisitDebuggerStatement(DebuggerStatement* node) {
@@ -524,16 +2769,9 @@ void CCodeGenerator::VisitDebuggerStatement(DebuggerStatement* node) {
 
 
 void CCodeGenerator::VisitFunctionLiteral(FunctionLiteral* node) {
-  CIndentedScope indent(this, "FUNC LITERAL", node->position());
-  PrintIndented("LITERAL ID");
-  Print(" %d\n", node->function_literal_id());
-  PrintLiteralIndented("NAME", node->raw_name(), false);
-  PrintLiteralIndented("INFERRED NAME", node->raw_inferred_name(), false);
-  // We don't want to see the function literal in this case: it
-  // will be printed via PrintProgram when the code for it is
-  // generated.
-  // PrintParameters(node->scope());
-  // PrintStatements(node->body());
+  // The body is printed on its own when the driver reaches the function in
+  // the call graph; here it is just a closure.
+  PrintClosureCreation(node);
 }
 
 
@@ -627,15 +2865,43 @@ void CCodeGenerator::VisitNativeFunctionLiteral(NativeFunctionLiteral* node) {
 
 
 void CCodeGenerator::VisitConditional(Conditional* node) {
-  CIndentedScope indent(this, "CONDITIONAL", node->position());
-  PrintIndentedVisit("CONDITION", node->condition());
-  PrintIndentedVisit("THEN", node->then_expression());
-  PrintIndentedVisit("ELSE", node->else_expression());
+  InferredType type = RepresentationOf(node);
+  Print("(");
+  PrintConverted(node->condition(), InferredType::kBoolean);
+  Print(" ? ");
+  PrintConverted(node->then_expression(), type);
+  Print(" : ");
+  PrintConverted(node->else_expression(), type);
+  Print(")");
 }
 
 
 void CCodeGenerator::VisitLiteral(Literal* node) {
-  PrintLiteral(node, false);
+  switch (node->type()) {
+    case Literal::kSmi:
+      Print("%d", Smi::ToInt(node->AsSmiLiteral()));
+      break;
+    case Literal::kHeapNumber:
+      PrintNumber(node->AsNumber());
+      break;
+    case Literal::kBoolean:
+      Print("%s", node->ToBooleanIsTrue() ? "true" : "false");
+      break;
+    case Literal::kString:
+      Print("make_string(");
+      PrintString(node->AsRawString());
+      Print(")");
+      break;
+    case Literal::kNull:
+      Print("make_null()");
+      break;
+    case Literal::kBigInt:
+      // BigInts are not supported by the runtime yet.
+    case Literal::kUndefined:
+    case Literal::kTheHole:
+      Print("make_undefined()");
+      break;
+  }
 }
 
 
@@ -656,10 +2922,46 @@ void CCodeGenerator::VisitRegExpLiteral(RegExpLiteral* node) {
 
 
 void CCodeGenerator::VisitObjectLiteral(ObjectLiteral* node) {
+  if (PrintObjectLiteral(node)) return;
   CIndentedScope indent(this, "OBJ LITERAL", node->position());
   PrintObjectProperties(node->properties());
 }
 
+// Builds the object with one store per property; the store caches replay
+// the shape transitions after the first run. Returns false for literals with
+// accessors, spreads or __proto__.
+bool CCodeGenerator::PrintObjectLiteral(ObjectLiteral* node) {
+  for (ObjectLiteral::Property* property : *node->properties()) {
+    switch (property->kind()) {
+      case ObjectLiteral::Property::CONSTANT:
+      case ObjectLiteral::Property::COMPUTED:
+      case ObjectLiteral::Property::MATERIALIZED_LITERAL:
+        break;
+      default:
+        return false;
+    }
+  }
+  int object = temp_count_++;
+  Print("({ js_value _js_t%d = js_object_new(%d); ", object,
+        node->properties()->length());
+  for (ObjectLiteral::Property* property : *node->properties()) {
+    auto ic = store_ics_.find(property);
+    if (ic != store_ics_.end()) {
+      Print("js_store_named(_js_t%d, ", object);
+      PrintConverted(property->value(), InferredType::kDynamic);
+      Print(", &_js_ic_%d); ", ic->second);
+    } else {
+      Print("js_set_property(_js_t%d, ", object);
+      PrintConverted(property->key(), InferredType::kDynamic);
+      Print(", ");
+      PrintConverted(property->value(), InferredType::kDynamic);
+      Print("); ");
+    }
+  }
+  Print("_js_t%d; })", object);
+  return true;
+}
+
 void CCodeGenerator::PrintObjectProperties(
     const ZonePtrList<ObjectLiteral::Property>* properties) {
   for (int i = 0; i < properties->length(); i++) {
@@ -698,6 +3000,7 @@ void CCodeGenerator::PrintObjectProperties(
 
 
 void CCodeGenerator::VisitArrayLiteral(ArrayLiteral* node) {
+  if (PrintArrayLiteral(node)) return;
   CIndentedScope array_indent(this, "ARRAY LITERAL", node->position());
   if (node->values()->length() > 0) {
     CIndentedScope indent(this, "VALUES", node->position());
@@ -708,6 +3011,47 @@ void CCodeGenerator::VisitArrayLiteral(ArrayLiteral* node) {
 }
 
 
+// Stores the elements unboxed when their representations allow it, so that
+// the array starts out in the most specific elements kind. Returns false for
+// literals with spreads or holes.
+bool CCodeGenerator::PrintArrayLiteral(ArrayLiteral* node) {
+  if (node->builder()->first_spread_index() >= 0) return false;
+  InferredType element_type = InferredType::kSmi;
+  for (Expression* value : *node->values()) {
+    if (value->IsTheHoleLiteral()) return false;
+    InferredType type = RepresentationOf(value);
+    if (type == InferredType::kDouble && element_type == InferredType::kSmi) {
+      element_type = InferredType::kDouble;
+    } else if (type != InferredType::kSmi && type != InferredType::kDouble) {
+      element_type = InferredType::kDynamic;
+    }
+  }
+  const char* kind = element_type == InferredType::kSmi ? "SMI"
+                     : element_type == InferredType::kDouble ? "DOUBLE"
+                                                             : "GENERIC";
+  const char* elements = element_type == InferredType::kSmi ? "smi"
+                         : element_type == InferredType::kDouble ? "double"
+                                                                 : "generic";
+  int length = node->values()->length();
+  if (length == 0) {
+    Print("js_array_new(JS_ELEMENTS_SMI, 0)");
+    return true;
+  }
+  int array = temp_count_++;
+  int store = temp_count_++;
+  Print("({ js_value _js_t%d = js_array_new(JS_ELEMENTS_%s, %d); ", array,
+        kind, length);
+  PrintCType(element_type);
+  Print("* _js_t%d = js_array_%s_elements(_js_t%d); ", store, elements, array);
+  for (int i = 0; i < length; i++) {
+    Print("_js_t%d[%d] = ", store, i);
+    PrintConverted(node->values()->at(i), element_type);
+    Print("; ");
+  }
+  Print("_js_t%d; })", array);
+  return true;
+}
+
 void CCodeGenerator::VisitVariableProxy(VariableProxy* node) {
   // base::EmbeddedVector<char, 128> buf;
   // int pos = SNPrintF(buf, "VAR PROXY");
@@ -740,24 +3084,52 @@ void CCodeGenerator::VisitVariableProxy(VariableProxy* node) {
   //       SNPrintF(buf + pos, " repl global[%d]", var->index());
   //       break;
   //   }
-  PrintLiteral(node->raw_name(), false);
+  if (node->is_resolved()) {
+    PrintVariable(node->var());
+  } else {
+    PrintLiteral(node->raw_name(), false);
+  }
 }
 
 
 void CCodeGenerator::VisitAssignment(Assignment* node) {
   // CIndentedScope indent(this, Token::Name(node->op()), node->position());
-  PrintIndented("");
-  Visit(node->target());
-  Print(" = ");
-  Visit(node->value());
-  Print(";\n");
+  Print("(");
+  PrintAssignment(node);
+  Print(")");
 }
 
 void CCodeGenerator::VisitCompoundAssignment(CompoundAssignment* node) {
   VisitAssignment(node);
 }
 
+void CCodeGenerator::PrintAssignment(Assignment* node) {
+  Property* property = node->target()->AsProperty();
+  if (property != nullptr) {
+    PrintPropertyAssignment(node, property);
+    return;
+  }
+  InferredType type = RepresentationOf(node->target());
+  Visit(node->target());
+  Print(" = ");
+  if (node->IsCompoundAssignment()) {
+    PrintConverted(static_cast<CompoundAssignment*>(node)->binary_operation(),
+                   type);
+  } else if (Token::IsLogicalAssignmentOp(node->op())) {
+    PrintLogicalOperation(Token::BinaryOpForAssignment(node->op()), type,
+                          node->target(), {node->value()});
+  } else {
+    PrintConverted(node->value(), type);
+  }
+}
+
+// Inside a resume function a suspend has been printed before its statement;
+// see PrintSuspend.
 void CCodeGenerator::VisitYield(Yield* node) {
+  if (generator_frame_ != nullptr) {
+    Print("_js_sent");
+    return;
+  }
   base::EmbeddedVector<char, 128> buf;
   SNPrintF(buf, "YIELD");
   CIndentedScope indent(this, buf.begin(), node->position());
@@ -772,6 +3144,10 @@ void CCodeGenerator::VisitYieldStar(YieldStar* node) {
 }
 
 void CCodeGenerator::VisitAwait(Await* node) {
+  if (generator_frame_ != nullptr) {
+    Print("_js_sent");
+    return;
+  }
   base::EmbeddedVector<char, 128> buf;
   SNPrintF(buf, "AWAIT");
   CIndentedScope indent(this, buf.begin(), node->position());
@@ -779,8 +3155,9 @@ void CCodeGenerator::VisitAwait(Await* node) {
 }
 
 void CCodeGenerator::VisitThrow(Throw* node) {
-  CIndentedScope indent(this, "THROW", node->position());
-  Visit(node->exception());
+  Print("({ js_throw(");
+  PrintConverted(node->exception(), InferredType::kDynamic);
+  Print("); goto %s; })", ExceptionHandlerLabel().c_str());
 }
 
 void CCodeGenerator::VisitOptionalChain(OptionalChain* node) {
@@ -788,13 +3165,151 @@ void CCodeGenerator::VisitOptionalChain(OptionalChain* node) {
   Visit(node->expression());
 }
 
+InferredType CCodeGenerator::KeyRepresentationOf(Property* property) {
+  return RepresentationOf(property->key()) == InferredType::kSmi
+             ? InferredType::kSmi
+             : InferredType::kDynamic;
+}
+
+void CCodeGenerator::PrintPropertyOperand(Expression* expr,
+                                          InferredType type) {
+  auto it = operand_temps_.find(expr);
+  if (it != operand_temps_.end()) {
+    Print("_js_t%d", it->second);
+  } else {
+    PrintConverted(expr, type);
+  }
+}
+
+void CCodeGenerator::BindPropertyOperand(Expression* expr,
+                                         InferredType type) {
+  int id = temp_count_++;
+  PrintCType(type);
+  Print(" _js_t%d = ", id);
+  PrintConverted(expr, type);
+  Print("; ");
+  operand_temps_[expr] = id;
+}
+
+// Prints a store to {property} of the boxed value printed by {print_value}.
+template <typename PrintValue>
+void CCodeGenerator::PrintPropertyStore(Property* property,
+                                        PrintValue print_value) {
+  auto ic = store_ics_.find(property);
+  bool is_named = ic != store_ics_.end();
+  InferredType key_type = KeyRepresentationOf(property);
+  Print(is_named                          ? "js_store_named("
+        : key_type == InferredType::kSmi ? "js_set_element("
+                                          : "js_set_property(");
+  PrintPropertyOperand(property->obj(), InferredType::kDynamic);
+  Print(", ");
+  if (!is_named) {
+    PrintPropertyOperand(property->key(), key_type);
+    Print(", ");
+  }
+  print_value();
+  if (is_named) Print(", &_js_ic_%d", ic->second);
+  Print(")");
+}
+
+void CCodeGenerator::PrintPropertyAssignment(Assignment* node,
+                                             Property* property) {
+  AssignType type = Property::GetAssignType(property);
+  if (type != NAMED_PROPERTY && type != KEYED_PROPERTY) {
+    Visit(property);
+    Print(" = ");
+    PrintConverted(node->value(), InferredType::kDynamic);
+    return;
+  }
+  if (!node->IsCompoundAssignment() &&
+      !Token::IsLogicalAssignmentOp(node->op())) {
+    if (array_loop_ != nullptr && PrintArrayLoopStore(node, property)) return;
+    PrintPropertyStore(property, [&]() {
+      PrintConverted(node->value(), InferredType::kDynamic);
+    });
+    return;
+  }
+  // The receiver and key are read and written, but evaluated only once.
+  Print("({ ");
+  BindPropertyOperand(property->obj(), InferredType::kDynamic);
+  if (type == KEYED_PROPERTY) {
+    BindPropertyOperand(property->key(), KeyRepresentationOf(property));
+  }
+  PrintPropertyStore(property, [&]() {
+    if (node->IsCompoundAssignment()) {
+      PrintConverted(
+          static_cast<CompoundAssignment*>(node)->binary_operation(),
+          InferredType::kDynamic);
+    } else {
+      PrintLogicalOperation(Token::BinaryOpForAssignment(node->op()),
+                            InferredType::kDynamic, property,
+                            {node->value()});
+    }
+  });
+  Print("; })");
+  operand_temps_.erase(property->obj());
+  operand_temps_.erase(property->key());
+}
+
+void CCodeGenerator::PrintPropertyCountOperation(CountOperation* node,
+                                                 Property* property) {
+  AssignType type = Property::GetAssignType(property);
+  Print("({ ");
+  BindPropertyOperand(property->obj(), InferredType::kDynamic);
+  if (type == KEYED_PROPERTY) {
+    BindPropertyOperand(property->key(), KeyRepresentationOf(property));
+  }
+  int old_value = temp_count_++;
+  Print("js_value _js_t%d = make_number(js_to_number(", old_value);
+  Visit(property);
+  Print(")); ");
+  PrintPropertyStore(property, [&]() {
+    Print("make_number(js_number_value(_js_t%d) %s 1)", old_value,
+          node->op() == Token::INC ? "+" : "-");
+  });
+  Print("; ");
+  if (!node->is_prefix()) Print("_js_t%d; ", old_value);
+  Print("})");
+  operand_temps_.erase(property->obj());
+  operand_temps_.erase(property->key());
+}
+
 void CCodeGenerator::VisitProperty(Property* node) {
+  AssignType type = Property::GetAssignType(node);
+  if (type == NAMED_PROPERTY) {
+    if (RepresentationOf(node) == InferredType::kSmi) {
+      // The inference only types the length of a string. It counts UTF-8
+      // bytes, which is the UTF-16 length only for ASCII; see js2c_string.h.
+      Print("js_string_length(");
+      PrintPropertyOperand(node->obj(), InferredType::kDynamic);
+      Print(")");
+      return;
+    }
+    auto ic = load_ics_.find(node);
+    DCHECK(ic != load_ics_.end());
+    bool is_length = NamedPropertyKey(node)->IsOneByteEqualTo("length");
+    Print(is_length ? "js_load_length(" : "js_load_named(");
+    PrintPropertyOperand(node->obj(), InferredType::kDynamic);
+    Print(", &_js_ic_%d)", ic->second);
+    return;
+  }
+  if (type == KEYED_PROPERTY) {
+    if (array_loop_ != nullptr && PrintArrayLoopLoad(node)) return;
+    InferredType key_type = KeyRepresentationOf(node);
+    Print(key_type == InferredType::kSmi ? "js_get_element("
+                                         : "js_get_property(");
+    PrintPropertyOperand(node->obj(), InferredType::kDynamic);
+    Print(", ");
+    PrintPropertyOperand(node->key(), key_type);
+    Print(")");
+    return;
+  }
+
   base::EmbeddedVector<char, 128> buf;
   SNPrintF(buf, "PROPERTY");
   CIndentedScope indent(this, buf.begin(), node->position());
 
   Visit(node->obj());
-  AssignType type = Property::GetAssignType(node);
   switch (type) {
     case NAMED_PROPERTY:
     case NAMED_SUPER_PROPERTY: {
@@ -832,12 +3347,317 @@ void CCodeGenerator::VisitCall(Call* node) {
   // SNPrintF(buf, "CALL");
   // CIndentedScope indent(this, buf.begin());
 
-  Visit(node->expression());
+  if (PrintArrayBuiltinCall(node)) return;
+
+  FunctionLiteral* callee = DirectCallee(types_, node);
+  if (callee != nullptr && escapes_ != nullptr &&
+      escapes_->NeedsArenaScope(CalleeTypes(node, callee))) {
+    PrintArenaCall(node, callee);
+    return;
+  }
+  bool may_throw = CallMayThrow(node, callee);
+  if (may_throw) Print("JS_CHECKED_CALL(%s, ", ExceptionHandlerLabel().c_str());
+  if (callee == nullptr) {
+    PrintIndirectCall(node);
+  } else {
+    PrintDirectCall(node, callee);
+  }
+  if (may_throw) Print(")");
+}
+
+bool CCodeGenerator::CallMayThrow(Call* node, FunctionLiteral* callee) const {
+  if (callee != nullptr) {
+    return call_graph_ == nullptr || call_graph_->MayThrow(callee);
+  }
+  return closures_ != nullptr && !IsRuntimeFunctionCall(node);
+}
+
+// Nothing the callee allocates outlives the call, so it is all released
+// when the call returns. The result is unboxed and needs no arena memory.
+// The arguments are evaluated into temporaries before the scope is entered:
+// what they allocate may be kept by the caller, as in f(x = [1, 2]), and an
+// exception they throw goes to the handler directly.
+void CCodeGenerator::PrintArenaCall(Call* node, FunctionLiteral* callee) {
+  const FunctionTypes* callee_types = CalleeTypes(node, callee);
+  DeclarationScope* callee_scope = callee->scope();
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  Print("({ ");
+  std::vector<std::string> values;
+  for (int i = 0; i < arguments->length(); i++) {
+    if (i >= callee_scope->num_parameters()) {
+      Print("(void)");
+      Visit(arguments->at(i));
+      Print("; ");
+      continue;
+    }
+    InferredType type =
+        CRepresentation(callee_types->TypeOf(callee_scope->parameter(i)));
+    values.push_back("_js_t" + std::to_string(temp_count_++));
+    PrintCType(type);
+    Print(" %s = ", values.back().c_str());
+    PrintConverted(arguments->at(i), type);
+    Print("; ");
+  }
+
+  base::EmbeddedVector<char, 32> scope;
+  base::EmbeddedVector<char, 32> result;
+  SNPrintF(scope, "_js_t%d", temp_count_++);
+  SNPrintF(result, "_js_t%d", temp_count_++);
+  Print("js_arena_scope %s = js_arena_enter_scope(); ", scope.begin());
+  PrintCType(RepresentationOf(node));
+  Print(" %s = ", result.begin());
+  PrintFunctionName(callee, callee_types);
   Print("(");
-  PrintArguments(node->arguments());
+  for (int i = 0; i < callee_scope->num_parameters(); i++) {
+    if (i > 0) Print(", ");
+    if (i < static_cast<int>(values.size())) {
+      Print("%s", values[i].c_str());
+      continue;
+    }
+    InferredType type = callee_types->TypeOf(callee_scope->parameter(i));
+    PrintConversionPrefix(InferredType::kDynamic, type);
+    Print("make_undefined()");
+    PrintConversionSuffix(InferredType::kDynamic, type);
+  }
+  if (NeedsClosure(callee)) {
+    if (callee_scope->num_parameters() > 0) Print(", ");
+    Visit(node->expression());
+  }
+  Print("); js_arena_exit_scope(%s); ", scope.begin());
+  if (CallMayThrow(node, callee)) {
+    Print("if (__builtin_expect(js_exception_pending, 0)) goto %s; ",
+          ExceptionHandlerLabel().c_str());
+  }
+  Print("%s; })", result.begin());
+}
+
+// Lowers calls of the array and string methods with a runtime builtin. The
+// generator methods call the method of anything that is not a generator
+// themselves.
+bool CCodeGenerator::PrintArrayBuiltinCall(Call* node) {
+  ArrayOpCallback callback;
+  ArrayBuiltin builtin = LowerableArrayBuiltin(types_, node, &callback);
+  if (builtin == ArrayBuiltin::kNone) return false;
+  if (builtin != ArrayBuiltin::kGeneratorNext &&
+      builtin != ArrayBuiltin::kGeneratorThrow) {
+    PrintGuardedArrayBuiltinCall(node);
+    return true;
+  }
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  Expression* receiver = node->expression()->AsProperty()->obj();
+  // Resuming a generator runs its body, which may throw.
+  bool may_throw = CallMayThrow(node, nullptr);
+  if (may_throw) Print("JS_CHECKED_CALL(%s, ", ExceptionHandlerLabel().c_str());
+  Print(builtin == ArrayBuiltin::kGeneratorNext ? "js_generator_next("
+                                                : "js_generator_throw(");
+  PrintConverted(receiver, InferredType::kDynamic);
+  Print(", ");
+  if (arguments->length() == 1) {
+    PrintConverted(arguments->at(0), InferredType::kDynamic);
+  } else {
+    Print("make_undefined()");
+  }
+  Print(may_throw ? "))" : ")");
+  return true;
+}
+
+// Nothing is known about the receiver, so the builtin is only called on an
+// array, or on a string for indexOf and the string methods. Anything else
+// calls the method it has, as the call does without the lowering, which may
+// throw. The receiver and the arguments are evaluated once into
+// temporaries, in order, and shared by both calls. The callback of map and
+// reduce, which the builtin replaces, is only evaluated for the method call.
+void CCodeGenerator::PrintGuardedArrayBuiltinCall(Call* node) {
+  ArrayOpCallback callback;
+  ArrayBuiltin builtin = LowerableArrayBuiltin(types_, node, &callback);
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  Property* property = node->expression()->AsProperty();
+  auto ic = load_ics_.find(property);
+  DCHECK(ic != load_ics_.end());
+  bool may_throw = CallMayThrow(node, nullptr);
+  if (may_throw) Print("JS_CHECKED_CALL(%s, ", ExceptionHandlerLabel().c_str());
+  int receiver = temp_count_++;
+  Print("({ js_value _js_t%d = ", receiver);
+  PrintConverted(property->obj(), InferredType::kDynamic);
+  Print("; ");
+  bool has_callback =
+      builtin == ArrayBuiltin::kMap || builtin == ArrayBuiltin::kReduce;
+  std::vector<int> values(arguments->length(), -1);
+  for (int i = has_callback ? 1 : 0; i < arguments->length(); i++) {
+    values[i] = temp_count_++;
+    Print("js_value _js_t%d = ", values[i]);
+    PrintConverted(arguments->at(i), InferredType::kDynamic);
+    Print("; ");
+  }
+
+  if (builtin == ArrayBuiltin::kIndexOf) {
+    Print("js_is_array(_js_t%d) || js_is_string(_js_t%d) ? ", receiver,
+          receiver);
+  } else if (builtin == ArrayBuiltin::kSubstring ||
+             builtin == ArrayBuiltin::kCharAt) {
+    Print("js_is_string(_js_t%d) ? ", receiver);
+  } else {
+    Print("js_is_array(_js_t%d) ? ", receiver);
+  }
+  switch (builtin) {
+    case ArrayBuiltin::kFill:
+      Print("js_array_fill(_js_t%d, _js_t%d)", receiver, values[0]);
+      break;
+    case ArrayBuiltin::kIndexOf:
+      Print("js_array_index_of(_js_t%d, _js_t%d)", receiver, values[0]);
+      break;
+    case ArrayBuiltin::kMap:
+      Print("js_array_map_op(_js_t%d, %s, ", receiver, callback.op);
+      PrintConverted(callback.operand, InferredType::kDynamic);
+      Print(", %s)", callback.swapped ? "true" : "false");
+      break;
+    case ArrayBuiltin::kReduce:
+      Print("js_array_reduce_op(_js_t%d, %s, ", receiver, callback.op);
+      if (arguments->length() == 2) {
+        Print("true, _js_t%d", values[1]);
+      } else {
+        Print("false, make_undefined()");
+      }
+      Print(", %s)", callback.swapped ? "true" : "false");
+      break;
+    case ArrayBuiltin::kSubstring:
+      Print("js_string_substring(_js_t%d, _js_t%d, ", receiver, values[0]);
+      if (arguments->length() == 2) {
+        Print("_js_t%d)", values[1]);
+      } else {
+        Print("make_undefined())");
+      }
+      break;
+    case ArrayBuiltin::kCharAt:
+      Print("js_string_char_at(_js_t%d, _js_t%d)", receiver, values[0]);
+      break;
+    default:
+      UNREACHABLE();
+  }
+
+  Print(" : js_call(js_load_named(_js_t%d, &_js_ic_%d), %d, ", receiver,
+        ic->second, arguments->length());
+  Print("(const js_value[]){");
+  for (int i = 0; i < arguments->length(); i++) {
+    if (i > 0) Print(", ");
+    if (values[i] < 0) {
+      PrintConverted(arguments->at(i), InferredType::kDynamic);
+    } else {
+      Print("_js_t%d", values[i]);
+    }
+  }
+  Print("}); })");
+  if (may_throw) Print(")");
+}
+
+void CCodeGenerator::PrintDirectCall(Call* node, FunctionLiteral* callee) {
+  // Arguments are converted to the parameter types of the callee. Missing
+  // ones are undefined and extra ones are only evaluated.
+  const FunctionTypes* callee_types = CalleeTypes(node, callee);
+  DeclarationScope* scope = callee->scope();
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  int extra = arguments->length() - scope->num_parameters();
+  if (extra > 0) {
+    Print("(");
+    for (int i = scope->num_parameters(); i < arguments->length(); i++) {
+      Print("(void)");
+      Visit(arguments->at(i));
+      Print(", ");
+    }
+  }
+  PrintFunctionName(callee, callee_types);
+  Print("(");
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    if (i > 0) Print(", ");
+    InferredType type = callee_types->TypeOf(scope->parameter(i));
+    if (i < arguments->length()) {
+      PrintConverted(arguments->at(i), type);
+    } else {
+      PrintConversionPrefix(InferredType::kDynamic, type);
+      Print("make_undefined()");
+      PrintConversionSuffix(InferredType::kDynamic, type);
+    }
+  }
+  if (NeedsClosure(callee)) {
+    // The variable the callee is called through holds its closure.
+    if (scope->num_parameters() > 0) Print(", ");
+    Visit(node->expression());
+  }
   Print(")");
+  if (extra > 0) Print(")");
+}
+
+
+// Calls through a value go through js_call, except for the names the runtime
+// provides as C functions, such as print, which are not declared anywhere.
+void CCodeGenerator::PrintIndirectCall(Call* node) {
+  if (closures_ == nullptr || IsRuntimeFunctionCall(node)) {
+    Visit(node->expression());
+    Print("(");
+    PrintArguments(node->arguments());
+    Print(")");
+    return;
+  }
+  FunctionLiteral* target = CallFeedbackTarget(node);
+  if (target != nullptr) {
+    PrintGuardedCall(node, target);
+    return;
+  }
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  Print("js_call(");
+  PrintConverted(node->expression(), InferredType::kDynamic);
+  if (arguments->is_empty()) {
+    Print(", 0, NULL)");
+    return;
+  }
+  Print(", %d, (const js_value[]){", arguments->length());
+  for (int i = 0; i < arguments->length(); i++) {
+    if (i > 0) Print(", ");
+    PrintConverted(arguments->at(i), InferredType::kDynamic);
+  }
+  Print("})");
 }
 
+FunctionLiteral* CCodeGenerator::CallFeedbackTarget(Call* node) const {
+  if (feedback_ == nullptr || node->spread_position() != Call::kNoSpread) {
+    return nullptr;
+  }
+  auto it = functions_by_position_.find(
+      feedback_->CallTarget(node->position()));
+  if (it == functions_by_position_.end()) return nullptr;
+  // Only functions that may be called through their value have the boxed
+  // entry the guard compares against.
+  FunctionLiteral* target = it->second;
+  return HasBoxedEntry(target) ? target : nullptr;
+}
+
+// The callee and the arguments are evaluated once into temporaries, in
+// order, and shared by the direct and the generic call.
+void CCodeGenerator::PrintGuardedCall(Call* node, FunctionLiteral* target) {
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  int callee = temp_count_++;
+  Print("({ js_value _js_t%d = ", callee);
+  PrintConverted(node->expression(), InferredType::kDynamic);
+  Print("; ");
+  std::string argv = "NULL";
+  if (!arguments->is_empty()) {
+    int values = temp_count_++;
+    argv = "_js_t" + std::to_string(values);
+    Print("const js_value %s[] = {", argv.c_str());
+    for (int i = 0; i < arguments->length(); i++) {
+      if (i > 0) Print(", ");
+      PrintConverted(arguments->at(i), InferredType::kDynamic);
+    }
+    Print("}; ");
+  }
+  Print("__builtin_expect(js_is_closure_of(_js_t%d, ", callee);
+  PrintFunctionName(target);
+  Print("__boxed), 1) ? ");
+  PrintFunctionName(target);
+  Print("__boxed(_js_t%d, %d, %s) : js_call(_js_t%d, %d, %s); })", callee,
+        arguments->length(), argv.c_str(), callee, arguments->length(),
+        argv.c_str());
+}
 
 void CCodeGenerator::VisitCallNew(CallNew* node) {
   CIndentedScope indent(this, "CALL NEW", node->position());
@@ -847,6 +3667,16 @@ void CCodeGenerator::VisitCallNew(CallNew* node) {
 
 
 void CCodeGenerator::VisitCallRuntime(CallRuntime* node) {
+  // The catch block the parser wraps around the body of an async function.
+  if (generator_frame_ != nullptr && !node->is_jsruntime() &&
+      node->function()->function_id == Runtime::kInlineAsyncFunctionReject) {
+    Print("js_async_function_reject(");
+    PrintConverted(node->arguments()->at(0), InferredType::kDynamic);
+    Print(", ");
+    PrintConverted(node->arguments()->at(1), InferredType::kDynamic);
+    Print(")");
+    return;
+  }
   base::EmbeddedVector<char, 128> buf;
   SNPrintF(buf, "CALL RUNTIME %s%s", node->debug_name(),
            node->is_jsruntime() ? " (JS function)" : "");
@@ -856,168 +3686,329 @@ void CCodeGenerator::VisitCallRuntime(CallRuntime* node) {
 
 
 void CCodeGenerator::VisitUnaryOperation(UnaryOperation* node) {
+  InferredType type = RepresentationOf(node);
+  Expression* operand = node->expression();
+  switch (node->op()) {
+    case Token::NOT:
+      Print("(!");
+      PrintConverted(operand, InferredType::kBoolean);
+      Print(")");
+      return;
+    case Token::BIT_NOT:
+      Print("(~");
+      PrintConverted(operand, InferredType::kSmi);
+      Print(")");
+      return;
+    case Token::ADD:
+      PrintConverted(operand, type);
+      return;
+    case Token::SUB:
+      if (type == InferredType::kSmi) {
+        Print("(-");
+        PrintConverted(operand, InferredType::kSmi);
+        Print(")");
+      } else {
+        PrintConversionPrefix(InferredType::kDouble, type);
+        Print("(-");
+        PrintConverted(operand, InferredType::kDouble);
+        Print(")");
+        PrintConversionSuffix(InferredType::kDouble, type);
+      }
+      return;
+    case Token::TYPEOF:
+      Print("js_typeof(");
+      PrintConverted(operand, InferredType::kDynamic);
+      Print(")");
+      return;
+    case Token::VOID:
+      Print("((void)");
+      Visit(operand);
+      Print(", make_undefined())");
+      return;
+    default:
+      break;
+  }
   CIndentedScope indent(this, Token::Name(node->op()), node->position());
   Visit(node->expression());
 }
 
 
 void CCodeGenerator::VisitCountOperation(CountOperation* node) {
-  base::EmbeddedVector<char, 128> buf;
-  SNPrintF(buf, "%s %s", (node->is_prefix() ? "PRE" : "POST"),
-           Token::Name(node->op()));
-  CIndentedScope indent(this, buf.begin(), node->position());
-  Visit(node->expression());
+  Property* property = node->expression()->AsProperty();
+  if (property != nullptr && (Property::GetAssignType(property) ==
+                                  NAMED_PROPERTY ||
+                              Property::GetAssignType(property) ==
+                                  KEYED_PROPERTY)) {
+    PrintPropertyCountOperation(node, property);
+    return;
+  }
+  VariableProxy* proxy = node->expression()->AsVariableProxy();
+  if (proxy == nullptr || !proxy->is_resolved()) {
+    base::EmbeddedVector<char, 128> buf;
+    SNPrintF(buf, "%s %s", (node->is_prefix() ? "PRE" : "POST"),
+             Token::Name(node->op()));
+    CIndentedScope indent(this, buf.begin(), node->position());
+    Visit(node->expression());
+    return;
+  }
+
+  int delta = node->op() == Token::INC ? 1 : -1;
+  switch (RepresentationOf(proxy)) {
+    case InferredType::kSmi:
+      // The old value of a postfix operation is recomputed from the new one.
+      // The update is only typed kSmi where it stays in int32.
+      Print("(");
+      Visit(proxy);
+      Print(" = ");
+      Visit(proxy);
+      Print(" + %d", delta);
+      if (!node->is_prefix()) {
+        Print(", ");
+        Visit(proxy);
+        Print(" - %d", delta);
+      }
+      Print(")");
+      break;
+    case InferredType::kDouble:
+      if (node->is_prefix()) Print("%s", Token::String(node->op()));
+      Visit(proxy);
+      if (!node->is_prefix()) Print("%s", Token::String(node->op()));
+      break;
+    default:
+      Print("(");
+      Visit(proxy);
+      Print(" = make_number(js_to_number(");
+      Visit(proxy);
+      Print(") + %d)", delta);
+      if (!node->is_prefix()) {
+        Print(", make_number(js_to_number(");
+        Visit(proxy);
+        Print(") - %d)", delta);
+      }
+      Print(")");
+      break;
+  }
 }
 
 
 void CCodeGenerator::VisitBinaryOperation(BinaryOperation* node) {
 //   CIndentedScope indent(this, Token::Name(node->op()), node->position());
-  Visit(node->left());
-  switch (node->op()) {
-  case Token::ADD:
-    Print(" + ");
-    break;
-  case Token::TEMPLATE_SPAN:
-  case Token::TEMPLATE_TAIL:
-  case Token::PERIOD:
-  case Token::LBRACK:
-  case Token::QUESTION_PERIOD:
-  case Token::LPAREN:
-  case Token::RPAREN:
-  case Token::RBRACK:
-  case Token::LBRACE:
-  case Token::COLON:
-  case Token::ELLIPSIS:
-  case Token::CONDITIONAL:
-  case Token::SEMICOLON:
-  case Token::RBRACE:
-  case Token::EOS:
-  case Token::ARROW:
-  case Token::INIT:
-  case Token::ASSIGN:
-  case Token::ASSIGN_NULLISH:
-  case Token::ASSIGN_OR:
-  case Token::ASSIGN_AND:
-  case Token::ASSIGN_BIT_OR:
-  case Token::ASSIGN_BIT_XOR:
-  case Token::ASSIGN_BIT_AND:
-  case Token::ASSIGN_SHL:
-  case Token::ASSIGN_SAR:
-  case Token::ASSIGN_SHR:
-  case Token::ASSIGN_MUL:
-  case Token::ASSIGN_DIV:
-  case Token::ASSIGN_MOD:
-  case Token::ASSIGN_EXP:
-  case Token::ASSIGN_ADD:
-  case Token::ASSIGN_SUB:
-  case Token::COMMA:
-  case Token::NULLISH:
-  case Token::OR:
-  case Token::AND:
-  case Token::BIT_OR:
-  case Token::BIT_XOR:
-  case Token::BIT_AND:
-  case Token::SHL:
-  case Token::SAR:
-  case Token::SHR:
-  case Token::MUL:
-  case Token::DIV:
-  case Token::MOD:
-  case Token::EXP:
-  case Token::SUB:
-    Print(" - ");
-    break;
-  case Token::NOT:
-  case Token::BIT_NOT:
-  case Token::DELETE:
-  case Token::TYPEOF:
-  case Token::VOID:
-  case Token::INC:
-  case Token::DEC:
-  case Token::EQ:
-  case Token::EQ_STRICT:
-  case Token::NE:
-  case Token::NE_STRICT:
-  case Token::LT:
-  case Token::GT:
-  case Token::LTE:
-  case Token::GTE:
-  case Token::INSTANCEOF:
-  case Token::IN:
-  case Token::BREAK:
-  case Token::CASE:
-  case Token::CATCH:
-  case Token::CONTINUE:
-  case Token::DEBUGGER:
-  case Token::DEFAULT:
-  case Token::DO:
-  case Token::ELSE:
-  case Token::FINALLY:
-  case Token::FOR:
-  case Token::FUNCTION:
-  case Token::IF:
-  case Token::NEW:
-  case Token::RETURN:
-  case Token::SWITCH:
-  case Token::THROW:
-  case Token::TRY:
-  case Token::VAR:
-  case Token::WHILE:
-  case Token::WITH:
-  case Token::THIS:
-  case Token::NULL_LITERAL:
-  case Token::TRUE_LITERAL:
-  case Token::FALSE_LITERAL:
-  case Token::NUMBER:
-  case Token::SMI:
-  case Token::BIGINT:
-  case Token::STRING:
-  case Token::SUPER:
-  case Token::IDENTIFIER:
-  case Token::GET:
-  case Token::SET:
-  case Token::ASYNC:
-  case Token::AWAIT:
-  case Token::YIELD:
-  case Token::LET:
-  case Token::STATIC:
-  case Token::FUTURE_STRICT_RESERVED_WORD:
-  case Token::ESCAPED_STRICT_RESERVED_WORD:
-  case Token::ENUM:
-  case Token::CLASS:
-  case Token::CONST:
-  case Token::EXPORT:
-  case Token::EXTENDS:
-  case Token::IMPORT:
-  case Token::PRIVATE_NAME:
-  case Token::ILLEGAL:
-  case Token::ESCAPED_KEYWORD:
-  case Token::WHITESPACE:
-  case Token::UNINITIALIZED:
-  case Token::REGEXP_LITERAL:
-  case Token::NUM_TOKENS:
-    break;
-  }
-  Visit(node->right());
+  InferredType type = RepresentationOf(node);
+  if (IsLogicalOp(node->op())) {
+    PrintLogicalOperation(node->op(), type, node->left(), {node->right()});
+    return;
+  }
+  CBinaryOperation operation =
+      GetCBinaryOperation(node->op(), type);
+  if (node->op() == Token::ADD && type == InferredType::kDynamic &&
+      feedback_ != nullptr &&
+      IsNumericType(feedback_->BinaryOperationHint(node->position()))) {
+    operation.prefix = "js_speculative_add(";
+  }
+  PrintConversionPrefix(operation.result, type);
+  Print("%s", operation.prefix);
+  PrintConverted(node->left(), operation.left);
+  Print("%s", operation.infix);
+  PrintConverted(node->right(), operation.right);
+  Print("%s", operation.suffix);
+  PrintConversionSuffix(operation.result, type);
 }
 
 void CCodeGenerator::VisitNaryOperation(NaryOperation* node) {
   // CIndentedScope indent(this, Token::Name(node->op()), node->position());
-  Visit(node->first());
-  Print(" %s ", Token::String(node->op()));
+  InferredType type = RepresentationOf(node);
+  if (IsLogicalOp(node->op())) {
+    std::vector<Expression*> rest;
+    for (size_t i = 0; i < node->subsequent_length(); ++i) {
+      rest.push_back(node->subsequent(i));
+    }
+    PrintLogicalOperation(node->op(), type, node->first(), rest);
+    return;
+  }
+
+  // Once the first addition produces a string every later one appends to
+  // it, so the whole chain is built with one allocation of the final size.
+  if (node->op() == Token::ADD &&
+      types_ != nullptr &&
+      types_->BinaryOperationType(node, 0, TypeOf(node->first()),
+                                  TypeOf(node->subsequent(0))) ==
+          InferredType::kString) {
+    Print("js_string_concat(%zu, (const js_value[]){",
+          node->subsequent_length() + 1);
+    PrintConverted(node->first(), InferredType::kDynamic);
+    for (size_t i = 0; i < node->subsequent_length(); ++i) {
+      Print(", ");
+      PrintConverted(node->subsequent(i), InferredType::kDynamic);
+    }
+    Print("})");
+    return;
+  }
+
+  // The operation is left-associative, so the C expression is nested with
+  // the first operation innermost. Type the intermediate results the same
+  // way the inference did.
+  std::vector<CBinaryOperation> operations;
+  InferredType intermediate = TypeOf(node->first());
   for (size_t i = 0; i < node->subsequent_length(); ++i) {
-    Visit(node->subsequent(i));
+    Expression* operand = node->subsequent(i);
+    intermediate = types_ != nullptr
+                       ? types_->BinaryOperationType(node, i, intermediate,
+                                                     TypeOf(operand))
+                       : InferredType::kDynamic;
+    bool last = i + 1 == node->subsequent_length();
+    operations.push_back(GetCBinaryOperation(
+        node->op(), last ? type : CRepresentation(intermediate)));
+    if (node->op() == Token::ADD &&
+        operations.back().result == InferredType::kDynamic &&
+        feedback_ != nullptr &&
+        IsNumericType(feedback_->BinaryOperationHint(
+            node->subsequent_op_position(i)))) {
+      operations.back().prefix = "js_speculative_add(";
+    }
+  }
 
-    if (i != node->subsequent_length() - 1) {
-      Print(" %s ", Token::String(node->op()));
+  size_t count = operations.size();
+  PrintConversionPrefix(operations[count - 1].result, type);
+  for (size_t i = count; i-- > 0;) {
+    Print("%s", operations[i].prefix);
+    if (i > 0) {
+      PrintConversionPrefix(operations[i - 1].result, operations[i].left);
     }
   }
+  PrintConverted(node->first(), operations[0].left);
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0) {
+      PrintConversionSuffix(operations[i - 1].result, operations[i].left);
+    }
+    Print("%s", operations[i].infix);
+    PrintConverted(node->subsequent(i), operations[i].right);
+    Print("%s", operations[i].suffix);
+  }
+  PrintConversionSuffix(operations[count - 1].result, type);
+}
+
+void CCodeGenerator::PrintLogicalOperation(
+    Token::Value op, InferredType type, Expression* first,
+    const std::vector<Expression*>& rest) {
+  if (type == InferredType::kBoolean && op != Token::NULLISH) {
+    Print("(");
+    PrintConverted(first, InferredType::kBoolean);
+    for (Expression* operand : rest) {
+      Print(op == Token::OR ? " || " : " && ");
+      PrintConverted(operand, InferredType::kBoolean);
+    }
+    Print(")");
+    return;
+  }
+
+  // The result is one of the operands, so each of them is evaluated into a
+  // temporary of a GNU statement expression before it is tested.
+  base::EmbeddedVector<char, 32> name;
+  SNPrintF(name, "_js_t%d", temp_count_++);
+  Print("({ ");
+  PrintCType(type);
+  Print(" %s = ", name.begin());
+  PrintConverted(first, type);
+  Print("; ");
+  for (Expression* operand : rest) {
+    Print("if (");
+    switch (op) {
+      case Token::OR:
+        Print("!");
+        PrintTruthiness(name.begin(), type);
+        break;
+      case Token::AND:
+        PrintTruthiness(name.begin(), type);
+        break;
+      default:
+        // Only a boxed value can be null or undefined.
+        if (type == InferredType::kDynamic) {
+          Print("js_is_nullish(%s)", name.begin());
+        } else {
+          Print("false");
+        }
+        break;
+    }
+    Print(") %s = ", name.begin());
+    PrintConverted(operand, type);
+    Print("; ");
+  }
+  Print("%s; })", name.begin());
 }
 
 void CCodeGenerator::VisitCompareOperation(CompareOperation* node) {
-  CIndentedScope indent(this, Token::Name(node->op()), node->position());
-  Visit(node->left());
-  Visit(node->right());
+  Token::Value op = node->op();
+  if (op == Token::INSTANCEOF || op == Token::IN) {
+    CIndentedScope indent(this, Token::Name(node->op()), node->position());
+    Visit(node->left());
+    Visit(node->right());
+    return;
+  }
+
+  InferredType left = RepresentationOf(node->left());
+  InferredType right = RepresentationOf(node->right());
+  bool strict = op == Token::EQ_STRICT || op == Token::NE_STRICT;
+  bool negate = op == Token::NE || op == Token::NE_STRICT;
+
+  if (IsUnboxedType(left) && IsUnboxedType(right)) {
+    if (strict && left != right &&
+        !(IsNumericType(left) && IsNumericType(right))) {
+      // A boolean is never strictly equal to a number.
+      Print("((void)");
+      Visit(node->left());
+      Print(", (void)");
+      Visit(node->right());
+      Print(", %s)", negate ? "true" : "false");
+      return;
+    }
+    // Booleans compare as numbers, except against each other.
+    InferredType type = left == right ? left
+                        : left == InferredType::kDouble ||
+                                right == InferredType::kDouble
+                            ? InferredType::kDouble
+                            : InferredType::kSmi;
+    Print("(");
+    PrintConverted(node->left(), type);
+    Print(" %s ", strict ? (negate ? "!=" : "==") : Token::String(op));
+    PrintConverted(node->right(), type);
+    Print(")");
+    return;
+  }
+
+  const char* function;
+  switch (op) {
+    case Token::EQ_STRICT:
+    case Token::NE_STRICT:
+      function = "strict_equals";
+      break;
+    case Token::EQ:
+    case Token::NE:
+      function = "equals";
+      break;
+    case Token::LT:
+      function = "less_than";
+      break;
+    case Token::GT:
+      function = "greater_than";
+      break;
+    case Token::LTE:
+      function = "less_than_or_equal";
+      break;
+    case Token::GTE:
+      function = "greater_than_or_equal";
+      break;
+    default:
+      UNREACHABLE();
+  }
+  bool speculative =
+      feedback_ != nullptr &&
+      IsNumericType(feedback_->CompareOperationHint(node->position()));
+  Print("%sjs_%s%s(", negate ? "!" : "", speculative ? "speculative_" : "",
+        function);
+  PrintConverted(node->left(), InferredType::kDynamic);
+  Print(", ");
+  PrintConverted(node->right(), InferredType::kDynamic);
+  Print(")");
 }
 
 
@@ -1034,17 +4025,30 @@ void CCodeGenerator::VisitGetTemplateObject(GetTemplateObject* node) {
   CIndentedScope indent(this, "GET-TEMPLATE-OBJECT", node->position());
 }
 
+// Built like a chain of + that produces a string; see VisitNaryOperation.
 void CCodeGenerator::VisitTemplateLiteral(TemplateLiteral* node) {
-  CIndentedScope indent(this, "TEMPLATE-LITERAL", node->position());
-  const AstRawString* string = node->string_parts()->first();
-  if (!string->IsEmpty()) PrintLiteralIndented("SPAN", string, true);
-  for (int i = 0; i < node->substitutions()->length();) {
-    PrintIndentedVisit("EXPR", node->substitutions()->at(i++));
-    if (i < node->string_parts()->length()) {
-      string = node->string_parts()->at(i);
-      if (!string->IsEmpty()) PrintLiteralIndented("SPAN", string, true);
+  const ZonePtrList<const AstRawString>* spans = node->string_parts();
+  const ZonePtrList<Expression>* substitutions = node->substitutions();
+  int count = substitutions->length();
+  for (const AstRawString* span : *spans) {
+    if (!span->IsEmpty()) count++;
+  }
+  Print("js_string_concat(%d, (const js_value[]){", count);
+  const char* separator = "";
+  for (int i = 0; i < spans->length(); i++) {
+    if (!spans->at(i)->IsEmpty()) {
+      Print("%smake_string(", separator);
+      PrintString(spans->at(i));
+      Print(")");
+      separator = ", ";
+    }
+    if (i < substitutions->length()) {
+      Print("%s", separator);
+      PrintConverted(substitutions->at(i), InferredType::kDynamic);
+      separator = ", ";
     }
   }
+  Print("})");
 }
 
 void CCodeGenerator::VisitImportCallExpression(ImportCallExpression* node) {
@@ -2,10 +2,23 @@
 #define V8_C_CODE_GENERATOR_H_
 
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "src/ast/ast.h"
 #include "src/base/compiler-specific.h"
 #include "src/execution/isolate.h"
+#include "src/js2c/call-graph.h"
+#include "src/js2c/closure-conversion.h"
+#include "src/js2c/escape-analysis.h"
+#include "src/js2c/generator-frame.h"
+#include "src/js2c/output-buffer.h"
+#include "src/js2c/interned-strings.h"
+#include "src/js2c/type-feedback.h"
+#include "src/js2c/type-inference.h"
 #include "src/objects/function-kind.h"
 
 namespace v8 {
@@ -13,22 +26,47 @@ namespace internal {
 
 class CCodeGenerator final : public AstVisitor<CCodeGenerator> {
  public:
-  explicit CCodeGenerator(uintptr_t stack_limit);
+  // Without {types} every value is emitted boxed, without {escapes} no
+  // call is wrapped in an arena scope, without {call_graph} functions are
+  // named after their JavaScript names and never inline, without
+  // {closures} nothing is captured, without {feedback} no speculative
+  // fast path is emitted, and without {strings} string literals are
+  // printed in place. The analyses must outlive all Print calls.
+  explicit CCodeGenerator(uintptr_t stack_limit,
+                          const TypeInference* types = nullptr,
+                          const EscapeAnalysis* escapes = nullptr,
+                          const CallGraph* call_graph = nullptr,
+                          const ClosureConversion* closures = nullptr,
+                          const TypeFeedback* feedback = nullptr,
+                          const InternedStrings* strings = nullptr);
   ~CCodeGenerator();
 
-  void PrepareCFile();
+  void PrepareHeaderFile();
+  // {header_name} is the file the C file includes for the declarations.
+  void PrepareCFile(const char* header_name = "test.h");
+  // Declares the variables of the script as C globals. Must come before the
+  // functions in the C file.
+  void PrintGlobals(FunctionLiteral* program);
+  // Defines _js_strings, the interned strings of the program. Must come
+  // before the functions in the C file.
+  void PrintInternedStrings();
   void FinishCFile();
 
-  // The following routines print a node into a string.
-  // The result string is alive as long as the AstPrinter is alive.
-  const char* PrintProgram(FunctionLiteral* program);
-  void PrintFunction(FunctionLiteral* function, bool is_top_level);
-  const char* PrintFunctionDeclaration(FunctionLiteral* function);
-  const char* Finish();
+  // The following routines print into output().
+  void PrintProgram(FunctionLiteral* program);
+  // {types} selects a specialization of the function; the default is the
+  // generic version.
+  void PrintFunction(FunctionLiteral* function, bool is_top_level,
+                     const FunctionTypes* types = nullptr);
+  void PrintFunctionDeclaration(FunctionLiteral* function,
+                                const FunctionTypes* types = nullptr);
+  void Finish();
 
   void PRINTF_FORMAT(2, 3) Print(const char* format, ...);
 
-  const char* GetOutput();
+  const OutputBuffer& output() const { return output_; }
+  // For moving the output of one generator into another.
+  OutputBuffer* mutable_output() { return &output_; }
 
   // Individual nodes
 #define DECLARE_VISIT(type) void Visit##type(type* node);
@@ -69,16 +107,246 @@ class CCodeGenerator final : public AstVisitor<CCodeGenerator> {
   void PrintClassStaticElements(
       const ZonePtrList<ClassLiteral::StaticElement>* static_elements);
 
+  // Typed emission. Every expression is printed in the C representation
+  // returned by RepresentationOf and converted where a different one is
+  // needed.
+  InferredType TypeOf(Expression* expr) const;
+  InferredType RepresentationOf(Expression* expr) const;
+  InferredType VariableRepresentation(Variable* var) const;
+  void PrintCType(InferredType type);
+  void PrintConverted(Expression* expr, InferredType type);
+  void PrintConversionPrefix(InferredType from, InferredType to);
+  void PrintConversionSuffix(InferredType from, InferredType to);
+  void PrintTruthiness(const char* name, InferredType type);
+  void PrintNumber(double value);
+  void PrintCString(const AstRawString* value);
+  void PrintCString(const std::string& utf8);
+  // The interned copy of {value} if it is in the string table.
+  void PrintString(const AstRawString* value);
+  void AssignFunctionNames();
+  void AssignGlobalNames(FunctionLiteral* program);
+  void PrintFunctionName(FunctionLiteral* function,
+                         const FunctionTypes* types = nullptr);
+  void PrintFunctionSignature(FunctionLiteral* function, bool is_top_level,
+                              const FunctionTypes* types);
+  void BeginFunction(FunctionLiteral* function);
+  const FunctionTypes* CalleeTypes(Call* node, FunctionLiteral* callee) const;
+  void PrintTemporaries(DeclarationScope* scope);
+  void PrintScopeLocals(Scope* scope);
+  void PrintLocalDeclaration(Variable* var);
+  void DeclareVariableName(Variable* var);
+  void PrintVariableName(Variable* var);
+  void PrintVariable(Variable* var);
+  void PrintGcFrame(FunctionLiteral* function);
+  void PrintAssignment(Assignment* node);
+  void PrintDirectCall(Call* node, FunctionLiteral* callee);
+  void PrintIndirectCall(Call* node);
+  void PrintLogicalOperation(Token::Value op, InferredType type,
+                             Expression* first,
+                             const std::vector<Expression*>& rest);
+  void PrintBody(Statement* body);
+  void PrintLoopBody(IterationStatement* node);
+
+  // for-in and for-of loops that assign to a variable are counted loops over
+  // the indices of the iterable, which a rooted _js_iterable_<n> local holds
+  // while they run; see js2c_iteration.h. Other ones are printed as before.
+  bool IsLowerableForEach(ForEachStatement* node) const;
+  void PrintIterationLocals(FunctionLiteral* function);
+  void PrintForEach(ForEachStatement* node);
+  void PrintCaseMatch(Expression* tag, Expression* label);
+
+  // Counted loops for (; i < a.length; i++) over an array are versioned
+  // when the body cannot resize an array or change its elements kind: for
+  // each elements kind, a check that the arrays the body indexes with i
+  // have that kind and at least a.length elements guards a copy of the
+  // loop that reads the length once and indexes the elements directly, as
+  // the C compiler can vectorize. The loop as written is the fallback.
+  struct ArrayLoop {
+    int id;
+    VariableProxy* index;
+    // The array whose length bounds the loop.
+    VariableProxy* bound;
+    // The arrays the body indexes with {index}; the elements of the n-th
+    // are in _js_elements_<id>_<n>.
+    std::vector<Variable*> arrays;
+    // The representation of the elements of each version: kSmi, kDouble or
+    // kDynamic for generic elements, or kNone if the body indexes no array.
+    std::vector<InferredType> kinds;
+  };
+  bool MatchArrayLoop(ForStatement* node, ArrayLoop* loop);
+  void PrintArrayLoop(ForStatement* node, const ArrayLoop& loop);
+  void PrintForLoop(ForStatement* node);
+  int ArrayLoopElements(Property* property) const;
+  bool PrintArrayLoopLoad(Property* node);
+  bool PrintArrayLoopStore(Assignment* node, Property* property);
+
+  // Closures; see ClosureConversion and js2c_closure.h. Functions that may
+  // be called through their value, or that have captures, get a boxed entry
+  // point named <name>__boxed and closure objects.
+  bool NeedsClosure(FunctionLiteral* function) const;
+  bool HasBoxedEntry(FunctionLiteral* function) const;
+  void PrintBoxedEntrySignature(FunctionLiteral* function);
+  void PrintBoxedEntry(FunctionLiteral* function);
+  void PrintCaptures(FunctionLiteral* function);
+  void PrintEnvironment(FunctionLiteral* function);
+  void PrintDeclaredClosures(Scope* scope);
+  void PrintClosureCreation(FunctionLiteral* function);
+
+  // Speculation on type feedback; see TypeFeedback. Generic operations whose
+  // operands were numbers in the training run get an inline fast path, and
+  // indirect calls that always went to the same function call its boxed
+  // entry directly behind a check of the closure.
+  FunctionLiteral* CallFeedbackTarget(Call* node) const;
+  void PrintGuardedCall(Call* node, FunctionLiteral* target);
+
+  // Property accesses. Named ones go through an inline cache declared as a
+  // static js_ic at the top of the function; see js2c_object.h.
+  // Keyed accesses with an int32 key go to the elements of arrays directly;
+  // see js2c_array.h.
+  void PrintInlineCaches(FunctionLiteral* function);
+  InferredType KeyRepresentationOf(Property* property);
+  void PrintPropertyOperand(Expression* expr, InferredType type);
+  void BindPropertyOperand(Expression* expr, InferredType type);
+  template <typename PrintValue>
+  void PrintPropertyStore(Property* property, PrintValue print_value);
+  void PrintPropertyAssignment(Assignment* node, Property* property);
+  void PrintPropertyCountOperation(CountOperation* node, Property* property);
+  bool PrintObjectLiteral(ObjectLiteral* node);
+  bool PrintArrayLiteral(ArrayLiteral* node);
+  bool PrintArrayBuiltinCall(Call* node);
+  void PrintGuardedArrayBuiltinCall(Call* node);
+  void PrintArenaCall(Call* node, FunctionLiteral* callee);
+  void PrintJumpLabel(const char* prefix, BreakableStatement* target);
+  int JumpTargetId(BreakableStatement* target);
+  void PrintJump(BreakableStatement* target, bool is_continue);
+
+  // Exceptions; see js2c_exception.h.
+  bool CallMayThrow(Call* node, FunctionLiteral* callee) const;
+  std::string ExceptionHandlerLabel();
+  void PrintFinallyLocals(FunctionLiteral* function);
+  void PrintReturnValue();
+  void PrintLeaveToFinally(int completion);
+
+  // Generators and async functions; see GeneratorFrame and
+  // js2c_generator.h. The body goes to a resume function named
+  // <name>__resume, and the function itself only creates the frame.
+  bool PrintResumableFunction(FunctionLiteral* function,
+                              const FunctionTypes* types);
+  void PrintResumeFunction(FunctionLiteral* function);
+  void PrintGeneratorEntry(FunctionLiteral* function,
+                           const FunctionTypes* types);
+  void PrintSuspend(Suspend* node);
+  void PrintReturnOperand(ReturnStatement* node);
+
   void inc_indent() { indent_++; }
   void dec_indent() { indent_--; }
 
   DEFINE_AST_VISITOR_SUBCLASS_MEMBERS();
 
-  char* output_;  // output string buffer
-  int size_;      // output_ size
-  int pos_;       // current printing position
+  OutputBuffer output_;
   int indent_;
   int c_file_fd_;
+
+  const TypeInference* types_;
+  const EscapeAnalysis* escapes_;
+  const CallGraph* call_graph_;
+  const ClosureConversion* closures_;
+  const TypeFeedback* feedback_;
+  const InternedStrings* strings_;
+  FunctionLiteral* function_;
+  const FunctionTypes* function_types_;
+  InferredType return_type_;
+  InferredType entry_return_type_;
+  // Whether main has to check for an uncaught exception.
+  bool entry_may_throw_;
+  // Whether main has to run the jobs that async functions queue.
+  bool has_async_functions_;
+  int temp_count_;
+  std::unordered_set<Variable*> declared_variables_;
+
+  // Unique C names of the functions in the call graph. Anonymous functions
+  // and functions that share a name get a numeric suffix, the same in every
+  // generator of a program.
+  std::unordered_map<FunctionLiteral*, std::string> function_names_;
+  // The same functions by start position, which is how type feedback names
+  // call targets.
+  std::unordered_map<int, FunctionLiteral*> functions_by_position_;
+
+  // Locals of nested blocks are hoisted to the top of the C function, so
+  // shadowed names get a numeric suffix.
+  std::unordered_map<Variable*, std::string> variable_names_;
+  std::unordered_set<std::string> used_names_;
+  // Names of the script variables, which no local may shadow.
+  std::unordered_map<Variable*, std::string> global_names_;
+  std::vector<Variable*> globals_;
+
+  // The locals that hold the environment records the function being printed
+  // can reach, by the scope of the function that owns each.
+  std::unordered_map<DeclarationScope*, std::string> environment_names_;
+
+  // Boxed locals are registered with the collector through a js_gc_frame
+  // named _js_frame; see js2c_gc.h. These are their C names.
+  std::vector<std::string> gc_roots_;
+  bool has_gc_frame_;
+
+  // Inline caches by the Property or ObjectLiteral::Property they serve.
+  // Compound assignments have both a load and a store cache.
+  int ic_count_;
+  std::unordered_map<const void*, int> load_ics_;
+  std::unordered_map<const void*, int> store_ics_;
+  // Receivers and keys of read-modify-write accesses, which are evaluated
+  // once into a temporary.
+  std::unordered_map<Expression*, int> operand_temps_;
+
+  // Statements a C break or continue leaves. Jumps to any other target are
+  // emitted as a goto to a label printed after the target.
+  std::vector<BreakableStatement*> breakables_;
+  std::unordered_map<BreakableStatement*, int> jump_target_ids_;
+  std::unordered_set<BreakableStatement*> break_targets_used_;
+  std::unordered_set<BreakableStatement*> continue_targets_used_;
+
+  // The code being printed goes to the label of the innermost handler when
+  // it throws: that of a try statement or of an arena scope it is in, or
+  // js_unwind at the end of the function if there is none.
+  struct ExceptionHandler {
+    std::string label;
+    bool used;
+  };
+  std::vector<ExceptionHandler> handlers_;
+  bool unwind_used_;
+
+  // The try/finally statements whose try block is being printed, innermost
+  // last. Leaving the block by a throw, a return or a jump to a target
+  // outside it goes to the finally block with _js_completion_<id> telling
+  // its end where to continue.
+  struct FinallyBlock {
+    int id;
+    bool returns;
+    // Whether the try block has a resume point, after which the completion
+    // variable has to be set again for a normal exit.
+    bool resumes;
+    // The targets of breaks and continues (true) that leave the try block.
+    std::vector<std::pair<BreakableStatement*, bool>> jumps;
+  };
+  std::vector<FinallyBlock> finallies_;
+  // The index of the rooted _js_exception_<n> local of each try/finally
+  // statement, which holds its exception while the finally block runs.
+  std::unordered_map<TryFinallyStatement*, int> finally_exception_slots_;
+  // The number of finally blocks around each jump target.
+  std::unordered_map<BreakableStatement*, size_t> finally_depths_;
+
+  // The index of the _js_iterable_<n> local of each lowered for-in and
+  // for-of statement.
+  std::unordered_map<ForEachStatement*, int> iterable_locals_;
+
+  // The version of an array loop being printed, and the representation of
+  // its elements.
+  const ArrayLoop* array_loop_;
+  InferredType array_loop_kind_;
+
+  // The frame of the generator or async function whose resume function or
+  // entry is being printed, or nullptr.
+  std::unique_ptr<GeneratorFrame> generator_frame_;
 };
 
 }  // namespace internal
@@ -0,0 +1,165 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/call-graph.h"
+
+namespace v8 {
+namespace internal {
+
+CallGraph::CallGraph(uintptr_t stack_limit, const TypeInference* types)
+    : AstTraversalVisitor<CallGraph>(stack_limit), types_(types) {}
+
+void CallGraph::Analyze(FunctionLiteral* program) {
+  Enqueue(program);
+  while (!worklist_.empty()) {
+    FunctionLiteral* literal = worklist_.back();
+    worklist_.pop_back();
+    AnalyzeFunction(literal);
+    if (HasStackOverflow()) return;
+  }
+  // Functions that are never called directly are roots of the order too, in
+  // the order they appear in the source.
+  for (FunctionLiteral* literal : discovered_) Order(literal);
+  PropagateThrows();
+}
+
+const std::vector<FunctionLiteral*>& CallGraph::CalleesOf(
+    FunctionLiteral* function) const {
+  return nodes_.at(function).callees;
+}
+
+bool CallGraph::IsLeaf(FunctionLiteral* function) const {
+  auto it = nodes_.find(function);
+  return it != nodes_.end() && !it->second.has_calls;
+}
+
+bool CallGraph::MayEscape(FunctionLiteral* function) const {
+  auto it = nodes_.find(function);
+  return it == nodes_.end() || it->second.escapes;
+}
+
+bool CallGraph::MayThrow(FunctionLiteral* function) const {
+  auto it = nodes_.find(function);
+  return it == nodes_.end() || it->second.throws;
+}
+
+bool CallGraph::IsInlineCandidate(FunctionLiteral* function) const {
+  return !function->is_toplevel() &&
+         (IsLeaf(function) || !MayEscape(function));
+}
+
+void CallGraph::Enqueue(FunctionLiteral* literal) {
+  if (nodes_.count(literal) != 0) return;
+  nodes_[literal];
+  discovered_.push_back(literal);
+  worklist_.push_back(literal);
+}
+
+void CallGraph::AnalyzeFunction(FunctionLiteral* literal) {
+  current_ = &nodes_[literal];
+  VisitDeclarations(literal->scope()->declarations());
+  VisitStatements(literal->body());
+  current_ = nullptr;
+}
+
+void CallGraph::Order(FunctionLiteral* literal) {
+  Node& node = nodes_[literal];
+  if (node.visited) return;
+  node.visited = true;
+  for (FunctionLiteral* callee : node.callees) Order(callee);
+  order_.push_back(literal);
+}
+
+void CallGraph::PropagateThrows() {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& entry : nodes_) {
+      Node& node = entry.second;
+      if (node.throws) continue;
+      for (FunctionLiteral* callee : node.uncaught_callees) {
+        if (nodes_[callee].throws) {
+          node.throws = changed = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void CallGraph::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  FunctionLiteral* literal = node->fun();
+  Enqueue(literal);
+  // A binding that is assigned elsewhere is called through its value.
+  if (types_ == nullptr || types_->DeclaredFunction(node->var()) != literal) {
+    nodes_[literal].escapes = true;
+  }
+}
+
+void CallGraph::VisitFunctionLiteral(FunctionLiteral* node) {
+  Enqueue(node);
+  nodes_[node].escapes = true;
+}
+
+void CallGraph::VisitVariableProxy(VariableProxy* node) {
+  if (types_ == nullptr || !node->is_resolved()) return;
+  FunctionLiteral* literal = types_->DeclaredFunction(node->var());
+  if (literal == nullptr) return;
+  Enqueue(literal);
+  nodes_[literal].escapes = true;
+}
+
+void CallGraph::VisitCall(Call* node) {
+  current_->has_calls = true;
+  // Mirrors DirectCallee in the code generator.
+  VariableProxy* proxy = node->expression()->AsVariableProxy();
+  FunctionLiteral* callee =
+      types_ != nullptr && proxy != nullptr && proxy->is_resolved() &&
+              !node->is_possibly_eval() &&
+              node->spread_position() == Call::kNoSpread
+          ? types_->DeclaredFunction(proxy->var())
+          : nullptr;
+  if (callee == nullptr || types_->TypesFor(callee) == nullptr) {
+    // Mirrors IsRuntimeFunctionCall in the code generator.
+    if (proxy == nullptr || (proxy->is_resolved() &&
+                             !IsDynamicVariableMode(proxy->var()->mode()))) {
+      MarkThrow();
+    }
+    AstTraversalVisitor::VisitCall(node);
+    return;
+  }
+  Enqueue(callee);
+  current_->callees.push_back(callee);
+  if (catch_depth_ == 0) current_->uncaught_callees.push_back(callee);
+  for (Expression* argument : *node->arguments()) Visit(argument);
+}
+
+void CallGraph::VisitCallNew(CallNew* node) {
+  current_->has_calls = true;
+  MarkThrow();
+  AstTraversalVisitor::VisitCallNew(node);
+}
+
+void CallGraph::VisitForOfStatement(ForOfStatement* node) {
+  current_->has_calls = true;
+  MarkThrow();
+  AstTraversalVisitor::VisitForOfStatement(node);
+}
+
+void CallGraph::VisitThrow(Throw* node) {
+  MarkThrow();
+  AstTraversalVisitor::VisitThrow(node);
+}
+
+void CallGraph::VisitTryCatchStatement(TryCatchStatement* node) {
+  catch_depth_++;
+  Visit(node->try_block());
+  catch_depth_--;
+  Visit(node->catch_block());
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -0,0 +1,96 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_CALL_GRAPH_H_
+#define V8_JS2C_CALL_GRAPH_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/js2c/type-inference.h"
+
+namespace v8 {
+namespace internal {
+
+// The static call graph of the whole program, which decides what the driver
+// emits and in which order.
+//
+// Every function literal in the program is a node: declarations, function
+// expressions and arrow functions at any depth. An edge is a call that the
+// code generator emits as a direct C call. A function escapes if its value
+// is used other than as the callee of such a call, so it may be called from
+// code the translator cannot see.
+//
+// A function may throw if it contains a throw, a call that is not direct or
+// a for-of loop, which may resume a generator, or directly calls a function
+// that may throw, outside the try block of a try/catch statement. Calls of the C functions of the runtime, such as
+// print, never throw.
+class CallGraph final : public AstTraversalVisitor<CallGraph> {
+ public:
+  CallGraph(uintptr_t stack_limit, const TypeInference* types);
+
+  void Analyze(FunctionLiteral* program);
+
+  // All functions, callees before their callers. The members of a cycle
+  // come in discovery order; their prototypes make any order valid C.
+  const std::vector<FunctionLiteral*>& functions() const { return order_; }
+
+  const std::vector<FunctionLiteral*>& CalleesOf(
+      FunctionLiteral* function) const;
+  // True if {function} calls nothing at all, directly or otherwise.
+  bool IsLeaf(FunctionLiteral* function) const;
+  bool MayEscape(FunctionLiteral* function) const;
+  bool MayThrow(FunctionLiteral* function) const;
+
+  // True if {function} can be emitted static inline: it is not the entry
+  // point, and it is either a leaf or only called directly.
+  bool IsInlineCandidate(FunctionLiteral* function) const;
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitVariableProxy(VariableProxy* node);
+  void VisitCall(Call* node);
+  void VisitCallNew(CallNew* node);
+  void VisitForOfStatement(ForOfStatement* node);
+  void VisitThrow(Throw* node);
+  void VisitTryCatchStatement(TryCatchStatement* node);
+
+ private:
+  struct Node {
+    std::vector<FunctionLiteral*> callees;
+    // The callees whose exceptions reach the caller.
+    std::vector<FunctionLiteral*> uncaught_callees;
+    bool has_calls = false;
+    bool escapes = false;
+    bool throws = false;
+    bool visited = false;
+  };
+
+  void Enqueue(FunctionLiteral* literal);
+  void AnalyzeFunction(FunctionLiteral* literal);
+  void Order(FunctionLiteral* literal);
+  void PropagateThrows();
+  void MarkThrow() {
+    if (catch_depth_ == 0) current_->throws = true;
+  }
+
+  const TypeInference* types_;
+  std::unordered_map<FunctionLiteral*, Node> nodes_;
+  std::vector<FunctionLiteral*> discovered_;
+  std::vector<FunctionLiteral*> worklist_;
+  std::vector<FunctionLiteral*> order_;
+
+  Node* current_ = nullptr;
+  // The number of try blocks of try/catch statements around the current
+  // node.
+  int catch_depth_ = 0;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_CALL_GRAPH_H_
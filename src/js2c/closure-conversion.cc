@@ -0,0 +1,187 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/closure-conversion.h"
+
+namespace v8 {
+namespace internal {
+
+ClosureConversion::ClosureConversion(uintptr_t stack_limit,
+                                     const TypeInference* types)
+    : AstTraversalVisitor<ClosureConversion>(stack_limit), types_(types) {}
+
+void ClosureConversion::Analyze(FunctionLiteral* program) {
+  Collect(program);
+  if (HasStackOverflow()) return;
+
+  // A direct call to a function that has a closure passes it along, which
+  // makes the variable it is called through free in the caller as well.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (FunctionLiteral* literal : order_) {
+      if (UpdateFreeVariables(literal)) changed = true;
+    }
+  }
+
+  // Declared functions are created on entry to the enclosing function and
+  // function expressions where they are evaluated. A closure that may be
+  // created before a variable is initialized has to see the later value.
+  for (FunctionLiteral* literal : order_) {
+    for (const Child& child : infos_[literal].children) {
+      for (Variable* var : infos_[child.literal].free_variables) {
+        if (var->scope()->GetClosureScope() != literal->scope() ||
+            var->IsParameter() || var == literal->scope()->function_var()) {
+          continue;
+        }
+        if (child.is_declaration ||
+            child.literal->start_position() <= var->initializer_position()) {
+          uncopyable_.insert(var);
+        }
+      }
+    }
+  }
+
+  for (FunctionLiteral* literal : order_) AssignCaptures(literal);
+}
+
+const std::vector<ClosureConversion::Capture>& ClosureConversion::CapturesOf(
+    FunctionLiteral* function) const {
+  return infos_.at(function).captures;
+}
+
+bool ClosureConversion::NeedsClosure(FunctionLiteral* function) const {
+  auto it = infos_.find(function);
+  return it != infos_.end() &&
+         (it->second.uses_self || !it->second.free_variables.empty());
+}
+
+int ClosureConversion::EnvironmentSlotOf(Variable* var) const {
+  auto it = environment_slots_.find(var);
+  return it == environment_slots_.end() ? -1 : it->second;
+}
+
+int ClosureConversion::EnvironmentSizeOf(FunctionLiteral* function) const {
+  auto it = infos_.find(function);
+  return it == infos_.end() ? 0 : it->second.environment_size;
+}
+
+// static
+bool ClosureConversion::IsGlobal(Variable* var) {
+  return var->scope()->is_script_scope() && !var->IsStackAllocated() &&
+         !IsDynamicVariableMode(var->mode());
+}
+
+void ClosureConversion::Collect(FunctionLiteral* literal) {
+  if (infos_.count(literal) != 0) return;
+  literals_[literal->scope()] = literal;
+  current_ = &infos_[literal];
+  current_literal_ = literal;
+  VisitDeclarations(literal->scope()->declarations());
+  VisitStatements(literal->body());
+  current_ = nullptr;
+  current_literal_ = nullptr;
+  for (const Child& child : infos_[literal].children) {
+    Collect(child.literal);
+    if (HasStackOverflow()) return;
+  }
+  order_.push_back(literal);
+}
+
+bool ClosureConversion::AddFreeVariable(FunctionLiteral* literal,
+                                        Variable* var) {
+  // Variables that eval or with make dynamic are not context slots and are
+  // left alone.
+  if (!var->IsContextSlot() || IsGlobal(var) ||
+      var->scope()->GetClosureScope() == literal->scope()) {
+    return false;
+  }
+  Info& info = infos_[literal];
+  if (!info.free_set.insert(var).second) return false;
+  info.free_variables.push_back(var);
+  return true;
+}
+
+bool ClosureConversion::UpdateFreeVariables(FunctionLiteral* literal) {
+  Info& info = infos_[literal];
+  bool changed = false;
+  for (Variable* var : info.references) {
+    if (AddFreeVariable(literal, var)) changed = true;
+  }
+  for (auto& call : info.direct_calls) {
+    if (NeedsClosure(call.second) && AddFreeVariable(literal, call.first)) {
+      changed = true;
+    }
+  }
+  for (const Child& child : info.children) {
+    for (Variable* var : infos_[child.literal].free_variables) {
+      if (AddFreeVariable(literal, var)) changed = true;
+    }
+  }
+  return changed;
+}
+
+bool ClosureConversion::IsCopied(Variable* var) const {
+  if (var->maybe_assigned() == kMaybeAssigned || uncopyable_.count(var)) {
+    return false;
+  }
+  return var->IsParameter() || IsLexicalVariableMode(var->mode()) ||
+         var == var->scope()->GetClosureScope()->function_var();
+}
+
+void ClosureConversion::AssignCaptures(FunctionLiteral* literal) {
+  Info& info = infos_[literal];
+  std::unordered_set<DeclarationScope*> owners;
+  for (Variable* var : info.free_variables) {
+    if (IsCopied(var)) {
+      info.captures.push_back({var, nullptr});
+      continue;
+    }
+    DeclarationScope* owner = var->scope()->GetClosureScope();
+    DCHECK_NE(literals_.count(owner), 0);
+    if (environment_slots_.count(var) == 0) {
+      environment_slots_[var] = infos_[literals_[owner]].environment_size++;
+    }
+    if (owners.insert(owner).second) info.captures.push_back({nullptr, owner});
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void ClosureConversion::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  current_->children.push_back({node->fun(), true});
+}
+
+void ClosureConversion::VisitFunctionLiteral(FunctionLiteral* node) {
+  current_->children.push_back({node, false});
+}
+
+void ClosureConversion::VisitVariableProxy(VariableProxy* node) {
+  if (!node->is_resolved()) return;
+  if (node->var() == current_literal_->scope()->function_var()) {
+    current_->uses_self = true;
+    return;
+  }
+  current_->references.push_back(node->var());
+}
+
+void ClosureConversion::VisitCall(Call* node) {
+  // Mirrors DirectCallee in the code generator.
+  VariableProxy* proxy = node->expression()->AsVariableProxy();
+  FunctionLiteral* callee =
+      types_ != nullptr && proxy != nullptr && proxy->is_resolved() &&
+              !node->is_possibly_eval() &&
+              node->spread_position() == Call::kNoSpread
+          ? types_->DeclaredFunction(proxy->var())
+          : nullptr;
+  if (callee == nullptr || types_->TypesFor(callee) == nullptr) {
+    AstTraversalVisitor::VisitCall(node);
+    return;
+  }
+  current_->direct_calls.push_back({proxy->var(), callee});
+  for (Expression* argument : *node->arguments()) Visit(argument);
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -0,0 +1,111 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_CLOSURE_CONVERSION_H_
+#define V8_JS2C_CLOSURE_CONVERSION_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+#include "src/js2c/type-inference.h"
+
+namespace v8 {
+namespace internal {
+
+// Decides how translated functions reach the variables of the functions
+// they are nested in; see js2c_closure.h for the runtime side.
+//
+// The scope analysis of the parser already put every variable that a nested
+// function uses into a context slot (Variable::IsContextSlot) and left the
+// others on the stack, which stay C locals. A context variable that is never
+// assigned after its initialization is copied into the closures that use it,
+// provided every such closure is created after the initialization. Any other
+// context variable lives in a heap environment record of the function that
+// declares it, and the closures capture the record.
+//
+// Closures are flat: a function captures everything it uses from enclosing
+// functions, including what the functions nested in it use, so it never
+// follows a chain of contexts. Variables of the script are C globals and are
+// not captured at all.
+class ClosureConversion final : public AstTraversalVisitor<ClosureConversion> {
+ public:
+  // One slot of a closure: the value of {var}, or the environment record of
+  // the function with scope {owner}.
+  struct Capture {
+    Variable* var;
+    DeclarationScope* owner;
+  };
+
+  ClosureConversion(uintptr_t stack_limit, const TypeInference* types);
+
+  void Analyze(FunctionLiteral* program);
+
+  // The slots of the closure of {function}, in order.
+  const std::vector<Capture>& CapturesOf(FunctionLiteral* function) const;
+
+  // True if the C function of {function} takes its closure as an extra last
+  // parameter, because it captures something or refers to itself by name.
+  bool NeedsClosure(FunctionLiteral* function) const;
+
+  // Returns the slot of {var} in the environment record of the function that
+  // declares it, or -1 if it is not stored in one.
+  int EnvironmentSlotOf(Variable* var) const;
+  // The size of the environment record of {function}, zero if it has none.
+  int EnvironmentSizeOf(FunctionLiteral* function) const;
+
+  // True for the variables declared by the script, which are C globals.
+  static bool IsGlobal(Variable* var);
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitVariableProxy(VariableProxy* node);
+  void VisitCall(Call* node);
+
+ private:
+  struct Child {
+    FunctionLiteral* literal;
+    bool is_declaration;  // created when the enclosing function is entered
+  };
+
+  struct Info {
+    std::vector<Variable*> references;
+    // Callees of direct calls, with the variables they are called through.
+    std::vector<std::pair<Variable*, FunctionLiteral*>> direct_calls;
+    std::vector<Child> children;
+    std::vector<Variable*> free_variables;
+    std::unordered_set<Variable*> free_set;
+    std::vector<Capture> captures;
+    bool uses_self = false;
+    int environment_size = 0;
+  };
+
+  void Collect(FunctionLiteral* literal);
+  bool AddFreeVariable(FunctionLiteral* literal, Variable* var);
+  bool UpdateFreeVariables(FunctionLiteral* literal);
+  bool IsCopied(Variable* var) const;
+  void AssignCaptures(FunctionLiteral* literal);
+
+  const TypeInference* types_;
+  std::unordered_map<FunctionLiteral*, Info> infos_;
+  std::unordered_map<DeclarationScope*, FunctionLiteral*> literals_;
+  // Functions in post-order, nested functions before their parents.
+  std::vector<FunctionLiteral*> order_;
+  // Captured variables that some closure may see before they are
+  // initialized, so that they cannot be copied.
+  std::unordered_set<Variable*> uncopyable_;
+  std::unordered_map<Variable*, int> environment_slots_;
+
+  Info* current_ = nullptr;
+  FunctionLiteral* current_literal_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_CLOSURE_CONVERSION_H_
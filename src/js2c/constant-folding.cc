@@ -0,0 +1,702 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/constant-folding.h"
+
+#include <limits>
+
+#include "src/base/ieee754.h"
+#include "src/base/overflowing-math.h"
+#include "src/numbers/conversions-inl.h"
+#include "src/utils/utils.h"
+#include "src/zone/zone-list-inl.h"
+
+namespace v8 {
+namespace internal {
+
+namespace {
+
+bool IsLogicalOp(Token::Value op) {
+  return op == Token::OR || op == Token::AND || op == Token::NULLISH;
+}
+
+bool IsNullish(Literal* literal) {
+  return literal->type() == Literal::kNull ||
+         literal->type() == Literal::kUndefined;
+}
+
+// Literals that a const can be propagated as.
+bool IsPropagatable(Literal* literal) {
+  switch (literal->type()) {
+    case Literal::kSmi:
+    case Literal::kHeapNumber:
+    case Literal::kString:
+    case Literal::kBoolean:
+    case Literal::kUndefined:
+    case Literal::kNull:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// ToNumber of a literal other than a string, which would need parsing.
+bool ToNumber(Literal* literal, double* value) {
+  switch (literal->type()) {
+    case Literal::kSmi:
+    case Literal::kHeapNumber:
+      *value = literal->AsNumber();
+      return true;
+    case Literal::kBoolean:
+      *value = literal->AsBooleanLiteral() ? 1 : 0;
+      return true;
+    case Literal::kNull:
+      *value = 0;
+      return true;
+    case Literal::kUndefined:
+      *value = std::numeric_limits<double>::quiet_NaN();
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Whether two literals are equal under === or, unless {strict}, ==. Returns
+// false if that is not known statically: for BigInts and for a string
+// compared loosely to a number or boolean.
+bool LiteralsEqual(Literal* left, Literal* right, bool strict, bool* result) {
+  Literal::Type left_type =
+      left->IsNumber() ? Literal::kHeapNumber : left->type();
+  Literal::Type right_type =
+      right->IsNumber() ? Literal::kHeapNumber : right->type();
+  if (!IsPropagatable(left) || !IsPropagatable(right)) return false;
+  if (left_type == right_type) {
+    switch (left_type) {
+      case Literal::kHeapNumber:
+        *result = left->AsNumber() == right->AsNumber();
+        return true;
+      case Literal::kString:
+        *result = AstRawString::Equal(left->AsRawString(),
+                                      right->AsRawString());
+        return true;
+      case Literal::kBoolean:
+        *result = left->AsBooleanLiteral() == right->AsBooleanLiteral();
+        return true;
+      default:
+        *result = true;
+        return true;
+    }
+  }
+  if (strict) {
+    *result = false;
+    return true;
+  }
+  if (IsNullish(left) || IsNullish(right)) {
+    *result = IsNullish(left) && IsNullish(right);
+    return true;
+  }
+  double x, y;
+  if (!ToNumber(left, &x) || !ToNumber(right, &y)) return false;
+  *result = x == y;
+  return true;
+}
+
+// Bindings whose declaration can go when nothing reads them: not
+// parameters, properties of the global object or exports, and not in reach
+// of a sloppy eval.
+bool IsRemovableBinding(Variable* var) {
+  return (var->mode() == VariableMode::kLet ||
+          var->mode() == VariableMode::kConst ||
+          var->mode() == VariableMode::kVar) &&
+         !var->IsParameter() && !var->IsGlobalObjectProperty() &&
+         !var->IsExport() && !var->scope()->inner_scope_calls_eval();
+}
+
+// Finds what keeps dead code from being removed: a function or class, which
+// the scopes still list, or a suspend, which has a resume point.
+class RemovalBlocker final : public AstTraversalVisitor<RemovalBlocker> {
+ public:
+  explicit RemovalBlocker(uintptr_t stack_limit)
+      : AstTraversalVisitor(stack_limit) {}
+
+  bool found() const { return found_; }
+
+  void VisitFunctionLiteral(FunctionLiteral* node) { found_ = true; }
+  void VisitClassLiteral(ClassLiteral* node) { found_ = true; }
+  void VisitYield(Yield* node) { found_ = true; }
+  void VisitYieldStar(YieldStar* node) { found_ = true; }
+  void VisitAwait(Await* node) { found_ = true; }
+
+  void VisitForOfStatement(ForOfStatement* node) {
+    if (node->type() == IteratorType::kAsync) found_ = true;
+    AstTraversalVisitor::VisitForOfStatement(node);
+  }
+
+ private:
+  bool found_ = false;
+};
+
+// Counts the references to each variable, and those that are
+// initializations.
+class ReferenceCounter final : public AstTraversalVisitor<ReferenceCounter> {
+ public:
+  explicit ReferenceCounter(uintptr_t stack_limit)
+      : AstTraversalVisitor(stack_limit) {}
+
+  // The variables with an initialization, in the order they are found.
+  const std::vector<Variable*>& initialized() const { return initialized_; }
+
+  // Whether every reference to {var} initializes it with a literal.
+  bool IsOnlyInitializedWithLiterals(Variable* var) const {
+    auto references = references_.find(var);
+    auto initializations = initializations_.find(var);
+    return initializations != initializations_.end() &&
+           references != references_.end() &&
+           references->second == initializations->second &&
+           other_initializations_.count(var) == 0;
+  }
+
+  int InitializationCountOf(Variable* var) const {
+    auto it = initializations_.find(var);
+    return it == initializations_.end() ? 0 : it->second;
+  }
+
+  void VisitVariableProxy(VariableProxy* node) {
+    if (node->is_resolved()) references_[node->var()]++;
+  }
+
+  void VisitAssignment(Assignment* node) {
+    VariableProxy* target = node->target()->AsVariableProxy();
+    if (node->op() == Token::INIT && target != nullptr &&
+        target->is_resolved()) {
+      Variable* var = target->var();
+      if (initializations_[var]++ == 0) initialized_.push_back(var);
+      if (!node->value()->IsLiteral()) other_initializations_.insert(var);
+    }
+    AstTraversalVisitor::VisitAssignment(node);
+  }
+
+ private:
+  std::unordered_map<Variable*, int> references_;
+  std::unordered_map<Variable*, int> initializations_;
+  std::unordered_set<Variable*> other_initializations_;
+  std::vector<Variable*> initialized_;
+};
+
+}  // namespace
+
+ConstantFolding::ConstantFolding(uintptr_t stack_limit,
+                                 AstValueFactory* ast_value_factory,
+                                 Zone* zone)
+    : AstTraversalVisitor<ConstantFolding>(stack_limit),
+      factory_(ast_value_factory, zone) {}
+
+void ConstantFolding::Rewrite(FunctionLiteral* program) {
+  for (int round = 0; round < kMaxRounds; round++) {
+    changed_ = false;
+    Visit(program);
+    if (HasStackOverflow() || !changed_) break;
+  }
+  if (HasStackOverflow()) return;
+  RemoveUnusedDeclarations(program);
+}
+
+std::string ConstantFolding::DescribeConstants() const {
+  std::string description;
+  for (Variable* var : constant_order_) {
+    const AstRawString* name = var->raw_name();
+    description += std::to_string(var->initializer_position()) + ":";
+    description.append(reinterpret_cast<const char*>(name->raw_data()),
+                       name->byte_length());
+    Literal* literal = constants_.at(var);
+    switch (literal->type()) {
+      case Literal::kSmi:
+      case Literal::kHeapNumber: {
+        double value = literal->AsNumber();
+        description += "=n";
+        description.append(reinterpret_cast<const char*>(&value),
+                           sizeof(value));
+        break;
+      }
+      case Literal::kString: {
+        const AstRawString* string = literal->AsRawString();
+        description += "=s" + std::to_string(string->byte_length()) + ":";
+        description.append(reinterpret_cast<const char*>(string->raw_data()),
+                           string->byte_length());
+        break;
+      }
+      case Literal::kBoolean:
+        description += literal->AsBooleanLiteral() ? "=true" : "=false";
+        break;
+      case Literal::kNull:
+        description += "=null";
+        break;
+      default:
+        description += "=undefined";
+        break;
+    }
+    description += ";";
+  }
+  return description;
+}
+
+Expression* ConstantFolding::Fold(Expression* expr) {
+  replaced_ = nullptr;
+  Visit(expr);
+  if (replaced_ != expr) return expr;
+  changed_ = true;
+  return replacement_;
+}
+
+Statement* ConstantFolding::FoldStatement(Statement* statement) {
+  replaced_statement_ = nullptr;
+  Visit(statement);
+  if (replaced_statement_ != statement) return statement;
+  changed_ = true;
+  return statement_replacement_;
+}
+
+// Empty statements are dropped, and in the last round so are the
+// initializations of unused bindings.
+void ConstantFolding::FoldStatements(ZonePtrList<Statement>* statements) {
+  for (int i = 0; i < statements->length(); i++) {
+    Statement* statement = FoldStatement(statements->at(i));
+    if (HasStackOverflow()) return;
+    if (statement->IsEmptyStatement() || IsUnusedInitialization(statement)) {
+      statements->Remove(i);
+      i--;
+    } else {
+      statements->Set(i, statement);
+    }
+  }
+}
+
+void ConstantFolding::Replace(Expression* node, Expression* replacement) {
+  replaced_ = node;
+  replacement_ = replacement;
+}
+
+void ConstantFolding::ReplaceStatement(Statement* node,
+                                       Statement* replacement) {
+  replaced_statement_ = node;
+  statement_replacement_ = replacement;
+}
+
+bool ConstantFolding::CanRemove(AstNode* node) {
+  RemovalBlocker blocker(stack_limit());
+  blocker.Visit(node);
+  return !blocker.found() && !blocker.HasStackOverflow();
+}
+
+// Every use gets a literal of its own, with its position.
+Literal* ConstantFolding::CopyLiteral(Literal* literal, int pos) {
+  switch (literal->type()) {
+    case Literal::kSmi:
+    case Literal::kHeapNumber:
+      return factory_.NewNumberLiteral(literal->AsNumber(), pos);
+    case Literal::kString:
+      return factory_.NewStringLiteral(literal->AsRawString(), pos);
+    case Literal::kBoolean:
+      return factory_.NewBooleanLiteral(literal->AsBooleanLiteral(), pos);
+    case Literal::kNull:
+      return factory_.NewNullLiteral(pos);
+    case Literal::kUndefined:
+      return factory_.NewUndefinedLiteral(pos);
+    default:
+      UNREACHABLE();
+  }
+}
+
+Literal* ConstantFolding::FoldUnaryOperation(Token::Value op,
+                                             Literal* operand, int pos) {
+  if (!IsPropagatable(operand)) return nullptr;
+  double value;
+  switch (op) {
+    case Token::NOT:
+      return factory_.NewBooleanLiteral(operand->ToBooleanIsFalse(), pos);
+    case Token::VOID:
+      return factory_.NewUndefinedLiteral(pos);
+    case Token::ADD:
+      if (!ToNumber(operand, &value)) return nullptr;
+      return factory_.NewNumberLiteral(value, pos);
+    case Token::SUB:
+      if (!ToNumber(operand, &value)) return nullptr;
+      return factory_.NewNumberLiteral(-value, pos);
+    case Token::BIT_NOT:
+      if (!ToNumber(operand, &value)) return nullptr;
+      return factory_.NewNumberLiteral(~DoubleToInt32(value), pos);
+    default:
+      return nullptr;
+  }
+}
+
+// As Parser::ShortcutNumericLiteralBinaryExpression, but also for %, and
+// for booleans, null and undefined, which convert to numbers. An addition
+// with a string is left alone.
+Literal* ConstantFolding::FoldBinaryOperation(Token::Value op, Literal* left,
+                                              Literal* right, int pos) {
+  double x, y;
+  if (!ToNumber(left, &x) || !ToNumber(right, &y)) return nullptr;
+  switch (op) {
+    case Token::ADD:
+      return factory_.NewNumberLiteral(x + y, pos);
+    case Token::SUB:
+      return factory_.NewNumberLiteral(x - y, pos);
+    case Token::MUL:
+      return factory_.NewNumberLiteral(x * y, pos);
+    case Token::DIV:
+      return factory_.NewNumberLiteral(base::Divide(x, y), pos);
+    case Token::MOD:
+      return factory_.NewNumberLiteral(Modulo(x, y), pos);
+    case Token::EXP:
+      return factory_.NewNumberLiteral(base::ieee754::pow(x, y), pos);
+    case Token::BIT_OR:
+      return factory_.NewNumberLiteral(DoubleToInt32(x) | DoubleToInt32(y),
+                                       pos);
+    case Token::BIT_AND:
+      return factory_.NewNumberLiteral(DoubleToInt32(x) & DoubleToInt32(y),
+                                       pos);
+    case Token::BIT_XOR:
+      return factory_.NewNumberLiteral(DoubleToInt32(x) ^ DoubleToInt32(y),
+                                       pos);
+    case Token::SHL:
+      return factory_.NewNumberLiteral(
+          base::ShlWithWraparound(DoubleToInt32(x), DoubleToInt32(y)), pos);
+    case Token::SHR: {
+      uint32_t shift = DoubleToInt32(y) & 0x1F;
+      return factory_.NewNumberLiteral(DoubleToUint32(x) >> shift, pos);
+    }
+    case Token::SAR: {
+      uint32_t shift = DoubleToInt32(y) & 0x1F;
+      return factory_.NewNumberLiteral(
+          ArithmeticShiftRight(DoubleToInt32(x), shift), pos);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+Literal* ConstantFolding::FoldCompareOperation(Token::Value op,
+                                               Literal* left, Literal* right,
+                                               int pos) {
+  bool result;
+  double x, y;
+  switch (op) {
+    case Token::EQ:
+    case Token::NE:
+    case Token::EQ_STRICT:
+    case Token::NE_STRICT: {
+      bool strict = op == Token::EQ_STRICT || op == Token::NE_STRICT;
+      if (!LiteralsEqual(left, right, strict, &result)) return nullptr;
+      if (op == Token::NE || op == Token::NE_STRICT) result = !result;
+      break;
+    }
+    case Token::LT:
+    case Token::GT:
+    case Token::LTE:
+    case Token::GTE:
+      // Strings compare by code units, which is left to the runtime.
+      if (!ToNumber(left, &x) || !ToNumber(right, &y)) return nullptr;
+      if (op == Token::LT) {
+        result = x < y;
+      } else if (op == Token::GT) {
+        result = x > y;
+      } else if (op == Token::LTE) {
+        result = x <= y;
+      } else {
+        result = x >= y;
+      }
+      break;
+    default:
+      return nullptr;
+  }
+  return factory_.NewBooleanLiteral(result, pos);
+}
+
+bool ConstantFolding::SelectsLeft(Token::Value op, Literal* left) {
+  switch (op) {
+    case Token::AND:
+      return left->ToBooleanIsFalse();
+    case Token::OR:
+      return left->ToBooleanIsTrue();
+    default:
+      DCHECK_EQ(op, Token::NULLISH);
+      return !IsNullish(left);
+  }
+}
+
+// A binding is unused when all its references are initializations with a
+// literal. A last round removes those, and the declaration goes if all of
+// them were in statement lists.
+void ConstantFolding::RemoveUnusedDeclarations(FunctionLiteral* program) {
+  ReferenceCounter counter(stack_limit());
+  counter.Visit(program);
+  if (counter.HasStackOverflow()) return;
+  for (Variable* var : counter.initialized()) {
+    if (counter.IsOnlyInitializedWithLiterals(var) &&
+        IsRemovableBinding(var)) {
+      unused_.insert(var);
+    }
+  }
+  if (unused_.empty()) return;
+  Visit(program);
+  if (HasStackOverflow()) return;
+
+  ReferenceCounter remaining(stack_limit());
+  remaining.Visit(program);
+  for (Variable* var : unused_) {
+    if (remaining.InitializationCountOf(var) != 0) continue;
+    std::vector<Declaration*> declarations;
+    for (Declaration* decl : *var->scope()->declarations()) {
+      if (decl->var() == var) declarations.push_back(decl);
+    }
+    for (Declaration* decl : declarations) {
+      var->scope()->declarations()->Remove(decl);
+    }
+  }
+}
+
+bool ConstantFolding::IsUnusedInitialization(Statement* statement) const {
+  if (unused_.empty() || !statement->IsExpressionStatement()) return false;
+  Assignment* assignment =
+      statement->AsExpressionStatement()->expression()->AsAssignment();
+  if (assignment == nullptr || assignment->op() != Token::INIT ||
+      !assignment->value()->IsLiteral()) {
+    return false;
+  }
+  VariableProxy* target = assignment->target()->AsVariableProxy();
+  return target != nullptr && target->is_resolved() &&
+         unused_.count(target->var()) != 0;
+}
+
+void ConstantFolding::VisitFunctionLiteral(FunctionLiteral* node) {
+  VisitDeclarations(node->scope()->declarations());
+  // A lazily parsed function literal has no body.
+  if (node->scope()->was_lazily_parsed()) return;
+  FoldStatements(node->body());
+}
+
+void ConstantFolding::VisitBlock(Block* node) {
+  if (node->scope() != nullptr) {
+    VisitDeclarations(node->scope()->declarations());
+  }
+  FoldStatements(node->statements());
+}
+
+// A statement that is only a literal does nothing.
+void ConstantFolding::VisitExpressionStatement(ExpressionStatement* node) {
+  node->set_expression(Fold(node->expression()));
+  if (node->expression()->IsLiteral()) {
+    ReplaceStatement(node, factory_.EmptyStatement());
+  }
+}
+
+void ConstantFolding::VisitIfStatement(IfStatement* node) {
+  node->set_condition(Fold(node->condition()));
+  node->set_then_statement(FoldStatement(node->then_statement()));
+  node->set_else_statement(FoldStatement(node->else_statement()));
+  Literal* condition = node->condition()->AsLiteral();
+  if (condition == nullptr || !IsPropagatable(condition)) return;
+  bool value = condition->ToBooleanIsTrue();
+  if (!CanRemove(value ? node->else_statement() : node->then_statement())) {
+    return;
+  }
+  ReplaceStatement(node,
+                   value ? node->then_statement() : node->else_statement());
+}
+
+void ConstantFolding::VisitReturnStatement(ReturnStatement* node) {
+  if (node->expression() != nullptr) {
+    node->set_expression(Fold(node->expression()));
+  }
+}
+
+void ConstantFolding::VisitDoWhileStatement(DoWhileStatement* node) {
+  node->set_body(FoldStatement(node->body()));
+  node->set_cond(Fold(node->cond()));
+}
+
+void ConstantFolding::VisitWhileStatement(WhileStatement* node) {
+  node->set_cond(Fold(node->cond()));
+  node->set_body(FoldStatement(node->body()));
+  if (node->cond()->ToBooleanIsFalse() && CanRemove(node->body())) {
+    ReplaceStatement(node, factory_.EmptyStatement());
+  }
+}
+
+// A loop whose condition is false only runs its init statement.
+void ConstantFolding::VisitForStatement(ForStatement* node) {
+  if (node->init() != nullptr) Visit(node->init());
+  if (node->cond() != nullptr) node->set_cond(Fold(node->cond()));
+  if (node->next() != nullptr) Visit(node->next());
+  node->set_body(FoldStatement(node->body()));
+  if (node->cond() == nullptr || !node->cond()->ToBooleanIsFalse() ||
+      !CanRemove(node->body()) ||
+      (node->next() != nullptr && !CanRemove(node->next()))) {
+    return;
+  }
+  ReplaceStatement(node, node->init() != nullptr ? node->init()
+                                                 : factory_.EmptyStatement());
+}
+
+void ConstantFolding::VisitSwitchStatement(SwitchStatement* node) {
+  node->set_tag(Fold(node->tag()));
+  for (CaseClause* clause : *node->cases()) {
+    if (!clause->is_default()) Visit(clause->label());
+    FoldStatements(clause->statements());
+  }
+}
+
+void ConstantFolding::VisitConditional(Conditional* node) {
+  node->set_condition(Fold(node->condition()));
+  node->set_then_expression(Fold(node->then_expression()));
+  node->set_else_expression(Fold(node->else_expression()));
+  Literal* condition = node->condition()->AsLiteral();
+  if (condition == nullptr || !IsPropagatable(condition)) return;
+  bool value = condition->ToBooleanIsTrue();
+  if (!CanRemove(value ? node->else_expression() : node->then_expression())) {
+    return;
+  }
+  Replace(node, value ? node->then_expression() : node->else_expression());
+}
+
+void ConstantFolding::VisitVariableProxy(VariableProxy* node) {
+  if (!node->is_resolved()) return;
+  auto it = constants_.find(node->var());
+  if (it != constants_.end()) {
+    Replace(node, CopyLiteral(it->second, node->position()));
+  }
+}
+
+// The target of an assignment to a variable is not a read. The value of a
+// compound assignment is also the right operand of its binary operation,
+// so it is only folded inside; see VisitCompoundAssignment, which does not
+// come here.
+void ConstantFolding::VisitAssignment(Assignment* node) {
+  VariableProxy* target = node->target()->AsVariableProxy();
+  if (target == nullptr) Visit(node->target());
+  node->set_value(Fold(node->value()));
+  if (node->op() != Token::INIT || target == nullptr ||
+      !target->is_resolved() ||
+      target->var()->mode() != VariableMode::kConst) {
+    return;
+  }
+  Literal* value = node->value()->AsLiteral();
+  if (value == nullptr || !IsPropagatable(value)) return;
+  if (constants_.emplace(target->var(), value).second) {
+    constant_order_.push_back(target->var());
+    changed_ = true;
+  }
+}
+
+void ConstantFolding::VisitUnaryOperation(UnaryOperation* node) {
+  node->set_expression(Fold(node->expression()));
+  Literal* operand = node->expression()->AsLiteral();
+  if (operand == nullptr) return;
+  Literal* result =
+      FoldUnaryOperation(node->op(), operand, node->position());
+  if (result != nullptr) Replace(node, result);
+}
+
+void ConstantFolding::VisitBinaryOperation(BinaryOperation* node) {
+  node->set_left(Fold(node->left()));
+  node->set_right(Fold(node->right()));
+  Literal* left = node->left()->AsLiteral();
+  if (left == nullptr || !IsPropagatable(left)) return;
+  if (node->op() == Token::COMMA) {
+    Replace(node, node->right());
+    return;
+  }
+  if (IsLogicalOp(node->op())) {
+    bool selects_left = SelectsLeft(node->op(), left);
+    if (selects_left && !CanRemove(node->right())) return;
+    Replace(node, selects_left ? node->left() : node->right());
+    return;
+  }
+  Literal* right = node->right()->AsLiteral();
+  if (right == nullptr) return;
+  Literal* result =
+      FoldBinaryOperation(node->op(), left, right, node->position());
+  if (result != nullptr) Replace(node, result);
+}
+
+// Logical operations drop the literal operands that pass on to the next
+// one; arithmetic folds literal operands from the left, as far as they go.
+void ConstantFolding::VisitNaryOperation(NaryOperation* node) {
+  node->set_first(Fold(node->first()));
+  for (size_t i = 0; i < node->subsequent_length(); i++) {
+    node->set_subsequent(i, Fold(node->subsequent(i)));
+  }
+  Token::Value op = node->op();
+  // Each operand with the position of the operator before it.
+  std::vector<std::pair<Expression*, int>> operands;
+  operands.push_back({node->first(), node->position()});
+  for (size_t i = 0; i < node->subsequent_length(); i++) {
+    operands.push_back(
+        {node->subsequent(i), node->subsequent_op_position(i)});
+  }
+
+  size_t folded = 0;
+  if (IsLogicalOp(op)) {
+    while (folded + 1 < operands.size()) {
+      Literal* literal = operands[folded].first->AsLiteral();
+      if (literal == nullptr || !IsPropagatable(literal)) break;
+      if (SelectsLeft(op, literal)) {
+        bool removable = true;
+        for (size_t i = folded + 1; i < operands.size(); i++) {
+          removable &= CanRemove(operands[i].first);
+        }
+        if (removable) {
+          Replace(node, literal);
+          return;
+        }
+        break;
+      }
+      folded++;
+    }
+    operands.erase(operands.begin(), operands.begin() + folded);
+  } else {
+    while (operands.size() >= 2) {
+      Literal* left = operands[0].first->AsLiteral();
+      Literal* right = operands[1].first->AsLiteral();
+      if (left == nullptr || right == nullptr) break;
+      Literal* result =
+          FoldBinaryOperation(op, left, right, operands[1].second);
+      if (result == nullptr) break;
+      operands[1].first = result;
+      operands.erase(operands.begin());
+      folded++;
+    }
+  }
+  if (folded == 0) return;
+
+  if (operands.size() == 1) {
+    Replace(node, operands[0].first);
+  } else if (operands.size() == 2) {
+    Replace(node, factory_.NewBinaryOperation(op, operands[0].first,
+                                              operands[1].first,
+                                              operands[1].second));
+  } else {
+    NaryOperation* rest = factory_.NewNaryOperation(op, operands[0].first,
+                                                    operands.size() - 1);
+    for (size_t i = 1; i < operands.size(); i++) {
+      rest->AddSubsequent(operands[i].first, operands[i].second);
+    }
+    Replace(node, rest);
+  }
+}
+
+void ConstantFolding::VisitCompareOperation(CompareOperation* node) {
+  node->set_left(Fold(node->left()));
+  node->set_right(Fold(node->right()));
+  Literal* left = node->left()->AsLiteral();
+  Literal* right = node->right()->AsLiteral();
+  if (left == nullptr || right == nullptr) return;
+  Literal* result =
+      FoldCompareOperation(node->op(), left, right, node->position());
+  if (result != nullptr) Replace(node, result);
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -0,0 +1,113 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_CONSTANT_FOLDING_H_
+#define V8_JS2C_CONSTANT_FOLDING_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+
+namespace v8 {
+namespace internal {
+
+// Simplifies the program in place before the analyses run, so that they and
+// the code generator only see the code that can run.
+//
+// Unary, binary, n-ary and compare operations on literals are folded the
+// way the parser folds arithmetic on number literals; logical operations and
+// conditionals with a literal condition are replaced by the operand they
+// select. A const binding initialized with a literal is propagated into its
+// reads, which may make more operations foldable, so the program is
+// rewritten until nothing changes. Reads are only replaced where the parent
+// node can take the literal: in operands, conditions, assigned and returned
+// values and expression statements.
+//
+// An if statement or conditional with a literal condition loses the branch
+// that is never taken, and a while or for loop whose condition is false
+// disappears. Code that declares or creates a function, or that suspends,
+// is kept, since the scopes, the call graph and the resume points still
+// count on it. Finally, the initializations of let, const and var bindings
+// that nothing reads any more are removed together with their declaration
+// if the value is a literal.
+//
+// The translator does not model the temporal dead zone, so a const read
+// before its initialization gets the value either way.
+class ConstantFolding final : public AstTraversalVisitor<ConstantFolding> {
+ public:
+  ConstantFolding(uintptr_t stack_limit, AstValueFactory* ast_value_factory,
+                  Zone* zone);
+
+  void Rewrite(FunctionLiteral* program);
+
+  static constexpr int kMaxRounds = 8;
+
+  // The names and values of the propagated constants, in the order they
+  // were found. The C code of a function may depend on constants declared
+  // outside of it, so this goes into every cache key.
+  std::string DescribeConstants() const;
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitBlock(Block* node);
+  void VisitExpressionStatement(ExpressionStatement* node);
+  void VisitIfStatement(IfStatement* node);
+  void VisitReturnStatement(ReturnStatement* node);
+  void VisitDoWhileStatement(DoWhileStatement* node);
+  void VisitWhileStatement(WhileStatement* node);
+  void VisitForStatement(ForStatement* node);
+  void VisitSwitchStatement(SwitchStatement* node);
+  void VisitConditional(Conditional* node);
+  void VisitVariableProxy(VariableProxy* node);
+  void VisitAssignment(Assignment* node);
+  void VisitUnaryOperation(UnaryOperation* node);
+  void VisitBinaryOperation(BinaryOperation* node);
+  void VisitNaryOperation(NaryOperation* node);
+  void VisitCompareOperation(CompareOperation* node);
+
+ private:
+  // Visits {expr} and returns what replaces it.
+  Expression* Fold(Expression* expr);
+  Statement* FoldStatement(Statement* statement);
+  void FoldStatements(ZonePtrList<Statement>* statements);
+  void Replace(Expression* node, Expression* replacement);
+  void ReplaceStatement(Statement* node, Statement* replacement);
+
+  Literal* CopyLiteral(Literal* literal, int pos);
+  Literal* FoldUnaryOperation(Token::Value op, Literal* operand, int pos);
+  Literal* FoldBinaryOperation(Token::Value op, Literal* left, Literal* right,
+                               int pos);
+  Literal* FoldCompareOperation(Token::Value op, Literal* left, Literal* right,
+                                int pos);
+  // For a logical operation with the literal left operand {left}, whether
+  // the result is {left}, as for false && x, rather than the right operand.
+  static bool SelectsLeft(Token::Value op, Literal* left);
+  bool CanRemove(AstNode* node);
+
+  void RemoveUnusedDeclarations(FunctionLiteral* program);
+  bool IsUnusedInitialization(Statement* statement) const;
+
+  AstNodeFactory factory_;
+  bool changed_ = false;
+  std::unordered_map<Variable*, Literal*> constants_;
+  std::vector<Variable*> constant_order_;
+  // The bindings whose initializations are removed.
+  std::unordered_set<Variable*> unused_;
+
+  // The node that the last Replace or ReplaceStatement was for.
+  Expression* replaced_ = nullptr;
+  Expression* replacement_ = nullptr;
+  Statement* replaced_statement_ = nullptr;
+  Statement* statement_replacement_ = nullptr;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_CONSTANT_FOLDING_H_
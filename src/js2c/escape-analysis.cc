@@ -0,0 +1,244 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/escape-analysis.h"
+
+namespace v8 {
+namespace internal {
+
+EscapeAnalysis::EscapeAnalysis(uintptr_t stack_limit,
+                               const TypeInference* types)
+    : AstTraversalVisitor<EscapeAnalysis>(stack_limit), types_(types) {}
+
+void EscapeAnalysis::Analyze(FunctionLiteral* program) {
+  Enqueue(program);
+  while (!worklist_.empty()) {
+    FunctionLiteral* literal = worklist_.back();
+    worklist_.pop_back();
+    AnalyzeFunction(literal);
+    if (HasStackOverflow()) return;
+  }
+  Propagate();
+}
+
+bool EscapeAnalysis::MayAllocate(FunctionLiteral* function) const {
+  auto it = summaries_.find(function);
+  return it == summaries_.end() || it->second.allocates;
+}
+
+bool EscapeAnalysis::MayEscape(FunctionLiteral* function) const {
+  auto it = summaries_.find(function);
+  return it == summaries_.end() || it->second.escapes;
+}
+
+bool EscapeAnalysis::NeedsArenaScope(const FunctionTypes* callee) const {
+  return callee != nullptr && IsUnboxedType(callee->return_type()) &&
+         MayAllocate(callee->literal()) && !MayEscape(callee->literal());
+}
+
+void EscapeAnalysis::Enqueue(FunctionLiteral* literal) {
+  if (summaries_.count(literal) != 0) return;
+  summaries_[literal];
+  worklist_.push_back(literal);
+}
+
+void EscapeAnalysis::AnalyzeFunction(FunctionLiteral* literal) {
+  current_ = &summaries_[literal];
+  const FunctionTypes* generic = types_->TypesFor(literal);
+  // Functions the inference never reached are not emitted as direct
+  // callees, so there is nothing to gain from looking inside them.
+  if (generic == nullptr || IsResumableFunction(literal->kind())) {
+    MarkEscape();
+  } else {
+    current_types_ = types_->SpecializationsOf(literal);
+    current_types_.push_back(generic);
+  }
+  VisitDeclarations(literal->scope()->declarations());
+  VisitStatements(literal->body());
+  current_ = nullptr;
+  current_types_.clear();
+}
+
+void EscapeAnalysis::Propagate() {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& entry : summaries_) {
+      Summary& summary = entry.second;
+      for (FunctionLiteral* callee : summary.callees) {
+        const Summary& callee_summary = summaries_.find(callee)->second;
+        if (callee_summary.allocates && !summary.allocates) {
+          summary.allocates = changed = true;
+        }
+        if (callee_summary.escapes && !summary.escapes) {
+          summary.escapes = changed = true;
+        }
+      }
+    }
+  }
+}
+
+bool EscapeAnalysis::IsHeapType(Expression* expr) const {
+  if (current_types_.empty()) return true;
+  for (const FunctionTypes* types : current_types_) {
+    if (!IsUnboxedType(types->TypeOf(expr))) return true;
+  }
+  return false;
+}
+
+bool EscapeAnalysis::IsStringType(Expression* expr) const {
+  if (current_types_.empty()) return false;
+  for (const FunctionTypes* types : current_types_) {
+    if (types->TypeOf(expr) != InferredType::kString) return false;
+  }
+  return true;
+}
+
+void EscapeAnalysis::AnalyzeStore(Expression* target, Expression* value) {
+  VariableProxy* proxy = target->AsVariableProxy();
+  if (proxy == nullptr) {
+    // Properties, private fields and destructuring patterns.
+    if (IsHeapType(value)) MarkEscape();
+    return;
+  }
+  if (!proxy->is_resolved() || !proxy->var()->IsStackAllocated()) {
+    // Context slots outlive the call through the closures that share them,
+    // and globals outlive everything.
+    if (IsHeapType(value)) MarkEscape();
+  }
+}
+
+// The value a for-in or for-of loop assigns is a heap value.
+void EscapeAnalysis::AnalyzeLoopTarget(Expression* each) {
+  VariableProxy* proxy = each->AsVariableProxy();
+  if (proxy == nullptr || !proxy->is_resolved() ||
+      !proxy->var()->IsStackAllocated()) {
+    MarkEscape();
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void EscapeAnalysis::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  // The closure is created on entry and may capture anything it can see,
+  // like that of a function literal.
+  MarkEscape();
+  Enqueue(node->fun());
+}
+
+void EscapeAnalysis::VisitFunctionLiteral(FunctionLiteral* node) {
+  // The closure object may capture anything it can see.
+  MarkEscape();
+  Enqueue(node);
+}
+
+void EscapeAnalysis::VisitClassLiteral(ClassLiteral* node) {
+  MarkEscape();
+  AstTraversalVisitor::VisitClassLiteral(node);
+}
+
+void EscapeAnalysis::VisitObjectLiteral(ObjectLiteral* node) {
+  MarkAllocation();
+  AstTraversalVisitor::VisitObjectLiteral(node);
+}
+
+void EscapeAnalysis::VisitArrayLiteral(ArrayLiteral* node) {
+  MarkAllocation();
+  AstTraversalVisitor::VisitArrayLiteral(node);
+}
+
+void EscapeAnalysis::VisitRegExpLiteral(RegExpLiteral* node) {
+  MarkAllocation();
+}
+
+void EscapeAnalysis::VisitTemplateLiteral(TemplateLiteral* node) {
+  MarkAllocation();
+  AstTraversalVisitor::VisitTemplateLiteral(node);
+}
+
+void EscapeAnalysis::VisitAssignment(Assignment* node) {
+  AnalyzeStore(node->target(), node->value());
+  AstTraversalVisitor::VisitAssignment(node);
+}
+
+void EscapeAnalysis::VisitCompoundAssignment(CompoundAssignment* node) {
+  AnalyzeStore(node->target(), node->binary_operation());
+  Visit(node->binary_operation());
+}
+
+void EscapeAnalysis::VisitBinaryOperation(BinaryOperation* node) {
+  // Only a concatenation produces a new heap value.
+  if (node->op() == Token::ADD && IsHeapType(node)) MarkAllocation();
+  AstTraversalVisitor::VisitBinaryOperation(node);
+}
+
+void EscapeAnalysis::VisitNaryOperation(NaryOperation* node) {
+  if (node->op() == Token::ADD && IsHeapType(node)) MarkAllocation();
+  AstTraversalVisitor::VisitNaryOperation(node);
+}
+
+void EscapeAnalysis::VisitCall(Call* node) {
+  VariableProxy* proxy = node->expression()->AsVariableProxy();
+  FunctionLiteral* callee =
+      proxy != nullptr && proxy->is_resolved() && !node->is_possibly_eval() &&
+              node->spread_position() == Call::kNoSpread
+          ? types_->DeclaredFunction(proxy->var())
+          : nullptr;
+  if (callee == nullptr) {
+    // Unknown code can keep its arguments alive.
+    MarkEscape();
+    AstTraversalVisitor::VisitCall(node);
+    return;
+  }
+  current_->callees.push_back(callee);
+  Enqueue(callee);
+  for (Expression* argument : *node->arguments()) Visit(argument);
+}
+
+void EscapeAnalysis::VisitCallNew(CallNew* node) {
+  MarkEscape();
+  AstTraversalVisitor::VisitCallNew(node);
+}
+
+// The keys of arrays and strings are allocated.
+void EscapeAnalysis::VisitForInStatement(ForInStatement* node) {
+  MarkAllocation();
+  AnalyzeLoopTarget(node->each());
+  AstTraversalVisitor::VisitForInStatement(node);
+}
+
+// Characters outside ASCII are allocated, and a generator runs code of its
+// own.
+void EscapeAnalysis::VisitForOfStatement(ForOfStatement* node) {
+  if (IsStringType(node->subject())) {
+    MarkAllocation();
+    AnalyzeLoopTarget(node->each());
+  } else {
+    MarkEscape();
+  }
+  AstTraversalVisitor::VisitForOfStatement(node);
+}
+
+void EscapeAnalysis::VisitThrow(Throw* node) {
+  if (IsHeapType(node->exception())) MarkEscape();
+  AstTraversalVisitor::VisitThrow(node);
+}
+
+void EscapeAnalysis::VisitYield(Yield* node) {
+  MarkEscape();
+  AstTraversalVisitor::VisitYield(node);
+}
+
+void EscapeAnalysis::VisitYieldStar(YieldStar* node) {
+  MarkEscape();
+  AstTraversalVisitor::VisitYieldStar(node);
+}
+
+void EscapeAnalysis::VisitAwait(Await* node) {
+  MarkEscape();
+  AstTraversalVisitor::VisitAwait(node);
+}
+
+}  // namespace internal
+}  // namespace v8
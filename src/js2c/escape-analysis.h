@@ -0,0 +1,96 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_ESCAPE_ANALYSIS_H_
+#define V8_JS2C_ESCAPE_ANALYSIS_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+#include "src/js2c/type-inference.h"
+
+namespace v8 {
+namespace internal {
+
+// Decides which calls can run inside an arena scope of the js2c runtime, so
+// that everything they allocate is released in one step when they return.
+//
+// A function allocates if it creates a heap value itself (string
+// concatenation, literals, closures) or calls something that does. Its
+// allocations escape if it may store a heap value anywhere that outlives the
+// call: a variable that the scope analysis did not put on the stack (context
+// slots, globals), a property, a thrown exception or an unknown callee. Both
+// properties are propagated through the direct call graph. A value that is
+// returned escapes unless the return type is unboxed, which is checked per
+// call site.
+class EscapeAnalysis final : public AstTraversalVisitor<EscapeAnalysis> {
+ public:
+  EscapeAnalysis(uintptr_t stack_limit, const TypeInference* types);
+
+  void Analyze(FunctionLiteral* program);
+
+  bool MayAllocate(FunctionLiteral* function) const;
+  bool MayEscape(FunctionLiteral* function) const;
+
+  // True if calls to the version {callee} of a function should be wrapped in
+  // an arena scope: it may allocate, but nothing it allocates is reachable
+  // after it returns.
+  bool NeedsArenaScope(const FunctionTypes* callee) const;
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitClassLiteral(ClassLiteral* node);
+  void VisitObjectLiteral(ObjectLiteral* node);
+  void VisitArrayLiteral(ArrayLiteral* node);
+  void VisitRegExpLiteral(RegExpLiteral* node);
+  void VisitTemplateLiteral(TemplateLiteral* node);
+  void VisitAssignment(Assignment* node);
+  void VisitCompoundAssignment(CompoundAssignment* node);
+  void VisitBinaryOperation(BinaryOperation* node);
+  void VisitNaryOperation(NaryOperation* node);
+  void VisitCall(Call* node);
+  void VisitCallNew(CallNew* node);
+  void VisitForInStatement(ForInStatement* node);
+  void VisitForOfStatement(ForOfStatement* node);
+  void VisitThrow(Throw* node);
+  void VisitYield(Yield* node);
+  void VisitYieldStar(YieldStar* node);
+  void VisitAwait(Await* node);
+
+ private:
+  struct Summary {
+    bool allocates = false;
+    bool escapes = false;
+    std::vector<FunctionLiteral*> callees;
+  };
+
+  void AnalyzeFunction(FunctionLiteral* literal);
+  void Enqueue(FunctionLiteral* literal);
+  void Propagate();
+
+  void MarkAllocation() { current_->allocates = true; }
+  void MarkEscape() { current_->allocates = current_->escapes = true; }
+  bool IsHeapType(Expression* expr) const;
+  bool IsStringType(Expression* expr) const;
+  void AnalyzeStore(Expression* target, Expression* value);
+  void AnalyzeLoopTarget(Expression* each);
+
+  const TypeInference* types_;
+  std::unordered_map<FunctionLiteral*, Summary> summaries_;
+  std::vector<FunctionLiteral*> worklist_;
+
+  Summary* current_ = nullptr;
+  // The generic version and the specializations of the current function.
+  // The summary holds for all of them.
+  std::vector<const FunctionTypes*> current_types_;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_ESCAPE_ANALYSIS_H_
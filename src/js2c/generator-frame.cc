@@ -0,0 +1,230 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/generator-frame.h"
+
+namespace v8 {
+namespace internal {
+
+GeneratorFrame::GeneratorFrame(uintptr_t stack_limit,
+                               const ClosureConversion* closures,
+                               FunctionLiteral* function)
+    : AstTraversalVisitor<GeneratorFrame>(stack_limit),
+      closures_(closures),
+      function_(function) {}
+
+void GeneratorFrame::Analyze() {
+  if (!IsResumableFunction(function_->kind()) ||
+      IsAsyncGeneratorFunction(function_->kind())) {
+    supported_ = false;
+    return;
+  }
+  // Declared functions are created on entry, before the first suspend.
+  VisitDeclarations(function_->scope()->declarations());
+  VisitStatements(function_->body());
+  if (HasStackOverflow() ||
+      resume_point_count() != function_->suspend_count()) {
+    supported_ = false;
+  }
+  if (!supported_) return;
+  for (const Loop& loop : loops_) {
+    if (!loop.suspends) continue;
+    for (Variable* var : loop.references) {
+      references_[var].crosses_suspend = true;
+    }
+  }
+  AssignSlots();
+}
+
+int GeneratorFrame::ResumePointOf(Suspend* suspend) const {
+  auto it = resume_points_.find(suspend);
+  DCHECK(it != resume_points_.end());
+  return it->second;
+}
+
+int GeneratorFrame::SlotOf(Variable* var) const {
+  auto it = slots_.find(var);
+  return it == slots_.end() ? -1 : it->second;
+}
+
+Suspend* GeneratorFrame::StatementSuspend(Statement* statement) {
+  Expression* expr = nullptr;
+  if (statement->IsExpressionStatement()) {
+    expr = statement->AsExpressionStatement()->expression();
+  } else if (statement->IsReturnStatement()) {
+    expr = statement->AsReturnStatement()->expression();
+  }
+  if (expr == nullptr) return nullptr;
+  Assignment* assignment = expr->AsAssignment();
+  if (assignment != nullptr && assignment->target()->IsVariableProxy() &&
+      !Token::IsLogicalAssignmentOp(assignment->op())) {
+    expr = assignment->value();
+  }
+  if (expr->IsYield()) return expr->AsYield();
+  if (expr->IsAwait()) return expr->AsAwait();
+  return nullptr;
+}
+
+// Parameters always live in the frame, where the entry function stores
+// them. The rest are laid out in the order they are first referenced.
+void GeneratorFrame::AssignSlots() {
+  DeclarationScope* scope = function_->scope();
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    Variable* parameter = scope->parameter(i);
+    if (closures_ != nullptr && closures_->EnvironmentSlotOf(parameter) >= 0) {
+      continue;
+    }
+    slots_[parameter] = slot_count_++;
+  }
+  for (Variable* var : variables_) {
+    if (!references_[var].crosses_suspend || slots_.count(var) != 0) continue;
+    slots_[var] = slot_count_++;
+  }
+  if (closures_ != nullptr && closures_->NeedsClosure(function_)) {
+    closure_slot_ = slot_count_++;
+  }
+  if (closures_ != nullptr && closures_->EnvironmentSizeOf(function_) > 0) {
+    environment_slot_ = slot_count_++;
+  }
+}
+
+// Only the locals of the function itself are candidates. Environment slots
+// are reached through the record, and the generator object is the first
+// parameter of the resume function.
+void GeneratorFrame::AddReference(Variable* var) {
+  DeclarationScope* scope = function_->scope();
+  if (var->scope()->GetClosureScope() != scope ||
+      ClosureConversion::IsGlobal(var) || var == scope->function_var() ||
+      var == scope->generator_object_var() ||
+      (closures_ != nullptr && closures_->EnvironmentSlotOf(var) >= 0)) {
+    return;
+  }
+  int segment = resume_point_count();
+  auto it = references_.find(var);
+  if (it == references_.end()) {
+    variables_.push_back(var);
+    references_[var] = {segment, false};
+  } else if (it->second.segment != segment) {
+    it->second.crosses_suspend = true;
+  }
+  for (size_t loop : loop_stack_) loops_[loop].references.push_back(var);
+}
+
+// Creating a closure reads the variables it copies.
+void GeneratorFrame::AddCaptures(FunctionLiteral* literal) {
+  if (closures_ == nullptr) return;
+  for (const ClosureConversion::Capture& capture :
+       closures_->CapturesOf(literal)) {
+    if (capture.var != nullptr) AddReference(capture.var);
+  }
+}
+
+void GeneratorFrame::AddSuspend(Suspend* suspend) {
+  if (suspend != statement_suspend_ || finally_depth_ > 0) {
+    supported_ = false;
+  }
+  statement_suspend_ = nullptr;
+  Visit(suspend->expression());
+  suspends_.push_back(suspend);
+  resume_points_[suspend] = resume_point_count();
+  for (size_t loop : loop_stack_) loops_[loop].suspends = true;
+}
+
+void GeneratorFrame::EnterLoop() {
+  loop_stack_.push_back(loops_.size());
+  loops_.emplace_back();
+}
+
+void GeneratorFrame::ExitLoop() { loop_stack_.pop_back(); }
+
+void GeneratorFrame::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  AddReference(node->var());
+  AddCaptures(node->fun());
+}
+
+void GeneratorFrame::VisitFunctionLiteral(FunctionLiteral* node) {
+  AddCaptures(node);
+}
+
+void GeneratorFrame::VisitClassLiteral(ClassLiteral* node) {}
+
+void GeneratorFrame::VisitExpressionStatement(ExpressionStatement* node) {
+  statement_suspend_ = StatementSuspend(node);
+  AstTraversalVisitor::VisitExpressionStatement(node);
+}
+
+void GeneratorFrame::VisitReturnStatement(ReturnStatement* node) {
+  statement_suspend_ = StatementSuspend(node);
+  AstTraversalVisitor::VisitReturnStatement(node);
+}
+
+void GeneratorFrame::VisitDoWhileStatement(DoWhileStatement* node) {
+  EnterLoop();
+  AstTraversalVisitor::VisitDoWhileStatement(node);
+  ExitLoop();
+}
+
+void GeneratorFrame::VisitWhileStatement(WhileStatement* node) {
+  EnterLoop();
+  AstTraversalVisitor::VisitWhileStatement(node);
+  ExitLoop();
+}
+
+void GeneratorFrame::VisitForStatement(ForStatement* node) {
+  EnterLoop();
+  AstTraversalVisitor::VisitForStatement(node);
+  ExitLoop();
+}
+
+// The iterable and the index of these loops are C locals.
+void GeneratorFrame::VisitForInStatement(ForInStatement* node) {
+  EnterLoop();
+  AstTraversalVisitor::VisitForInStatement(node);
+  if (loops_[loop_stack_.back()].suspends) supported_ = false;
+  ExitLoop();
+}
+
+void GeneratorFrame::VisitForOfStatement(ForOfStatement* node) {
+  EnterLoop();
+  AstTraversalVisitor::VisitForOfStatement(node);
+  if (loops_[loop_stack_.back()].suspends) supported_ = false;
+  ExitLoop();
+}
+
+// The catch variable is assigned where the catch block starts.
+void GeneratorFrame::VisitTryCatchStatement(TryCatchStatement* node) {
+  Visit(node->try_block());
+  if (node->scope() != nullptr) AddReference(node->scope()->catch_variable());
+  Visit(node->catch_block());
+}
+
+void GeneratorFrame::VisitTryFinallyStatement(TryFinallyStatement* node) {
+  Visit(node->try_block());
+  finally_depth_++;
+  Visit(node->finally_block());
+  finally_depth_--;
+}
+
+// The variable a suspend is assigned to is written after the resume.
+void GeneratorFrame::VisitAssignment(Assignment* node) {
+  if (statement_suspend_ == nullptr || node->value() != statement_suspend_) {
+    AstTraversalVisitor::VisitAssignment(node);
+    return;
+  }
+  Visit(node->value());
+  Visit(node->target());
+}
+
+void GeneratorFrame::VisitYield(Yield* node) { AddSuspend(node); }
+
+void GeneratorFrame::VisitYieldStar(YieldStar* node) { supported_ = false; }
+
+void GeneratorFrame::VisitAwait(Await* node) { AddSuspend(node); }
+
+void GeneratorFrame::VisitVariableProxy(VariableProxy* node) {
+  if (node->is_resolved()) AddReference(node->var());
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -0,0 +1,123 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_GENERATOR_FRAME_H_
+#define V8_JS2C_GENERATOR_FRAME_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+#include "src/js2c/closure-conversion.h"
+
+namespace v8 {
+namespace internal {
+
+// Lays out the heap frame of a generator or async function, whose body the
+// code generator prints as a resumable C function; see js2c_generator.h.
+//
+// The suspends of the body (the initial yield of a generator, yield and
+// await) are numbered from 1 in source order, the order in which the parser
+// counted them in FunctionLiteral::suspend_count(). Each suspend returns from
+// the C function, so the body splits into segments between suspends that
+// run in different calls. A variable of the function stays a C local if
+// every reference to it is in one segment and none is in a loop that
+// suspends. All others get a slot of the frame, as do the parameters, which
+// only the entry function receives, and the closure and environment record.
+//
+// Suspends are lowered at statement level: a suspend must be the whole
+// expression of an expression statement or a return, or the value that one
+// assigns to a variable. Bodies with a suspend anywhere else, a yield*, a
+// suspend in a finally block or in a for-in or for-of loop are not
+// supported, and neither are async generators; the code generator prints
+// those as before.
+class GeneratorFrame final : public AstTraversalVisitor<GeneratorFrame> {
+ public:
+  GeneratorFrame(uintptr_t stack_limit, const ClosureConversion* closures,
+                 FunctionLiteral* function);
+
+  void Analyze();
+
+  bool is_supported() const { return supported_; }
+
+  // The number of the resume point right after {suspend}.
+  int ResumePointOf(Suspend* suspend) const;
+  int resume_point_count() const { return static_cast<int>(suspends_.size()); }
+
+  // The slot of {var} in the frame, or -1 if it stays a C local.
+  int SlotOf(Variable* var) const;
+  // -1 if the function has no closure or no environment record.
+  int closure_slot() const { return closure_slot_; }
+  int environment_slot() const { return environment_slot_; }
+  int slot_count() const { return slot_count_; }
+
+  // The suspend that {statement} consists of, as described above, or
+  // nullptr.
+  static Suspend* StatementSuspend(Statement* statement);
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitClassLiteral(ClassLiteral* node);
+  void VisitExpressionStatement(ExpressionStatement* node);
+  void VisitReturnStatement(ReturnStatement* node);
+  void VisitDoWhileStatement(DoWhileStatement* node);
+  void VisitWhileStatement(WhileStatement* node);
+  void VisitForStatement(ForStatement* node);
+  void VisitForInStatement(ForInStatement* node);
+  void VisitForOfStatement(ForOfStatement* node);
+  void VisitTryCatchStatement(TryCatchStatement* node);
+  void VisitTryFinallyStatement(TryFinallyStatement* node);
+  void VisitAssignment(Assignment* node);
+  void VisitYield(Yield* node);
+  void VisitYieldStar(YieldStar* node);
+  void VisitAwait(Await* node);
+  void VisitVariableProxy(VariableProxy* node);
+
+ private:
+  struct Reference {
+    int segment;
+    bool crosses_suspend;
+  };
+
+  struct Loop {
+    bool suspends = false;
+    std::vector<Variable*> references;
+  };
+
+  void AddReference(Variable* var);
+  void AddCaptures(FunctionLiteral* literal);
+  void AddSuspend(Suspend* suspend);
+  void EnterLoop();
+  void ExitLoop();
+  void AssignSlots();
+
+  const ClosureConversion* closures_;
+  FunctionLiteral* function_;
+  bool supported_ = true;
+
+  std::vector<Suspend*> suspends_;
+  std::unordered_map<Suspend*, int> resume_points_;
+  // The suspend the statement being visited consists of.
+  Suspend* statement_suspend_ = nullptr;
+  int finally_depth_ = 0;
+
+  // Variables in the order they are first referenced.
+  std::vector<Variable*> variables_;
+  std::unordered_map<Variable*, Reference> references_;
+  std::vector<Loop> loops_;
+  std::vector<size_t> loop_stack_;
+
+  std::unordered_map<Variable*, int> slots_;
+  int closure_slot_ = -1;
+  int environment_slot_ = -1;
+  int slot_count_ = 0;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_GENERATOR_FRAME_H_
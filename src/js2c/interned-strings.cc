@@ -0,0 +1,89 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/interned-strings.h"
+
+#include "src/ast/ast-value-factory.h"
+#include "src/objects/name.h"
+#include "src/strings/string-hasher-inl.h"
+#include "src/strings/unicode.h"
+
+namespace v8 {
+namespace internal {
+
+InternedStrings::InternedStrings(uintptr_t stack_limit)
+    : AstTraversalVisitor<InternedStrings>(stack_limit) {}
+
+void InternedStrings::Analyze(FunctionLiteral* program) {
+  VisitFunctionLiteral(program);
+}
+
+int InternedStrings::IndexOf(const AstRawString* string) const {
+  auto it = indices_.find(string);
+  return it == indices_.end() ? -1 : it->second;
+}
+
+void InternedStrings::VisitLiteral(Literal* node) {
+  if (node->type() == Literal::kString) Add(node->AsRawString());
+}
+
+void InternedStrings::VisitTemplateLiteral(TemplateLiteral* node) {
+  for (const AstRawString* string : *node->string_parts()) {
+    if (!string->IsEmpty()) Add(string);
+  }
+  AstTraversalVisitor::VisitTemplateLiteral(node);
+}
+
+void InternedStrings::Add(const AstRawString* string) {
+  if (indices_.count(string) != 0) return;
+  indices_[string] = static_cast<int>(entries_.size());
+  std::string utf8 = EncodeUtf8(string);
+  uint32_t hash = HashUtf8(utf8);
+  entries_.push_back({string, std::move(utf8), hash, string->is_one_byte()});
+}
+
+std::string EncodeUtf8(const AstRawString* string) {
+  std::string result;
+  const unsigned char* raw_bytes = string->raw_data();
+  const uint16_t* raw_chars = reinterpret_cast<const uint16_t*>(raw_bytes);
+  int length = string->length();
+  for (int i = 0; i < length; i++) {
+    uint32_t c = string->is_one_byte() ? raw_bytes[i] : raw_chars[i];
+    if (unibrow::Utf16::IsLeadSurrogate(c) && i + 1 < length &&
+        unibrow::Utf16::IsTrailSurrogate(raw_chars[i + 1])) {
+      c = unibrow::Utf16::CombineSurrogatePair(c, raw_chars[++i]);
+    }
+    if (c < 0x80) {
+      result += static_cast<char>(c);
+    } else if (c < 0x800) {
+      result += static_cast<char>(0xC0 | (c >> 6));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      result += static_cast<char>(0xE0 | (c >> 12));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+      result += static_cast<char>(0xF0 | (c >> 18));
+      result += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      result += static_cast<char>(0x80 | (c & 0x3F));
+    }
+  }
+  return result;
+}
+
+uint32_t HashUtf8(const std::string& utf8) {
+  // Unlike HashSequentialString, integer indices hash like any other string
+  // and there is no cutoff for long strings, which keeps js_string_hash
+  // simple.
+  uint32_t running_hash = 0;
+  for (char c : utf8) {
+    running_hash = StringHasher::AddCharacterCore(
+        running_hash, static_cast<unsigned char>(c));
+  }
+  return StringHasher::GetHashCore(running_hash) & Name::HashBits::kMax;
+}
+
+}  // namespace internal
+}  // namespace v8
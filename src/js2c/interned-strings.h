@@ -0,0 +1,67 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_INTERNED_STRINGS_H_
+#define V8_JS2C_INTERNED_STRINGS_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+
+namespace v8 {
+namespace internal {
+
+// The string literals of the whole program, property names and the spans of
+// template literals included, which the code generator emits once each into
+// a static table in .rodata; see js_string_header in js2c.h.
+//
+// The parser already interns AstRawStrings, so equal literals are the same
+// pointer. Every entry carries what the runtime would otherwise compute when
+// the program starts: the UTF-8 bytes the C strings hold, their hash and
+// whether the JavaScript string is one-byte.
+class InternedStrings final : public AstTraversalVisitor<InternedStrings> {
+ public:
+  struct Entry {
+    const AstRawString* string;
+    std::string utf8;
+    uint32_t hash;
+    bool is_one_byte;
+  };
+
+  explicit InternedStrings(uintptr_t stack_limit);
+
+  void Analyze(FunctionLiteral* program);
+
+  // In the order the strings first appear in the source.
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  // The index of {string} in entries(), or -1 if it is not in the table.
+  int IndexOf(const AstRawString* string) const;
+
+  // AstTraversalVisitor overrides.
+  void VisitLiteral(Literal* node);
+  void VisitTemplateLiteral(TemplateLiteral* node);
+
+ private:
+  void Add(const AstRawString* string);
+
+  std::vector<Entry> entries_;
+  std::unordered_map<const AstRawString*, int> indices_;
+};
+
+// The bytes of {string} as the runtime stores them: UTF-8, with lone
+// surrogates encoded like any other code point.
+std::string EncodeUtf8(const AstRawString* string);
+
+// V8's StringHasher with a zero seed over {utf8}, as js_string_hash computes
+// it at run time.
+uint32_t HashUtf8(const std::string& utf8);
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_INTERNED_STRINGS_H_
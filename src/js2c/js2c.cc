@@ -4,28 +4,52 @@
 
 #include "src/js2c/js2c.h"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 #include "include/libplatform/libplatform.h"
-#include "include/v8-context.h"
 #include "include/v8-initialization.h"
 #include "include/v8-isolate.h"
 #include "include/v8-local-handle.h"
+#include "include/v8-platform.h"
 #include "include/v8-primitive.h"
 #include "include/v8-script.h"
 #include "src/api/api-inl.h"
+#include "src/base/platform/condition-variable.h"
+#include "src/base/platform/elapsed-timer.h"
+#include "src/base/platform/mutex.h"
+#include "src/base/platform/platform.h"
 #include "src/ast/ast.h"
 #include "src/codegen/script-details.h"
 #include "src/common/globals.h"
 #include "src/execution/isolate.h"
 #include "src/flags/flags.h"
+#include "src/init/v8.h"
 #include "src/js2c/c-code-generator.h"
+#include "src/js2c/call-graph.h"
+#include "src/js2c/closure-conversion.h"
+#include "src/js2c/constant-folding.h"
+#include "src/js2c/escape-analysis.h"
+#include "src/js2c/interned-strings.h"
+#include "src/js2c/range-analysis.h"
+#include "src/js2c/translation-cache.h"
+#include "src/js2c/type-feedback.h"
+#include "src/js2c/type-inference.h"
 #include "src/objects/script.h"
+#include "src/objects/string.h"
 #include "src/parsing/parsing.h"
+#include "src/utils/utils.h"
 #include "src/ast/prettyprinter.h"
 
 namespace v8 {
@@ -90,90 +114,209 @@ i::Handle<i::Script> NewScript(
   SetScriptFieldsFromDetails(isolate, *script, script_details, &no_gc);
   return script;
 }
-}  // namespace
 
-JS2C::JS2C(Local<Context> context, ScriptCompiler::Source* source) {
-  auto isolate =
-      reinterpret_cast<v8::internal::Isolate*>(context->GetIsolate());
-  i::ScriptDetails script_details = GetScriptDetails(
-      isolate, source->resource_name, source->resource_line_offset,
-      source->resource_column_offset, source->source_map_url,
-      source->host_defined_options, source->resource_options);
-  i::Handle<i::String> str = Utils::OpenHandle(*(source->source_string));
-  i::UnoptimizedCompileState compile_state;
-  i::ReusableUnoptimizedCompileState reusable_state(isolate);
-  i::LanguageMode language_mode =
-      construct_language_mode(i::v8_flags.use_strict);
-  i::UnoptimizedCompileFlags flags =
-      i::UnoptimizedCompileFlags::ForToplevelCompile(
-          isolate, true, language_mode, script_details.repl_mode,
-          script_details.origin_options.IsModule() ? ScriptType::kModule
-                                                   : ScriptType::kClassic,
-          false);
-
-  flags.set_is_eager(true);
-
-  i::ParseInfo parse_info(isolate, flags, &compile_state, &reusable_state);
-  i::Handle<i::Script> script =
-      NewScript(isolate, &parse_info, str, script_details, i::NOT_NATIVES_CODE);
-  i::parsing::ParseProgram(
-      &parse_info, script, isolate, i::parsing::ReportStatisticsMode::kYes);
-
-  header_generator_ = new i::CCodeGenerator(parse_info.stack_limit());
-  generator_ = new i::CCodeGenerator(parse_info.stack_limit());
-
-  std::vector<i::FunctionLiteral*> functions_to_compile;
-  functions_to_compile.push_back(parse_info.literal());
-
-  i::FunctionLiteral* literal = functions_to_compile.back();
-  functions_to_compile.pop_back();
+// A C function to print: the generic version of a function literal, or one
+// of its specializations.
+using EmissionUnit = std::pair<i::FunctionLiteral*, const i::FunctionTypes*>;
+
+// Prints the C functions {units[i]} for every i in {pending}, on the worker
+// threads of the platform or serially. Every thread that joins has a
+// generator of its own and claims functions in order. The output of each
+// function is kept in a buffer of its own, so that the C file comes out the
+// same whatever the number of threads.
+class PrintFunctionsJob final : public JobTask {
+ public:
+  PrintFunctionsJob(const std::vector<EmissionUnit>& units,
+                    const std::vector<size_t>& pending,
+                    std::vector<i::OutputBuffer>* outputs,
+                    const i::TypeInference* types,
+                    const i::EscapeAnalysis* escapes,
+                    const i::CallGraph* call_graph,
+                    const i::ClosureConversion* closures,
+                    const i::TypeFeedback* feedback,
+                    const i::InternedStrings* strings)
+      : units_(units),
+        pending_(pending),
+        outputs_(outputs),
+        types_(types),
+        escapes_(escapes),
+        call_graph_(call_graph),
+        closures_(closures),
+        feedback_(feedback),
+        strings_(strings) {}
+
+  void Run(JobDelegate* delegate) override {
+    // The stack limit is that of the thread the generator runs on.
+    PrintFunctions(
+        i::GetCurrentStackPosition() - i::v8_flags.stack_size * i::KB,
+        delegate);
+  }
 
-  generator_->PrepareCFile();
+  size_t GetMaxConcurrency(size_t worker_count) const override {
+    size_t next = next_.load(std::memory_order_relaxed);
+    return next >= pending_.size() ? 0 : pending_.size() - next;
+  }
 
-  header_generator_->PrintFunctionDeclaration(literal);
-  generator_->PrintFunction(literal, true);
+  // Without a {delegate} this prints everything on the calling thread.
+  void PrintFunctions(uintptr_t stack_limit, JobDelegate* delegate) {
+    i::CCodeGenerator generator(stack_limit, types_, escapes_, call_graph_,
+                                closures_, feedback_, strings_);
+    while (delegate == nullptr || !delegate->ShouldYield()) {
+      size_t next = next_.fetch_add(1, std::memory_order_relaxed);
+      if (next >= pending_.size()) return;
+      size_t index = pending_[next];
+      i::FunctionLiteral* literal = units_[index].first;
+      generator.PrintFunction(literal, literal->is_toplevel(),
+                              units_[index].second);
+      (*outputs_)[index].Append(generator.mutable_output());
+    }
+  }
 
-  i::StdoutStream os;
-  os << i::AstPrinter(parse_info.stack_limit()).PrintProgram(literal);
-  os << "\n\n";
+ private:
+  const std::vector<EmissionUnit>& units_;
+  const std::vector<size_t>& pending_;
+  std::vector<i::OutputBuffer>* outputs_;
+  const i::TypeInference* types_;
+  const i::EscapeAnalysis* escapes_;
+  const i::CallGraph* call_graph_;
+  const i::ClosureConversion* closures_;
+  const i::TypeFeedback* feedback_;
+  const i::InternedStrings* strings_;
+  std::atomic<size_t> next_{0};
+};
+
+// The function scope directly inside the script that contains {literal}.
+// Its source covers everything a function takes its captures from; see
+// ClosureConversion.
+i::DeclarationScope* OutermostFunctionScope(i::FunctionLiteral* literal) {
+  i::DeclarationScope* outermost = literal->scope();
+  for (i::Scope* scope = outermost->outer_scope();
+       scope != nullptr && !scope->is_script_scope();
+       scope = scope->outer_scope()) {
+    if (scope->is_function_scope()) outermost = scope->AsDeclarationScope();
+  }
+  return outermost;
+}
+}  // namespace
 
-  generator_->FinishCFile();
+JS2C::JS2C(Isolate* isolate, ScriptCompiler::Source* source,
+           const std::string& output_base, bool print_ast)
+    : output_base_(output_base),
+      print_ast_(print_ast),
+      header_generator_(nullptr),
+      generator_(nullptr) {
+  Generate(isolate, source);
 }
 
-JS2C::~JS2C() { return; }
+JS2C::~JS2C() {
+  delete header_generator_;
+  delete generator_;
+}
 
 void JS2C::WriteToStdout() {
-  i::StdoutStream os;
-  os << header_generator_->GetOutput();
-  os << "\n";
-  os << generator_->GetOutput();
+  // The outputs bypass stdio, so whatever it buffered goes first.
+  fflush(stdout);
+  if (!header_generator_->output().WriteTo(STDOUT_FILENO) ||
+      write(STDOUT_FILENO, "\n", 1) != 1 ||
+      !generator_->output().WriteTo(STDOUT_FILENO)) {
+    fprintf(stderr, "Error writing to stdout\n");
+  }
 }
 
-void JS2C::WriteToFiles() {
-  std::ofstream ofstream_h;
-  std::ofstream ofstream_c;
-  ofstream_h.open("test.h");
-  ofstream_c.open("test.c");
-
-  ofstream_h << header_generator_->GetOutput();
-  ofstream_c << generator_->GetOutput();
-
-  ofstream_h.close();
-  ofstream_c.close();
+bool JS2C::WriteToFiles() {
+  return WriteToFile(output_base_ + ".h", header_generator_->output()) &&
+         WriteToFile(output_base_ + ".c", generator_->output());
 }
 
-void JS2C::PerformJS2C(i::ParseInfo* parse_info, i::FunctionLiteral* literal) {
-  return;
+bool JS2C::WriteToFile(const std::string& path,
+                       const i::OutputBuffer& output) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "Error opening file: %s\n", path.c_str());
+    return false;
+  }
+  bool written = output.WriteTo(fd);
+  if (close(fd) != 0) written = false;
+  if (!written) fprintf(stderr, "Error writing file: %s\n", path.c_str());
+  return written;
 }
 
-void JS2C::FinishJS2C(i::ParseInfo* parse_info, std::ofstream& ofstream) {
-  return;
+// The C code of a function depends on its own source and, through its
+// captures, on the source of the functions it is nested in. It also depends
+// on the rest of the program: on the names and signatures of all functions,
+// which are in the header, on the script variables, on the interned strings,
+// on the constants propagated into it and on which functions allocate or
+// throw. Those go into every key, so that
+// a change to any of them misses the cache for every function. Unsupported
+// nodes are printed with their source position, so the position goes into
+// the key as well.
+std::vector<i::TranslationCache::Key> JS2C::CacheKeys(
+    Isolate* isolate, Local<String> source,
+    const std::vector<EmissionUnit>& units,
+    const i::ConstantFolding& constant_folding,
+    const i::EscapeAnalysis& escapes, const i::CallGraph& call_graph) {
+  // Bump when a change to the translator changes the code it prints.
+  static const char kTranslatorRevision[] = "js2c 29";
+
+  i::TranslationCache::Key program;
+  program.Add(std::string(kTranslatorRevision));
+  program.Add(std::string(V8::GetVersion()));
+  program.Add(uint64_t{i::FlagList::Hash()});
+  if (i::v8_flags.js2c_feedback != nullptr) {
+    bool exists;
+    program.Add(i::ReadFile(i::v8_flags.js2c_feedback, &exists, false));
+  }
+  program.Add(header_generator_->output());
+  program.Add(generator_->output());
+  program.Add(constant_folding.DescribeConstants());
+  for (const EmissionUnit& unit : units) {
+    if (unit.second != nullptr) continue;
+    program.Add(uint64_t{escapes.MayAllocate(unit.first)} |
+                uint64_t{escapes.MayEscape(unit.first)} << 1 |
+                uint64_t{call_graph.MayThrow(unit.first)} << 2);
+  }
+
+  // A mapped ASCII source is hashed in place. Others are copied out as
+  // UTF-16 once.
+  const char* one_byte = nullptr;
+  std::vector<uint16_t> characters;
+  if (source->IsExternalOneByte()) {
+    one_byte = source->GetExternalOneByteStringResource()->data();
+  } else {
+    characters.resize(source->Length());
+    source->Write(isolate, characters.data(), 0, source->Length(),
+                  String::NO_NULL_TERMINATION);
+  }
+  std::vector<i::TranslationCache::Key> keys;
+  for (const EmissionUnit& unit : units) {
+    i::TranslationCache::Key key = program;
+    i::FunctionLiteral* literal = unit.first;
+    key.Add(uint64_t{literal->is_toplevel()});
+    key.Add(static_cast<uint64_t>(literal->start_position()));
+    if (unit.second != nullptr) {
+      for (int i = 0; i < unit.second->parameter_count(); i++) {
+        key.Add(static_cast<uint64_t>(unit.second->parameter(i)));
+      }
+    }
+    int start = 0;
+    int end = source->Length();
+    if (!literal->is_toplevel()) {
+      i::DeclarationScope* scope = OutermostFunctionScope(literal);
+      start = scope->start_position();
+      end = scope->end_position();
+    }
+    if (one_byte != nullptr) {
+      key.Add(one_byte + start, end - start);
+    } else {
+      key.Add(characters.data() + start, (end - start) * sizeof(uint16_t));
+    }
+    keys.push_back(key);
+  }
+  return keys;
 }
 
-void JS2C::Generate(Local<Context> context,
-                         ScriptCompiler::Source* source) {
-  auto isolate =
-      reinterpret_cast<v8::internal::Isolate*>(context->GetIsolate());
+void JS2C::Generate(Isolate* v8_isolate, ScriptCompiler::Source* source) {
+  i::Isolate* isolate = reinterpret_cast<i::Isolate*>(v8_isolate);
   i::ScriptDetails script_details = GetScriptDetails(
       isolate, source->resource_name, source->resource_line_offset,
       source->resource_column_offset, source->source_map_url,
@@ -195,95 +338,427 @@ void JS2C::Generate(Local<Context> context,
   i::ParseInfo parse_info(isolate, flags, &compile_state, &reusable_state);
   i::Handle<i::Script> script =
       NewScript(isolate, &parse_info, str, script_details, i::NOT_NATIVES_CODE);
-  bool result = i::parsing::ParseProgram(
-      &parse_info, script, isolate, i::parsing::ReportStatisticsMode::kYes);
+  if (!i::parsing::ParseProgram(&parse_info, script, isolate,
+                                i::parsing::ReportStatisticsMode::kYes)) {
+    return;
+  }
+
+  // Folding first lets every analysis see only the code that can run.
+  i::ConstantFolding constant_folding(parse_info.stack_limit(),
+                                      parse_info.ast_value_factory(),
+                                      parse_info.zone());
+  constant_folding.Rewrite(parse_info.literal());
+
+  // Types are inferred for the whole program before anything is emitted so
+  // that every function can be printed with its final signature. Smi
+  // arithmetic that range analysis cannot prove to stay in int32 is done on
+  // doubles, which changes the types it flows into, so both run again until
+  // every Smi operation left is proven. Each round only moves operations to
+  // doubles, so this ends.
+  i::DoubleOperations double_operations;
+  std::unique_ptr<i::TypeInference> inference;
+  std::unique_ptr<i::RangeAnalysis> ranges;
+  int speculated_operation_count = -1;
+  do {
+    inference = std::make_unique<i::TypeInference>(parse_info.stack_limit(),
+                                                   &double_operations);
+    inference->Analyze(parse_info.literal());
+    ranges = std::make_unique<i::RangeAnalysis>(parse_info.stack_limit(),
+                                                inference.get());
+    ranges->Analyze(parse_info.literal());
+    if (speculated_operation_count < 0) {
+      speculated_operation_count = ranges->smi_operation_count();
+    }
+  } while (!inference->HasStackOverflow() && !ranges->HasStackOverflow() &&
+           ranges->AddDoubleOperations(&double_operations));
+  if (i::v8_flags.js2c_range_stats) {
+    fprintf(stderr, "js2c ranges: %d of %d Smi operations kept on int32\n",
+            ranges->proven_operation_count(), speculated_operation_count);
+  }
+  const i::TypeInference& type_inference = *inference;
+
+  i::EscapeAnalysis escape_analysis(parse_info.stack_limit(), &type_inference);
+  escape_analysis.Analyze(parse_info.literal());
+
+  i::CallGraph call_graph(parse_info.stack_limit(), &type_inference);
+  call_graph.Analyze(parse_info.literal());
+
+  i::ClosureConversion closure_conversion(parse_info.stack_limit(),
+                                          &type_inference);
+  closure_conversion.Analyze(parse_info.literal());
+
+  i::InternedStrings interned_strings(parse_info.stack_limit());
+  interned_strings.Analyze(parse_info.literal());
+
+  // Type feedback from a training run of the same script in d8; see
+  // i::DumpTypeFeedback.
+  i::TypeFeedback type_feedback;
+  const i::TypeFeedback* feedback = nullptr;
+  if (i::v8_flags.js2c_feedback != nullptr) {
+    String::Utf8Value script_name(v8_isolate, source->resource_name);
+    if (type_feedback.Load(i::v8_flags.js2c_feedback,
+                           *script_name != nullptr ? *script_name : "")) {
+      feedback = &type_feedback;
+    } else {
+      fprintf(stderr, "Error opening file: %s\n", i::v8_flags.js2c_feedback);
+    }
+  }
 
-  printf("%s\n", result ? "success" : "failure");
+  header_generator_ = new i::CCodeGenerator(
+      parse_info.stack_limit(), &type_inference, &escape_analysis,
+      &call_graph, &closure_conversion, feedback, &interned_strings);
+  generator_ = new i::CCodeGenerator(parse_info.stack_limit(), &type_inference,
+                                     &escape_analysis, &call_graph,
+                                     &closure_conversion, feedback,
+                                     &interned_strings);
+
+  // The C file includes the header next to it.
+  size_t slash = output_base_.find_last_of('/');
+  std::string header_name =
+      (slash == std::string::npos ? output_base_
+                                  : output_base_.substr(slash + 1)) +
+      ".h";
+  header_generator_->PrepareHeaderFile();
+  generator_->PrepareCFile(header_name.c_str());
+  generator_->PrintGlobals(parse_info.literal());
+  generator_->PrintInternedStrings();
+
+  // Every function is emitted once, callees first, so that the C compiler
+  // has seen a definition before the calls it may inline.
+  std::vector<EmissionUnit> units;
+  for (i::FunctionLiteral* literal : call_graph.functions()) {
+    units.push_back({literal, nullptr});
+    for (const i::FunctionTypes* clone :
+         type_inference.SpecializationsOf(literal)) {
+      units.push_back({literal, clone});
+    }
+  }
+  for (const EmissionUnit& unit : units) {
+    header_generator_->PrintFunctionDeclaration(unit.first, unit.second);
+  }
 
-  std::vector<i::FunctionLiteral*> functions_to_compile;
-  functions_to_compile.push_back(parse_info.literal());
+  // With --js2c-cache only the functions that are not in the cache are
+  // printed.
+  std::vector<i::OutputBuffer> outputs(units.size());
+  std::vector<size_t> pending;
+  std::unique_ptr<i::TranslationCache> cache;
+  std::vector<i::TranslationCache::Key> keys;
+  if (i::v8_flags.js2c_cache != nullptr) {
+    cache = std::make_unique<i::TranslationCache>(i::v8_flags.js2c_cache);
+    keys = CacheKeys(v8_isolate, source->source_string, units,
+                     constant_folding, escape_analysis, call_graph);
+    for (size_t index = 0; index < units.size(); index++) {
+      if (!cache->Lookup(keys[index], &outputs[index])) {
+        pending.push_back(index);
+      }
+    }
+  } else {
+    for (size_t index = 0; index < units.size(); index++) {
+      pending.push_back(index);
+    }
+  }
 
-  std::ofstream ofstream_h;
-  std::ofstream ofstream_c;
-  ofstream_h.open("test.h");
-  ofstream_c.open("test.c");
-  ofstream_c << "#include \"test.h\"" << std::endl
-             << "#include <stdio.h>" << std::endl
-             << std::endl;
+  // The calling thread joins the workers.
+  auto job = std::make_unique<PrintFunctionsJob>(
+      units, pending, &outputs, &type_inference, &escape_analysis,
+      &call_graph, &closure_conversion, feedback, &interned_strings);
+  if (i::v8_flags.js2c_parallel) {
+    i::V8::GetCurrentPlatform()
+        ->PostJob(TaskPriority::kUserBlocking, std::move(job))
+        ->Join();
+  } else {
+    job->PrintFunctions(parse_info.stack_limit(), nullptr);
+  }
 
-  while (!functions_to_compile.empty()) {
-    i::FunctionLiteral* literal = functions_to_compile.back();
-    functions_to_compile.pop_back();
+  if (cache) {
+    for (size_t index : pending) cache->Store(keys[index], outputs[index]);
+    fprintf(stderr, "js2c cache: %d hits, %d misses\n", cache->hits(),
+            cache->misses());
+  }
+  for (i::OutputBuffer& output : outputs) {
+    generator_->mutable_output()->Append(&output);
+  }
 
-    // TODO: Give the functions vector to AST visitor
-    PerformJS2C(&parse_info, literal);
+  if (print_ast_) {
+    i::StdoutStream os;
+    os << i::AstPrinter(parse_info.stack_limit())
+              .PrintProgram(parse_info.literal());
+    os << "\n\n";
   }
 
-  return;
+  generator_->FinishCFile();
 }
 
 }  // namespace v8
 
-int main(int argc, char* argv[]) {
-  if (argc < 2) {
-    fprintf(stderr, "Please specify a file to compile.\n");
-    return 1;
-  }
+namespace {
 
-  const char* filename = argv[1];
+// Keeps a mapped source file alive for as long as the external string that
+// the parser reads it through.
+class MappedSourceResource
+    : public v8::String::ExternalOneByteStringResource {
+ public:
+  explicit MappedSourceResource(
+      std::unique_ptr<v8::base::OS::MemoryMappedFile> file)
+      : file_(std::move(file)) {}
+  const char* data() const override {
+    return static_cast<const char*>(file_->memory());
+  }
+  size_t length() const override { return file_->size(); }
+
+ private:
+  std::unique_ptr<v8::base::OS::MemoryMappedFile> file_;
+};
+
+// Maps {path} and wraps it in a string. An ASCII file, which is what
+// generated bundles are, becomes an external string over the mapping, so
+// that the scanner reads it in place and it is never copied. Anything else
+// is decoded from the mapping into a heap string.
+v8::MaybeLocal<v8::String> ReadSource(v8::Isolate* isolate,
+                                      const std::string& path) {
+  std::unique_ptr<v8::base::OS::MemoryMappedFile> file(
+      v8::base::OS::MemoryMappedFile::open(
+          path.c_str(), v8::base::OS::MemoryMappedFile::FileMode::kReadOnly));
+  if (!file) return v8::MaybeLocal<v8::String>();
+  if (file->size() > static_cast<size_t>(v8::String::kMaxLength)) {
+    return v8::MaybeLocal<v8::String>();
+  }
+  int size = static_cast<int>(file->size());
+  const char* chars = static_cast<const char*>(file->memory());
+  if (v8::internal::String::IsAscii(chars, size)) {
+    return v8::String::NewExternalOneByte(
+        isolate, new MappedSourceResource(std::move(file)));
+  }
+  return v8::String::NewFromUtf8(isolate, chars, v8::NewStringType::kNormal,
+                                 size);
+}
 
-  // Initialize V8.
-  v8::V8::InitializeICUDefaultLocation(argv[0]);
-  v8::V8::InitializeExternalStartupData(argv[0]);
-  std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
-  // v8::V8::SetFlagsFromCommandLine(&argc, argv, true);
-  v8::V8::InitializePlatform(platform.get());
-  v8::V8::Initialize();
+// Reads {path} and translates it. Returns false if the file could not be
+// read or parsed or the output could not be written.
+bool TranslateFile(v8::Isolate* isolate, const std::string& path,
+                   const std::string& output_base, bool print) {
+  v8::base::ElapsedTimer timer;
+  if (v8::internal::v8_flags.js2c_startup_stats) timer.Start();
+  v8::HandleScope handle_scope(isolate);
+  v8::Local<v8::String> source_string;
+  if (!ReadSource(isolate, path).ToLocal(&source_string)) {
+    fprintf(stderr, "Error opening file: %s\n", path.c_str());
+    return false;
+  }
+  v8::Local<v8::String> name;
+  if (!v8::String::NewFromUtf8(isolate, path.c_str()).ToLocal(&name)) {
+    fprintf(stderr, "Error opening file: %s\n", path.c_str());
+    return false;
+  }
+  // The name matches the script to its type feedback.
+  v8::ScriptOrigin origin(isolate, name);
+  v8::ScriptCompiler::Source source(source_string, origin);
+
+  v8::JS2C js2c(isolate, &source, output_base, print);
+  if (!js2c.succeeded()) {
+    fprintf(stderr, "Error parsing file: %s\n", path.c_str());
+    return false;
+  }
+  if (print) js2c.WriteToStdout();
+  bool ok = js2c.WriteToFiles();
+  if (v8::internal::v8_flags.js2c_startup_stats) {
+    fprintf(stderr, "js2c startup: %s translated in %.3f ms\n", path.c_str(),
+            timer.Elapsed().InMillisecondsF());
+  }
+  return ok;
+}
 
-  // Create a new Isolate and make it the current one.
-  v8::Isolate::CreateParams create_params;
-  create_params.array_buffer_allocator =
+// Creates an isolate for translating, which needs no context.
+v8::Isolate* NewTranslatorIsolate(v8::Isolate::CreateParams* create_params) {
+  v8::base::ElapsedTimer timer;
+  if (v8::internal::v8_flags.js2c_startup_stats) timer.Start();
+  create_params->array_buffer_allocator =
       v8::ArrayBuffer::Allocator::NewDefaultAllocator();
-  v8::Isolate* isolate = v8::Isolate::New(create_params);
-  {
-    v8::Isolate::Scope isolate_scope(isolate);
+  v8::Isolate* isolate = v8::Isolate::New(*create_params);
+  if (v8::internal::v8_flags.js2c_startup_stats) {
+    fprintf(stderr, "js2c startup: isolate created in %.3f ms\n",
+            timer.Elapsed().InMillisecondsF());
+  }
+  return isolate;
+}
+
+// <input>.js is written to <input>.h and <input>.c.
+std::string DefaultOutputBase(const std::string& path) {
+  size_t dot = path.find_last_of('.');
+  size_t slash = path.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return path;
+  }
+  return path.substr(0, dot);
+}
 
-    // Create a stack-allocated handle scope.
-    v8::HandleScope handle_scope(isolate);
+struct TranslationRequest {
+  std::string path;
+  std::string output_base;
+};
+
+// The files that are waiting for a translator thread. Pop blocks until there
+// is a request or the queue is closed.
+class RequestQueue {
+ public:
+  void Push(TranslationRequest request) {
+    v8::base::MutexGuard guard(&mutex_);
+    requests_.push_back(std::move(request));
+    available_.NotifyOne();
+  }
 
-    // Create a new context.
-    v8::Local<v8::Context> context = v8::Context::New(isolate);
+  void Close() {
+    v8::base::MutexGuard guard(&mutex_);
+    closed_ = true;
+    available_.NotifyAll();
+  }
 
-    // Enter the context for compiling and running the hello world script.
-    v8::Context::Scope context_scope(context);
+  bool Pop(TranslationRequest* request) {
+    v8::base::MutexGuard guard(&mutex_);
+    while (requests_.empty() && !closed_) available_.Wait(&mutex_);
+    if (requests_.empty()) return false;
+    *request = std::move(requests_.front());
+    requests_.pop_front();
+    return true;
+  }
 
+ private:
+  v8::base::Mutex mutex_;
+  v8::base::ConditionVariable available_;
+  std::deque<TranslationRequest> requests_;
+  bool closed_ = false;
+};
+
+// Translates requests from a queue with an isolate of its own, so that its
+// startup cost is paid once per thread instead of once per file. In server
+// mode every request is answered on stdout.
+class TranslatorThread : public v8::base::Thread {
+ public:
+  TranslatorThread(RequestQueue* queue, v8::base::Mutex* reply_mutex,
+                   bool reply)
+      : v8::base::Thread(v8::base::Thread::Options("JS2CTranslator")),
+        queue_(queue),
+        reply_mutex_(reply_mutex),
+        reply_(reply) {}
+
+  void Run() override {
+    v8::Isolate::CreateParams create_params;
+    v8::Isolate* isolate = NewTranslatorIsolate(&create_params);
     {
-      // printf("%s\n", filename);
-      std::ifstream ifstream;
-      ifstream.open(filename);
-      if (ifstream.fail()) {
-        fprintf(stderr, "Error opening file: %s\n", filename);
-        exit(1);
+      v8::Isolate::Scope isolate_scope(isolate);
+      TranslationRequest request;
+      while (queue_->Pop(&request)) {
+        bool ok =
+            TranslateFile(isolate, request.path, request.output_base, false);
+        if (!ok) failed_ = true;
+        if (reply_) {
+          v8::base::MutexGuard guard(reply_mutex_);
+          printf("%s %s\n", ok ? "ok" : "error", request.path.c_str());
+          fflush(stdout);
+        }
       }
-      std::string cpp_code;
-      std::ostringstream ss;
-      ss << ifstream.rdbuf();
-      cpp_code = ss.str();
-
-      // Create a string containing the JavaScript source code.
-      v8::Local<v8::String> source_string =
-          v8::String::NewFromUtf8(isolate, cpp_code.c_str()).ToLocalChecked();
-      v8::ScriptCompiler::Source source(source_string);
-
-      v8::JS2C js2c(context, &source);
-      js2c.WriteToStdout();
-      js2c.WriteToFiles();
     }
+    isolate->Dispose();
+    delete create_params.array_buffer_allocator;
   }
-  // Dispose the isolate and tear down V8.
-  isolate->Dispose();
+
+  bool failed() const { return failed_; }
+
+ private:
+  RequestQueue* queue_;
+  v8::base::Mutex* reply_mutex_;
+  bool reply_;
+  bool failed_ = false;
+};
+
+// Translates the files of {queue} on --js2c-jobs threads until it is closed
+// and drained. {fill} runs on the calling thread while they work. Returns
+// false if any file failed.
+template <typename Fill>
+bool TranslateQueued(RequestQueue* queue, bool reply, Fill fill) {
+  v8::base::Mutex reply_mutex;
+  std::vector<std::unique_ptr<TranslatorThread>> threads;
+  for (int i = 0; i < std::max(1, v8::internal::v8_flags.js2c_jobs.value());
+       i++) {
+    threads.push_back(
+        std::make_unique<TranslatorThread>(queue, &reply_mutex, reply));
+    CHECK(threads.back()->Start());
+  }
+  fill();
+  queue->Close();
+  bool ok = true;
+  for (auto& thread : threads) {
+    thread->Join();
+    if (thread->failed()) ok = false;
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // Initialize V8. The V8 flags, such as --js2c-feedback, are removed from
+  // the command line.
+  v8::V8::InitializeICUDefaultLocation(argv[0]);
+  v8::V8::InitializeExternalStartupData(argv[0]);
+  std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
+  v8::V8::SetFlagsFromCommandLine(&argc, argv, true);
+  bool batch = v8::internal::v8_flags.js2c_batch;
+  bool server = v8::internal::v8_flags.js2c_server;
+  if (argc < 2 && !server) {
+    fprintf(stderr, "Please specify a file to compile.\n");
+    return 1;
+  }
+
+  v8::base::ElapsedTimer timer;
+  if (v8::internal::v8_flags.js2c_startup_stats) timer.Start();
+  v8::V8::InitializePlatform(platform.get());
+  v8::V8::Initialize();
+  if (v8::internal::v8_flags.js2c_startup_stats) {
+    fprintf(stderr, "js2c startup: V8 initialized in %.3f ms\n",
+            timer.Elapsed().InMillisecondsF());
+  }
+
+  bool ok;
+  RequestQueue queue;
+  if (server) {
+    // One request per line: the input and, optionally, the output base.
+    ok = TranslateQueued(&queue, true, [&queue]() {
+      char* buffer = nullptr;
+      size_t capacity = 0;
+      ssize_t length;
+      while ((length = getline(&buffer, &capacity, stdin)) >= 0) {
+        std::istringstream fields(std::string(buffer, length));
+        TranslationRequest request;
+        if (!(fields >> request.path)) continue;
+        if (!(fields >> request.output_base)) {
+          request.output_base = DefaultOutputBase(request.path);
+        }
+        queue.Push(std::move(request));
+      }
+      free(buffer);
+    });
+  } else if (batch) {
+    ok = TranslateQueued(&queue, false, [&queue, argc, argv]() {
+      for (int i = 1; i < argc; i++) {
+        queue.Push({argv[i], DefaultOutputBase(argv[i])});
+      }
+    });
+  } else {
+    // Create a new Isolate and make it the current one.
+    v8::Isolate::CreateParams create_params;
+    v8::Isolate* isolate = NewTranslatorIsolate(&create_params);
+    {
+      v8::Isolate::Scope isolate_scope(isolate);
+      ok = TranslateFile(isolate, argv[1], "test", true);
+    }
+    isolate->Dispose();
+    delete create_params.array_buffer_allocator;
+  }
+
+  // Tear down V8.
   v8::V8::Dispose();
   v8::V8::DisposePlatform();
-  delete create_params.array_buffer_allocator;
-  return 0;
+  return ok ? 0 : 1;
 }
@@ -1,8 +1,12 @@
 #ifndef V8_JS2C_H_
 #define V8_JS2C_H_
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "include/libplatform/libplatform.h"
-#include "include/v8-context.h"
+#include "include/v8-isolate.h"
 #include "include/v8-initialization.h"
 #include "include/v8-isolate.h"
 #include "include/v8-local-handle.h"
@@ -15,23 +19,44 @@
 #include "src/execution/isolate.h"
 #include "src/flags/flags.h"
 #include "src/js2c/c-code-generator.h"
+#include "src/js2c/constant-folding.h"
+#include "src/js2c/translation-cache.h"
 
 namespace v8 {
 
 class JS2C {
  public:
-  explicit JS2C(Local<Context> context, ScriptCompiler::Source* source);
+  // Translates {source}. WriteToFiles writes the result to <output_base>.h
+  // and <output_base>.c. With {print_ast} the AST is printed to stdout.
+  //
+  // Only the parser runs on {isolate}, so it needs no context: the isolate
+  // provides the AST string constants and the Script the parser reads from.
+  JS2C(Isolate* isolate, ScriptCompiler::Source* source,
+       const std::string& output_base = "test", bool print_ast = true);
   ~JS2C();
 
-  void Generate(Local<Context> context, ScriptCompiler::Source* source);
+  void Generate(Isolate* isolate, ScriptCompiler::Source* source);
+
+  // False if the source did not parse, in which case there is no output.
+  bool succeeded() const { return generator_ != nullptr; }
 
   void WriteToStdout();
-  void WriteToFiles();
+  // Returns false on an I/O error.
+  bool WriteToFiles();
 
  private:
-  void PerformJS2C(i::ParseInfo* parse_info, i::FunctionLiteral* literal);
-  void FinishJS2C(i::ParseInfo* parse_info, std::ofstream& ofstream);
+  // Digests of everything the C code of each of {units} depends on; see
+  // i::TranslationCache.
+  std::vector<i::TranslationCache::Key> CacheKeys(
+      Isolate* isolate, Local<String> source,
+      const std::vector<std::pair<i::FunctionLiteral*,
+                                  const i::FunctionTypes*>>& units,
+      const i::ConstantFolding& constant_folding,
+      const i::EscapeAnalysis& escapes, const i::CallGraph& call_graph);
+  bool WriteToFile(const std::string& path, const i::OutputBuffer& output);
 
+  std::string output_base_;
+  bool print_ast_;
   i::CCodeGenerator* header_generator_;
   i::CCodeGenerator* generator_;
 };
@@ -0,0 +1,126 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/output-buffer.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "src/base/build_config.h"
+#include "src/base/logging.h"
+
+#if V8_OS_POSIX
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#elif V8_OS_WIN
+#include <io.h>
+#endif
+
+namespace v8 {
+namespace internal {
+
+void OutputBuffer::VPrintF(const char* format, va_list arguments) {
+  Chunk* chunk = chunks_.empty() ? nullptr : &chunks_.back();
+  size_t available = chunk == nullptr ? 0 : chunk->capacity - chunk->length;
+  va_list copy;
+  va_copy(copy, arguments);
+  char* tail = chunk == nullptr ? nullptr : chunk->data.get() + chunk->length;
+  int n = vsnprintf(tail, available, format, copy);
+  va_end(copy);
+  CHECK_GE(n, 0);
+  size_t length = static_cast<size_t>(n);
+
+  // What did not fit in the last chunk is printed again into a new one. The
+  // rest of the last chunk stays unused.
+  if (length >= available) {
+    chunk = NewChunk(length + 1);
+    vsnprintf(chunk->data.get(), chunk->capacity, format, arguments);
+  }
+  chunk->length += length;
+  size_ += length;
+}
+
+void OutputBuffer::Append(const char* data, size_t length) {
+  while (length > 0) {
+    if (chunks_.empty() || chunks_.back().length == chunks_.back().capacity) {
+      NewChunk(length);
+    }
+    Chunk& chunk = chunks_.back();
+    size_t count = std::min(length, chunk.capacity - chunk.length);
+    memcpy(chunk.data.get() + chunk.length, data, count);
+    chunk.length += count;
+    size_ += count;
+    data += count;
+    length -= count;
+  }
+}
+
+OutputBuffer::Chunk* OutputBuffer::NewChunk(size_t length) {
+  size_t capacity = std::max(
+      std::min(std::max(kMinChunkSize, size_), kMaxChunkSize), length);
+  chunks_.push_back({std::unique_ptr<char[]>(new char[capacity]), capacity, 0});
+  return &chunks_.back();
+}
+
+void OutputBuffer::Append(OutputBuffer* other) {
+  for (Chunk& chunk : other->chunks_) chunks_.push_back(std::move(chunk));
+  size_ += other->size_;
+  other->chunks_.clear();
+  other->size_ = 0;
+}
+
+void OutputBuffer::Clear() {
+  if (chunks_.size() > 1) chunks_.resize(1);
+  if (!chunks_.empty()) chunks_[0].length = 0;
+  size_ = 0;
+}
+
+bool OutputBuffer::WriteTo(int fd) const {
+#if V8_OS_POSIX
+  std::vector<struct iovec> vectors;
+  for (const Chunk& chunk : chunks_) {
+    if (chunk.length > 0) vectors.push_back({chunk.data.get(), chunk.length});
+  }
+  size_t index = 0;
+  while (index < vectors.size()) {
+    int count = static_cast<int>(std::min<size_t>(vectors.size() - index,
+                                                  IOV_MAX));
+    ssize_t written = writev(fd, &vectors[index], count);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    // Skip what was written, which may end in the middle of a chunk.
+    size_t remaining = static_cast<size_t>(written);
+    while (index < vectors.size() && remaining >= vectors[index].iov_len) {
+      remaining -= vectors[index].iov_len;
+      index++;
+    }
+    if (remaining > 0) {
+      vectors[index].iov_base =
+          static_cast<char*>(vectors[index].iov_base) + remaining;
+      vectors[index].iov_len -= remaining;
+    }
+  }
+  return true;
+#else
+  for (const Chunk& chunk : chunks_) {
+    size_t offset = 0;
+    while (offset < chunk.length) {
+      int written = _write(fd, chunk.data.get() + offset,
+                           static_cast<unsigned>(chunk.length - offset));
+      if (written < 0) return false;
+      offset += static_cast<size_t>(written);
+    }
+  }
+  return true;
+#endif
+}
+
+}  // namespace internal
+}  // namespace v8
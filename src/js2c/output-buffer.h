@@ -0,0 +1,74 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_OUTPUT_BUFFER_H_
+#define V8_JS2C_OUTPUT_BUFFER_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+namespace v8 {
+namespace internal {
+
+// The text a CCodeGenerator prints. It is kept in a list of chunks, so that
+// appending never moves what is already written and printing a large bundle
+// takes time and memory linear in its size. The chunks go straight to a file
+// descriptor with writev.
+class OutputBuffer final {
+ public:
+  OutputBuffer() = default;
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  void VPrintF(const char* format, va_list arguments);
+  void Append(const char* data, size_t length);
+  // Moves the chunks of {other} to the end of this buffer and leaves
+  // {other} empty.
+  void Append(OutputBuffer* other);
+  // Drops the text but keeps the first chunk for reuse.
+  void Clear();
+
+  // Writes the text to {fd}. Returns false on an I/O error.
+  bool WriteTo(int fd) const;
+
+  // The number of bytes printed since the last Clear, and the number of
+  // chunks they take.
+  size_t size() const { return size_; }
+  size_t chunk_count() const { return chunks_.size(); }
+
+  // Calls {callback} with the data and length of every chunk, in order.
+  template <typename Callback>
+  void ForEachChunk(Callback callback) const {
+    for (const Chunk& chunk : chunks_) {
+      callback(static_cast<const char*>(chunk.data.get()), chunk.length);
+    }
+  }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t capacity;
+    size_t length;
+  };
+
+  // Chunks start small, since there is a buffer per function while they are
+  // printed in parallel, and double up to kMaxChunkSize. A single Print that
+  // needs more gets a chunk of its own.
+  static constexpr size_t kMinChunkSize = 1024;
+  static constexpr size_t kMaxChunkSize = 64 * 1024;
+
+  // Adds a chunk with room for at least {length} bytes.
+  Chunk* NewChunk(size_t length);
+
+  std::vector<Chunk> chunks_;
+  size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_OUTPUT_BUFFER_H_
@@ -0,0 +1,845 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/range-analysis.h"
+
+#include <algorithm>
+
+#include "src/common/globals.h"
+#include "src/parsing/token.h"
+
+namespace v8 {
+namespace internal {
+
+namespace {
+
+constexpr Int32Range kAnyInt32 = {kMinInt, kMaxInt};
+
+bool IsInt32(Int32Range range) {
+  return range.min >= kMinInt && range.max <= kMaxInt;
+}
+
+bool ContainsZero(Int32Range range) {
+  return range.min <= 0 && range.max >= 0;
+}
+
+Int32Range JoinRanges(Int32Range a, Int32Range b) {
+  return {std::min(a.min, b.min), std::max(a.max, b.max)};
+}
+
+bool SameRange(Int32Range a, Int32Range b) {
+  return a.min == b.min && a.max == b.max;
+}
+
+// Variables that are missing from an environment can hold any int32.
+Int32Range Lookup(const std::unordered_map<Variable*, Int32Range>& ranges,
+                  Variable* var) {
+  auto it = ranges.find(var);
+  return it == ranges.end() ? kAnyInt32 : it->second;
+}
+
+// The smallest 2^n - 1 that is at least {value}, which bounds the bitwise
+// or and xor of non-negative values up to {value}.
+int64_t AllOnesAtLeast(int64_t value) {
+  int64_t mask = 0;
+  while (mask < value) mask = mask * 2 + 1;
+  return mask;
+}
+
+// The comparison that holds when {op} does not, for operands that are not
+// NaN.
+Token::Value NegateComparison(Token::Value op) {
+  switch (op) {
+    case Token::LT:
+      return Token::GTE;
+    case Token::GTE:
+      return Token::LT;
+    case Token::GT:
+      return Token::LTE;
+    case Token::LTE:
+      return Token::GT;
+    case Token::EQ:
+      return Token::NE;
+    case Token::NE:
+      return Token::EQ;
+    case Token::EQ_STRICT:
+      return Token::NE_STRICT;
+    case Token::NE_STRICT:
+      return Token::EQ_STRICT;
+    default:
+      return Token::ILLEGAL;
+  }
+}
+
+bool IsLogicalOp(Token::Value op) {
+  return op == Token::OR || op == Token::AND || op == Token::NULLISH;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+void RangeAnalysis::Environment::Join(const Environment& other) {
+  if (!other.reachable) return;
+  if (!reachable) {
+    *this = other;
+    return;
+  }
+  for (auto it = ranges.begin(); it != ranges.end();) {
+    auto other_it = other.ranges.find(it->first);
+    if (other_it == other.ranges.end()) {
+      it = ranges.erase(it);
+      continue;
+    }
+    it->second = JoinRanges(it->second, other_it->second);
+    ++it;
+  }
+}
+
+void RangeAnalysis::Environment::Widen(const Environment& previous) {
+  if (!reachable || !previous.reachable) return;
+  for (auto it = ranges.begin(); it != ranges.end();) {
+    auto previous_it = previous.ranges.find(it->first);
+    if (previous_it == previous.ranges.end()) {
+      it = ranges.erase(it);
+      continue;
+    }
+    Int32Range& range = it->second;
+    const Int32Range& old = previous_it->second;
+    range.min = range.min < old.min ? kMinInt : old.min;
+    range.max = range.max > old.max ? kMaxInt : old.max;
+    ++it;
+  }
+}
+
+bool RangeAnalysis::Environment::operator==(const Environment& other) const {
+  if (reachable != other.reachable) return false;
+  for (auto& entry : ranges) {
+    if (!SameRange(entry.second, Lookup(other.ranges, entry.first))) {
+      return false;
+    }
+  }
+  for (auto& entry : other.ranges) {
+    if (!SameRange(entry.second, Lookup(ranges, entry.first))) return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+RangeAnalysis::RangeAnalysis(uintptr_t stack_limit, const TypeInference* types)
+    : AstTraversalVisitor<RangeAnalysis>(stack_limit), types_(types) {}
+
+void RangeAnalysis::Analyze(FunctionLiteral* program) {
+  Enqueue(program);
+  while (!worklist_.empty()) {
+    FunctionLiteral* literal = worklist_.back();
+    worklist_.pop_back();
+    // Functions the inference never reached are printed without types, so
+    // they have no Smi arithmetic.
+    const FunctionTypes* generic = types_->TypesFor(literal);
+    if (generic == nullptr) continue;
+    AnalyzeFunction(generic);
+    for (const FunctionTypes* clone : types_->SpecializationsOf(literal)) {
+      AnalyzeFunction(clone);
+    }
+    if (HasStackOverflow()) return;
+  }
+  CountSites();
+}
+
+bool RangeAnalysis::AddDoubleOperations(DoubleOperations* operations) const {
+  bool added = false;
+  for (auto& entry : sites_) {
+    for (auto& site : entry.second) {
+      for (size_t index = 0; index < site.second.size(); index++) {
+        if (site.second[index] == Site::kUnproven) {
+          added |= operations->Add(site.first, index);
+        }
+      }
+    }
+  }
+  return added;
+}
+
+void RangeAnalysis::Enqueue(FunctionLiteral* literal) {
+  if (enqueued_.insert(literal).second) worklist_.push_back(literal);
+}
+
+void RangeAnalysis::AnalyzeFunction(const FunctionTypes* types) {
+  FunctionLiteral* literal = types->literal();
+  current_ = types;
+  current_sites_ = &sites_[types];
+  // Parameters can be any int32, which is what a missing variable holds.
+  env_ = Environment();
+  env_.reachable = true;
+  storage_.clear();
+  break_envs_.clear();
+  continue_envs_.clear();
+
+  VisitDeclarations(literal->scope()->declarations());
+  VisitStatements(literal->body());
+  current_ = nullptr;
+  current_sites_ = nullptr;
+}
+
+void RangeAnalysis::CountSites() {
+  for (auto& entry : sites_) {
+    for (auto& site : entry.second) {
+      for (Site state : site.second) {
+        if (state == Site::kUnreached) continue;
+        smi_operation_count_++;
+        if (state == Site::kProven) proven_operation_count_++;
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+Int32Range RangeAnalysis::RangeOf(Expression* expr) {
+  result_expr_ = nullptr;
+  Visit(expr);
+  switch (current_->TypeOf(expr)) {
+    case InferredType::kSmi:
+      return result_expr_ == expr ? result_ : kAnyInt32;
+    case InferredType::kBoolean:
+      return {0, 1};
+    default:
+      // Anything else is converted to int32 by a bitwise operator, if at
+      // all.
+      return kAnyInt32;
+  }
+}
+
+void RangeAnalysis::Record(Expression* expr, Int32Range range) {
+  result_expr_ = expr;
+  result_ = range;
+}
+
+// Records whether the Smi operation at {index} of {operation} stays in
+// int32, given {exact}, the range of its mathematical result, and whether
+// it can be -0. An operation in a loop is visited once per round, and is
+// unproven if it leaves int32 in any of them. An unproven operation can
+// produce a double, which ends the Smi.
+Int32Range RangeAnalysis::SmiOperationRange(Expression* operation,
+                                            size_t index, Int32Range exact,
+                                            bool minus_zero) {
+  std::vector<Site>& sites = (*current_sites_)[operation];
+  if (sites.size() <= index) sites.resize(index + 1, Site::kUnreached);
+  bool proven = IsInt32(exact) && !minus_zero;
+  sites[index] = std::max(sites[index],
+                          proven ? Site::kProven : Site::kUnproven);
+  return proven ? exact : kAnyInt32;
+}
+
+// The range of {left} {op} {right} when it produces a value of {type}. Only
+// Smi results have a range.
+Int32Range RangeAnalysis::BinaryOperationRange(Expression* operation,
+                                               size_t index, Token::Value op,
+                                               InferredType type,
+                                               Int32Range left,
+                                               Int32Range right) {
+  if (type != InferredType::kSmi) return kAnyInt32;
+  switch (op) {
+    case Token::ADD:
+      return SmiOperationRange(operation, index,
+                               {left.min + right.min, left.max + right.max});
+    case Token::SUB:
+      return SmiOperationRange(operation, index,
+                               {left.min - right.max, left.max - right.min});
+    case Token::MUL: {
+      int64_t products[] = {left.min * right.min, left.min * right.max,
+                            left.max * right.min, left.max * right.max};
+      // 0 times a negative number is -0.
+      bool minus_zero = (ContainsZero(left) && right.min < 0) ||
+                        (ContainsZero(right) && left.min < 0);
+      return SmiOperationRange(
+          operation, index,
+          {*std::min_element(std::begin(products), std::end(products)),
+           *std::max_element(std::begin(products), std::end(products))},
+          minus_zero);
+    }
+    case Token::MOD: {
+      // Only a Smi for a positive constant divisor. The result has the sign
+      // of the dividend, so a negative one can give -0, and is smaller than
+      // the divisor.
+      int64_t bound = right.max - 1;
+      return SmiOperationRange(operation, index,
+                               {0, std::min(left.max, bound)},
+                               left.min < 0);
+    }
+    case Token::BIT_AND:
+      if (left.min >= 0 && right.min >= 0) {
+        return {0, std::min(left.max, right.max)};
+      }
+      if (left.min >= 0) return {0, left.max};
+      if (right.min >= 0) return {0, right.max};
+      return kAnyInt32;
+    case Token::BIT_OR:
+    case Token::BIT_XOR:
+      if (left.min >= 0 && right.min >= 0) {
+        return {0, AllOnesAtLeast(std::max(left.max, right.max))};
+      }
+      return kAnyInt32;
+    case Token::SAR:
+      if (right.min == right.max) {
+        int shift = static_cast<int>(right.min & 31);
+        return {left.min >> shift, left.max >> shift};
+      }
+      // Shifting moves a value towards 0 or -1.
+      return {std::min<int64_t>(left.min, 0), std::max<int64_t>(left.max, 0)};
+    default:
+      return kAnyInt32;
+  }
+}
+
+bool RangeAnalysis::IsTrackedInEnvironment(Variable* var) const {
+  return var != nullptr && var->IsStackAllocated() &&
+         var->scope()->GetClosureScope() == current_->literal()->scope();
+}
+
+// {target} is the target of an assignment whose reference has been
+// evaluated. Property stores change no variable.
+void RangeAnalysis::AssignTarget(Expression* target, Int32Range range) {
+  VariableProxy* proxy = target->AsVariableProxy();
+  if (proxy != nullptr) {
+    if (proxy->is_resolved()) AssignVariable(proxy->var(), range);
+    return;
+  }
+  if (target->IsPattern()) {
+    Visit(target);
+    AssignPatternTargets(target);
+  }
+}
+
+// The variables a destructuring pattern assigns get values out of an object
+// or an array, which can be anything.
+void RangeAnalysis::AssignPatternTargets(Expression* pattern) {
+  if (pattern->IsVariableProxy()) {
+    AssignTarget(pattern, kAnyInt32);
+  } else if (pattern->IsAssignment()) {
+    // A target with a default value.
+    AssignPatternTargets(pattern->AsAssignment()->target());
+  } else if (pattern->IsSpread()) {
+    AssignPatternTargets(pattern->AsSpread()->expression());
+  } else if (pattern->IsObjectLiteral()) {
+    for (ObjectLiteral::Property* property :
+         *pattern->AsObjectLiteral()->properties()) {
+      AssignPatternTargets(property->value());
+    }
+  } else if (pattern->IsArrayLiteral()) {
+    for (Expression* value : *pattern->AsArrayLiteral()->values()) {
+      AssignPatternTargets(value);
+    }
+  }
+}
+
+void RangeAnalysis::AssignVariable(Variable* var, Int32Range range) {
+  if (!IsTrackedInEnvironment(var)) return;
+  if (assigned_ != nullptr) assigned_->insert(var);
+  env_.ranges[var] = range;
+  auto it = storage_.find(var);
+  if (it == storage_.end()) {
+    storage_[var] = range;
+  } else {
+    it->second = JoinRanges(it->second, range);
+  }
+}
+
+Int32Range RangeAnalysis::LookupVariable(Variable* var) const {
+  if (!env_.reachable || !IsTrackedInEnvironment(var)) return kAnyInt32;
+  return Lookup(env_.ranges, var);
+}
+
+void RangeAnalysis::WidenToStorageRanges(Environment* env) {
+  // Any assignment inside a protected region may be the last one before an
+  // exception, so the handler has to assume every range assigned so far.
+  for (auto& entry : storage_) {
+    auto it = env->ranges.find(entry.first);
+    if (it != env->ranges.end()) {
+      it->second = JoinRanges(it->second, entry.second);
+    }
+  }
+}
+
+void RangeAnalysis::Branch(Expression* condition, Environment* if_false) {
+  RangeOf(condition);
+  if (!IsPureCondition(condition)) {
+    *if_false = env_;
+    return;
+  }
+  Environment if_true = env_;
+  Refine(condition, false);
+  *if_false = std::move(env_);
+  env_ = std::move(if_true);
+  Refine(condition, true);
+}
+
+// Conditions that assign nothing, so that what they test still holds once
+// they have been evaluated.
+bool RangeAnalysis::IsPureCondition(Expression* expr) const {
+  if (expr->IsLiteral() || expr->IsVariableProxy()) return true;
+  Property* property = expr->AsProperty();
+  if (property != nullptr) {
+    // The length of a string, the only Smi property.
+    return current_->TypeOf(expr) == InferredType::kSmi &&
+           IsPureCondition(property->obj());
+  }
+  UnaryOperation* unary = expr->AsUnaryOperation();
+  if (unary != nullptr) {
+    return unary->op() == Token::NOT && IsPureCondition(unary->expression());
+  }
+  CompareOperation* compare = expr->AsCompareOperation();
+  if (compare != nullptr) {
+    return IsPureCondition(compare->left()) &&
+           IsPureCondition(compare->right());
+  }
+  BinaryOperation* binary = expr->AsBinaryOperation();
+  if (binary != nullptr) {
+    return (binary->op() == Token::AND || binary->op() == Token::OR) &&
+           IsPureCondition(binary->left()) && IsPureCondition(binary->right());
+  }
+  NaryOperation* nary = expr->AsNaryOperation();
+  if (nary != nullptr) {
+    if (nary->op() != Token::AND && nary->op() != Token::OR) return false;
+    if (!IsPureCondition(nary->first())) return false;
+    for (size_t i = 0; i < nary->subsequent_length(); ++i) {
+      if (!IsPureCondition(nary->subsequent(i))) return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Narrows env_ to the states in which the pure {condition} is {value}.
+void RangeAnalysis::Refine(Expression* condition, bool value) {
+  if (!env_.reachable) return;
+  UnaryOperation* unary = condition->AsUnaryOperation();
+  if (unary != nullptr) {
+    Refine(unary->expression(), !value);
+    return;
+  }
+  // Every operand of a && b is true when it is, and every operand of a || b
+  // false when it is.
+  Token::Value all_operands = value ? Token::AND : Token::OR;
+  BinaryOperation* binary = condition->AsBinaryOperation();
+  if (binary != nullptr) {
+    if (binary->op() != all_operands) return;
+    Refine(binary->left(), value);
+    Refine(binary->right(), value);
+    return;
+  }
+  NaryOperation* nary = condition->AsNaryOperation();
+  if (nary != nullptr) {
+    if (nary->op() != all_operands) return;
+    Refine(nary->first(), value);
+    for (size_t i = 0; i < nary->subsequent_length(); ++i) {
+      Refine(nary->subsequent(i), value);
+    }
+    return;
+  }
+  CompareOperation* compare = condition->AsCompareOperation();
+  if (compare != nullptr) RefineComparison(compare, value);
+}
+
+void RangeAnalysis::RefineComparison(CompareOperation* node, bool value) {
+  Expression* left = node->left();
+  Expression* right = node->right();
+  if (current_->TypeOf(left) != InferredType::kSmi ||
+      current_->TypeOf(right) != InferredType::kSmi) {
+    return;
+  }
+  Token::Value op = value ? node->op() : NegateComparison(node->op());
+  Int32Range left_range = RangeOf(left);
+  Int32Range right_range = RangeOf(right);
+  Int32Range new_left = left_range;
+  Int32Range new_right = right_range;
+  switch (op) {
+    case Token::LT:
+      new_left.max = std::min(left_range.max, right_range.max - 1);
+      new_right.min = std::max(right_range.min, left_range.min + 1);
+      break;
+    case Token::LTE:
+      new_left.max = std::min(left_range.max, right_range.max);
+      new_right.min = std::max(right_range.min, left_range.min);
+      break;
+    case Token::GT:
+      new_left.min = std::max(left_range.min, right_range.min + 1);
+      new_right.max = std::min(right_range.max, left_range.max - 1);
+      break;
+    case Token::GTE:
+      new_left.min = std::max(left_range.min, right_range.min);
+      new_right.max = std::min(right_range.max, left_range.max);
+      break;
+    case Token::EQ:
+    case Token::EQ_STRICT:
+      new_left = {std::max(left_range.min, right_range.min),
+                  std::min(left_range.max, right_range.max)};
+      new_right = new_left;
+      break;
+    default:
+      return;
+  }
+  RefineOperand(left, new_left);
+  RefineOperand(right, new_right);
+}
+
+void RangeAnalysis::RefineOperand(Expression* operand, Int32Range range) {
+  if (range.min > range.max) {
+    // The comparison cannot come out this way.
+    env_.reachable = false;
+    return;
+  }
+  VariableProxy* proxy = operand->AsVariableProxy();
+  if (proxy == nullptr || !proxy->is_resolved() ||
+      !IsTrackedInEnvironment(proxy->var())) {
+    return;
+  }
+  env_.ranges[proxy->var()] = range;
+}
+
+template <typename Body>
+void RangeAnalysis::AnalyzeLoop(IterationStatement* loop, Body body) {
+  Environment entry = env_;
+  Environment header = entry;
+  for (int round = 0;; round++) {
+    env_ = header;
+    break_envs_.erase(loop);
+    continue_envs_.erase(loop);
+    body();
+    if (HasStackOverflow()) return;
+    env_.Join(continue_envs_[loop]);
+    Environment next = entry;
+    next.Join(env_);
+    if (round >= kWideningDelay) next.Widen(header);
+    if (next == header) break;
+    header = next;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void RangeAnalysis::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  Enqueue(node->fun());
+}
+
+void RangeAnalysis::VisitBlock(Block* node) {
+  if (node->scope() != nullptr) {
+    VisitDeclarations(node->scope()->declarations());
+  }
+  VisitStatements(node->statements());
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitIfStatement(IfStatement* node) {
+  Environment if_false;
+  Branch(node->condition(), &if_false);
+  Visit(node->then_statement());
+  Environment after_then = env_;
+  env_ = if_false;
+  Visit(node->else_statement());
+  env_.Join(after_then);
+}
+
+void RangeAnalysis::VisitContinueStatement(ContinueStatement* node) {
+  continue_envs_[node->target()].Join(env_);
+  env_.reachable = false;
+}
+
+void RangeAnalysis::VisitBreakStatement(BreakStatement* node) {
+  break_envs_[node->target()].Join(env_);
+  env_.reachable = false;
+}
+
+void RangeAnalysis::VisitReturnStatement(ReturnStatement* node) {
+  RangeOf(node->expression());
+  env_.reachable = false;
+}
+
+void RangeAnalysis::VisitDoWhileStatement(DoWhileStatement* node) {
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    Visit(node->body());
+    env_.Join(continue_envs_[node]);
+    continue_envs_.erase(node);
+    Branch(node->cond(), &exit);
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitWhileStatement(WhileStatement* node) {
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    Branch(node->cond(), &exit);
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitForStatement(ForStatement* node) {
+  if (node->init() != nullptr) Visit(node->init());
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    if (node->cond() != nullptr) Branch(node->cond(), &exit);
+    Visit(node->body());
+    env_.Join(continue_envs_[node]);
+    continue_envs_.erase(node);
+    if (node->next() != nullptr) Visit(node->next());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+// The keys and values these loops assign are never Smis whose range is
+// known.
+void RangeAnalysis::VisitForInStatement(ForInStatement* node) {
+  RangeOf(node->subject());
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    exit = env_;
+    if (node->each()->IsProperty()) Visit(node->each());
+    AssignTarget(node->each(), kAnyInt32);
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitForOfStatement(ForOfStatement* node) {
+  RangeOf(node->subject());
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    exit = env_;
+    if (node->each()->IsProperty()) Visit(node->each());
+    AssignTarget(node->each(), kAnyInt32);
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitSwitchStatement(SwitchStatement* node) {
+  RangeOf(node->tag());
+  Environment labels = env_;
+  Environment fallthrough;
+  bool has_default = false;
+  for (CaseClause* clause : *node->cases()) {
+    env_ = labels;
+    if (clause->is_default()) {
+      has_default = true;
+    } else {
+      RangeOf(clause->label());
+      labels = env_;
+    }
+    env_.Join(fallthrough);
+    VisitStatements(clause->statements());
+    fallthrough = env_;
+  }
+  env_ = fallthrough;
+  if (!has_default) env_.Join(labels);
+  env_.Join(break_envs_[node]);
+}
+
+void RangeAnalysis::VisitTryCatchStatement(TryCatchStatement* node) {
+  Environment entry = env_;
+  Visit(node->try_block());
+  Environment after_try = env_;
+  env_ = entry;
+  WidenToStorageRanges(&env_);
+  if (node->scope() != nullptr) {
+    AssignVariable(node->scope()->catch_variable(), kAnyInt32);
+  }
+  Visit(node->catch_block());
+  env_.Join(after_try);
+}
+
+void RangeAnalysis::VisitTryFinallyStatement(TryFinallyStatement* node) {
+  Environment entry = env_;
+  Visit(node->try_block());
+  Environment after_try = env_;
+  env_ = entry;
+  WidenToStorageRanges(&env_);
+  env_.Join(after_try);
+  Visit(node->finally_block());
+  // Jumps out of the try block run the finally block on the way to their
+  // target, which sees what it assigns too.
+  for (auto& jump : break_envs_) WidenToStorageRanges(&jump.second);
+  for (auto& jump : continue_envs_) WidenToStorageRanges(&jump.second);
+  if (!after_try.reachable) env_.reachable = false;
+}
+
+void RangeAnalysis::VisitFunctionLiteral(FunctionLiteral* node) {
+  // The body is analyzed separately, with variables of its own.
+  Enqueue(node);
+}
+
+void RangeAnalysis::VisitConditional(Conditional* node) {
+  Environment if_false;
+  Branch(node->condition(), &if_false);
+  Int32Range then_range = RangeOf(node->then_expression());
+  Environment after_then = env_;
+  env_ = if_false;
+  Int32Range else_range = RangeOf(node->else_expression());
+  env_.Join(after_then);
+  Record(node, JoinRanges(then_range, else_range));
+}
+
+// The chain can stop at any optional link, after which nothing runs, so a
+// variable it assigns can hold anything afterwards.
+void RangeAnalysis::VisitOptionalChain(OptionalChain* node) {
+  Environment before = env_;
+  std::unordered_set<Variable*> assigned;
+  std::unordered_set<Variable*>* outer = assigned_;
+  assigned_ = &assigned;
+  Visit(node->expression());
+  assigned_ = outer;
+  env_.Join(before);
+  for (Variable* var : assigned) {
+    env_.ranges.erase(var);
+    if (outer != nullptr) outer->insert(var);
+  }
+}
+
+void RangeAnalysis::VisitLiteral(Literal* node) {
+  if (node->type() == Literal::kSmi) {
+    int64_t value = node->AsSmiLiteral().value();
+    Record(node, {value, value});
+    return;
+  }
+  Record(node, kAnyInt32);
+}
+
+void RangeAnalysis::VisitVariableProxy(VariableProxy* node) {
+  Record(node, node->is_resolved() ? LookupVariable(node->var()) : kAnyInt32);
+}
+
+void RangeAnalysis::VisitAssignment(Assignment* node) {
+  Expression* target = node->target();
+  Int32Range range;
+  if (Token::IsLogicalAssignmentOp(node->op())) {
+    Int32Range old_value = RangeOf(target);
+    Environment before = env_;
+    range = JoinRanges(old_value, RangeOf(node->value()));
+    env_.Join(before);
+  } else {
+    // The receiver and key of a property are evaluated before the value.
+    if (target->IsProperty()) Visit(target);
+    range = RangeOf(node->value());
+  }
+  AssignTarget(target, range);
+  Record(node, range);
+}
+
+void RangeAnalysis::VisitCompoundAssignment(CompoundAssignment* node) {
+  // The binary operation reads the target.
+  Int32Range range = RangeOf(node->binary_operation());
+  AssignTarget(node->target(), range);
+  Record(node, range);
+}
+
+void RangeAnalysis::VisitProperty(Property* node) {
+  AstTraversalVisitor::VisitProperty(node);
+  // The only Smi property is the length of a string.
+  Record(node, {0, kMaxInt});
+}
+
+void RangeAnalysis::VisitUnaryOperation(UnaryOperation* node) {
+  Int32Range operand = RangeOf(node->expression());
+  switch (node->op()) {
+    case Token::ADD:
+      Record(node, operand);
+      return;
+    case Token::SUB:
+      if (current_->TypeOf(node) == InferredType::kSmi) {
+        // -0 is -0.
+        Record(node, SmiOperationRange(node, 0, {-operand.max, -operand.min},
+                                       ContainsZero(operand)));
+        return;
+      }
+      break;
+    case Token::BIT_NOT:
+      Record(node, {~operand.max, ~operand.min});
+      return;
+    default:
+      break;
+  }
+  Record(node, kAnyInt32);
+}
+
+void RangeAnalysis::VisitCountOperation(CountOperation* node) {
+  Int32Range old_value = RangeOf(node->expression());
+  Int32Range new_value = kAnyInt32;
+  if (current_->TypeOf(node) == InferredType::kSmi) {
+    int delta = node->op() == Token::INC ? 1 : -1;
+    new_value = SmiOperationRange(
+        node, 0, {old_value.min + delta, old_value.max + delta});
+  }
+  if (node->expression()->IsVariableProxy()) {
+    AssignTarget(node->expression(), new_value);
+  }
+  Record(node, node->is_prefix() ? new_value : old_value);
+}
+
+void RangeAnalysis::VisitBinaryOperation(BinaryOperation* node) {
+  Int32Range left = RangeOf(node->left());
+  if (IsLogicalOp(node->op())) {
+    Environment before = env_;
+    Int32Range right = RangeOf(node->right());
+    env_.Join(before);
+    Record(node, JoinRanges(left, right));
+    return;
+  }
+  Int32Range right = RangeOf(node->right());
+  if (node->op() == Token::COMMA) {
+    Record(node, right);
+    return;
+  }
+  Record(node, BinaryOperationRange(node, 0, node->op(),
+                                    current_->TypeOf(node), left, right));
+}
+
+void RangeAnalysis::VisitNaryOperation(NaryOperation* node) {
+  Token::Value op = node->op();
+  Int32Range range = RangeOf(node->first());
+  if (IsLogicalOp(op)) {
+    // Evaluation can stop after any operand.
+    Environment merged = env_;
+    for (size_t i = 0; i < node->subsequent_length(); ++i) {
+      range = JoinRanges(range, RangeOf(node->subsequent(i)));
+      merged.Join(env_);
+    }
+    env_ = merged;
+    Record(node, range);
+    return;
+  }
+  // The intermediate results are typed the way the inference and the code
+  // generator type them.
+  InferredType intermediate = current_->TypeOf(node->first());
+  for (size_t i = 0; i < node->subsequent_length(); ++i) {
+    Expression* operand = node->subsequent(i);
+    Int32Range right = RangeOf(operand);
+    intermediate = types_->BinaryOperationType(node, i, intermediate,
+                                               current_->TypeOf(operand));
+    if (op == Token::COMMA) {
+      range = right;
+      continue;
+    }
+    bool last = i + 1 == node->subsequent_length();
+    range = BinaryOperationRange(node, i, op,
+                                 last ? current_->TypeOf(node) : intermediate,
+                                 range, right);
+  }
+  Record(node, range);
+}
+
+void RangeAnalysis::VisitThrow(Throw* node) {
+  RangeOf(node->exception());
+  env_.reachable = false;
+}
+
+}  // namespace internal
+}  // namespace v8
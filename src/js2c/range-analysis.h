@@ -0,0 +1,168 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_RANGE_ANALYSIS_H_
+#define V8_JS2C_RANGE_ANALYSIS_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+#include "src/js2c/type-inference.h"
+
+namespace v8 {
+namespace internal {
+
+// The int32 values min..max. The bounds are wide enough to hold the exact
+// result of an operation on two ranges.
+struct Int32Range {
+  int64_t min;
+  int64_t max;
+};
+
+// Proves that Smi arithmetic stays in int32 and never produces -0, which
+// is what lets TypeInference keep it on int32_t rather than double.
+//
+// Every version of a function that TypeInference produced is analyzed on
+// its own, with an abstract environment that maps the stack-allocated
+// variables of the function to an interval of int32 values, joined and
+// iterated around loops the same way the inference tracks their types.
+// Intervals start from Smi literals and booleans, from the bitwise
+// operators (x & 255 is in [0, 255], x >> 24 in [-128, 127]), from x % c and
+// from string lengths; any other Smi can be any int32, which is also what
+// x | 0 says. Comparisons of two Smis narrow their variable operands on
+// each branch, which bounds the induction variable of a counted loop: in
+// the body of for (let i = 0; i < n; i++), i is at most n - 1, so i++
+// cannot overflow. Bounds that still move after kWideningDelay rounds of a
+// loop are widened to the int32 limits.
+//
+// An operation that is not proven can produce a double, so it gets any
+// int32 here and AddDoubleOperations reports it. The driver then infers the
+// types again with it typed kDouble, and analyzes those types, until no
+// operation is left unproven: from then on every Smi is an int32 and the
+// intervals are sound.
+class RangeAnalysis final : public AstTraversalVisitor<RangeAnalysis> {
+ public:
+  RangeAnalysis(uintptr_t stack_limit, const TypeInference* types);
+
+  void Analyze(FunctionLiteral* program);
+
+  static constexpr int kWideningDelay = 3;
+
+  // Adds the Smi additions, subtractions, multiplications, negations,
+  // remainders and count operations that are not proven in some version of
+  // a function to {operations}. Returns false if there are none.
+  bool AddDoubleOperations(DoubleOperations* operations) const;
+
+  // Over all versions of all functions: the reachable Smi operations, and
+  // those that are proven.
+  int smi_operation_count() const { return smi_operation_count_; }
+  int proven_operation_count() const { return proven_operation_count_; }
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitBlock(Block* node);
+  void VisitIfStatement(IfStatement* node);
+  void VisitContinueStatement(ContinueStatement* node);
+  void VisitBreakStatement(BreakStatement* node);
+  void VisitReturnStatement(ReturnStatement* node);
+  void VisitDoWhileStatement(DoWhileStatement* node);
+  void VisitWhileStatement(WhileStatement* node);
+  void VisitForStatement(ForStatement* node);
+  void VisitForInStatement(ForInStatement* node);
+  void VisitForOfStatement(ForOfStatement* node);
+  void VisitSwitchStatement(SwitchStatement* node);
+  void VisitTryCatchStatement(TryCatchStatement* node);
+  void VisitTryFinallyStatement(TryFinallyStatement* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitConditional(Conditional* node);
+  void VisitOptionalChain(OptionalChain* node);
+  void VisitLiteral(Literal* node);
+  void VisitVariableProxy(VariableProxy* node);
+  void VisitAssignment(Assignment* node);
+  void VisitCompoundAssignment(CompoundAssignment* node);
+  void VisitProperty(Property* node);
+  void VisitUnaryOperation(UnaryOperation* node);
+  void VisitCountOperation(CountOperation* node);
+  void VisitBinaryOperation(BinaryOperation* node);
+  void VisitNaryOperation(NaryOperation* node);
+  void VisitThrow(Throw* node);
+
+ private:
+  // Abstract state at a program point. Variables that are missing can hold
+  // any int32. An unreachable environment, which is what a jump target
+  // starts out with, is the identity of Join.
+  struct Environment {
+    bool reachable = false;
+    std::unordered_map<Variable*, Int32Range> ranges;
+
+    void Join(const Environment& other);
+    // Moves every bound that grew since {previous} to the int32 limit.
+    void Widen(const Environment& previous);
+    bool operator==(const Environment& other) const;
+  };
+
+  enum class Site : uint8_t { kUnreached, kProven, kUnproven };
+  // The Smi operations of one version of a function.
+  using Sites = std::unordered_map<Expression*, std::vector<Site>>;
+
+  void Enqueue(FunctionLiteral* literal);
+  void AnalyzeFunction(const FunctionTypes* types);
+  void CountSites();
+
+  Int32Range RangeOf(Expression* expr);
+  void Record(Expression* expr, Int32Range range);
+  Int32Range SmiOperationRange(Expression* operation, size_t index,
+                               Int32Range exact, bool minus_zero = false);
+  Int32Range BinaryOperationRange(Expression* operation, size_t index,
+                                  Token::Value op, InferredType type,
+                                  Int32Range left, Int32Range right);
+
+  void AssignTarget(Expression* target, Int32Range range);
+  void AssignPatternTargets(Expression* pattern);
+  void AssignVariable(Variable* var, Int32Range range);
+  Int32Range LookupVariable(Variable* var) const;
+  bool IsTrackedInEnvironment(Variable* var) const;
+  void WidenToStorageRanges(Environment* env);
+
+  // Evaluates {condition} and leaves env_ at the state where it was true;
+  // *if_false gets the state where it was false.
+  void Branch(Expression* condition, Environment* if_false);
+  bool IsPureCondition(Expression* expr) const;
+  void Refine(Expression* condition, bool value);
+  void RefineComparison(CompareOperation* node, bool value);
+  void RefineOperand(Expression* operand, Int32Range range);
+
+  // Runs {body} until the environment at the loop header is stable.
+  template <typename Body>
+  void AnalyzeLoop(IterationStatement* loop, Body body);
+
+  const TypeInference* types_;
+  std::vector<FunctionLiteral*> worklist_;
+  std::unordered_set<FunctionLiteral*> enqueued_;
+  std::unordered_map<const FunctionTypes*, Sites> sites_;
+  int smi_operation_count_ = 0;
+  int proven_operation_count_ = 0;
+
+  const FunctionTypes* current_ = nullptr;
+  Sites* current_sites_ = nullptr;
+  Environment env_;
+  // The join of every range assigned to each variable so far.
+  std::unordered_map<Variable*, Int32Range> storage_;
+  // Collects the variables assigned in the optional chain being visited.
+  std::unordered_set<Variable*>* assigned_ = nullptr;
+  std::unordered_map<BreakableStatement*, Environment> break_envs_;
+  std::unordered_map<IterationStatement*, Environment> continue_envs_;
+  // The range of the expression visited last.
+  Expression* result_expr_ = nullptr;
+  Int32Range result_ = {0, 0};
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_RANGE_ANALYSIS_H_
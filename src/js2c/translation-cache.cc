@@ -0,0 +1,86 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/translation-cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace v8 {
+namespace internal {
+
+void TranslationCache::Key::Add(const void* data, size_t length) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++) {
+    low_ = (low_ ^ bytes[i]) * 0x100000001b3ull;
+    high_ = (high_ ^ bytes[i]) * 0x9e3779b97f4a7c15ull;
+    high_ ^= high_ >> 29;
+  }
+}
+
+void TranslationCache::Key::Add(const OutputBuffer& output) {
+  output.ForEachChunk(
+      [this](const char* data, size_t length) { Add(data, length); });
+}
+
+std::string TranslationCache::Key::ToString() const {
+  char buffer[33];
+  snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+           static_cast<unsigned long long>(high_),
+           static_cast<unsigned long long>(low_));
+  return buffer;
+}
+
+TranslationCache::TranslationCache(const char* directory)
+    : directory_(directory) {
+  if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Error creating directory: %s\n", directory);
+  }
+}
+
+bool TranslationCache::Lookup(const Key& key, OutputBuffer* output) {
+  int fd = open(PathOf(key).c_str(), O_RDONLY);
+  if (fd < 0) {
+    misses_++;
+    return false;
+  }
+  std::string code;
+  char buffer[16 * 1024];
+  ssize_t count;
+  while ((count = read(fd, buffer, sizeof(buffer))) != 0) {
+    if (count < 0 && errno == EINTR) continue;
+    if (count < 0) break;
+    code.append(buffer, static_cast<size_t>(count));
+  }
+  close(fd);
+  if (count < 0) {
+    misses_++;
+    return false;
+  }
+  output->Append(code.data(), code.size());
+  hits_++;
+  return true;
+}
+
+void TranslationCache::Store(const Key& key, const OutputBuffer& output) {
+  std::string path = PathOf(key);
+  std::string temporary = path + ".tmp" + std::to_string(getpid());
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return;
+  bool written = output.WriteTo(fd);
+  if (close(fd) != 0 || !written ||
+      rename(temporary.c_str(), path.c_str()) != 0) {
+    unlink(temporary.c_str());
+  }
+}
+
+std::string TranslationCache::PathOf(const Key& key) const {
+  return directory_ + "/" + key.ToString() + ".c";
+}
+
+}  // namespace internal
+}  // namespace v8
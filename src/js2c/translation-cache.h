@@ -0,0 +1,65 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_TRANSLATION_CACHE_H_
+#define V8_JS2C_TRANSLATION_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "src/js2c/output-buffer.h"
+
+namespace v8 {
+namespace internal {
+
+// An on-disk cache of the C code of single functions, addressed by a digest
+// of everything the code depends on. v8_js2c uses it with --js2c-cache so
+// that a rebuild only prints the functions that changed.
+//
+// Each entry is a file named after the hex digest. Entries are written to a
+// temporary file first and renamed into place, so concurrent translations
+// can share a directory.
+class TranslationCache final {
+ public:
+  // A 128-bit digest built from two differently mixed FNV-1a hashes. It has
+  // to be stable across runs, unlike std::hash.
+  class Key {
+   public:
+    void Add(const void* data, size_t length);
+    void Add(const std::string& value) { Add(value.data(), value.size()); }
+    void Add(uint64_t value) { Add(&value, sizeof(value)); }
+    void Add(const OutputBuffer& output);
+
+    std::string ToString() const;
+
+   private:
+    uint64_t low_ = 0xcbf29ce484222325ull;
+    uint64_t high_ = 0x6c62272e07bb0142ull;
+  };
+
+  // Creates {directory} if it does not exist.
+  explicit TranslationCache(const char* directory);
+
+  // Appends the code stored under {key} to {output}. Returns false on a
+  // miss, leaving {output} alone.
+  bool Lookup(const Key& key, OutputBuffer* output);
+  void Store(const Key& key, const OutputBuffer& output);
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+ private:
+  std::string PathOf(const Key& key) const;
+
+  std::string directory_;
+  int hits_ = 0;
+  int misses_ = 0;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_TRANSLATION_CACHE_H_
@@ -0,0 +1,271 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/type-feedback.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+#include "src/codegen/source-position-table.h"
+#include "src/execution/isolate.h"
+#include "src/heap/heap.h"
+#include "src/interpreter/bytecode-array-iterator.h"
+#include "src/objects/feedback-vector-inl.h"
+#include "src/objects/js-function-inl.h"
+#include "src/objects/objects-inl.h"
+#include "src/objects/script-inl.h"
+#include "src/objects/shared-function-info-inl.h"
+
+namespace v8 {
+namespace internal {
+
+namespace {
+
+const char* BinaryOperationHintName(BinaryOperationHint hint) {
+  switch (hint) {
+    case BinaryOperationHint::kNone:
+      return nullptr;
+    case BinaryOperationHint::kSignedSmall:
+    case BinaryOperationHint::kSignedSmallInputs:
+      return "smi";
+    case BinaryOperationHint::kNumber:
+      return "number";
+    case BinaryOperationHint::kString:
+      return "string";
+    default:
+      return "any";
+  }
+}
+
+const char* CompareOperationHintName(CompareOperationHint hint) {
+  switch (hint) {
+    case CompareOperationHint::kNone:
+      return nullptr;
+    case CompareOperationHint::kSignedSmall:
+      return "smi";
+    case CompareOperationHint::kNumber:
+      return "number";
+    case CompareOperationHint::kInternalizedString:
+    case CompareOperationHint::kString:
+      return "string";
+    default:
+      return "any";
+  }
+}
+
+InferredType HintType(const std::string& name) {
+  if (name == "smi") return InferredType::kSmi;
+  if (name == "number") return InferredType::kDouble;
+  if (name == "string") return InferredType::kString;
+  return InferredType::kDynamic;
+}
+
+// The shared function info a monomorphic call site has seen, or an empty
+// one. Calls to different closures of the same function literal record the
+// feedback cell they share instead of the closure.
+SharedFunctionInfo CallTargetOf(const FeedbackNexus& nexus) {
+  if (nexus.ic_state() != InlineCacheState::MONOMORPHIC) {
+    return SharedFunctionInfo();
+  }
+  HeapObject target;
+  if (!nexus.GetFeedback().GetHeapObjectIfWeak(&target)) {
+    return SharedFunctionInfo();
+  }
+  if (target.IsJSFunction()) return JSFunction::cast(target).shared();
+  if (target.IsFeedbackCell() &&
+      FeedbackCell::cast(target).value().IsFeedbackVector()) {
+    return FeedbackVector::cast(FeedbackCell::cast(target).value())
+        .shared_function_info();
+  }
+  return SharedFunctionInfo();
+}
+
+void DumpFunction(Isolate* isolate, Handle<JSFunction> function,
+                  std::ostream& os) {
+  Handle<SharedFunctionInfo> shared(function->shared(), isolate);
+  SharedFunctionInfo::EnsureSourcePositionsAvailable(isolate, shared);
+  Handle<BytecodeArray> bytecode(shared->GetBytecodeArray(isolate), isolate);
+  Handle<FeedbackVector> vector(function->feedback_vector(), isolate);
+
+  // Only a bytecode that starts an entry of the source position table can be
+  // mapped back to its expression; the others are skipped.
+  SourcePositionTableIterator positions(
+      handle(bytecode->SourcePositionTable(), isolate));
+  for (interpreter::BytecodeArrayIterator it(bytecode); !it.done();
+       it.Advance()) {
+    while (!positions.done() && positions.code_offset() < it.current_offset()) {
+      positions.Advance();
+    }
+    if (positions.done() || positions.code_offset() != it.current_offset() ||
+        positions.is_statement()) {
+      continue;
+    }
+    int position = positions.source_position().ScriptOffset();
+
+    interpreter::Bytecode bytecode_kind = it.current_bytecode();
+    switch (bytecode_kind) {
+      case interpreter::Bytecode::kAdd:
+      case interpreter::Bytecode::kSub:
+      case interpreter::Bytecode::kMul:
+      case interpreter::Bytecode::kAddSmi:
+      case interpreter::Bytecode::kSubSmi:
+      case interpreter::Bytecode::kMulSmi: {
+        FeedbackNexus nexus(vector, it.GetSlotOperand(1));
+        const char* hint =
+            BinaryOperationHintName(nexus.GetBinaryOperationFeedback());
+        if (hint != nullptr) os << "binop " << position << " " << hint << "\n";
+        break;
+      }
+      case interpreter::Bytecode::kTestEqual:
+      case interpreter::Bytecode::kTestEqualStrict:
+      case interpreter::Bytecode::kTestLessThan:
+      case interpreter::Bytecode::kTestGreaterThan:
+      case interpreter::Bytecode::kTestLessThanOrEqual:
+      case interpreter::Bytecode::kTestGreaterThanOrEqual: {
+        FeedbackNexus nexus(vector, it.GetSlotOperand(1));
+        const char* hint =
+            CompareOperationHintName(nexus.GetCompareOperationFeedback());
+        if (hint != nullptr) {
+          os << "compare " << position << " " << hint << "\n";
+        }
+        break;
+      }
+      case interpreter::Bytecode::kCallAnyReceiver:
+      case interpreter::Bytecode::kCallProperty:
+      case interpreter::Bytecode::kCallProperty0:
+      case interpreter::Bytecode::kCallProperty1:
+      case interpreter::Bytecode::kCallProperty2:
+      case interpreter::Bytecode::kCallUndefinedReceiver:
+      case interpreter::Bytecode::kCallUndefinedReceiver0:
+      case interpreter::Bytecode::kCallUndefinedReceiver1:
+      case interpreter::Bytecode::kCallUndefinedReceiver2: {
+        int slot_operand =
+            interpreter::Bytecodes::NumberOfOperands(bytecode_kind) - 1;
+        FeedbackNexus nexus(vector, it.GetSlotOperand(slot_operand));
+        if (nexus.ic_state() == InlineCacheState::UNINITIALIZED) break;
+        SharedFunctionInfo target = CallTargetOf(nexus);
+        os << "call " << position << " ";
+        if (target.is_null()) {
+          os << "megamorphic\n";
+        } else {
+          os << target.StartPosition() << "\n";
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+void DumpTypeFeedback(Isolate* isolate, const char* path) {
+  HandleScope scope(isolate);
+
+  // Closures of the same function literal share their feedback vector, so
+  // each vector is dumped once.
+  std::vector<Handle<JSFunction>> functions;
+  {
+    std::unordered_set<Address> vectors;
+    HeapObjectIterator heap_iterator(isolate->heap());
+    for (HeapObject object = heap_iterator.Next(); !object.is_null();
+         object = heap_iterator.Next()) {
+      if (!object.IsJSFunction()) continue;
+      JSFunction function = JSFunction::cast(object);
+      SharedFunctionInfo shared = function.shared();
+      if (!function.has_feedback_vector() || !shared.IsUserJavaScript() ||
+          !shared.HasBytecodeArray()) {
+        continue;
+      }
+      if (!vectors.insert(function.feedback_vector().ptr()).second) continue;
+      functions.push_back(handle(function, isolate));
+    }
+  }
+
+  std::map<std::string, std::ostringstream> scripts;
+  for (Handle<JSFunction> function : functions) {
+    Object name = Script::cast(function->shared().script()).name();
+    std::string script_name =
+        name.IsString() ? String::cast(name).ToCString().get() : "";
+    DumpFunction(isolate, function, scripts[script_name]);
+  }
+
+  std::ofstream os(path);
+  if (!os) {
+    PrintF(stderr, "Error opening file: %s\n", path);
+    return;
+  }
+  os << "# js2c type feedback\n";
+  for (const auto& script : scripts) {
+    os << "script " << script.first << "\n" << script.second.str();
+  }
+}
+
+bool TypeFeedback::Load(const char* path, const char* script_name) {
+  std::ifstream is(path);
+  if (!is) return false;
+
+  auto base_name = [](const std::string& name) {
+    size_t slash = name.find_last_of('/');
+    return slash == std::string::npos ? name : name.substr(slash + 1);
+  };
+  std::string wanted = base_name(script_name);
+  bool in_script = false;
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    if (kind.empty() || kind[0] == '#') continue;
+    if (kind == "script") {
+      std::string name;
+      std::getline(fields >> std::ws, name);
+      in_script = base_name(name) == wanted;
+      continue;
+    }
+    int position;
+    std::string value;
+    if (!in_script || !(fields >> position >> value)) continue;
+    if (kind == "binop" || kind == "compare") {
+      // A function literal that was instantiated in several native contexts
+      // has a vector per context; their hints are joined.
+      auto& hints =
+          kind == "binop" ? binary_operations_ : compare_operations_;
+      InferredType& hint = hints[position];
+      hint = JoinTypes(hint, HintType(value));
+    } else if (kind == "call") {
+      int target = value == "megamorphic" ? -1 : std::atoi(value.c_str());
+      auto it = call_targets_.find(position);
+      if (it == call_targets_.end()) {
+        call_targets_[position] = target;
+      } else if (it->second != target) {
+        it->second = -1;
+      }
+    }
+  }
+  return true;
+}
+
+InferredType TypeFeedback::BinaryOperationHint(int position) const {
+  auto it = binary_operations_.find(position);
+  return it == binary_operations_.end() ? InferredType::kNone : it->second;
+}
+
+InferredType TypeFeedback::CompareOperationHint(int position) const {
+  auto it = compare_operations_.find(position);
+  return it == compare_operations_.end() ? InferredType::kNone : it->second;
+}
+
+int TypeFeedback::CallTarget(int position) const {
+  auto it = call_targets_.find(position);
+  return it == call_targets_.end() ? -1 : it->second;
+}
+
+}  // namespace internal
+}  // namespace v8
@@ -0,0 +1,63 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_TYPE_FEEDBACK_H_
+#define V8_JS2C_TYPE_FEEDBACK_H_
+
+#include <string>
+#include <unordered_map>
+
+#include "src/js2c/type-inference.h"
+
+namespace v8 {
+namespace internal {
+
+class Isolate;
+
+// Writes the type feedback that the functions of the user scripts in
+// {isolate} have collected so far to the file {path}. d8 calls this after
+// running a training workload with --js2c-feedback-dump.
+//
+// The file is line based. Every site is identified by the source position
+// of its expression, which the bytecode source position table maps back from
+// the offset of the bytecode that owns the feedback slot:
+//
+//   script <name>
+//   binop <position> smi|number|string|any
+//   compare <position> smi|number|string|any
+//   call <position> <start position of the callee>|megamorphic
+//
+// Sites that never executed are left out.
+void DumpTypeFeedback(Isolate* isolate, const char* path);
+
+// The feedback of one script, read back by v8_js2c with --js2c-feedback.
+// The code generator only uses it where type inference could not prove a
+// type, and always behind a guard, so stale feedback costs speed but never
+// correctness.
+class TypeFeedback {
+ public:
+  // Reads the entries for the script whose name has the same base name as
+  // {script_name}. Returns false if {path} cannot be read.
+  bool Load(const char* path, const char* script_name);
+
+  // The types the binary or compare operation at {position} has seen:
+  // kSmi, kDouble for any number, kString, kDynamic for anything else, or
+  // kNone without feedback.
+  InferredType BinaryOperationHint(int position) const;
+  InferredType CompareOperationHint(int position) const;
+
+  // The start position of the only function the call at {position} has
+  // called, or -1.
+  int CallTarget(int position) const;
+
+ private:
+  std::unordered_map<int, InferredType> binary_operations_;
+  std::unordered_map<int, InferredType> compare_operations_;
+  std::unordered_map<int, int> call_targets_;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_TYPE_FEEDBACK_H_
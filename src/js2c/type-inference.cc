@@ -0,0 +1,860 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "src/js2c/type-inference.h"
+
+#include <algorithm>
+
+#include "src/ast/ast-value-factory.h"
+#include "src/objects/function-kind.h"
+#include "src/parsing/token.h"
+
+namespace v8 {
+namespace internal {
+
+InferredType JoinTypes(InferredType a, InferredType b) {
+  if (a == b) return a;
+  if (a == InferredType::kNone) return b;
+  if (b == InferredType::kNone) return a;
+  if (IsNumericType(a) && IsNumericType(b)) return InferredType::kDouble;
+  return InferredType::kDynamic;
+}
+
+const char* InferredTypeToString(InferredType type) {
+  switch (type) {
+    case InferredType::kNone:
+      return "none";
+    case InferredType::kSmi:
+      return "smi";
+    case InferredType::kDouble:
+      return "double";
+    case InferredType::kBoolean:
+      return "boolean";
+    case InferredType::kString:
+      return "string";
+    case InferredType::kUndefined:
+      return "undefined";
+    case InferredType::kDynamic:
+      return "dynamic";
+  }
+  UNREACHABLE();
+}
+
+namespace {
+
+// Variables that are missing from an environment have not been assigned on
+// any path reaching it yet, so they still hold undefined.
+InferredType Lookup(const std::unordered_map<Variable*, InferredType>& types,
+                    Variable* var) {
+  auto it = types.find(var);
+  return it == types.end() ? InferredType::kUndefined : it->second;
+}
+
+// The type a value has after ToNumber. Booleans and Smis stay int32.
+InferredType ToNumberType(InferredType type) {
+  switch (type) {
+    case InferredType::kNone:
+      return InferredType::kNone;
+    case InferredType::kSmi:
+    case InferredType::kBoolean:
+      return InferredType::kSmi;
+    default:
+      return InferredType::kDouble;
+  }
+}
+
+bool IsLogicalOp(Token::Value op) {
+  return op == Token::OR || op == Token::AND || op == Token::NULLISH;
+}
+
+bool IsPositiveSmiLiteral(Expression* expr) {
+  Literal* literal = expr->AsLiteral();
+  return literal != nullptr && literal->type() == Literal::kSmi &&
+         literal->AsSmiLiteral().value() > 0;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+FunctionTypes::FunctionTypes(const TypeInference* inference,
+                             FunctionLiteral* literal)
+    : inference_(inference), literal_(literal) {}
+
+InferredType FunctionTypes::parameter(int index) const {
+  DCHECK_LT(index, parameter_count());
+  return parameters_[index];
+}
+
+InferredType FunctionTypes::return_type() const { return return_type_; }
+
+InferredType FunctionTypes::TypeOf(Expression* expr) const {
+  auto it = expressions_.find(expr);
+  return it == expressions_.end() ? InferredType::kDynamic : it->second;
+}
+
+InferredType FunctionTypes::TypeOf(Variable* var) const {
+  auto it = locals_.find(var);
+  if (it != locals_.end()) return it->second;
+  return inference_->StorageTypeOf(var);
+}
+
+const FunctionTypes* FunctionTypes::CalleeTypesAt(Call* call) const {
+  auto it = call_targets_.find(call);
+  return it == call_targets_.end() ? nullptr : it->second;
+}
+
+//-----------------------------------------------------------------------------
+
+void TypeInference::Environment::Join(const Environment& other) {
+  if (!other.reachable) return;
+  if (!reachable) {
+    *this = other;
+    return;
+  }
+  for (auto& entry : types) {
+    entry.second = JoinTypes(entry.second, Lookup(other.types, entry.first));
+  }
+  for (auto& entry : other.types) {
+    if (types.count(entry.first) == 0) {
+      types[entry.first] = JoinTypes(InferredType::kUndefined, entry.second);
+    }
+  }
+}
+
+bool TypeInference::Environment::operator==(const Environment& other) const {
+  if (reachable != other.reachable) return false;
+  for (auto& entry : types) {
+    if (entry.second != Lookup(other.types, entry.first)) return false;
+  }
+  for (auto& entry : other.types) {
+    if (entry.second != Lookup(types, entry.first)) return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+TypeInference::TypeInference(uintptr_t stack_limit,
+                             const DoubleOperations* double_operations)
+    : AstTraversalVisitor<TypeInference>(stack_limit),
+      double_operations_(double_operations) {}
+
+void TypeInference::Analyze(FunctionLiteral* program) {
+  CollectDeclarations(program->scope());
+  do {
+    changed_ = false;
+    enqueued_.clear();
+    Enqueue(program);
+    while (!worklist_.empty()) {
+      FunctionTypes* types = worklist_.back();
+      worklist_.pop_back();
+      AnalyzeFunction(types);
+      if (HasStackOverflow()) return;
+    }
+  } while (changed_);
+
+  // Clones made for argument types that later widened are no longer called.
+  for (auto& entry : specializations_) {
+    std::vector<std::unique_ptr<FunctionTypes>>& clones = entry.second;
+    auto unreached = [this](const std::unique_ptr<FunctionTypes>& clone) {
+      return enqueued_.count(clone.get()) == 0;
+    };
+    clones.erase(std::remove_if(clones.begin(), clones.end(), unreached),
+                 clones.end());
+  }
+}
+
+const FunctionTypes* TypeInference::TypesFor(FunctionLiteral* literal) const {
+  auto it = functions_.find(literal);
+  return it == functions_.end() ? nullptr : it->second.get();
+}
+
+std::vector<const FunctionTypes*> TypeInference::SpecializationsOf(
+    FunctionLiteral* literal) const {
+  std::vector<const FunctionTypes*> result;
+  auto it = specializations_.find(literal);
+  if (it == specializations_.end()) return result;
+  for (const std::unique_ptr<FunctionTypes>& clone : it->second) {
+    result.push_back(clone.get());
+  }
+  return result;
+}
+
+FunctionLiteral* TypeInference::DeclaredFunction(Variable* var) const {
+  if (var == nullptr || reassigned_functions_.count(var) != 0) return nullptr;
+  auto it = declared_functions_.find(var);
+  return it == declared_functions_.end() ? nullptr : it->second;
+}
+
+InferredType TypeInference::StorageTypeOf(Variable* var) const {
+  auto it = shared_variables_.find(var);
+  if (it == shared_variables_.end() || it->second == InferredType::kNone) {
+    return InferredType::kDynamic;
+  }
+  return it->second;
+}
+
+void TypeInference::CollectDeclarations(Scope* scope) {
+  for (Declaration* decl : *scope->declarations()) {
+    Variable* var = decl->var();
+    if (decl->IsFunctionDeclaration()) {
+      FunctionLiteral* literal = decl->AsFunctionDeclaration()->fun();
+      auto it = declared_functions_.find(var);
+      if (it == declared_functions_.end()) {
+        declared_functions_[var] = literal;
+      } else if (it->second != literal) {
+        // Sloppy mode allows redeclaring a function, so the callee is not
+        // known statically.
+        reassigned_functions_.insert(var);
+      }
+    } else if (var->mode() == VariableMode::kVar &&
+               !var->IsStackAllocated()) {
+      // Hoisted var bindings are observable as undefined before their
+      // initialization runs.
+      JoinSharedVariable(var, InferredType::kUndefined);
+    }
+  }
+  for (Scope* inner = scope->inner_scope(); inner != nullptr;
+       inner = inner->sibling()) {
+    CollectDeclarations(inner);
+  }
+}
+
+void TypeInference::Enqueue(FunctionLiteral* literal) {
+  Enqueue(GetOrCreateTypes(literal));
+}
+
+void TypeInference::Enqueue(FunctionTypes* types) {
+  if (enqueued_.insert(types).second) worklist_.push_back(types);
+}
+
+// Returns the clone of {literal} for calls with {arguments}, creating it if
+// the function has room for one more, or nullptr if the call goes to the
+// generic version.
+FunctionTypes* TypeInference::Specialize(
+    FunctionLiteral* literal, const std::vector<InferredType>& arguments) {
+  if (arguments.empty() || IsResumableFunction(literal->kind()) ||
+      IsClassConstructor(literal->kind()) ||
+      !literal->scope()->has_simple_parameters()) {
+    return nullptr;
+  }
+  for (InferredType type : arguments) {
+    if (!IsUnboxedType(type)) return nullptr;
+  }
+  std::vector<std::unique_ptr<FunctionTypes>>& clones =
+      specializations_[literal];
+  for (std::unique_ptr<FunctionTypes>& clone : clones) {
+    if (clone->parameters_ == arguments) return clone.get();
+  }
+  if (clones.size() >= kMaxSpecializations) return nullptr;
+  clones.push_back(std::make_unique<FunctionTypes>(this, literal));
+  FunctionTypes* clone = clones.back().get();
+  clone->is_specialization_ = true;
+  clone->parameters_ = arguments;
+  changed_ = true;
+  return clone;
+}
+
+FunctionTypes* TypeInference::GetOrCreateTypes(FunctionLiteral* literal) {
+  std::unique_ptr<FunctionTypes>& types = functions_[literal];
+  if (!types) {
+    types = std::make_unique<FunctionTypes>(this, literal);
+    types->parameters_.resize(literal->scope()->num_parameters(),
+                              InferredType::kNone);
+  }
+  return types.get();
+}
+
+void TypeInference::AnalyzeFunction(FunctionTypes* types) {
+  FunctionLiteral* literal = types->literal();
+  current_ = types;
+  // Everything local is recomputed from the current signatures.
+  current_->expressions_.clear();
+  current_->locals_.clear();
+  current_->call_targets_.clear();
+  env_ = Environment();
+  env_.reachable = true;
+  break_envs_.clear();
+  continue_envs_.clear();
+
+  DeclarationScope* scope = literal->scope();
+  if (IsResumableFunction(literal->kind()) ||
+      IsClassConstructor(literal->kind()) ||
+      !scope->has_simple_parameters()) {
+    MarkEscaping(literal);
+    JoinReturnType(InferredType::kDynamic);
+  }
+  for (int i = 0; i < scope->num_parameters(); i++) {
+    AssignVariable(scope->parameter(i), current_->parameters_[i]);
+  }
+
+  VisitDeclarations(scope->declarations());
+  VisitStatements(literal->body());
+  if (env_.reachable) JoinReturnType(InferredType::kUndefined);
+  current_ = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+
+InferredType TypeInference::Infer(Expression* expr) {
+  Visit(expr);
+  return current_->TypeOf(expr);
+}
+
+void TypeInference::Record(Expression* expr, InferredType type) {
+  InferredType& recorded = current_->expressions_[expr];
+  recorded = JoinTypes(recorded, type);
+}
+
+bool TypeInference::IsTrackedInEnvironment(Variable* var) const {
+  return var != nullptr && var->IsStackAllocated() &&
+         var->scope()->GetClosureScope() == current_->literal()->scope();
+}
+
+void TypeInference::AssignTarget(Expression* target, InferredType type) {
+  VariableProxy* proxy = target->AsVariableProxy();
+  if (proxy != nullptr) {
+    if (proxy->is_resolved()) AssignVariable(proxy->var(), type);
+    Record(proxy, type);
+    return;
+  }
+  // Property stores and destructuring patterns only need their
+  // subexpressions visited.
+  Visit(target);
+}
+
+void TypeInference::AssignVariable(Variable* var, InferredType type) {
+  if (declared_functions_.count(var) != 0 &&
+      reassigned_functions_.insert(var).second) {
+    changed_ = true;
+  }
+  if (IsTrackedInEnvironment(var)) {
+    env_.types[var] = type;
+    InferredType& storage = current_->locals_[var];
+    storage = JoinTypes(storage, type);
+  } else {
+    JoinSharedVariable(var, type);
+  }
+}
+
+InferredType TypeInference::LookupVariable(Variable* var) {
+  if (!IsTrackedInEnvironment(var)) return StorageTypeOf(var);
+  if (!env_.reachable) return InferredType::kNone;
+  InferredType type = Lookup(env_.types, var);
+  InferredType& storage = current_->locals_[var];
+  storage = JoinTypes(storage, type);
+  return type;
+}
+
+void TypeInference::JoinSharedVariable(Variable* var, InferredType type) {
+  InferredType& storage = shared_variables_[var];
+  InferredType joined = JoinTypes(storage, type);
+  if (joined != storage) {
+    storage = joined;
+    changed_ = true;
+  }
+}
+
+void TypeInference::JoinParameter(FunctionLiteral* literal, int index,
+                                  InferredType type) {
+  FunctionTypes* types = GetOrCreateTypes(literal);
+  InferredType joined = JoinTypes(types->parameters_[index], type);
+  if (joined != types->parameters_[index]) {
+    types->parameters_[index] = joined;
+    changed_ = true;
+  }
+}
+
+void TypeInference::JoinReturnType(InferredType type) {
+  InferredType joined = JoinTypes(current_->return_type_, type);
+  if (joined != current_->return_type_) {
+    current_->return_type_ = joined;
+    changed_ = true;
+  }
+}
+
+void TypeInference::MarkEscaping(FunctionLiteral* literal) {
+  if (!escaping_functions_.insert(literal).second) return;
+  FunctionTypes* types = GetOrCreateTypes(literal);
+  for (InferredType& parameter : types->parameters_) {
+    parameter = InferredType::kDynamic;
+  }
+  changed_ = true;
+}
+
+void TypeInference::WidenToStorageTypes(Environment* env) {
+  // Any assignment inside a protected region may be the last one before an
+  // exception, so the handler has to assume every type assigned so far.
+  for (auto& entry : current_->locals_) {
+    InferredType type = Lookup(env->types, entry.first);
+    env->types[entry.first] = JoinTypes(type, entry.second);
+  }
+}
+
+template <typename Body>
+void TypeInference::AnalyzeLoop(IterationStatement* loop, Body body) {
+  Environment entry = env_;
+  Environment header = entry;
+  for (;;) {
+    env_ = header;
+    break_envs_.erase(loop);
+    continue_envs_.erase(loop);
+    body();
+    if (HasStackOverflow()) return;
+    env_.Join(continue_envs_[loop]);
+    Environment next = entry;
+    next.Join(env_);
+    if (next == header) break;
+    header = next;
+  }
+}
+
+InferredType TypeInference::SmiOperationType(Expression* operation,
+                                             size_t index) const {
+  if (double_operations_ != nullptr &&
+      double_operations_->Contains(operation, index)) {
+    return InferredType::kDouble;
+  }
+  return InferredType::kSmi;
+}
+
+InferredType TypeInference::BinaryOperationType(Expression* operation,
+                                                size_t index,
+                                                InferredType left,
+                                                InferredType right) const {
+  if (left == InferredType::kNone || right == InferredType::kNone) {
+    return InferredType::kNone;
+  }
+  Token::Value op;
+  Expression* right_expr;
+  if (operation->IsBinaryOperation()) {
+    op = operation->AsBinaryOperation()->op();
+    right_expr = operation->AsBinaryOperation()->right();
+  } else {
+    op = operation->AsNaryOperation()->op();
+    right_expr = operation->AsNaryOperation()->subsequent(index);
+  }
+  switch (op) {
+    case Token::COMMA:
+      return right;
+    case Token::OR:
+    case Token::AND:
+      return JoinTypes(left, right);
+    case Token::NULLISH:
+      if (left == InferredType::kUndefined) return right;
+      return left == InferredType::kDynamic ? JoinTypes(left, right) : left;
+    case Token::ADD:
+      if (left == InferredType::kString || right == InferredType::kString) {
+        return InferredType::kString;
+      }
+      if (left == InferredType::kDynamic || right == InferredType::kDynamic) {
+        return InferredType::kDynamic;
+      }
+      [[fallthrough]];
+    case Token::SUB:
+    case Token::MUL:
+      if (ToNumberType(left) == InferredType::kSmi &&
+          ToNumberType(right) == InferredType::kSmi) {
+        return SmiOperationType(operation, index);
+      }
+      return InferredType::kDouble;
+    case Token::MOD:
+      if (ToNumberType(left) == InferredType::kSmi &&
+          IsPositiveSmiLiteral(right_expr)) {
+        return SmiOperationType(operation, index);
+      }
+      return InferredType::kDouble;
+    case Token::DIV:
+    case Token::EXP:
+    case Token::SHR:
+      return InferredType::kDouble;
+    case Token::BIT_OR:
+    case Token::BIT_XOR:
+    case Token::BIT_AND:
+    case Token::SHL:
+    case Token::SAR:
+      return InferredType::kSmi;
+    default:
+      return InferredType::kDynamic;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void TypeInference::VisitFunctionDeclaration(FunctionDeclaration* node) {
+  Enqueue(node->fun());
+}
+
+void TypeInference::VisitBlock(Block* node) {
+  if (node->scope() != nullptr) VisitDeclarations(node->scope()->declarations());
+  VisitStatements(node->statements());
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitIfStatement(IfStatement* node) {
+  Infer(node->condition());
+  Environment before = env_;
+  Visit(node->then_statement());
+  Environment after_then = env_;
+  env_ = before;
+  Visit(node->else_statement());
+  env_.Join(after_then);
+}
+
+void TypeInference::VisitContinueStatement(ContinueStatement* node) {
+  continue_envs_[node->target()].Join(env_);
+  env_.reachable = false;
+}
+
+void TypeInference::VisitBreakStatement(BreakStatement* node) {
+  break_envs_[node->target()].Join(env_);
+  env_.reachable = false;
+}
+
+void TypeInference::VisitReturnStatement(ReturnStatement* node) {
+  JoinReturnType(Infer(node->expression()));
+  env_.reachable = false;
+}
+
+void TypeInference::VisitDoWhileStatement(DoWhileStatement* node) {
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    Visit(node->body());
+    env_.Join(continue_envs_[node]);
+    continue_envs_.erase(node);
+    Infer(node->cond());
+    exit = env_;
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitWhileStatement(WhileStatement* node) {
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    Infer(node->cond());
+    exit = env_;
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitForStatement(ForStatement* node) {
+  if (node->init() != nullptr) Visit(node->init());
+  Environment exit;
+  exit.reachable = false;
+  AnalyzeLoop(node, [&]() {
+    if (node->cond() != nullptr) {
+      Infer(node->cond());
+      exit = env_;
+    }
+    Visit(node->body());
+    env_.Join(continue_envs_[node]);
+    continue_envs_.erase(node);
+    if (node->next() != nullptr) Visit(node->next());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitForInStatement(ForInStatement* node) {
+  Infer(node->subject());
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    exit = env_;
+    AssignTarget(node->each(), InferredType::kString);
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitForOfStatement(ForOfStatement* node) {
+  // The characters of a string are strings.
+  InferredType subject = Infer(node->subject());
+  InferredType each = subject == InferredType::kString &&
+                              node->type() == IteratorType::kNormal
+                          ? InferredType::kString
+                          : InferredType::kDynamic;
+  Environment exit;
+  AnalyzeLoop(node, [&]() {
+    exit = env_;
+    AssignTarget(node->each(), each);
+    Visit(node->body());
+  });
+  env_ = exit;
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitSwitchStatement(SwitchStatement* node) {
+  Infer(node->tag());
+  Environment labels = env_;
+  Environment fallthrough;
+  fallthrough.reachable = false;
+  bool has_default = false;
+  for (CaseClause* clause : *node->cases()) {
+    if (clause->is_default()) {
+      has_default = true;
+      env_ = labels;
+    } else {
+      env_ = labels;
+      Infer(clause->label());
+      labels = env_;
+    }
+    env_.Join(fallthrough);
+    VisitStatements(clause->statements());
+    fallthrough = env_;
+  }
+  env_ = fallthrough;
+  if (!has_default) env_.Join(labels);
+  env_.Join(break_envs_[node]);
+}
+
+void TypeInference::VisitTryCatchStatement(TryCatchStatement* node) {
+  Environment entry = env_;
+  Visit(node->try_block());
+  Environment after_try = env_;
+  env_ = entry;
+  WidenToStorageTypes(&env_);
+  if (node->scope() != nullptr) {
+    AssignVariable(node->scope()->catch_variable(), InferredType::kDynamic);
+  }
+  Visit(node->catch_block());
+  env_.Join(after_try);
+}
+
+void TypeInference::VisitTryFinallyStatement(TryFinallyStatement* node) {
+  Environment entry = env_;
+  Visit(node->try_block());
+  Environment after_try = env_;
+  env_ = entry;
+  WidenToStorageTypes(&env_);
+  env_.Join(after_try);
+  Visit(node->finally_block());
+  // Jumps out of the try block run the finally block on the way to their
+  // target, so what it assigns reaches the target as well.
+  for (auto& jump : break_envs_) WidenToStorageTypes(&jump.second);
+  for (auto& jump : continue_envs_) WidenToStorageTypes(&jump.second);
+  if (!after_try.reachable) env_.reachable = false;
+}
+
+void TypeInference::VisitFunctionLiteral(FunctionLiteral* node) {
+  // The body is analyzed separately; here the function is just a value that
+  // may be called from anywhere.
+  Enqueue(node);
+  MarkEscaping(node);
+  Record(node, InferredType::kDynamic);
+}
+
+void TypeInference::VisitConditional(Conditional* node) {
+  Infer(node->condition());
+  Environment before = env_;
+  InferredType then_type = Infer(node->then_expression());
+  Environment after_then = env_;
+  env_ = before;
+  InferredType else_type = Infer(node->else_expression());
+  env_.Join(after_then);
+  Record(node, JoinTypes(then_type, else_type));
+}
+
+void TypeInference::VisitLiteral(Literal* node) {
+  InferredType type;
+  switch (node->type()) {
+    case Literal::kSmi:
+      type = InferredType::kSmi;
+      break;
+    case Literal::kHeapNumber:
+      type = InferredType::kDouble;
+      break;
+    case Literal::kBoolean:
+      type = InferredType::kBoolean;
+      break;
+    case Literal::kString:
+      type = InferredType::kString;
+      break;
+    case Literal::kUndefined:
+      type = InferredType::kUndefined;
+      break;
+    default:
+      type = InferredType::kDynamic;
+      break;
+  }
+  Record(node, type);
+}
+
+void TypeInference::VisitVariableProxy(VariableProxy* node) {
+  if (!node->is_resolved()) {
+    Record(node, InferredType::kDynamic);
+    return;
+  }
+  Variable* var = node->var();
+  FunctionLiteral* function = DeclaredFunction(var);
+  if (function != nullptr) {
+    // The function is used as a value rather than called directly.
+    MarkEscaping(function);
+    Record(node, InferredType::kDynamic);
+    return;
+  }
+  Record(node, LookupVariable(var));
+}
+
+void TypeInference::VisitAssignment(Assignment* node) {
+  InferredType type;
+  if (Token::IsLogicalAssignmentOp(node->op())) {
+    InferredType old_type = Infer(node->target());
+    Environment before = env_;
+    type = JoinTypes(old_type, Infer(node->value()));
+    env_.Join(before);
+  } else {
+    type = Infer(node->value());
+  }
+  AssignTarget(node->target(), type);
+  Record(node, type);
+}
+
+void TypeInference::VisitCompoundAssignment(CompoundAssignment* node) {
+  InferredType type = Infer(node->binary_operation());
+  AssignTarget(node->target(), type);
+  Record(node, type);
+}
+
+void TypeInference::VisitProperty(Property* node) {
+  InferredType object_type = Infer(node->obj());
+  Literal* key = node->key()->AsLiteral();
+  if (key != nullptr && key->IsString() &&
+      key->AsRawString()->IsOneByteEqualTo("length") &&
+      object_type == InferredType::kString) {
+    Record(node, InferredType::kSmi);
+    return;
+  }
+  Infer(node->key());
+  Record(node, InferredType::kDynamic);
+}
+
+void TypeInference::VisitCall(Call* node) {
+  VariableProxy* callee = node->expression()->AsVariableProxy();
+  FunctionLiteral* function =
+      callee != nullptr && callee->is_resolved() && !node->is_possibly_eval()
+          ? DeclaredFunction(callee->var())
+          : nullptr;
+  const ZonePtrList<Expression>* arguments = node->arguments();
+  if (function == nullptr || node->spread_position() != Call::kNoSpread) {
+    Infer(node->expression());
+    for (Expression* argument : *arguments) Infer(argument);
+    Record(node, InferredType::kDynamic);
+    return;
+  }
+
+  Record(callee, InferredType::kDynamic);
+  int parameter_count = function->scope()->num_parameters();
+  std::vector<InferredType> argument_types;
+  for (int i = 0; i < arguments->length(); i++) {
+    InferredType type = Infer(arguments->at(i));
+    if (i < parameter_count) argument_types.push_back(type);
+  }
+  for (int i = arguments->length(); i < parameter_count; i++) {
+    argument_types.push_back(InferredType::kUndefined);
+  }
+  FunctionTypes* target = Specialize(function, argument_types);
+  if (target != nullptr) {
+    Enqueue(target);
+  } else {
+    target = GetOrCreateTypes(function);
+    for (int i = 0; i < parameter_count; i++) {
+      JoinParameter(function, i, argument_types[i]);
+    }
+  }
+  current_->call_targets_[node] = target;
+  Record(node, target->return_type());
+}
+
+void TypeInference::VisitUnaryOperation(UnaryOperation* node) {
+  InferredType operand = Infer(node->expression());
+  InferredType type;
+  switch (node->op()) {
+    case Token::NOT:
+    case Token::DELETE:
+      type = InferredType::kBoolean;
+      break;
+    case Token::BIT_NOT:
+      type = InferredType::kSmi;
+      break;
+    case Token::ADD:
+      type = ToNumberType(operand);
+      break;
+    case Token::SUB:
+      type = ToNumberType(operand);
+      if (type == InferredType::kSmi) type = SmiOperationType(node);
+      break;
+    case Token::TYPEOF:
+      type = InferredType::kString;
+      break;
+    case Token::VOID:
+      type = InferredType::kUndefined;
+      break;
+    default:
+      type = InferredType::kDynamic;
+      break;
+  }
+  Record(node, type);
+}
+
+void TypeInference::VisitCountOperation(CountOperation* node) {
+  VariableProxy* proxy = node->expression()->AsVariableProxy();
+  if (proxy == nullptr || !proxy->is_resolved()) {
+    Infer(node->expression());
+    Record(node, InferredType::kDynamic);
+    return;
+  }
+  InferredType type = ToNumberType(Infer(proxy));
+  if (type == InferredType::kSmi) type = SmiOperationType(node);
+  AssignVariable(proxy->var(), type);
+  Record(node, type);
+}
+
+void TypeInference::VisitBinaryOperation(BinaryOperation* node) {
+  InferredType left = Infer(node->left());
+  InferredType right;
+  if (IsLogicalOp(node->op())) {
+    Environment before = env_;
+    right = Infer(node->right());
+    env_.Join(before);
+  } else {
+    right = Infer(node->right());
+  }
+  Record(node, BinaryOperationType(node, 0, left, right));
+}
+
+void TypeInference::VisitNaryOperation(NaryOperation* node) {
+  InferredType type = Infer(node->first());
+  bool is_logical = IsLogicalOp(node->op());
+  Environment before = env_;
+  for (size_t i = 0; i < node->subsequent_length(); ++i) {
+    type = BinaryOperationType(node, i, type, Infer(node->subsequent(i)));
+  }
+  if (is_logical) env_.Join(before);
+  Record(node, type);
+}
+
+void TypeInference::VisitTemplateLiteral(TemplateLiteral* node) {
+  for (Expression* substitution : *node->substitutions()) Infer(substitution);
+  Record(node, InferredType::kString);
+}
+
+void TypeInference::VisitCompareOperation(CompareOperation* node) {
+  Infer(node->left());
+  Infer(node->right());
+  Record(node, InferredType::kBoolean);
+}
+
+void TypeInference::VisitThrow(Throw* node) {
+  Infer(node->exception());
+  env_.reachable = false;
+  Record(node, InferredType::kNone);
+}
+
+}  // namespace internal
+}  // namespace v8
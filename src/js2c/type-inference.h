@@ -0,0 +1,252 @@
+// Copyright 2023 the V8 project authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef V8_JS2C_TYPE_INFERENCE_H_
+#define V8_JS2C_TYPE_INFERENCE_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ast/ast-traversal-visitor.h"
+#include "src/ast/ast.h"
+#include "src/ast/scopes.h"
+
+namespace v8 {
+namespace internal {
+
+// The types js2c can prove about a value. kSmi values are emitted as int32_t,
+// kDouble as double and kBoolean as bool; everything else stays boxed.
+// kNone is the bottom of the lattice (no value seen yet), kDynamic the top.
+enum class InferredType : uint8_t {
+  kNone,
+  kSmi,
+  kDouble,
+  kBoolean,
+  kString,
+  kUndefined,
+  kDynamic,
+};
+
+InferredType JoinTypes(InferredType a, InferredType b);
+const char* InferredTypeToString(InferredType type);
+
+inline bool IsNumericType(InferredType type) {
+  return type == InferredType::kSmi || type == InferredType::kDouble;
+}
+
+// Types that are emitted as a raw C value rather than a boxed js_value.
+inline bool IsUnboxedType(InferredType type) {
+  return IsNumericType(type) || type == InferredType::kBoolean;
+}
+
+class TypeInference;
+
+// Smi operations that can leave the int32 range or produce -0, where
+// JavaScript computes a double; see RangeAnalysis. Every operation has one
+// site, except an NaryOperation, which has one per subsequent operand.
+class DoubleOperations {
+ public:
+  bool Contains(Expression* operation, size_t index = 0) const {
+    auto it = operations_.find(operation);
+    return it != operations_.end() && it->second.count(index) != 0;
+  }
+
+  // Returns false if the site was already in.
+  bool Add(Expression* operation, size_t index = 0) {
+    return operations_[operation].insert(index).second;
+  }
+
+ private:
+  std::unordered_map<Expression*, std::unordered_set<size_t>> operations_;
+};
+
+// The result of type inference for a single function, or for one of its
+// specializations.
+class FunctionTypes {
+ public:
+  FunctionTypes(const TypeInference* inference, FunctionLiteral* literal);
+
+  FunctionLiteral* literal() const { return literal_; }
+  // True for a clone analyzed with the argument types of some direct calls;
+  // see TypeInference::SpecializationsOf.
+  bool is_specialization() const { return is_specialization_; }
+
+  int parameter_count() const { return static_cast<int>(parameters_.size()); }
+  InferredType parameter(int index) const;
+  InferredType return_type() const;
+
+  // The type of {expr} at the program point where it is evaluated.
+  InferredType TypeOf(Expression* expr) const;
+  // The storage type of {var}, i.e. the join over all program points.
+  InferredType TypeOf(Variable* var) const;
+
+  // The version of the callee that the direct call {call} in this function
+  // goes to, or nullptr if it is not a direct call.
+  const FunctionTypes* CalleeTypesAt(Call* call) const;
+
+ private:
+  friend class TypeInference;
+
+  const TypeInference* inference_;
+  FunctionLiteral* literal_;
+  bool is_specialization_ = false;
+  std::vector<InferredType> parameters_;
+  InferredType return_type_ = InferredType::kNone;
+  std::unordered_map<Expression*, InferredType> expressions_;
+  std::unordered_map<Variable*, InferredType> locals_;
+  std::unordered_map<Call*, FunctionTypes*> call_targets_;
+};
+
+// Flow-sensitive type inference over the whole program. Every function is
+// analyzed with an abstract environment mapping its stack-allocated variables
+// to types, which is joined at control flow merges and iterated to a fixpoint
+// around loops. Variables that live outside the stack frame (context slots and
+// globals) can be changed behind our back, so they only get a storage type.
+//
+// Parameter types are the join of the argument types seen at direct call
+// sites; functions whose value escapes take kDynamic parameters. The analysis
+// of the whole program is repeated until no signature changes.
+//
+// A direct call whose arguments are all unboxed goes to a specialization of
+// the callee instead: a clone analyzed with exactly those argument types,
+// shared by every call with the same types. Only the calls that do not get
+// one are joined into the parameters of the generic version, which also
+// serves calls through the value of the function. The number of clones per
+// function is bounded by kMaxSpecializations.
+//
+// Addition, subtraction, multiplication, negation, remainder and count
+// operations on Smis are typed kSmi unless they are among
+// {double_operations}, which then produce kDouble. The result is only sound
+// once those include every operation that RangeAnalysis cannot prove to
+// stay in int32 without producing -0, so the driver infers the types again
+// with the operations it finds until there are none left.
+class TypeInference final : public AstTraversalVisitor<TypeInference> {
+ public:
+  explicit TypeInference(uintptr_t stack_limit,
+                         const DoubleOperations* double_operations = nullptr);
+
+  void Analyze(FunctionLiteral* program);
+
+  static constexpr size_t kMaxSpecializations = 4;
+
+  // Returns nullptr for functions that were not reached from the program.
+  // This is the generic version of the function.
+  const FunctionTypes* TypesFor(FunctionLiteral* literal) const;
+
+  // The clones of {literal} that some direct call goes to, in the order they
+  // were created.
+  std::vector<const FunctionTypes*> SpecializationsOf(
+      FunctionLiteral* literal) const;
+
+  // Returns the literal if {var} is bound by a function declaration and is
+  // never reassigned, so that calls through it can be made directly.
+  FunctionLiteral* DeclaredFunction(Variable* var) const;
+
+  InferredType StorageTypeOf(Variable* var) const;
+
+  // The result type of the binary operation {operation}, or of the one on
+  // the subsequent operand {index} of the NaryOperation {operation}, on
+  // operands of types {left} and {right}. Shared with the code generator so
+  // that it can type the intermediate results of an NaryOperation.
+  InferredType BinaryOperationType(Expression* operation, size_t index,
+                                   InferredType left,
+                                   InferredType right) const;
+
+  // AstTraversalVisitor overrides.
+  void VisitFunctionDeclaration(FunctionDeclaration* node);
+  void VisitBlock(Block* node);
+  void VisitIfStatement(IfStatement* node);
+  void VisitContinueStatement(ContinueStatement* node);
+  void VisitBreakStatement(BreakStatement* node);
+  void VisitReturnStatement(ReturnStatement* node);
+  void VisitDoWhileStatement(DoWhileStatement* node);
+  void VisitWhileStatement(WhileStatement* node);
+  void VisitForStatement(ForStatement* node);
+  void VisitForInStatement(ForInStatement* node);
+  void VisitForOfStatement(ForOfStatement* node);
+  void VisitSwitchStatement(SwitchStatement* node);
+  void VisitTryCatchStatement(TryCatchStatement* node);
+  void VisitTryFinallyStatement(TryFinallyStatement* node);
+  void VisitFunctionLiteral(FunctionLiteral* node);
+  void VisitConditional(Conditional* node);
+  void VisitLiteral(Literal* node);
+  void VisitVariableProxy(VariableProxy* node);
+  void VisitAssignment(Assignment* node);
+  void VisitCompoundAssignment(CompoundAssignment* node);
+  void VisitProperty(Property* node);
+  void VisitCall(Call* node);
+  void VisitUnaryOperation(UnaryOperation* node);
+  void VisitCountOperation(CountOperation* node);
+  void VisitBinaryOperation(BinaryOperation* node);
+  void VisitNaryOperation(NaryOperation* node);
+  void VisitTemplateLiteral(TemplateLiteral* node);
+  void VisitCompareOperation(CompareOperation* node);
+  void VisitThrow(Throw* node);
+
+ private:
+  // Abstract state at a program point. An unreachable environment is the
+  // identity of Join, and is what a jump target starts out with before any
+  // jump to it is seen.
+  struct Environment {
+    bool reachable = false;
+    std::unordered_map<Variable*, InferredType> types;
+
+    void Join(const Environment& other);
+    bool operator==(const Environment& other) const;
+  };
+
+  void AnalyzeFunction(FunctionTypes* types);
+  void CollectDeclarations(Scope* scope);
+  void Enqueue(FunctionLiteral* literal);
+  void Enqueue(FunctionTypes* types);
+  FunctionTypes* Specialize(FunctionLiteral* literal,
+                            const std::vector<InferredType>& arguments);
+
+  InferredType Infer(Expression* expr);
+  void Record(Expression* expr, InferredType type);
+  void AssignTarget(Expression* target, InferredType type);
+  void AssignVariable(Variable* var, InferredType type);
+  InferredType LookupVariable(Variable* var);
+  bool IsTrackedInEnvironment(Variable* var) const;
+  void JoinSharedVariable(Variable* var, InferredType type);
+  void JoinParameter(FunctionLiteral* literal, int index, InferredType type);
+  void JoinReturnType(InferredType type);
+  void MarkEscaping(FunctionLiteral* literal);
+  void WidenToStorageTypes(Environment* env);
+
+  // Runs {body} until the environment at the loop header is stable.
+  template <typename Body>
+  void AnalyzeLoop(IterationStatement* loop, Body body);
+
+  FunctionTypes* GetOrCreateTypes(FunctionLiteral* literal);
+  // kSmi, or kDouble for the double operations.
+  InferredType SmiOperationType(Expression* operation, size_t index = 0) const;
+
+  const DoubleOperations* double_operations_;
+
+  std::unordered_map<FunctionLiteral*, std::unique_ptr<FunctionTypes>>
+      functions_;
+  std::unordered_map<FunctionLiteral*,
+                     std::vector<std::unique_ptr<FunctionTypes>>>
+      specializations_;
+  std::unordered_map<Variable*, FunctionLiteral*> declared_functions_;
+  std::unordered_map<Variable*, InferredType> shared_variables_;
+  std::unordered_set<Variable*> reassigned_functions_;
+  std::unordered_set<FunctionLiteral*> escaping_functions_;
+
+  FunctionTypes* current_ = nullptr;
+  Environment env_;
+  std::unordered_map<BreakableStatement*, Environment> break_envs_;
+  std::unordered_map<IterationStatement*, Environment> continue_envs_;
+  std::vector<FunctionTypes*> worklist_;
+  std::unordered_set<FunctionTypes*> enqueued_;
+  bool changed_ = false;
+};
+
+}  // namespace internal
+}  // namespace v8
+
+#endif  // V8_JS2C_TYPE_INFERENCE_H_